@@ -0,0 +1,803 @@
+#define STB_IMAGE_IMPLEMENTATION
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#define TINYGLTF_IMPLEMENTATION
+
+#include <vulkan/vulkan.hpp>
+
+VULKAN_HPP_DEFAULT_DISPATCH_LOADER_DYNAMIC_STORAGE
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <optional>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "constants.hpp"
+#include "AllocationCounter.hpp"
+#include "Animator.hpp"
+#include "CpuProfiler.hpp"
+#include "FrustumCulling.hpp"
+#include "GLTFLoader.hpp"
+#include "GltfBuilder.hpp"
+#include "InstanceCulling.hpp"
+#include "JobSystem.hpp"
+#include "LinearArena.hpp"
+#include "SceneBvh.hpp"
+#include "SyntheticCity.hpp"
+#include "SyntheticScene.hpp"
+
+// Window- and GPU-free micro-benchmarks of the engine's CPU hot paths over synthetic scenes.
+// Every benchmark sweeps a problem size and reports throughput plus the scaling exponent between
+// consecutive sizes (1 = linear, 2 = quadratic), so an optimisation can be checked numerically.
+
+namespace {
+struct BenchOptions {
+    std::uint32_t reps = 5;
+    std::string filter;  // Substring of the benchmark names to run (empty = all)
+    std::size_t maxInstances = 1'000'000;
+    std::size_t maxLoaderInstances = 100'000;
+    std::size_t maxKeyframes = 100'000;
+    std::string csvPath;
+    bool checkAllocations = false;  // Run the steady-state allocation check instead of the benchmarks
+};
+
+struct Measurement {
+    std::string benchmark;
+    const char* unit;
+    std::size_t size;   // Swept problem size
+    std::size_t items;  // Work items per run, for the throughput columns
+    double medianMs;
+    double minMs;
+};
+
+struct Timing {
+    double medianMs;
+    double minMs;
+};
+
+// Keeps the benchmarked results observable so the optimiser cannot drop the loops
+volatile double g_sink = 0.0;
+
+auto millisecondsSince(const std::chrono::steady_clock::time_point start) -> double {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+auto summarize(std::vector<double> samples) -> Timing {
+    std::sort(samples.begin(), samples.end());
+    const std::size_t mid = samples.size() / 2;
+    const double median = samples.size() % 2 == 1 ? samples[mid] : 0.5 * (samples[mid - 1] + samples[mid]);
+    return {.medianMs = median, .minMs = samples.front()};
+}
+
+// One untimed warmup run, then `reps` timed runs. setup() runs before each of them outside the timing.
+template <typename Setup, typename Fn>
+auto measure(const BenchOptions& options, Setup&& setup, Fn&& fn) -> Timing {
+    setup();
+    fn();
+
+    std::vector<double> samples;
+    samples.reserve(options.reps);
+    for (std::uint32_t rep = 0; rep < options.reps; rep++) {
+        setup();
+        const auto start = std::chrono::steady_clock::now();
+        fn();
+        samples.push_back(millisecondsSince(start));
+    }
+    return summarize(std::move(samples));
+}
+
+template <typename Fn>
+auto measure(const BenchOptions& options, Fn&& fn) -> Timing {
+    return measure(options, [] {}, std::forward<Fn>(fn));
+}
+
+// 1, 3, 10, 30, ... steps between first and last, always ending at last
+auto sweep(const std::size_t first, const std::size_t last) -> std::vector<std::size_t> {
+    std::vector<std::size_t> sizes;
+    for (std::size_t decade = first; decade <= last; decade *= 10) {
+        sizes.push_back(decade);
+        if (decade * 3 <= last) {
+            sizes.push_back(decade * 3);
+        }
+    }
+    if (sizes.empty() || sizes.back() != last) {
+        sizes.push_back(last);
+    }
+    return sizes;
+}
+
+// Reference for bvh.pick: every triangle of every instance, the same Möller-Trumbore test as SceneBvh
+auto linearPick(const Scene& scene, const Ray& ray) -> RayHit {
+    RayHit hit;
+    float tMax = ray.tMax;
+    for (std::uint32_t i = 0; i < scene.instances.size(); i++) {
+        const Instance& instance = scene.instances[i];
+        if (instance.meshIndex < 0 || (SceneBvh::instanceMask(scene, instance) & ray.mask) == 0) {
+            continue;
+        }
+
+        const glm::vec3 origin = glm::vec3(instance.inverseTransform * glm::vec4(ray.origin, 1.0f));
+        const glm::vec3 direction = glm::vec3(instance.inverseTransform * glm::vec4(ray.direction, 0.0f));
+        const Mesh& mesh = scene.meshes[instance.meshIndex];
+        for (std::uint32_t triangle = 0; triangle < mesh.indexCount / 3; triangle++) {
+            const std::uint32_t* indices = &scene.indices[mesh.baseIndex + 3 * triangle];
+            const glm::vec3 v0 = scene.vertices[mesh.baseVertex + indices[0]].position;
+            const glm::vec3 edge1 = scene.vertices[mesh.baseVertex + indices[1]].position - v0;
+            const glm::vec3 edge2 = scene.vertices[mesh.baseVertex + indices[2]].position - v0;
+
+            const glm::vec3 p = glm::cross(direction, edge2);
+            const float determinant = glm::dot(edge1, p);
+            if (std::abs(determinant) < 1e-12f) {
+                continue;
+            }
+            const float inverseDeterminant = 1.0f / determinant;
+            const glm::vec3 s = origin - v0;
+            const float u = glm::dot(s, p) * inverseDeterminant;
+            if (u < 0.0f || u > 1.0f) {
+                continue;
+            }
+            const glm::vec3 q = glm::cross(s, edge1);
+            const float v = glm::dot(direction, q) * inverseDeterminant;
+            if (v < 0.0f || u + v > 1.0f) {
+                continue;
+            }
+            const float distance = glm::dot(edge2, q) * inverseDeterminant;
+            if (distance < ray.tMin || distance > tMax) {
+                continue;
+            }
+
+            tMax = distance;
+            hit = {.t = distance, .instance = i, .triangle = triangle, .barycentrics = glm::vec2(u, v)};
+        }
+    }
+    return hit;
+}
+
+// One ray per cell of a grid over the camera's view, from the near to the far plane
+auto cameraRays(const Scene& scene, const std::uint32_t gridSize) -> std::vector<Ray> {
+    const glm::mat4 inverseViewProj = glm::inverse(scene.camera.getViewProjection());
+    std::vector<Ray> rays;
+    rays.reserve(static_cast<std::size_t>(gridSize) * gridSize);
+    for (std::uint32_t y = 0; y < gridSize; y++) {
+        for (std::uint32_t x = 0; x < gridSize; x++) {
+            const glm::vec2 ndc = (glm::vec2(x, y) + 0.5f) / static_cast<float>(gridSize) * 2.0f - 1.0f;
+            const glm::vec4 near = inverseViewProj * glm::vec4(ndc, 0.0f, 1.0f);
+            const glm::vec4 far = inverseViewProj * glm::vec4(ndc, 1.0f, 1.0f);
+            const glm::vec3 origin = glm::vec3(near) / near.w;
+            rays.push_back({.origin = origin, .direction = glm::vec3(far) / far.w - origin, .tMax = 1.0f});
+        }
+    }
+    return rays;
+}
+
+// Silences the loader's progress output while it is being timed
+class QuietStdout {
+public:
+    QuietStdout() : m_previous(std::cout.rdbuf(m_null.rdbuf())) {
+    }
+
+    ~QuietStdout() {
+        std::cout.rdbuf(m_previous);
+    }
+
+    QuietStdout(const QuietStdout&) = delete;
+    auto operator=(const QuietStdout&) -> QuietStdout& = delete;
+
+private:
+    std::ostringstream m_null;
+    std::streambuf* m_previous;
+};
+
+class BenchRunner {
+public:
+    explicit BenchRunner(BenchOptions options) : m_options(std::move(options)) {
+    }
+
+    void run() {
+        benchmarkLoader();
+        benchmarkCityLoad();
+        benchmarkSceneSweeps();
+        benchmarkKeyframeSweep();
+        benchmarkBoundsTests();
+        benchmarkBvh();
+        benchmarkDownscale();
+
+        printTables();
+        if (!m_options.csvPath.empty()) {
+            writeCsv();
+        }
+    }
+
+    // The per-frame CPU paths (animate, then cull) must not touch the heap once the frame arena has grown to its
+    // working size, same as the demo's --benchmark check. Throws when a steady-state frame called operator new.
+    void checkAllocations() {
+        constexpr std::uint32_t graceFrames = 8;  // The demo's minimum, the arena's high-water growth happens here
+        constexpr std::uint32_t checkedFrames = 240;
+
+        const std::size_t instances = std::min<std::size_t>(10'000, m_options.maxInstances);
+        const auto loaded = loadQuietly(buildSyntheticModel({.instanceCount = instances}));
+        Scene& scene = loaded->scene;
+
+        Animator animator;
+        LinearArena frameArena{FRAME_ARENA_INITIAL_SIZE};
+
+        const std::vector<std::uint32_t> materialPipelineIndices(scene.materials.size(), 0);
+        const auto instanceCount = static_cast<std::uint32_t>(scene.instances.size());
+        const std::uint32_t maxTransparent = std::min(instanceCount, 500u);
+        std::vector<DrawIndexedIndirectCommand> draws;
+        std::vector<std::uint32_t> drawPipelines;
+        draws.reserve(instanceCount);
+        drawPipelines.reserve(instanceCount);
+
+        std::uint64_t steadyStateAllocations = 0;
+        std::uint32_t allocatingFrames = 0;
+        for (std::uint32_t frame = 0; frame < graceFrames + checkedFrames; frame++) {
+            frameArena.reset();
+            const std::uint64_t allocationsAtFrameStart = AllocationCounter::threadAllocations();
+
+            const float time = static_cast<float>(frame) * 0.5f * SYNTHETIC_KEYFRAME_INTERVAL;
+            animator.animate(loaded->model, scene, time, frameArena);
+
+            draws.clear();
+            drawPipelines.clear();
+            std::uint32_t transparentCount = 0;
+            cullInstances(scene, Frustum::fromViewProjection(scene.camera.getViewProjection()), 0, instanceCount,
+                          materialPipelineIndices, maxTransparent, transparentCount, draws, drawPipelines);
+
+            const std::uint64_t frameAllocations = AllocationCounter::threadAllocations() - allocationsAtFrameStart;
+            if (frameAllocations > 0 && frame >= graceFrames) {
+                steadyStateAllocations += frameAllocations;
+                allocatingFrames++;
+            }
+        }
+        g_sink = g_sink + static_cast<double>(draws.size());
+
+        std::cout << std::format("[Bench] {} steady-state frames of {} instances: {} heap allocations in {} frames\n",
+                                 checkedFrames, instances, steadyStateAllocations, allocatingFrames);
+        if (steadyStateAllocations > 0) {
+            throw std::runtime_error(std::format("{} heap allocations in {} steady-state frames", steadyStateAllocations,
+                                                 allocatingFrames));
+        }
+    }
+
+private:
+    BenchOptions m_options;
+    JobSystem m_jobSystem;
+    std::vector<Measurement> m_results;
+
+    [[nodiscard]] auto enabled(const std::string_view name) const -> bool {
+        return m_options.filter.empty() || name.find(m_options.filter) != std::string_view::npos;
+    }
+
+    void record(std::string benchmark, const char* unit, const std::size_t size, const std::size_t items,
+                const Timing& timing) {
+        std::cerr << std::format("[Bench] {} {} -> {:.3f} ms\n", benchmark, size, timing.medianMs);
+        m_results.push_back({
+            .benchmark = std::move(benchmark),
+            .unit = unit,
+            .size = size,
+            .items = items,
+            .medianMs = timing.medianMs,
+            .minMs = timing.minMs,
+        });
+    }
+
+    auto loadQuietly(tinygltf::Model model) -> std::unique_ptr<LoadedGLTF> {
+        const QuietStdout quiet;
+        GLTFLoader loader(m_jobSystem);
+        return loader.loadModel(std::move(model));
+    }
+
+    // Full load from disk with the per-phase split taken from the profiling zones of each run
+    void benchmarkLoader() {
+        const bool loadFile = enabled("loader.load");
+        const bool loadModel = enabled("loader.loadModel");
+        const bool phases = enabled("loader.phase") || m_options.filter.starts_with("loader.phase.");
+        if (!loadFile && !loadModel && !phases) {
+            return;
+        }
+
+        GLTFLoader loader(m_jobSystem);
+        const auto directory = std::filesystem::temp_directory_path();
+
+        for (const std::size_t instances : sweep(1000, m_options.maxLoaderInstances)) {
+            const tinygltf::Model model = buildSyntheticModel({.instanceCount = instances});
+            std::unique_ptr<LoadedGLTF> loaded;
+
+            if (loadFile || phases) {
+                const auto path = (directory / std::format("cpu_bench_{}.glb", instances)).string();
+                writeGlb(model, path);
+
+                // Loader zones are summed per run; the setup before each run collects the previous timed one
+                std::map<std::string, std::vector<double>> phaseSamples;
+                std::uint32_t startedRuns = 0;
+                std::uint64_t since = 0;
+                const auto timing = measure(
+                    m_options,
+                    [&] {
+                        if (startedRuns >= 2) {
+                            collectPhases(since, phaseSamples);
+                        }
+                        startedRuns++;
+                        loaded.reset();
+                        since = CpuProfiler::now();
+                    },
+                    [&] {
+                        const QuietStdout quiet;
+                        loaded = loader.load(path);
+                    });
+                collectPhases(since, phaseSamples);
+
+                if (loadFile) {
+                    record("loader.load", "instance", instances, instances, timing);
+                }
+                for (const auto& [phase, samples] : phaseSamples) {
+                    const std::string name = "loader.phase." + phase;
+                    if (enabled(name)) {
+                        record(name, "instance", instances, instances, summarize(samples));
+                    }
+                }
+                std::filesystem::remove(path);
+            }
+
+            if (loadModel) {
+                tinygltf::Model pending;
+                const auto timing = measure(
+                    m_options,
+                    [&] {
+                        loaded.reset();
+                        pending = model;
+                    },
+                    [&] {
+                        const QuietStdout quiet;
+                        loaded = loader.loadModel(std::move(pending));
+                    });
+                record("loader.loadModel", "instance", instances, instances, timing);
+            }
+        }
+    }
+
+    // Full load of generated cities, with lights, vehicles and textures growing with the building count
+    void benchmarkCityLoad() {
+        if (!enabled("loader.city")) {
+            return;
+        }
+
+        GLTFLoader loader(m_jobSystem);
+        const auto directory = std::filesystem::temp_directory_path();
+
+        for (const std::size_t buildings : sweep(1000, m_options.maxLoaderInstances)) {
+            const CityDesc desc{
+                .buildingCount = buildings,
+                .uniqueBuildingCount = std::max<std::size_t>(buildings / 20, 1),
+                .pointLightCount = buildings / 30,
+                .spotLightCount = buildings / 60,
+                .vehicleCount = buildings / 40,
+            };
+            const auto path = (directory / std::format("cpu_bench_city_{}.glb", buildings)).string();
+            writeGlb(buildCityModel(desc), path);
+
+            std::unique_ptr<LoadedGLTF> loaded;
+            const auto timing = measure(
+                m_options, [&] { loaded.reset(); },
+                [&] {
+                    const QuietStdout quiet;
+                    loaded = loader.load(path);
+                });
+            record("loader.city", "building", buildings, buildings, timing);
+            std::filesystem::remove(path);
+        }
+    }
+
+    // Total time of every loader zone recorded since sinceNs, keyed by the name without the class prefix
+    static void collectPhases(const std::uint64_t sinceNs, std::map<std::string, std::vector<double>>& phaseSamples) {
+        constexpr std::string_view prefix = "GLTFLoader::";
+
+        std::map<std::string, double> runTotals;
+        for (const auto& event : CpuProfiler::snapshot(sinceNs)) {
+            const std::string_view name = event.name;
+            if (name.starts_with(prefix)) {
+                runTotals[std::string(name.substr(prefix.size()))] += static_cast<double>(event.endNs - event.startNs) / 1.0e6;
+            }
+        }
+        for (const auto& [phase, milliseconds] : runTotals) {
+            phaseSamples[phase].push_back(milliseconds);
+        }
+    }
+
+    // Animator::animate and the indirect draw culling loop over growing instance counts
+    void benchmarkSceneSweeps() {
+        const bool animate = enabled("animator.instances");
+        const bool cull = enabled("cull.instances");
+        if (!animate && !cull) {
+            return;
+        }
+
+        Animator animator;
+        LinearArena frameArena{FRAME_ARENA_INITIAL_SIZE};
+
+        for (const std::size_t instances : sweep(1000, m_options.maxInstances)) {
+            const auto loaded = loadQuietly(buildSyntheticModel({.instanceCount = instances}));
+            Scene& scene = loaded->scene;
+
+            if (animate) {
+                const float duration = 63.0f * SYNTHETIC_KEYFRAME_INTERVAL;
+                float time = 0.37f * duration;
+                const auto timing = measure(
+                    m_options,
+                    [&] {
+                        frameArena.reset();
+                        time += 0.5f * SYNTHETIC_KEYFRAME_INTERVAL;
+                    },
+                    [&] { animator.animate(loaded->model, scene, time, frameArena); });
+                record("animator.instances", "instance", instances, instances, timing);
+            }
+
+            if (cull) {
+                // Same inputs as ResourceManager::rebuildIndirectDrawCommands for the whole instance range
+                const std::vector<std::uint32_t> materialPipelineIndices(scene.materials.size(), 0);
+                const auto instanceCount = static_cast<std::uint32_t>(scene.instances.size());
+                const std::uint32_t maxTransparent = std::min(instanceCount, 500u);
+                const glm::mat4 viewProj = scene.camera.getViewProjection();
+
+                std::vector<DrawIndexedIndirectCommand> draws;
+                std::vector<std::uint32_t> drawPipelines;
+                draws.reserve(instanceCount);
+                drawPipelines.reserve(instanceCount);
+
+                const auto timing = measure(m_options, [&] {
+                    draws.clear();
+                    drawPipelines.clear();
+                    std::uint32_t transparentCount = 0;
+                    cullInstances(scene, Frustum::fromViewProjection(viewProj), 0, instanceCount,
+                                  materialPipelineIndices, maxTransparent, transparentCount, draws, drawPipelines);
+                });
+                g_sink = g_sink + static_cast<double>(draws.size());
+                record("cull.instances", "instance", instances, instances, timing);
+            }
+        }
+    }
+
+    // Fixed set of animated channels, growing keyframe count (keyframe lookup cost)
+    void benchmarkKeyframeSweep() {
+        if (!enabled("animator.keyframes")) {
+            return;
+        }
+
+        Animator animator;
+        LinearArena frameArena{FRAME_ARENA_INITIAL_SIZE};
+        const std::size_t instances = std::min<std::size_t>(10'000, m_options.maxInstances);
+
+        for (const std::size_t keyframes : sweep(10, m_options.maxKeyframes)) {
+            const auto loaded = loadQuietly(buildSyntheticModel({.instanceCount = instances, .keyframeCount = keyframes}));
+            const std::size_t channels = loaded->model.animations.empty() ? 0 : loaded->model.animations[0].channels.size();
+
+            // Sample halfway through the clip so the keyframe search covers a representative range
+            const float duration = static_cast<float>(keyframes - 1) * SYNTHETIC_KEYFRAME_INTERVAL;
+            float time = 0.5f * duration;
+            const auto timing = measure(
+                m_options,
+                [&] {
+                    frameArena.reset();
+                    time += 0.5f * SYNTHETIC_KEYFRAME_INTERVAL;
+                },
+                [&] { animator.animate(loaded->model, loaded->scene, time, frameArena); });
+            record("animator.keyframes", "channel", keyframes, channels, timing);
+        }
+    }
+
+    // Frustum::testAABB / testSphere and AABB::transform over random boxes around a fixed camera
+    void benchmarkBoundsTests() {
+        const bool aabb = enabled("frustum.testAABB");
+        const bool sphere = enabled("frustum.testSphere");
+        const bool transform = enabled("aabb.transform");
+        if (!aabb && !sphere && !transform) {
+            return;
+        }
+
+        const CameraParameters camera{
+            .yfov = 1.0f,
+            .aspectRatio = 16.0f / 9.0f,
+            .znear = 0.1f,
+            .zfar = 1000.0f,
+            .model = glm::mat4(1.0f),
+        };
+        const Frustum frustum = camera.getFrustum();
+
+        std::mt19937 rng(25);
+        std::uniform_real_distribution<float> position(-500.0f, 500.0f);
+        std::uniform_real_distribution<float> halfExtent(0.5f, 10.0f);
+        std::uniform_real_distribution<float> angle(0.0f, 6.2831853f);
+
+        // A small pool of instance matrices, reused round-robin like repeated meshes in the city
+        std::vector<glm::mat4> matrices(64);
+        for (auto& matrix : matrices) {
+            matrix = glm::translate(glm::mat4(1.0f), glm::vec3(position(rng), position(rng), position(rng))) *
+                     glm::rotate(glm::mat4(1.0f), angle(rng), glm::vec3(0.0f, 1.0f, 0.0f));
+        }
+
+        for (const std::size_t count : sweep(1000, m_options.maxInstances)) {
+            std::vector<AABB> boxes(count);
+            for (auto& box : boxes) {
+                const glm::vec3 center(position(rng), position(rng), position(rng));
+                const glm::vec3 extent(halfExtent(rng), halfExtent(rng), halfExtent(rng));
+                box = {center - extent, center + extent};
+            }
+
+            if (aabb) {
+                const auto timing = measure(m_options, [&] {
+                    std::size_t visible = 0;
+                    for (const auto& box : boxes) {
+                        visible += frustum.testAABB(box.min, box.max) ? 1 : 0;
+                    }
+                    g_sink = g_sink + static_cast<double>(visible);
+                });
+                record("frustum.testAABB", "box", count, count, timing);
+            }
+
+            if (sphere) {
+                const auto timing = measure(m_options, [&] {
+                    std::size_t visible = 0;
+                    for (const auto& box : boxes) {
+                        visible += frustum.testSphere(box.center(), box.radius()) ? 1 : 0;
+                    }
+                    g_sink = g_sink + static_cast<double>(visible);
+                });
+                record("frustum.testSphere", "box", count, count, timing);
+            }
+
+            if (transform) {
+                const auto timing = measure(m_options, [&] {
+                    glm::vec3 accumulated(0.0f);
+                    for (std::size_t i = 0; i < boxes.size(); i++) {
+                        const AABB transformed = boxes[i].transform(matrices[i % matrices.size()]);
+                        accumulated += transformed.max - transformed.min;
+                    }
+                    g_sink = g_sink + static_cast<double>(accumulated.x + accumulated.y + accumulated.z);
+                });
+                record("aabb.transform", "box", count, count, timing);
+            }
+        }
+    }
+
+    // SceneBvh construction, and closest-hit batches through the camera's view, over growing instance counts
+    void benchmarkBvh() {
+        const bool build = enabled("bvh.build");
+        const bool rays = enabled("bvh.rays");
+        const bool pick = enabled("bvh.pick");
+        const bool linearReference = enabled("linear.pick");
+        if (!build && !rays && !pick && !linearReference) {
+            return;
+        }
+
+        for (const std::size_t instances : sweep(1000, m_options.maxInstances)) {
+            const auto loaded = loadQuietly(buildSyntheticModel({.instanceCount = instances}));
+            const Scene& scene = loaded->scene;
+
+            if (build) {
+                std::optional<SceneBvh> bvh;
+                const auto timing = measure(m_options, [&] { bvh.reset(); }, [&] { bvh.emplace(scene, m_jobSystem); });
+                record("bvh.build", "instance", instances, instances, timing);
+            }
+
+            if (rays) {
+                const std::vector<Ray> gridRays = cameraRays(scene, 256);
+                const SceneBvh bvh(scene, m_jobSystem);
+                std::vector<RayHit> hits(gridRays.size());
+                const auto timing = measure(m_options, [&] { bvh.castRays(gridRays, hits); });
+                g_sink = g_sink + static_cast<double>(std::ranges::count_if(hits, [](const RayHit& hit) { return hit.hit(); }));
+                record("bvh.rays", "ray", instances, gridRays.size(), timing);
+            }
+
+            // Free camera picking casts single rays on the calling thread, compared with a linear search over
+            // every triangle. Both must find the same hits.
+            if (pick || linearReference) {
+                const std::vector<Ray> pickRays = cameraRays(scene, 4);
+                std::vector<RayHit> bvhHits(pickRays.size());
+                std::vector<RayHit> linearHits(pickRays.size());
+
+                const SceneBvh bvh(scene, m_jobSystem);
+                const auto bvhTiming = measure(m_options, [&] {
+                    for (std::size_t i = 0; i < pickRays.size(); i++) {
+                        bvhHits[i] = bvh.castRay(pickRays[i]);
+                    }
+                });
+                if (pick) {
+                    record("bvh.pick", "ray", instances, pickRays.size(), bvhTiming);
+                }
+
+                if (linearReference) {
+                    const auto timing = measure(m_options, [&] {
+                        for (std::size_t i = 0; i < pickRays.size(); i++) {
+                            linearHits[i] = linearPick(scene, pickRays[i]);
+                        }
+                    });
+                    record("linear.pick", "ray", instances, pickRays.size(), timing);
+
+                    for (std::size_t i = 0; i < pickRays.size(); i++) {
+                        if (bvhHits[i].hit() != linearHits[i].hit() ||
+                            std::abs(bvhHits[i].t - linearHits[i].t) > 1e-4f * std::max(1.0f, linearHits[i].t)) {
+                            throw std::runtime_error(std::format("bvh.pick and linear.pick disagree on ray {} of {} instances",
+                                                                 i, instances));
+                        }
+                    }
+                }
+                g_sink = g_sink + static_cast<double>(bvhHits.front().t);
+            }
+        }
+    }
+
+    // Halving RGBA textures, as the loader does for textures above the maximum dimension
+    void benchmarkDownscale() {
+        if (!enabled("image.downscale")) {
+            return;
+        }
+
+        std::mt19937 rng(25);
+        std::uniform_int_distribution<int> byte(0, 255);
+
+        for (std::uint32_t edge = 256; edge <= 4096; edge *= 2) {
+            std::vector<unsigned char> source(static_cast<std::size_t>(edge) * edge * 4);
+            for (auto& value : source) {
+                value = static_cast<unsigned char>(byte(rng));
+            }
+
+            const std::uint32_t dstEdge = edge / 2;
+            const std::size_t dstPixels = static_cast<std::size_t>(dstEdge) * dstEdge;
+            const auto timing = measure(m_options, [&] {
+                const auto result = GLTFLoader::downscaleImage(source, edge, edge, dstEdge, dstEdge, 4);
+                g_sink = g_sink + static_cast<double>(result[result.size() / 2]);
+            });
+            record("image.downscale", "pixel", dstPixels, dstPixels, timing);
+        }
+    }
+
+    // One table per benchmark, rows in sweep order
+    void printTables() const {
+        std::map<std::string, std::vector<const Measurement*>> byBenchmark;
+        for (const auto& measurement : m_results) {
+            byBenchmark[measurement.benchmark].push_back(&measurement);
+        }
+
+        std::cout << std::format("[Bench] {} timed runs per size (+1 warmup), median and min\n", m_options.reps);
+        for (const auto& [name, rows] : byBenchmark) {
+            const char* unit = rows.front()->unit;
+            std::cout << std::format("\n{} ({})\n", name, unit);
+            std::cout << std::format("  {:>10} {:>11} {:>11} {:>13} {:>11} {:>8}\n", "size", "median ms", "min ms",
+                                     std::format("{}/s", unit), std::format("ns/{}", unit), "scaling");
+
+            for (std::size_t i = 0; i < rows.size(); i++) {
+                const Measurement& row = *rows[i];
+                const double seconds = row.medianMs / 1000.0;
+                const double throughput = seconds > 0.0 ? static_cast<double>(row.items) / seconds : 0.0;
+                const double nsPerItem = row.items > 0 ? row.medianMs * 1.0e6 / static_cast<double>(row.items) : 0.0;
+
+                // Exponent of the time growth between this and the previous size: t ~ size^k
+                std::string scaling = "-";
+                if (i > 0) {
+                    const Measurement& previous = *rows[i - 1];
+                    if (previous.medianMs > 0.0 && row.medianMs > 0.0 && row.size != previous.size) {
+                        scaling = std::format("{:.2f}", std::log(row.medianMs / previous.medianMs) /
+                                                            std::log(static_cast<double>(row.size) /
+                                                                     static_cast<double>(previous.size)));
+                    }
+                }
+
+                std::cout << std::format("  {:>10} {:>11.3f} {:>11.3f} {:>13.4g} {:>11.2f} {:>8}\n", row.size,
+                                         row.medianMs, row.minMs, throughput, nsPerItem, scaling);
+            }
+        }
+        std::cout << std::flush;
+    }
+
+    void writeCsv() const {
+        std::ofstream file(m_options.csvPath);
+        if (!file) {
+            throw std::runtime_error("Failed to open " + m_options.csvPath + " for writing");
+        }
+
+        file << "benchmark,unit,size,items,median_ms,min_ms\n";
+        for (const auto& row : m_results) {
+            file << std::format("{},{},{},{},{:.6f},{:.6f}\n", row.benchmark, row.unit, row.size, row.items,
+                                row.medianMs, row.minMs);
+        }
+        std::cout << "[Bench] Results written to " << m_options.csvPath << std::endl;
+    }
+};
+
+auto requireValue(const int argc, char** argv, int& i) -> std::string {
+    if (i + 1 >= argc) {
+        throw std::runtime_error("Missing value for command line option " + std::string(argv[i]));
+    }
+    return argv[++i];
+}
+
+auto parseSize(const std::string_view option, const std::string& value) -> std::size_t {
+    try {
+        return static_cast<std::size_t>(std::stoull(value));
+    } catch (const std::exception&) {
+        throw std::runtime_error("Invalid value '" + value + "' for " + std::string(option));
+    }
+}
+
+void printUsage(const char* executableName) {
+    std::cout << "Usage: " << executableName << " [options]\n"
+              << "  --filter <text>              Only run benchmarks whose name contains text\n"
+              << "  --reps <n>                   Timed runs per size after one warmup run (default: 5)\n"
+              << "  --max-instances <n>          Largest instance count of the scene sweeps (default: 1000000)\n"
+              << "  --max-loader-instances <n>   Largest instance count of the loader sweep (default: 100000)\n"
+              << "  --max-keyframes <n>          Largest keyframe count of the animation sweep (default: 100000)\n"
+              << "  --csv <path>                 Also write every measurement as CSV\n"
+              << "  --check-allocations          Fail if steady-state animate and cull frames allocate (no benchmarks)\n"
+              << "Benchmarks: loader.load, loader.phase.*, loader.loadModel, loader.city, animator.instances,\n"
+              << "            animator.keyframes, cull.instances, frustum.testAABB, frustum.testSphere,\n"
+              << "            aabb.transform, bvh.build, bvh.rays, bvh.pick, linear.pick, image.downscale\n";
+}
+
+auto parseOptions(const int argc, char** argv, bool& showHelp) -> BenchOptions {
+    BenchOptions options{};
+
+    for (int i = 1; i < argc; i++) {
+        const std::string_view arg = argv[i];
+
+        if (arg == "--filter") {
+            options.filter = requireValue(argc, argv, i);
+        } else if (arg == "--reps") {
+            options.reps = static_cast<std::uint32_t>(std::max<std::size_t>(1, parseSize(arg, requireValue(argc, argv, i))));
+        } else if (arg == "--max-instances") {
+            options.maxInstances = std::max<std::size_t>(1000, parseSize(arg, requireValue(argc, argv, i)));
+        } else if (arg == "--max-loader-instances") {
+            options.maxLoaderInstances = std::max<std::size_t>(1000, parseSize(arg, requireValue(argc, argv, i)));
+        } else if (arg == "--max-keyframes") {
+            options.maxKeyframes = std::max<std::size_t>(10, parseSize(arg, requireValue(argc, argv, i)));
+        } else if (arg == "--csv") {
+            options.csvPath = requireValue(argc, argv, i);
+        } else if (arg == "--check-allocations") {
+            options.checkAllocations = true;
+        } else if (arg == "--help" || arg == "-h") {
+            showHelp = true;
+        } else {
+            throw std::runtime_error("Unknown command line option: " + std::string(arg));
+        }
+    }
+
+    return options;
+}
+} // namespace
+
+int main(int argc, char** argv) {
+    try {
+        bool showHelp = false;
+        BenchOptions options = parseOptions(argc, argv, showHelp);
+        if (showHelp) {
+            printUsage(argv[0]);
+            return 0;
+        }
+
+        PROFILE_THREAD_NAME("Bench");
+        const bool checkAllocations = options.checkAllocations;
+        BenchRunner runner(std::move(options));
+        if (checkAllocations) {
+            runner.checkAllocations();
+        } else {
+            runner.run();
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return -1;
+    }
+
+    return 0;
+}
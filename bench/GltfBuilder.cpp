@@ -0,0 +1,210 @@
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+#include <stb_image_write.h>
+
+#include "GltfBuilder.hpp"
+
+namespace {
+// normal, tangent (u direction), bitangent (v direction) of the six box faces
+constexpr float BOX_FACES[6][3][3] = {
+    {{1, 0, 0}, {0, 0, -1}, {0, 1, 0}},
+    {{-1, 0, 0}, {0, 0, 1}, {0, 1, 0}},
+    {{0, 1, 0}, {1, 0, 0}, {0, 0, -1}},
+    {{0, -1, 0}, {1, 0, 0}, {0, 0, 1}},
+    {{0, 0, 1}, {1, 0, 0}, {0, 1, 0}},
+    {{0, 0, -1}, {-1, 0, 0}, {0, 1, 0}},
+};
+constexpr float QUAD_CORNERS[4][2] = {{-1, -1}, {1, -1}, {1, 1}, {-1, 1}};
+
+auto ensureBuffer(tinygltf::Model& model) -> std::vector<unsigned char>& {
+    if (model.buffers.empty()) {
+        model.buffers.emplace_back();
+    }
+    return model.buffers[0].data;
+}
+
+auto accessorTypeOf(const int components) -> int {
+    switch (components) {
+        case 1: return TINYGLTF_TYPE_SCALAR;
+        case 2: return TINYGLTF_TYPE_VEC2;
+        case 3: return TINYGLTF_TYPE_VEC3;
+        case 4: return TINYGLTF_TYPE_VEC4;
+        default: throw std::runtime_error("Unsupported float accessor width");
+    }
+}
+
+template <typename Index>
+auto appendIndexAccessor(tinygltf::Model& model, const std::vector<std::uint32_t>& indices, const int componentType) -> int {
+    std::vector<Index> packed(indices.begin(), indices.end());
+    const int view = appendBufferView(model, packed.data(), packed.size() * sizeof(Index), TINYGLTF_TARGET_ELEMENT_ARRAY_BUFFER);
+    return appendAccessor(model, view, componentType, TINYGLTF_TYPE_SCALAR, packed.size());
+}
+} // namespace
+
+auto appendBufferView(tinygltf::Model& model, const void* data, const std::size_t size, const int target) -> int {
+    auto& bytes = ensureBuffer(model);
+    bytes.resize((bytes.size() + 3) & ~std::size_t{3});
+
+    tinygltf::BufferView view;
+    view.buffer = 0;
+    view.byteOffset = bytes.size();
+    view.byteLength = size;
+    view.target = target;
+
+    bytes.resize(bytes.size() + size);
+    if (size > 0) {
+        std::memcpy(bytes.data() + view.byteOffset, data, size);
+    }
+
+    model.bufferViews.push_back(view);
+    return static_cast<int>(model.bufferViews.size() - 1);
+}
+
+auto appendAccessor(tinygltf::Model& model, const int bufferView, const int componentType, const int type,
+                    const std::size_t count) -> int {
+    tinygltf::Accessor accessor;
+    accessor.bufferView = bufferView;
+    accessor.componentType = componentType;
+    accessor.type = type;
+    accessor.count = count;
+    model.accessors.push_back(accessor);
+    return static_cast<int>(model.accessors.size() - 1);
+}
+
+auto appendFloatAccessor(tinygltf::Model& model, const std::vector<float>& values, const int components,
+                         const int target) -> int {
+    const int view = appendBufferView(model, values.data(), values.size() * sizeof(float), target);
+    return appendAccessor(model, view, TINYGLTF_COMPONENT_TYPE_FLOAT, accessorTypeOf(components),
+                          values.size() / static_cast<std::size_t>(components));
+}
+
+auto appendBoxGeometry(tinygltf::Model& model, const std::vector<GltfBox>& boxes, const float uvSize)
+    -> PrimitiveAccessors {
+    std::vector<float> positions;
+    std::vector<float> normals;
+    std::vector<float> texCoords;
+    std::vector<float> tangents;
+    std::vector<std::uint32_t> indices;
+
+    std::array<float, 3> boundsMin{std::numeric_limits<float>::max(), std::numeric_limits<float>::max(),
+                                   std::numeric_limits<float>::max()};
+    std::array<float, 3> boundsMax{std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest(),
+                                   std::numeric_limits<float>::lowest()};
+
+    for (const auto& box : boxes) {
+        for (const auto& face : BOX_FACES) {
+            const auto base = static_cast<std::uint32_t>(positions.size() / 3);
+            for (const auto& corner : QUAD_CORNERS) {
+                float u = 0.0f;
+                float v = 0.0f;
+                for (int axis = 0; axis < 3; axis++) {
+                    const float center = 0.5f * (box.min[axis] + box.max[axis]);
+                    const float halfExtent = 0.5f * (box.max[axis] - box.min[axis]);
+                    const float direction = face[0][axis] + corner[0] * face[1][axis] + corner[1] * face[2][axis];
+                    const float position = center + direction * halfExtent;
+
+                    positions.push_back(position);
+                    normals.push_back(face[0][axis]);
+                    tangents.push_back(face[1][axis]);
+                    u += position * face[1][axis];
+                    v -= position * face[2][axis];
+
+                    boundsMin[axis] = std::min(boundsMin[axis], position);
+                    boundsMax[axis] = std::max(boundsMax[axis], position);
+                }
+                tangents.push_back(1.0f);
+                texCoords.push_back(u / uvSize);
+                texCoords.push_back(v / uvSize);
+            }
+            for (const std::uint32_t index : {0u, 1u, 2u, 0u, 2u, 3u}) {
+                indices.push_back(base + index);
+            }
+        }
+    }
+
+    PrimitiveAccessors accessors{};
+    accessors.position = appendFloatAccessor(model, positions, 3, TINYGLTF_TARGET_ARRAY_BUFFER);
+    model.accessors[accessors.position].minValues.assign(boundsMin.begin(), boundsMin.end());
+    model.accessors[accessors.position].maxValues.assign(boundsMax.begin(), boundsMax.end());
+    accessors.normal = appendFloatAccessor(model, normals, 3, TINYGLTF_TARGET_ARRAY_BUFFER);
+    accessors.texCoord = appendFloatAccessor(model, texCoords, 2, TINYGLTF_TARGET_ARRAY_BUFFER);
+    accessors.tangent = appendFloatAccessor(model, tangents, 4, TINYGLTF_TARGET_ARRAY_BUFFER);
+
+    const std::size_t vertexCount = positions.size() / 3;
+    accessors.indices = vertexCount <= std::numeric_limits<std::uint16_t>::max()
+                            ? appendIndexAccessor<std::uint16_t>(model, indices, TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT)
+                            : appendIndexAccessor<std::uint32_t>(model, indices, TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT);
+    return accessors;
+}
+
+auto appendMesh(tinygltf::Model& model, const PrimitiveAccessors& accessors, const int material, std::string name)
+    -> int {
+    tinygltf::Primitive primitive;
+    primitive.attributes["POSITION"] = accessors.position;
+    primitive.attributes["NORMAL"] = accessors.normal;
+    primitive.attributes["TEXCOORD_0"] = accessors.texCoord;
+    primitive.attributes["TANGENT"] = accessors.tangent;
+    primitive.indices = accessors.indices;
+    primitive.material = material;
+    primitive.mode = TINYGLTF_MODE_TRIANGLES;
+
+    tinygltf::Mesh mesh;
+    mesh.name = std::move(name);
+    mesh.primitives.push_back(primitive);
+    model.meshes.push_back(mesh);
+    return static_cast<int>(model.meshes.size() - 1);
+}
+
+auto appendPngTexture(tinygltf::Model& model, const std::vector<unsigned char>& rgba, const int width,
+                      const int height, std::string name) -> int {
+    std::vector<unsigned char> png;
+    const auto appendBytes = [](void* context, void* data, const int size) {
+        auto* out = static_cast<std::vector<unsigned char>*>(context);
+        const auto* bytes = static_cast<const unsigned char*>(data);
+        out->insert(out->end(), bytes, bytes + size);
+    };
+    if (stbi_write_png_to_func(appendBytes, &png, width, height, 4, rgba.data(), width * 4) == 0) {
+        throw std::runtime_error("Failed to encode texture " + name);
+    }
+
+    if (model.samplers.empty()) {
+        tinygltf::Sampler sampler;
+        sampler.magFilter = TINYGLTF_TEXTURE_FILTER_LINEAR;
+        sampler.minFilter = TINYGLTF_TEXTURE_FILTER_LINEAR_MIPMAP_LINEAR;
+        sampler.wrapS = TINYGLTF_TEXTURE_WRAP_REPEAT;
+        sampler.wrapT = TINYGLTF_TEXTURE_WRAP_REPEAT;
+        model.samplers.push_back(sampler);
+    }
+
+    tinygltf::Image image;
+    image.name = name;
+    image.mimeType = "image/png";
+    image.bufferView = appendBufferView(model, png.data(), png.size(), 0);
+    model.images.push_back(image);
+
+    tinygltf::Texture texture;
+    texture.name = std::move(name);
+    texture.source = static_cast<int>(model.images.size() - 1);
+    texture.sampler = 0;
+    model.textures.push_back(texture);
+    return static_cast<int>(model.textures.size() - 1);
+}
+
+void setExtrasFlag(tinygltf::Value& extras, const std::string& key, const bool value) {
+    tinygltf::Value::Object object;
+    if (extras.IsObject()) {
+        object = extras.Get<tinygltf::Value::Object>();
+    }
+    object[key] = tinygltf::Value(value);
+    extras = tinygltf::Value(std::move(object));
+}
+
+void writeGlb(const tinygltf::Model& model, const std::string& path) {
+    tinygltf::TinyGLTF writer;
+    if (!writer.WriteGltfSceneToFile(&model, path, false, true, false, true)) {
+        throw std::runtime_error("Failed to write glTF " + path);
+    }
+}
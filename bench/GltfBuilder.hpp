@@ -0,0 +1,53 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <tiny_gltf.h>
+
+// Helpers for writing glTF models from code (synthetic benchmark scenes, the city generator).
+// All data goes into buffer 0, which is created on first use and ends up in the GLB's binary chunk.
+
+// Appends raw bytes as a new buffer view (4-byte aligned) and returns its index. target 0 = no target
+auto appendBufferView(tinygltf::Model& model, const void* data, std::size_t size, int target) -> int;
+
+auto appendAccessor(tinygltf::Model& model, int bufferView, int componentType, int type, std::size_t count) -> int;
+
+// Float accessor over a tightly packed array of `components`-wide elements (VEC2/3/4 or SCALAR)
+auto appendFloatAccessor(tinygltf::Model& model, const std::vector<float>& values, int components, int target) -> int;
+
+// Axis-aligned box in mesh space
+struct GltfBox {
+    std::array<float, 3> min;
+    std::array<float, 3> max;
+};
+
+// Vertex attribute accessors of one primitive, as read by GLTFLoader::loadPrimitive
+struct PrimitiveAccessors {
+    int position;
+    int normal;
+    int texCoord;
+    int tangent;
+    int indices;
+};
+
+// Geometry of a set of boxes, one quad per face with its own normal and tangent. UVs are in world units
+// divided by uvSize, so tiled textures keep their size on differently sized boxes.
+auto appendBoxGeometry(tinygltf::Model& model, const std::vector<GltfBox>& boxes, float uvSize = 1.0f)
+    -> PrimitiveAccessors;
+
+// Mesh with a single triangle primitive over the given accessors; returns the mesh index
+auto appendMesh(tinygltf::Model& model, const PrimitiveAccessors& accessors, int material, std::string name) -> int;
+
+// Encodes RGBA8 pixels as PNG into the binary chunk and adds image + texture (with a repeat sampler).
+// Returns the texture index
+auto appendPngTexture(tinygltf::Model& model, const std::vector<unsigned char>& rgba, int width, int height,
+                      std::string name) -> int;
+
+// Flag stored in node or material extras, read back by GLTFLoader
+void setExtrasFlag(tinygltf::Value& extras, const std::string& key, bool value);
+
+// Writes a binary glTF, throws on failure
+void writeGlb(const tinygltf::Model& model, const std::string& path);
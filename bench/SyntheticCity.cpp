@@ -0,0 +1,497 @@
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "GltfBuilder.hpp"
+#include "SyntheticCity.hpp"
+
+namespace {
+constexpr float PI = 3.14159265358979f;
+
+constexpr float LOT_SIZE = 24.0f;          // Building lot edge (metres)
+constexpr std::size_t LOTS_PER_BLOCK = 4;  // Lots along one side of a block
+constexpr float STREET_WIDTH = 16.0f;
+constexpr float FACADE_TILE_SIZE = 4.0f;   // World size of one facade texture repeat
+constexpr std::size_t CAMERA_KEYFRAMES = 240;
+
+// Neon palette shared by emissive windows, lights and vehicles
+constexpr std::array<std::array<float, 3>, 6> NEON_COLORS = {{
+    {1.0f, 0.1f, 0.6f},
+    {0.1f, 0.9f, 1.0f},
+    {0.7f, 0.2f, 1.0f},
+    {1.0f, 0.8f, 0.1f},
+    {0.2f, 1.0f, 0.4f},
+    {1.0f, 0.3f, 0.1f},
+}};
+
+struct CityLayout {
+    std::size_t lotsPerSide;
+    float extent;  // Edge length of the built-up square, centred on the origin
+
+    // Lot centre in world space; a street separates every LOTS_PER_BLOCK lots
+    [[nodiscard]] auto lotCenter(const std::size_t lot) const -> float {
+        return static_cast<float>(lot) * LOT_SIZE + 0.5f * LOT_SIZE +
+               static_cast<float>(lot / LOTS_PER_BLOCK) * STREET_WIDTH - 0.5f * extent;
+    }
+
+    [[nodiscard]] auto blockCount() const -> std::size_t {
+        return (lotsPerSide + LOTS_PER_BLOCK - 1) / LOTS_PER_BLOCK;
+    }
+
+    // Street centreline just before block `block` (block 0 has one on its outer side as well)
+    [[nodiscard]] auto streetBefore(const std::size_t block) const -> float {
+        return lotCenter(block * LOTS_PER_BLOCK) - 0.5f * LOT_SIZE - 0.5f * STREET_WIDTH;
+    }
+};
+
+auto makeLayout(const std::size_t buildingCount) -> CityLayout {
+    const auto lotsPerSide = std::max<std::size_t>(
+        1, static_cast<std::size_t>(std::ceil(std::sqrt(static_cast<double>(buildingCount)))));
+    const float extent = static_cast<float>(lotsPerSide) * LOT_SIZE +
+                         static_cast<float>((lotsPerSide - 1) / LOTS_PER_BLOCK) * STREET_WIDTH;
+    return {.lotsPerSide = lotsPerSide, .extent = extent};
+}
+
+// glTF rotation (x, y, z, w) of a node turned by yaw around Y, then pitched around its X axis
+auto yawPitchRotation(const float yaw, const float pitch) -> std::array<float, 4> {
+    return {
+        std::cos(0.5f * yaw) * std::sin(0.5f * pitch),
+        std::sin(0.5f * yaw) * std::cos(0.5f * pitch),
+        -std::sin(0.5f * yaw) * std::sin(0.5f * pitch),
+        std::cos(0.5f * yaw) * std::cos(0.5f * pitch),
+    };
+}
+
+// Yaw that points a node's -Z axis along (dx, dz)
+auto headingYaw(const float dx, const float dz) -> float {
+    return std::atan2(-dx, -dz);
+}
+
+// Dark facade with a grid of windows, some of them lit in one of the neon colours
+auto makeFacadeTexture(const std::uint32_t size, const std::size_t variant, std::mt19937& rng)
+    -> std::vector<unsigned char> {
+    constexpr std::uint32_t cellSize = 16;
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+    const auto& neon = NEON_COLORS[variant % NEON_COLORS.size()];
+    const float litFraction = 0.2f + 0.5f * unit(rng);
+    const std::uint32_t cells = std::max<std::uint32_t>(1, size / cellSize);
+
+    std::vector<bool> lit(static_cast<std::size_t>(cells) * cells);
+    for (std::size_t i = 0; i < lit.size(); i++) {
+        lit[i] = unit(rng) < litFraction;
+    }
+
+    std::vector<unsigned char> pixels(static_cast<std::size_t>(size) * size * 4);
+    for (std::uint32_t y = 0; y < size; y++) {
+        for (std::uint32_t x = 0; x < size; x++) {
+            const std::uint32_t cx = std::min(x / cellSize, cells - 1);
+            const std::uint32_t cy = std::min(y / cellSize, cells - 1);
+            const bool window = x % cellSize >= 3 && x % cellSize < cellSize - 3 && y % cellSize >= 4 &&
+                                y % cellSize < cellSize - 2;
+
+            std::array<float, 3> color = {0.08f, 0.08f, 0.1f};
+            if (window) {
+                color = lit[static_cast<std::size_t>(cy) * cells + cx] ? neon : std::array<float, 3>{0.02f, 0.03f, 0.05f};
+            }
+
+            unsigned char* pixel = pixels.data() + (static_cast<std::size_t>(y) * size + x) * 4;
+            for (int c = 0; c < 3; c++) {
+                pixel[c] = static_cast<unsigned char>(std::clamp(color[c], 0.0f, 1.0f) * 255.0f);
+            }
+            pixel[3] = 255;
+        }
+    }
+    return pixels;
+}
+
+void appendMaterials(tinygltf::Model& model, const CityDesc& desc, const std::vector<int>& textures, std::mt19937& rng) {
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+    for (std::size_t i = 0; i < std::max<std::size_t>(desc.materialCount, 1); i++) {
+        tinygltf::Material material;
+        material.name = "Facade" + std::to_string(i);
+
+        const double tint = 0.3 + 0.4 * unit(rng);
+        material.pbrMetallicRoughness.baseColorFactor = {tint, tint, tint * 1.1, 1.0};
+        material.pbrMetallicRoughness.metallicFactor = 0.1 + 0.5 * unit(rng);
+        material.pbrMetallicRoughness.roughnessFactor = 0.3 + 0.6 * unit(rng);
+
+        if (!textures.empty()) {
+            const int texture = textures[i % textures.size()];
+            material.pbrMetallicRoughness.baseColorTexture.index = texture;
+
+            // Every third facade lights its windows
+            if (i % 3 == 0) {
+                material.emissiveTexture.index = texture;
+                material.emissiveFactor = {1.0, 1.0, 1.0};
+            }
+        }
+
+        if (i % 5 == 0) {
+            setExtrasFlag(material.extras, "reflective", true);
+        }
+        model.materials.push_back(material);
+    }
+
+    tinygltf::Material ground;
+    ground.name = "Asphalt";
+    ground.pbrMetallicRoughness.baseColorFactor = {0.05, 0.05, 0.06, 1.0};
+    ground.pbrMetallicRoughness.metallicFactor = 0.0;
+    ground.pbrMetallicRoughness.roughnessFactor = 0.4;
+    setExtrasFlag(ground.extras, "reflective", true);
+    model.materials.push_back(ground);
+
+    tinygltf::Material vehicle;
+    vehicle.name = "VehicleHull";
+    vehicle.pbrMetallicRoughness.baseColorFactor = {0.2, 0.2, 0.25, 1.0};
+    vehicle.pbrMetallicRoughness.metallicFactor = 0.8;
+    vehicle.pbrMetallicRoughness.roughnessFactor = 0.3;
+    vehicle.emissiveFactor = {0.1, 0.9, 1.0};
+    model.materials.push_back(vehicle);
+}
+
+// Podium and tower, or a single slab for the lower buildings. Origin at the footprint centre on the ground
+auto buildingBoxes(std::mt19937& rng) -> std::vector<GltfBox> {
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    const float width = 10.0f + 10.0f * unit(rng);
+    const float depth = 10.0f + 10.0f * unit(rng);
+    const float height = 12.0f + 140.0f * std::pow(unit(rng), 3.0f);
+
+    if (height < 50.0f) {
+        return {{.min = {-0.5f * width, 0.0f, -0.5f * depth}, .max = {0.5f * width, height, 0.5f * depth}}};
+    }
+
+    const float podium = 0.25f * height;
+    return {
+        {.min = {-0.5f * width, 0.0f, -0.5f * depth}, .max = {0.5f * width, podium, 0.5f * depth}},
+        {.min = {-0.35f * width, podium, -0.35f * depth}, .max = {0.35f * width, height, 0.35f * depth}},
+    };
+}
+
+void appendLights(tinygltf::Model& model, tinygltf::Scene& scene, const CityDesc& desc, const CityLayout& layout,
+                  std::mt19937& rng) {
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    std::uniform_int_distribution<std::size_t> street(0, layout.blockCount());
+
+    const auto appendLightNode = [&](tinygltf::Light light, tinygltf::Node node, const bool castsShadows) {
+        model.lights.push_back(std::move(light));
+        node.light = static_cast<int>(model.lights.size() - 1);
+        setExtrasFlag(node.extras, "castsShadows", castsShadows);
+        scene.nodes.push_back(static_cast<int>(model.nodes.size()));
+        model.nodes.push_back(std::move(node));
+    };
+
+    // Random point along a street centreline, running along x or z
+    const auto streetPosition = [&](const float height) -> std::vector<double> {
+        const float across = layout.streetBefore(street(rng));
+        const float along = (unit(rng) - 0.5f) * layout.extent;
+        return unit(rng) < 0.5f ? std::vector<double>{across, height, along} : std::vector<double>{along, height, across};
+    };
+
+    tinygltf::Light moon;
+    moon.name = "Moon";
+    moon.type = "directional";
+    moon.color = {0.6, 0.7, 1.0};
+    moon.intensity = 0.3 * 50000.0;
+    tinygltf::Node moonNode;
+    moonNode.name = "Moon";
+    const auto moonRotation = yawPitchRotation(0.6f, -1.0f);
+    moonNode.rotation.assign(moonRotation.begin(), moonRotation.end());
+    appendLightNode(moon, moonNode, false);
+
+    // Neon signs and glowing billboards between the buildings
+    for (std::size_t i = 0; i < desc.pointLightCount; i++) {
+        const auto& color = NEON_COLORS[i % NEON_COLORS.size()];
+
+        tinygltf::Light light;
+        light.name = "Neon" + std::to_string(i);
+        light.type = "point";
+        light.color = {color[0], color[1], color[2]};
+        light.intensity = 500.0 + 2500.0 * unit(rng);
+        light.range = 20.0 + 40.0 * unit(rng);
+
+        tinygltf::Node node;
+        node.name = light.name;
+        node.translation = streetPosition(4.0f + 26.0f * unit(rng));
+        appendLightNode(light, node, unit(rng) < desc.shadowCasterFraction);
+    }
+
+    // Street lamps pointing straight down
+    const auto downRotation = yawPitchRotation(0.0f, -0.5f * PI);
+    for (std::size_t i = 0; i < desc.spotLightCount; i++) {
+        tinygltf::Light light;
+        light.name = "StreetLamp" + std::to_string(i);
+        light.type = "spot";
+        light.color = {1.0, 0.85, 0.6};
+        light.intensity = 1000.0 + 3000.0 * unit(rng);
+        light.range = 40.0;
+        light.spot.innerConeAngle = 0.3;
+        light.spot.outerConeAngle = 0.6;
+
+        tinygltf::Node node;
+        node.name = light.name;
+        node.translation = streetPosition(8.0f + 4.0f * unit(rng));
+        node.rotation.assign(downRotation.begin(), downRotation.end());
+        appendLightNode(light, node, unit(rng) < desc.shadowCasterFraction);
+    }
+
+    if (!model.lights.empty()) {
+        model.extensionsUsed.emplace_back("KHR_lights_punctual");
+    }
+}
+
+// Keyframed loop around one block along the street centrelines, flying at a fixed altitude
+void appendVehicles(tinygltf::Model& model, tinygltf::Scene& scene, tinygltf::Animation& animation, const CityDesc& desc,
+                    const CityLayout& layout, const int vehicleMesh, std::mt19937& rng) {
+    if (desc.vehicleCount == 0) {
+        return;
+    }
+
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    std::uniform_int_distribution<std::size_t> block(0, layout.blockCount() - 1);
+
+    const std::size_t keyframes = std::max<std::size_t>(desc.vehicleKeyframes, 5);
+    std::vector<float> times(keyframes);
+    for (std::size_t k = 0; k < keyframes; k++) {
+        times[k] = desc.duration * static_cast<float>(k) / static_cast<float>(keyframes - 1);
+    }
+    const int timeAccessor = appendFloatAccessor(model, times, 1, 0);
+    model.accessors[timeAccessor].minValues = {times.front()};
+    model.accessors[timeAccessor].maxValues = {times.back()};
+
+    for (std::size_t v = 0; v < desc.vehicleCount; v++) {
+        const std::size_t bx = block(rng);
+        const std::size_t bz = block(rng);
+        const float x0 = layout.streetBefore(bx);
+        const float x1 = layout.streetBefore(bx + 1);
+        const float z0 = layout.streetBefore(bz);
+        const float z1 = layout.streetBefore(bz + 1);
+        const float altitude = 20.0f + 40.0f * unit(rng);
+        const float phase = unit(rng);
+        const bool clockwise = unit(rng) < 0.5f;
+
+        // Rectangle corners in driving order, perimeter parametrised by distance
+        std::array<std::array<float, 2>, 4> corners = {{{x0, z0}, {x1, z0}, {x1, z1}, {x0, z1}}};
+        if (clockwise) {
+            std::reverse(corners.begin(), corners.end());
+        }
+        const float sideX = x1 - x0;
+        const float sideZ = z1 - z0;
+        const float perimeter = 2.0f * (sideX + sideZ);
+
+        std::vector<float> translations;
+        std::vector<float> rotations;
+        translations.reserve(keyframes * 3);
+        rotations.reserve(keyframes * 4);
+
+        for (std::size_t k = 0; k < keyframes; k++) {
+            float distance = std::fmod(phase + static_cast<float>(k) / static_cast<float>(keyframes - 1), 1.0f) * perimeter;
+
+            std::size_t side = 0;
+            for (; side < 3; side++) {
+                const auto& a = corners[side];
+                const auto& b = corners[side + 1];
+                const float length = std::abs(b[0] - a[0]) + std::abs(b[1] - a[1]);
+                if (distance <= length) {
+                    break;
+                }
+                distance -= length;
+            }
+
+            const auto& a = corners[side];
+            const auto& b = corners[(side + 1) % 4];
+            const float length = std::max(std::abs(b[0] - a[0]) + std::abs(b[1] - a[1]), 1.0e-3f);
+            const float t = std::clamp(distance / length, 0.0f, 1.0f);
+
+            translations.push_back(a[0] + (b[0] - a[0]) * t);
+            translations.push_back(altitude);
+            translations.push_back(a[1] + (b[1] - a[1]) * t);
+
+            const auto rotation = yawPitchRotation(headingYaw(b[0] - a[0], b[1] - a[1]), 0.0f);
+            rotations.insert(rotations.end(), rotation.begin(), rotation.end());
+        }
+
+        tinygltf::Node node;
+        node.name = "Vehicle" + std::to_string(v);
+        node.mesh = vehicleMesh;
+        node.translation = {translations[0], translations[1], translations[2]};
+        setExtrasFlag(node.extras, "animated", true);
+        setExtrasFlag(node.extras, "castsShadows", true);
+
+        const int nodeIdx = static_cast<int>(model.nodes.size());
+        scene.nodes.push_back(nodeIdx);
+        model.nodes.push_back(std::move(node));
+
+        const int outputs[2] = {appendFloatAccessor(model, translations, 3, 0), appendFloatAccessor(model, rotations, 4, 0)};
+        const char* paths[2] = {"translation", "rotation"};
+        for (int channelIdx = 0; channelIdx < 2; channelIdx++) {
+            tinygltf::AnimationSampler sampler;
+            sampler.input = timeAccessor;
+            sampler.output = outputs[channelIdx];
+            sampler.interpolation = "LINEAR";
+            animation.samplers.push_back(sampler);
+
+            tinygltf::AnimationChannel channel;
+            channel.sampler = static_cast<int>(animation.samplers.size() - 1);
+            channel.target_node = nodeIdx;
+            channel.target_path = paths[channelIdx];
+            animation.channels.push_back(channel);
+        }
+    }
+}
+
+// Orbit around the city centre, looking slightly down at it (the benchmark camera path)
+void appendCamera(tinygltf::Model& model, tinygltf::Scene& scene, tinygltf::Animation& animation, const CityDesc& desc,
+                  const CityLayout& layout) {
+    const float radius = 0.6f * layout.extent + 60.0f;
+    const float height = 0.2f * layout.extent + 40.0f;
+    const float pitch = -0.8f * std::atan2(height, radius);
+
+    tinygltf::Camera camera;
+    camera.name = "OrbitCamera";
+    camera.type = "perspective";
+    camera.perspective.yfov = 0.9;
+    camera.perspective.aspectRatio = 16.0 / 9.0;
+    camera.perspective.znear = 0.1;
+    camera.perspective.zfar = std::max(1000.0f, 3.0f * layout.extent);
+    model.cameras.push_back(camera);
+
+    std::vector<float> times;
+    std::vector<float> translations;
+    std::vector<float> rotations;
+    for (std::size_t k = 0; k < CAMERA_KEYFRAMES; k++) {
+        const float u = static_cast<float>(k) / static_cast<float>(CAMERA_KEYFRAMES - 1);
+        const float angle = 2.0f * PI * u;
+        const float x = radius * std::cos(angle);
+        const float z = radius * std::sin(angle);
+
+        times.push_back(desc.duration * u);
+        translations.insert(translations.end(), {x, height, z});
+
+        const auto rotation = yawPitchRotation(headingYaw(-x, -z), pitch);
+        rotations.insert(rotations.end(), rotation.begin(), rotation.end());
+    }
+
+    tinygltf::Node node;
+    node.name = "Camera";
+    node.camera = 0;
+    node.translation = {translations[0], translations[1], translations[2]};
+    node.rotation = {rotations[0], rotations[1], rotations[2], rotations[3]};
+    const int nodeIdx = static_cast<int>(model.nodes.size());
+    scene.nodes.push_back(nodeIdx);
+    model.nodes.push_back(std::move(node));
+
+    const int timeAccessor = appendFloatAccessor(model, times, 1, 0);
+    model.accessors[timeAccessor].minValues = {times.front()};
+    model.accessors[timeAccessor].maxValues = {times.back()};
+
+    const int outputs[2] = {appendFloatAccessor(model, translations, 3, 0), appendFloatAccessor(model, rotations, 4, 0)};
+    const char* paths[2] = {"translation", "rotation"};
+    for (int channelIdx = 0; channelIdx < 2; channelIdx++) {
+        tinygltf::AnimationSampler sampler;
+        sampler.input = timeAccessor;
+        sampler.output = outputs[channelIdx];
+        sampler.interpolation = "LINEAR";
+        animation.samplers.push_back(sampler);
+
+        tinygltf::AnimationChannel channel;
+        channel.sampler = static_cast<int>(animation.samplers.size() - 1);
+        channel.target_node = nodeIdx;
+        channel.target_path = paths[channelIdx];
+        animation.channels.push_back(channel);
+    }
+}
+} // namespace
+
+auto expectedCityCounts(const CityDesc& desc) -> CityCounts {
+    const std::size_t uniqueBuildings = desc.buildingCount == 0 ? 0 : std::clamp<std::size_t>(desc.uniqueBuildingCount, 1, desc.buildingCount);
+    return {
+        .instances = desc.buildingCount + desc.vehicleCount + 1,
+        .animatedInstances = desc.vehicleCount,
+        .meshes = uniqueBuildings + 2,
+        .materials = std::max<std::size_t>(desc.materialCount, 1) + 2,
+        .pointLights = desc.pointLightCount,
+        .spotLights = desc.spotLightCount,
+    };
+}
+
+auto buildCityModel(const CityDesc& desc) -> tinygltf::Model {
+    tinygltf::Model model;
+    model.asset.version = "2.0";
+    model.asset.generator = "CityGenerator";
+
+    std::mt19937 rng(desc.seed);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    const CityLayout layout = makeLayout(desc.buildingCount);
+
+    std::vector<int> textures;
+    for (std::size_t i = 0; i < desc.textureCount; i++) {
+        const auto pixels = makeFacadeTexture(desc.textureSize, i, rng);
+        textures.push_back(appendPngTexture(model, pixels, static_cast<int>(desc.textureSize),
+                                            static_cast<int>(desc.textureSize), "Facade" + std::to_string(i)));
+    }
+
+    appendMaterials(model, desc, textures, rng);
+    const int facadeMaterials = static_cast<int>(std::max<std::size_t>(desc.materialCount, 1));
+    const int groundMaterial = facadeMaterials;
+    const int vehicleMaterial = facadeMaterials + 1;
+
+    const CityCounts counts = expectedCityCounts(desc);
+    const std::size_t uniqueBuildings = counts.meshes - 2;
+    std::vector<int> buildingMeshes;
+    for (std::size_t i = 0; i < uniqueBuildings; i++) {
+        buildingMeshes.push_back(appendMesh(model, appendBoxGeometry(model, buildingBoxes(rng), FACADE_TILE_SIZE),
+                                            static_cast<int>(i % static_cast<std::size_t>(facadeMaterials)),
+                                            "Building" + std::to_string(i)));
+    }
+
+    const float groundHalf = 0.5f * layout.extent + 100.0f;
+    const int groundMesh = appendMesh(
+        model, appendBoxGeometry(model, {{.min = {-groundHalf, -1.0f, -groundHalf}, .max = {groundHalf, 0.0f, groundHalf}}}, 8.0f),
+        groundMaterial, "Ground");
+    const int vehicleMesh = appendMesh(
+        model, appendBoxGeometry(model, {{.min = {-1.0f, -0.6f, -2.25f}, .max = {1.0f, 0.6f, 2.25f}}}), vehicleMaterial,
+        "Vehicle");
+
+    tinygltf::Scene scene;
+    scene.name = "City";
+    model.nodes.reserve(desc.buildingCount + desc.vehicleCount + desc.pointLightCount + desc.spotLightCount + 3);
+
+    tinygltf::Node ground;
+    ground.name = "Ground";
+    ground.mesh = groundMesh;
+    scene.nodes.push_back(static_cast<int>(model.nodes.size()));
+    model.nodes.push_back(ground);
+
+    std::uniform_int_distribution<std::size_t> meshPick(0, std::max<std::size_t>(uniqueBuildings, 1) - 1);
+    std::uniform_int_distribution<int> quarterTurns(0, 3);
+    for (std::size_t i = 0; i < desc.buildingCount; i++) {
+        const std::size_t lx = i % layout.lotsPerSide;
+        const std::size_t lz = i / layout.lotsPerSide;
+        const float yaw = 0.5f * PI * static_cast<float>(quarterTurns(rng));
+
+        tinygltf::Node node;
+        node.mesh = buildingMeshes[meshPick(rng)];
+        node.translation = {layout.lotCenter(lx), 0.0, layout.lotCenter(lz)};
+        node.rotation = {0.0, std::sin(0.5 * yaw), 0.0, std::cos(0.5 * yaw)};
+        setExtrasFlag(node.extras, "castsShadows", true);
+        scene.nodes.push_back(static_cast<int>(model.nodes.size()));
+        model.nodes.push_back(std::move(node));
+    }
+
+    tinygltf::Animation animation;
+    animation.name = "City";
+    appendVehicles(model, scene, animation, desc, layout, vehicleMesh, rng);
+    appendCamera(model, scene, animation, desc, layout);
+    model.animations.push_back(animation);
+
+    appendLights(model, scene, desc, layout, rng);
+
+    model.scenes.push_back(scene);
+    model.defaultScene = 0;
+    return model;
+}
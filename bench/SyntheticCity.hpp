@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <tiny_gltf.h>
+
+// Procedural city for scale testing: textured buildings on a street grid, street lights, flying vehicles
+// on keyframed loops around the blocks and a camera orbiting the city. The model only uses what
+// GLTFLoader reads (KHR_lights_punctual, castsShadows/animated/reflective extras), so it loads unchanged.
+struct CityDesc {
+    std::size_t buildingCount = 2000;
+    std::size_t uniqueBuildingCount = 100;  // Distinct building meshes, instanced across all buildings
+    std::size_t materialCount = 16;         // Facade materials (plus one for the ground and one for vehicles)
+    std::size_t textureCount = 8;           // Facade textures, shared round-robin by the materials (0 = untextured)
+    std::uint32_t textureSize = 256;        // Edge length of the generated textures (pixels)
+    std::size_t pointLightCount = 64;
+    std::size_t spotLightCount = 32;
+    float shadowCasterFraction = 0.1f;      // Share of the point/spot lights tagged castsShadows
+    std::size_t vehicleCount = 50;
+    std::size_t vehicleKeyframes = 120;     // Keys of every vehicle path
+    float duration = 30.0f;                 // Loop length of the vehicle and camera animation (seconds)
+    std::uint32_t seed = 2077;
+};
+
+// Meshes, materials and instances the loader should end up with for a description
+struct CityCounts {
+    std::size_t instances;
+    std::size_t animatedInstances;
+    std::size_t meshes;
+    std::size_t materials;
+    std::size_t pointLights;
+    std::size_t spotLights;
+};
+
+auto expectedCityCounts(const CityDesc& desc) -> CityCounts;
+
+auto buildCityModel(const CityDesc& desc) -> tinygltf::Model;
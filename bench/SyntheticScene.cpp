@@ -0,0 +1,166 @@
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+#include "GltfBuilder.hpp"
+#include "SyntheticScene.hpp"
+
+namespace {
+// Unit cube shared by an opaque and a blended mesh: same geometry, different material
+void appendCubeMeshes(tinygltf::Model& model) {
+    const PrimitiveAccessors cube = appendBoxGeometry(model, {{.min = {-0.5f, -0.5f, -0.5f}, .max = {0.5f, 0.5f, 0.5f}}});
+    appendMesh(model, cube, 0, "Block");
+    appendMesh(model, cube, 1, "GlassBlock");
+
+    tinygltf::Material opaque;
+    opaque.name = "Concrete";
+    opaque.pbrMetallicRoughness.baseColorFactor = {0.4, 0.4, 0.45, 1.0};
+    model.materials.push_back(opaque);
+
+    tinygltf::Material glass;
+    glass.name = "Glass";
+    glass.alphaMode = "BLEND";
+    glass.pbrMetallicRoughness.baseColorFactor = {0.2, 0.6, 0.9, 0.4};
+    model.materials.push_back(glass);
+}
+
+// One shared translation (vertical bob) and rotation (spin around Y) curve with keyframeCount keys
+void appendAnimationSamplers(tinygltf::Model& model, tinygltf::Animation& animation, const std::size_t keyframeCount) {
+    std::vector<float> times(keyframeCount);
+    std::vector<float> translations(keyframeCount * 3);
+    std::vector<float> rotations(keyframeCount * 4);
+
+    for (std::size_t i = 0; i < keyframeCount; i++) {
+        times[i] = static_cast<float>(i) * SYNTHETIC_KEYFRAME_INTERVAL;
+
+        translations[i * 3 + 0] = 0.0f;
+        translations[i * 3 + 1] = 2.0f * std::sin(times[i]);
+        translations[i * 3 + 2] = 0.0f;
+
+        const float halfAngle = 0.5f * times[i];
+        rotations[i * 4 + 0] = 0.0f;
+        rotations[i * 4 + 1] = std::sin(halfAngle);
+        rotations[i * 4 + 2] = 0.0f;
+        rotations[i * 4 + 3] = std::cos(halfAngle);
+    }
+
+    const int timeAccessor = appendFloatAccessor(model, times, 1, 0);
+    model.accessors[timeAccessor].minValues = {times.front()};
+    model.accessors[timeAccessor].maxValues = {times.back()};
+    const int translationAccessor = appendFloatAccessor(model, translations, 3, 0);
+    const int rotationAccessor = appendFloatAccessor(model, rotations, 4, 0);
+
+    tinygltf::AnimationSampler translationSampler;
+    translationSampler.input = timeAccessor;
+    translationSampler.output = translationAccessor;
+    translationSampler.interpolation = "LINEAR";
+    animation.samplers.push_back(translationSampler);
+
+    tinygltf::AnimationSampler rotationSampler;
+    rotationSampler.input = timeAccessor;
+    rotationSampler.output = rotationAccessor;
+    rotationSampler.interpolation = "LINEAR";
+    animation.samplers.push_back(rotationSampler);
+}
+} // namespace
+
+auto buildSyntheticModel(const SyntheticSceneDesc& desc) -> tinygltf::Model {
+    tinygltf::Model model;
+    model.asset.version = "2.0";
+    model.asset.generator = "CpuBenchmarks synthetic scene";
+
+    appendCubeMeshes(model);
+
+    tinygltf::Animation animation;
+    animation.name = "Traffic";
+    const std::size_t keyframeCount = std::max<std::size_t>(desc.keyframeCount, 2);
+    appendAnimationSamplers(model, animation, keyframeCount);
+
+    tinygltf::Scene scene;
+    std::mt19937 rng(desc.seed);
+    std::uniform_real_distribution<float> height(1.0f, 8.0f);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+    const auto gridSize = static_cast<std::size_t>(std::ceil(std::sqrt(static_cast<double>(desc.instanceCount))));
+    const std::size_t animatedStride = desc.animatedFraction > 0.0f
+                                           ? std::max<std::size_t>(1, static_cast<std::size_t>(std::lround(1.0f / desc.animatedFraction)))
+                                           : 0;
+
+    // Pivot nodes add one node per animated instance
+    model.nodes.reserve(desc.instanceCount + desc.instanceCount / std::max<std::size_t>(animatedStride, 1) + 2);
+
+    for (std::size_t i = 0; i < desc.instanceCount; i++) {
+        const double x = static_cast<double>(i % gridSize) * desc.spacing;
+        const double z = static_cast<double>(i / gridSize) * desc.spacing;
+        const double blockHeight = height(rng);
+
+        tinygltf::Node block;
+        block.mesh = unit(rng) < desc.transparentFraction ? 1 : 0;
+        block.scale = {0.6 * desc.spacing, blockHeight, 0.6 * desc.spacing};
+
+        const bool animated = animatedStride != 0 && i % animatedStride == 0;
+        if (!animated) {
+            block.translation = {x, 0.5 * blockHeight, z};
+            scene.nodes.push_back(static_cast<int>(model.nodes.size()));
+            model.nodes.push_back(block);
+            continue;
+        }
+
+        setExtrasFlag(block.extras, "animated", true);
+        block.scale = {0.3 * desc.spacing, 1.0, 0.3 * desc.spacing};
+
+        tinygltf::Node pivot;
+        pivot.translation = {x, 0.5 * blockHeight, z};
+
+        const int pivotIdx = static_cast<int>(model.nodes.size());
+        const int blockIdx = pivotIdx + 1;
+        pivot.children.push_back(blockIdx);
+        scene.nodes.push_back(pivotIdx);
+        model.nodes.push_back(pivot);
+        model.nodes.push_back(block);
+
+        for (int sampler = 0; sampler < 2; sampler++) {
+            tinygltf::AnimationChannel channel;
+            channel.sampler = sampler;
+            channel.target_node = blockIdx;
+            channel.target_path = sampler == 0 ? "translation" : "rotation";
+            animation.channels.push_back(channel);
+        }
+    }
+
+    if (!animation.channels.empty()) {
+        model.animations.push_back(animation);
+    }
+
+    // Camera at one corner, looking diagonally across the grid and slightly down
+    const double extent = static_cast<double>(gridSize) * desc.spacing;
+
+    tinygltf::Camera camera;
+    camera.type = "perspective";
+    camera.perspective.yfov = 1.0;
+    camera.perspective.aspectRatio = 16.0 / 9.0;
+    camera.perspective.znear = 0.1;
+    camera.perspective.zfar = std::max(1000.0, 2.0 * extent);
+    model.cameras.push_back(camera);
+
+    // yaw -135 degrees (towards +x/+z), then pitch -20 degrees
+    const double yaw = -0.75 * 3.14159265358979;
+    const double pitch = -0.35;
+    tinygltf::Node cameraNode;
+    cameraNode.name = "Camera";
+    cameraNode.camera = 0;
+    cameraNode.translation = {-0.1 * extent, 0.15 * extent + 20.0, -0.1 * extent};
+    cameraNode.rotation = {
+        std::cos(0.5 * yaw) * std::sin(0.5 * pitch),
+        std::sin(0.5 * yaw) * std::cos(0.5 * pitch),
+        -std::sin(0.5 * yaw) * std::sin(0.5 * pitch),
+        std::cos(0.5 * yaw) * std::cos(0.5 * pitch),
+    };
+    scene.nodes.push_back(static_cast<int>(model.nodes.size()));
+    model.nodes.push_back(cameraNode);
+
+    model.scenes.push_back(scene);
+    model.defaultScene = 0;
+
+    return model;
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <tiny_gltf.h>
+
+// Generated glTF city blocks for the CPU benchmarks: a grid of box instances, a fraction of them animated,
+// plus one camera above the grid looking across it. Animated boxes hang below a static pivot node at their
+// grid cell and all share one translation and one rotation curve, so the keyframe count scales
+// independently of the instance count.
+struct SyntheticSceneDesc {
+    std::size_t instanceCount = 1000;
+    float animatedFraction = 0.1f;      // Share of instances tagged `animated` and driven by the animation
+    std::size_t keyframeCount = 64;     // Keys of the translation and rotation curves (shared by every channel)
+    float transparentFraction = 0.05f;  // Share of instances using the blended material
+    float spacing = 10.0f;              // Distance between neighbouring grid cells
+    std::uint32_t seed = 25;            // Building heights are randomised, same seed = same scene
+};
+
+// Time between two keyframes of the synthetic animation (seconds)
+constexpr float SYNTHETIC_KEYFRAME_INTERVAL = 1.0f / 30.0f;
+
+// Builds the model in memory (embedded buffer, no images). Feed it to GLTFLoader::loadModel, or write it
+// out with writeGlb (GltfBuilder.hpp) to include parsing.
+auto buildSyntheticModel(const SyntheticSceneDesc& desc) -> tinygltf::Model;
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <cstdint>
+
+// Counts the global operator new calls made by the calling thread, used to check that steady-state frames
+// do not touch the heap (benchmark mode). The replacement operators live in AllocationCounter.cpp.
+//
+// The demo only has it with -DENABLE_ALLOCATION_COUNTER=ON (benchmark configurations), otherwise the default
+// operators stay in place and the count stays 0. CpuBenchmarks is always built with it (--check-allocations).
+
+#ifndef ALLOCATION_COUNTER_ENABLED
+#define ALLOCATION_COUNTER_ENABLED 0
+#endif
+
+class AllocationCounter {
+public:
+    // Heap allocations of the calling thread since it started
+    static auto threadAllocations() -> std::uint64_t;
+
+    static constexpr bool enabled() { return ALLOCATION_COUNTER_ENABLED != 0; }
+};
@@ -1,10 +1,20 @@
 #pragma once
 
+#include <memory_resource>
 #include <tiny_gltf.h>
 
 #include "Scene.hpp"
 
 class Animator {
 public:
-    void animate(const tinygltf::Model& model, Scene& scene, float time);
+    // Temporaries are allocated from frameMemory (the per-frame arena), which must outlive the call
+    void animate(const tinygltf::Model& model, Scene& scene, float time, std::pmr::memory_resource& frameMemory);
+
+    // Longest animation of the model, animate() wraps time to it (0 = nothing animated)
+    static auto loopDuration(const tinygltf::Model& model) -> float;
+
+    // The camera animate() would produce at time, without touching a scene (to look ahead along the path).
+    // Temporaries come from memory. Returns false when the model has no camera node.
+    static auto sampleCamera(const tinygltf::Model& model, float time, std::pmr::memory_resource& memory,
+                             CameraParameters& camera) -> bool;
 };
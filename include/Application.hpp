@@ -1,5 +1,6 @@
 #pragma once
 
+#include <future>
 #include <memory>
 #include <stdexcept>
 #include <GLFW/glfw3.h>
@@ -13,21 +14,37 @@ struct ma_engine;
 struct ma_sound;
 
 #include "constants.hpp"
+#include "CommandLine.hpp"
 #include "VulkanCore.hpp"
 #include "ResourceManager.hpp"
 #include "CommandManager.hpp"
 #include "GLTFLoader.hpp"
 #include "FreeCamera.hpp"
+#include "JobSystem.hpp"
+#include "StartupTimeline.hpp"
 
 class Application {
 public:
-    explicit Application();
+    explicit Application(const LaunchOptions& options);
 
     ~Application();
 
     void run();
 private:
-    GLFWwindow* m_window;
+    LaunchOptions m_options;
+
+    // Export chunks that start mid-sequence render a few unwritten frames first (TAA_EXPORT_PREROLL_FRAMES)
+    std::uint32_t m_exportPrerollFrames = 0;
+
+    // Startup: the scene (parse + texture decode) and the music load on workers while the
+    // device resources and pipelines are created on the main thread
+    StartupTimeline m_startup;
+    std::future<std::unique_ptr<LoadedGLTF>> m_sceneLoad;
+    std::future<bool> m_musicLoad;
+    StartupTimeline::PhaseId m_sceneLoadPhase = 0;
+    StartupTimeline::PhaseId m_musicLoadPhase = 0;
+
+    GLFWwindow* m_window = nullptr;
     std::unique_ptr<VulkanCore> m_vulkanCore = nullptr;
     
     ma_engine* m_audioEngine;
@@ -37,8 +54,21 @@ private:
     FreeCamera m_freeCamera;
     bool m_useFreeCam = false;
     bool m_fKeyPressed = false;
+    bool m_pickPressed = false;
+
+    // Declared last so it is destroyed (and its workers joined) before anything the jobs use
+    std::unique_ptr<JobSystem> m_jobSystem;
 
     void createWindow();
 
     void initVulkanCore();
+
+    void initAudio();
+
+    void startSceneLoad(StartupTimeline::PhaseId vulkanCorePhase);
+
+    void startMusicLoad(StartupTimeline::PhaseId audioEnginePhase);
+
+    // True once the window was closed, the frame budget is spent or (headless) SIGINT arrived
+    [[nodiscard]] bool shouldExit(std::uint32_t renderedFrames) const;
 };
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Summary statistics of one metric over all recorded (non-warmup) frames, in the metric's unit
+// (milliseconds for timings, plain numbers for counters and ratios)
+struct BenchmarkStatistics {
+    std::size_t samples = 0;
+    double min = 0.0;
+    double max = 0.0;
+    double mean = 0.0;
+    double p50 = 0.0;
+    double p95 = 0.0;
+    double p99 = 0.0;
+};
+
+// Run description written into the report header
+struct BenchmarkInfo {
+    std::string deviceName;
+    std::string scenePath;
+    std::uint32_t width = 0;
+    std::uint32_t height = 0;
+    bool headless = false;
+    double fixedTimeStep = 0.0;
+    std::uint32_t warmupFrames = 0;
+    double wallClockSeconds = 0.0;
+};
+
+// Collects named per-frame timings (CPU stages, GPU passes, ...) and counters (pipeline statistics,
+// overdraw) during a benchmark run.
+// Storage for every metric is reserved up front for the expected frame count so that
+// recording during the run does not allocate.
+class BenchmarkRecorder {
+public:
+    explicit BenchmarkRecorder(std::uint32_t expectedFrames);
+
+    // Returns the index of the metric, registering it on first use.
+    // Register all metrics before the first frame to keep recording allocation free.
+    auto metric(std::string_view name) -> std::size_t;
+
+    void record(std::size_t metricIndex, double valueMs);
+
+    // For results that arrive late (e.g. GPU timestamps read back frames later)
+    void recordAt(std::size_t metricIndex, std::uint32_t frame, double valueMs);
+
+    // Advances to the next frame; unrecorded metrics of the finished frame stay empty
+    void endFrame();
+
+    void setWarmupFrames(std::uint32_t warmupFrames) { m_warmupFrames = warmupFrames; }
+
+    [[nodiscard]] auto frameCount() const -> std::uint32_t { return m_currentFrame; }
+
+    [[nodiscard]] auto statistics(std::size_t metricIndex) const -> BenchmarkStatistics;
+
+    // <basePath>.json holds the run info and per-metric statistics,
+    // <basePath>.csv holds one row per frame with one column per metric
+    void writeReport(const std::string& basePath, const BenchmarkInfo& info) const;
+
+    void printSummary() const;
+
+private:
+    struct Metric {
+        std::string name;
+        std::vector<double> values;  // one entry per frame, NaN when not recorded
+    };
+
+    std::uint32_t m_expectedFrames;
+    std::uint32_t m_warmupFrames = 0;
+    std::uint32_t m_currentFrame = 0;
+    std::vector<Metric> m_metrics;
+
+    void writeJson(const std::string& path, const BenchmarkInfo& info) const;
+    void writeCsv(const std::string& path) const;
+};
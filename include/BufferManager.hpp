@@ -3,6 +3,8 @@
 #include <vulkan/vulkan.hpp>
 #include <vulkan/vulkan_raii.hpp>
 
+#include "MemoryTracker.hpp"
+
 class VulkanCore;
 class CommandManager;
 
@@ -11,6 +13,7 @@ public:
     explicit BufferManager(VulkanCore& vulkanCore, CommandManager& commandManager);
 
     void createBuffer(
+        MemoryCategory category,
         vk::DeviceSize size,
         vk::BufferUsageFlags usage,
         vk::MemoryPropertyFlags properties,
@@ -20,6 +23,7 @@ public:
         );
 
     void createBuffer(
+        MemoryCategory category,
         vk::DeviceSize size,
         vk::BufferUsageFlags usage,
         vk::MemoryPropertyFlags properties,
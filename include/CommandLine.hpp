@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+// Debug views replace the tonemapped image with a heatmap of per-pixel counters written by the scene
+// passes. The counting lives in specialized pipelines, so a run without a debug view pays nothing for it.
+enum class DebugView : std::uint8_t {
+    None,
+    Overdraw,       // Fragment shader invocations
+    RayCount,       // Shadow and reflection rays traced
+    RayCandidates,  // Ray query Proceed() trips (non-opaque candidates tested in the shader)
+};
+
+// Options parsed from argv in main() and handed to the Application
+struct LaunchOptions {
+    std::string scenePath = "assets/scene_full.glb";
+
+    // Headless: no GLFW window, surface, swapchain or present. Frames are rendered into
+    // an offscreen image ring with the same pass sequence as the windowed path.
+    bool headless = false;
+
+    // Number of frames to render before exiting (0 = run until the window is closed).
+    // Headless runs have no window to close, so they fall back to HEADLESS_DEFAULT_FRAME_COUNT.
+    std::uint32_t frameCount = 0;
+
+    // Benchmark: replay the glTF camera path at a fixed time step for an exact number of frames
+    // (frameCount, default BENCHMARK_DEFAULT_FRAME_COUNT) without audio or frame pacing,
+    // then write <benchmarkOutput>.json/.csv. Works windowed and headless.
+    bool benchmark = false;
+    double fixedTimeStep = 1.0 / 60.0;
+    std::uint32_t warmupFrames = 0;
+    std::string benchmarkOutput = "benchmark";
+
+    // Chrome Trace / Perfetto JSON of the CPU profiling zones, written on exit (empty = off)
+    std::string tracePath;
+
+    // Hitch detector: frames slower than hitchThreshold x the running median are logged, and the frames
+    // around them written as Chrome trace JSON into hitchDirectory (0 = off)
+    double hitchThreshold = 0.0;
+    std::string hitchDirectory = "hitches";
+
+    // Offline export: fixed-step headless frames read back without stalls and encoded on workers, as PNGs into
+    // a directory or as one .y4m file (empty = off). The scene renders at exportSupersample times the output
+    // size (0 = window size) and is box-filtered down.
+    std::string exportPath;
+    std::uint32_t exportWidth = 0;
+    std::uint32_t exportHeight = 0;
+    std::uint32_t exportSupersample = 1;
+
+    // Exports start at animation frame exportFirstFrame, and files are numbered from it. With exportWorkers > 0
+    // this process only coordinates: the range is rendered in chunks of exportChunkFrames (0 = automatic) by that
+    // many headless worker processes of the same executable, writing into the shared PNG directory.
+    std::uint32_t exportFirstFrame = 0;
+    std::uint32_t exportWorkers = 0;
+    std::uint32_t exportChunkFrames = 0;
+
+    // Potentially visible sets along the cinematic camera path: bakePvsPath bakes them (headless) and exits,
+    // pvsPath culls the static instances from a baked file (empty = off)
+    std::string bakePvsPath;
+    std::string pvsPath;
+
+    // Irradiance probe volume over the static city: bakeProbesPath bakes it on the CPU (headless) and exits,
+    // probesPath lights indirect diffuse from a baked file (empty = sky texture only)
+    std::string bakeProbesPath;
+    std::string probesPath;
+
+    // Material texture mips are streamed in ahead of the cinematic camera instead of uploaded at load
+    bool streamTextures = false;
+
+    // Name of the shared memory segment the latest frame's metrics are published to (empty = off)
+    std::string liveMetricsName;
+
+    // MemoryTracker JSON (per-category current/peak bytes and heap budgets), written on exit (empty = off)
+    std::string memoryReportPath;
+
+    // At most one debug view per run. Both ray views also report per-frame ray totals to the benchmark.
+    DebugView debugView = DebugView::None;
+
+    // Ignore the on-disk pipeline cache (cold start); the cache is still rewritten afterwards
+    bool resetPipelineCache = false;
+
+    bool showHelp = false;
+};
+
+auto parseCommandLine(int argc, char** argv) -> LaunchOptions;
+
+void printUsage(const char* executableName);
@@ -1,6 +1,5 @@
 #pragma once
 
-#include <functional>
 #include <vulkan/vulkan_raii.hpp>
 
 class VulkanCore;
@@ -15,7 +14,14 @@ public:
     CommandManager(CommandManager&&) = delete;
     auto operator=(CommandManager&&) -> CommandManager&& = delete;
 
-    void immediateSubmit(std::function<void(vk::CommandBuffer)>&& function) const;
+    // Records function(cmd) into a one-time command buffer and waits until the GPU executed it.
+    // A template rather than std::function so capturing lambdas are never copied to the heap.
+    template <typename Function>
+    void immediateSubmit(Function&& function) const {
+        const vk::CommandBuffer cmd = beginImmediate();
+        function(cmd);
+        endImmediate(cmd);
+    }
 
     auto getCommandBuffer(const std::uint32_t index) const -> const vk::raii::CommandBuffer& {
         return m_commandBuffers[index];
@@ -25,8 +31,14 @@ private:
     void createCommandPool();
     void createCommandBuffers();
 
+    [[nodiscard]] auto beginImmediate() const -> vk::CommandBuffer;
+    void endImmediate(vk::CommandBuffer cmd) const;
+
     VulkanCore& m_vulkanCore;
 
     vk::raii::CommandPool m_commandPool = nullptr;
     std::vector<vk::raii::CommandBuffer> m_commandBuffers;
+
+    // Reused by every immediateSubmit(), the queue wait guarantees it is idle again afterwards
+    vk::raii::CommandBuffer m_immediateCommandBuffer = nullptr;
 };
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+// Scoped CPU instrumentation zones.
+//
+//   void Foo::bar() {
+//       PROFILE_ZONE("Foo::bar");
+//       ...
+//   }
+//
+// Each thread writes fixed-size events into its own statically allocated ring buffer
+// (no locks, no allocations). CpuProfiler::writeChromeTrace() dumps everything as
+// Chrome Trace / Perfetto JSON (open in chrome://tracing or ui.perfetto.dev).
+//
+// Configure with -DENABLE_CPU_PROFILER=OFF to compile every zone out entirely.
+// Zone names must be string literals (only the pointer is stored).
+
+#ifndef CPU_PROFILER_ENABLED
+#define CPU_PROFILER_ENABLED 0
+#endif
+
+constexpr std::size_t CPU_PROFILER_MAX_THREADS = 16;            // Threads beyond this are not recorded
+constexpr std::size_t CPU_PROFILER_EVENTS_PER_THREAD = 1 << 14;  // Ring capacity, oldest events are overwritten
+
+// Snapshot entry used by the exporters
+struct CpuTraceEvent {
+    const char* name;
+    std::uint64_t startNs;
+    std::uint64_t endNs;
+    std::uint32_t threadIndex;
+};
+
+class CpuProfiler {
+public:
+    // Nanoseconds since the first profiler call in this process
+    static auto now() -> std::uint64_t {
+        static const auto epoch = std::chrono::steady_clock::now();
+        return static_cast<std::uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count());
+    }
+
+    static void record(const char* name, std::uint64_t startNs, std::uint64_t endNs);
+
+    // Name shown for the calling thread in the trace viewer (string literal)
+    static void setThreadName(const char* name);
+
+    // Copies every event still held in the rings that ended at or after sinceNs.
+    // Safe to call while other threads keep recording; entries overwritten mid-copy are dropped.
+    static auto snapshot(std::uint64_t sinceNs = 0) -> std::vector<CpuTraceEvent>;
+
+    static void writeChromeTrace(const std::string& path, std::uint64_t sinceNs = 0);
+
+    // Writes the thread names and zones as comma separated trace events (no enclosing array), for files
+    // that add their own events next to the zones. first is cleared once anything was written.
+    // Returns the number of zones written.
+    static auto writeChromeTraceEvents(std::ostream& out, std::uint64_t sinceNs, bool& first) -> std::size_t;
+
+    static auto threadName(std::uint32_t threadIndex) -> const char*;
+};
+
+class CpuZone {
+public:
+    explicit CpuZone(const char* name) : m_name(name), m_start(CpuProfiler::now()) {
+    }
+
+    ~CpuZone() {
+        CpuProfiler::record(m_name, m_start, CpuProfiler::now());
+    }
+
+    CpuZone(const CpuZone&) = delete;
+    auto operator=(const CpuZone&) -> CpuZone& = delete;
+
+private:
+    const char* m_name;
+    std::uint64_t m_start;
+};
+
+#define PROFILE_CONCAT_IMPL(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_IMPL(a, b)
+
+#if CPU_PROFILER_ENABLED
+#define PROFILE_ZONE(name) const CpuZone PROFILE_CONCAT(profileZone_, __LINE__)(name)
+#define PROFILE_THREAD_NAME(name) CpuProfiler::setThreadName(name)
+#else
+#define PROFILE_ZONE(name) ((void)0)
+#define PROFILE_THREAD_NAME(name) ((void)0)
+#endif
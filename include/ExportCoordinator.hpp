@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "CommandLine.hpp"
+
+// Parallel offline export (--export-workers), for render machines where one process leaves most cores idle
+// (software Vulkan). The frame range is split into chunks, each rendered by a worker process: the same
+// executable as a plain headless --export with its own --first-frame and --frames, writing into the shared
+// PNG directory. The coordinator itself creates no Vulkan device. It keeps every worker slot busy, reports
+// progress from the frames on disk, relaunches a chunk from its first missing frame when a worker fails or
+// stops early, and finally checks that the whole sequence exists.
+class ExportCoordinator {
+public:
+    ExportCoordinator(const LaunchOptions& options, std::string executable);
+
+    // Throws when frames are still missing after every retry, or when interrupted
+    void run();
+
+private:
+    struct Chunk {
+        std::uint32_t firstFrame = 0;
+        std::uint32_t frameCount = 0;
+        std::uint32_t attempts = 0;
+        bool done = false;
+    };
+
+    LaunchOptions m_options;
+    std::string m_executable;
+    std::filesystem::path m_outputDirectory;
+    std::filesystem::path m_logDirectory;
+    std::vector<Chunk> m_chunks;
+
+    // Arguments of a worker rendering frames [firstFrame, firstFrame + frameCount)
+    [[nodiscard]] auto workerArguments(std::uint32_t firstFrame, std::uint32_t frameCount) const -> std::vector<std::string>;
+
+    [[nodiscard]] auto frameExists(std::uint32_t frame) const -> bool;
+
+    // First frame of the chunk that is not on disk yet, firstFrame + frameCount when complete
+    [[nodiscard]] auto firstMissingFrame(const Chunk& chunk) const -> std::uint32_t;
+
+    [[nodiscard]] auto framesOnDisk(const Chunk& chunk) const -> std::uint32_t;
+
+    // Reports missing frames as ranges and removes the temporaries of killed workers. Returns the missing count.
+    auto verifySequence() const -> std::uint32_t;
+};
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <mutex>
+#include <optional>
+#include <vector>
+#include <vulkan/vulkan_raii.hpp>
+
+#include "constants.hpp"
+
+class VulkanCore;
+class BufferManager;
+class JobSystem;
+
+// Offline export of headless frames (--export), for videos of the cinematic path without screen recording.
+// Every frame's final image is copied into a ring of host-visible readback buffers. The copy is handed to
+// a worker once the frame slot's fence has signaled (MAX_FRAMES_IN_FLIGHT frames later), so the render
+// thread never waits for the GPU. Workers box-filter supersampled frames down to the output size and
+// encode them as PNG files (frame_000000.png, ...) or append them to a single Y4M (4:2:0) stream.
+// The render thread only waits when every readback buffer is still being encoded.
+class FrameExporter {
+public:
+    // outputPath: a .y4m file, anything else is a directory of PNGs. renderExtent is supersample times
+    // the output size in both directions. frameTime is the fixed animation step (the Y4M frame rate).
+    // PNGs are numbered from firstFrame, the sequence frame of the first recorded copy.
+    FrameExporter(VulkanCore& vulkanCore,
+                  BufferManager& bufferManager,
+                  JobSystem& jobSystem,
+                  std::filesystem::path outputPath,
+                  vk::Extent2D renderExtent,
+                  vk::Format format,
+                  std::uint32_t supersample,
+                  double frameTime,
+                  std::uint64_t firstFrame);
+
+    // Waits for the encoders still running, they reference the readback buffers
+    ~FrameExporter();
+
+    FrameExporter(const FrameExporter&) = delete;
+    auto operator=(const FrameExporter&) -> FrameExporter& = delete;
+
+    // Records the copy of the finished image (TransferSrcOptimal) into the next readback buffer
+    void recordCopy(const vk::raii::CommandBuffer& cmd, vk::Image image, std::uint32_t frameIndex);
+
+    // After the fence wait of frameIndex: the copy recorded in that slot is complete, hand it to a worker
+    void resolve(std::uint32_t frameIndex);
+
+    // The device must be idle. Encodes the frames still in flight, waits for every worker and closes the output.
+    void finish();
+
+    // PNG of a sequence frame. It only appears once completely written, so a killed export leaves no torn frames.
+    static auto framePath(const std::filesystem::path& directory, std::uint64_t frame) -> std::filesystem::path;
+
+private:
+    struct Readback {
+        vk::raii::Buffer buffer = nullptr;
+        vk::raii::DeviceMemory memory = nullptr;
+        const std::uint8_t* mapped = nullptr;
+        std::uint64_t frame = 0;
+        std::vector<std::uint8_t> rgb;  // Output size, 3 channels
+        std::vector<std::uint8_t> yuv;  // Y4M only: Y, U and V planes
+        std::future<void> encode;
+    };
+
+    enum class Format : std::uint8_t {
+        Png,
+        Y4m,
+    };
+
+    VulkanCore& m_vulkanCore;
+    JobSystem& m_jobSystem;
+    std::filesystem::path m_outputPath;
+    Format m_format;
+
+    vk::Extent2D m_renderExtent;
+    vk::Extent2D m_outputExtent;
+    std::uint32_t m_supersample;
+    std::uint64_t m_firstFrame;
+    bool m_bgra;
+    bool m_hostCached;  // Cached memory reads fast but may be non-coherent, it is invalidated before encoding
+
+    std::vector<Readback> m_readbacks;
+    std::array<std::optional<std::uint32_t>, MAX_FRAMES_IN_FLIGHT> m_inFlight{};  // Readback recorded in each frame slot
+    std::uint64_t m_recordedFrames = 0;
+
+    // Render thread waits for a readback buffer that was still being encoded
+    std::uint32_t m_stalls = 0;
+    double m_stallMs = 0.0;
+    std::chrono::steady_clock::time_point m_start;
+
+    // Supersampling averages in linear light
+    std::array<float, 256> m_srgbToLinear{};
+    std::array<std::uint8_t, 4096> m_linearToSrgb{};
+
+    // Y4M: workers convert in parallel but append in frame order
+    std::ofstream m_y4m;
+    std::mutex m_y4mMutex;
+    std::condition_variable m_y4mTurn;
+    std::uint64_t m_y4mNextFrame = 0;
+
+    void encode(Readback& readback);
+    void convertToRgb(Readback& readback) const;
+    void writePng(const Readback& readback) const;
+    void convertToYuv(Readback& readback) const;
+
+    // Appends the frame once every earlier frame is written. Frames whose conversion failed only pass the turn on.
+    void appendY4m(const Readback& readback, bool converted);
+
+    void waitForEncoders();
+};
@@ -5,8 +5,12 @@
 #include <map>
 #include <tiny_gltf.h>
 
+#include "constants.hpp"
 #include "SharedTypes.hpp"
 #include "Scene.hpp"
+#include "LinearArena.hpp"
+
+class JobSystem;
 
 struct LoadedGLTF {
     Scene scene;
@@ -17,9 +21,45 @@ class GLTFLoader {
 public:
     std::unique_ptr<LoadedGLTF> load(const std::string& path);
 
-    explicit GLTFLoader();
+    // Builds the scene from an already parsed model (load() after parsing, or a model generated in memory).
+    // Images still waiting in the deferred decode list are decoded first.
+    std::unique_ptr<LoadedGLTF> loadModel(tinygltf::Model model);
+
+    // Nearest-neighbour downscale used when textures exceed the configured maximum dimension
+    static std::vector<unsigned char> downscaleImage(const std::vector<unsigned char>& srcImage,
+                                                     std::uint32_t srcWidth,
+                                                     std::uint32_t srcHeight,
+                                                     std::uint32_t dstWidth,
+                                                     std::uint32_t dstHeight,
+                                                     int components);
+
+    // Image decoding and texture processing are spread over the job system's workers
+    explicit GLTFLoader(JobSystem& jobSystem);
 
 private:
+    // Encoded image captured during parsing, decoded in parallel afterwards
+    struct EncodedImage {
+        int imageIndex;
+        int requestedWidth;
+        int requestedHeight;
+        std::vector<unsigned char> bytes;
+    };
+
+    // Scene texture slot reserved while walking the materials, filled in parallel afterwards
+    struct PendingTexture {
+        std::vector<Texture>* textures;
+        std::size_t slot;
+        int gltfTexIndex;
+    };
+
+    JobSystem& m_jobSystem;
+
+    // Temporaries of the loading thread (primitive geometry, node bookkeeping), released when load() returns
+    LinearArena m_loadArena{LOADER_ARENA_INITIAL_SIZE};
+
+    std::vector<EncodedImage> m_encodedImages;
+    std::vector<PendingTexture> m_pendingTextures;
+
     // [gltfd mesh idx][gltff mesh primitive idx] => our mesh
     std::vector<std::vector<std::uint32_t>> m_gltfPrimitiveToEngineGeometry;
 
@@ -39,14 +79,24 @@ private:
 
     void loadMaterialsAndTextures(const tinygltf::Model& model, Scene& scene);
 
+    static bool deferImageDecode(tinygltf::Image* image,
+                                 int imageIndex,
+                                 std::string* err,
+                                 std::string* warn,
+                                 int requestedWidth,
+                                 int requestedHeight,
+                                 const unsigned char* bytes,
+                                 int size,
+                                 void* userData);
+
+    void decodeImages(tinygltf::Model& model);
+
     Texture loadTexture(const tinygltf::Texture& texture, const tinygltf::Model& model);
 
-    template <typename T>
     void loadTextureMap(int gltfTexIndex,
                         std::map<std::uint32_t, std::uint32_t>& gltfTextureMap,
-                        std::vector<T>& sceneTextures,
-                        std::int32_t& parsedMaterialTexIndex,
-                        const tinygltf::Model& model);
+                        std::vector<Texture>& sceneTextures,
+                        std::int32_t& parsedMaterialTexIndex);
 
     void loadNodes(const tinygltf::Model& model, Scene& scene);
 
@@ -60,6 +110,8 @@ private:
 
     auto loadPrimitive(const tinygltf::Primitive& prim, const tinygltf::Model& model) -> Geometry;
 
+    void partitionDynamicInstances(const tinygltf::Model& model, Scene& scene);
+
     void buildMeshToInstanceMapping(Scene& scene);
 
     void computeNodeWorldMatrix(const tinygltf::Model& model,
@@ -68,11 +120,4 @@ private:
                                 std::vector<glm::mat4>& outMatrices);
 
     auto getLocalTransform(const tinygltf::Node& node) -> glm::mat4;
-
-    std::vector<unsigned char> downscaleImage(const std::vector<unsigned char>& srcImage,
-                                              std::uint32_t srcWidth,
-                                              std::uint32_t srcHeight,
-                                              std::uint32_t dstWidth,
-                                              std::uint32_t dstHeight,
-                                              int components);
 };
@@ -0,0 +1,129 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <vector>
+#include <vulkan/vulkan_raii.hpp>
+
+#include "constants.hpp"
+
+class VulkanCore;
+
+// Every pass that gets a timestamp pair. Frame spans the whole command buffer.
+enum class GpuPass : std::uint32_t {
+    Upload,
+    TLASUpdate,
+    Opaque,
+    Transparent,
+    TAA,
+    HDR,
+    BrightPass,
+    BlurHorizontal,
+    BlurVertical,
+    Composite,
+    Frame,
+    Count,
+};
+
+constexpr std::size_t GPU_PASS_COUNT = static_cast<std::size_t>(GpuPass::Count);
+
+// Per-pass GPU time in milliseconds, NaN for passes that did not run in that frame
+using GpuPassTimings = std::array<double, GPU_PASS_COUNT>;
+
+// Pipeline statistics counters of one pass (only passes wrapped in begin/endStatistics are valid)
+struct GpuPipelineStatistics {
+    bool valid = false;
+    std::uint64_t vertexInvocations = 0;
+    std::uint64_t clippingInvocations = 0;   // Primitives that reached the clipping stage
+    std::uint64_t clippingPrimitives = 0;    // Primitives that left it (culled and clipped away ones excluded)
+    std::uint64_t fragmentInvocations = 0;
+};
+
+using GpuPassStatistics = std::array<GpuPipelineStatistics, GPU_PASS_COUNT>;
+
+// GPU timestamp profiler: writeTimestamp2 query pairs around each pass, one query pool per frame in flight.
+// Results of a pool are read back when its frame slot is recorded again (after the in-flight fence wait),
+// so reading never stalls the GPU. Passes that draw geometry can additionally be wrapped in pipeline
+// statistics queries (vertex/fragment invocations, clipping) when the device supports them.
+class GpuProfiler {
+public:
+    explicit GpuProfiler(VulkanCore& vulkanCore);
+
+    // Called with the resolved results of every finished frame (frameNumber counts beginFrame calls)
+    using ResultsCallback = std::function<void(std::uint64_t frameNumber,
+                                               const GpuPassTimings& timings,
+                                               const GpuPassStatistics& statistics)>;
+
+    [[nodiscard]] bool isEnabled() const { return m_enabled; }
+    [[nodiscard]] bool isStatisticsEnabled() const { return m_statisticsEnabled; }
+
+    // Frame number the next beginFrame will be reported under
+    [[nodiscard]] std::uint64_t getNextFrameNumber() const { return m_frameNumber; }
+
+    // Must be recorded right after cmd.begin(), outside of any rendering scope
+    void beginFrame(const vk::raii::CommandBuffer& cmd, std::uint32_t frameIndex);
+
+    void beginPass(const vk::raii::CommandBuffer& cmd, GpuPass pass);
+    void endPass(const vk::raii::CommandBuffer& cmd, GpuPass pass);
+
+    // Both must be recorded inside the same rendering scope
+    void beginStatistics(const vk::raii::CommandBuffer& cmd, GpuPass pass);
+    void endStatistics(const vk::raii::CommandBuffer& cmd, GpuPass pass);
+
+    // Reads every frame still pending. The device must be idle (e.g. at shutdown).
+    void resolvePendingFrames();
+
+    void setResultsCallback(ResultsCallback callback) { m_resultsCallback = std::move(callback); }
+
+    // Rolling averages over the last GPU_PROFILER_HISTORY_LENGTH resolved frames, in milliseconds
+    [[nodiscard]] auto getAverageTimings() const -> GpuPassTimings;
+    [[nodiscard]] auto getLatestTimings() const -> const GpuPassTimings& { return m_latestTimings; }
+    [[nodiscard]] auto getLatestStatistics() const -> const GpuPassStatistics& { return m_latestStatistics; }
+
+    void printAverages() const;
+
+    static auto passName(GpuPass pass) -> const char*;
+
+private:
+    VulkanCore& m_vulkanCore;
+
+    bool m_enabled = false;
+    bool m_statisticsEnabled = false;
+    double m_timestampPeriodNs = 1.0;
+    std::uint64_t m_timestampMask = ~0ULL;
+
+    std::vector<vk::raii::QueryPool> m_queryPools;            // one per frame in flight
+    std::vector<vk::raii::QueryPool> m_statisticsQueryPools;  // one per frame in flight, one query per pass
+
+    // Which passes were fully written into each pool, and which frame it belongs to
+    std::array<std::uint32_t, MAX_FRAMES_IN_FLIGHT> m_writtenPasses{};
+    std::array<std::uint32_t, MAX_FRAMES_IN_FLIGHT> m_writtenStatistics{};
+    std::array<std::uint64_t, MAX_FRAMES_IN_FLIGHT> m_poolFrameNumbers{};
+    std::array<bool, MAX_FRAMES_IN_FLIGHT> m_poolPending{};
+
+    std::uint32_t m_currentFrameIndex = 0;
+    std::uint64_t m_frameNumber = 0;
+
+    // Readback scratch: (value, availability) per query, sized once
+    std::vector<std::uint64_t> m_readback;
+    std::vector<std::uint64_t> m_statisticsReadback;
+
+    GpuPassTimings m_latestTimings{};
+    GpuPassStatistics m_latestStatistics{};
+    std::array<std::array<double, GPU_PROFILER_HISTORY_LENGTH>, GPU_PASS_COUNT> m_history{};
+    std::array<std::uint32_t, GPU_PASS_COUNT> m_historyCount{};
+    std::array<std::uint32_t, GPU_PASS_COUNT> m_historyCursor{};
+
+    ResultsCallback m_resultsCallback;
+
+    void createQueryPools();
+
+    void createStatisticsQueryPools();
+
+    void resolveFrame(std::uint32_t frameIndex);
+
+    void resolveTimings(std::uint32_t frameIndex, GpuPassTimings& timings);
+
+    void resolveStatistics(std::uint32_t frameIndex, GpuPassStatistics& statistics);
+};
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string>
+
+#include "constants.hpp"
+#include "GpuProfiler.hpp"
+#include "RayQueryPipeline.hpp"
+
+// CPU stages of a frame in the main loop. SceneUpdate covers culling and the per-frame uploads,
+// Other is whatever the stages do not account for (input polling, frame pacing).
+enum class FrameStage : std::uint32_t {
+    Animation,
+    FenceWait,
+    Acquire,
+    SceneUpdate,
+    Record,
+    Submit,
+    Present,
+    Other,
+    Count,
+};
+
+constexpr std::size_t FRAME_STAGE_COUNT = static_cast<std::size_t>(FrameStage::Count);
+
+// Watches frame times for frames that take more than a multiple of the running median over the last
+// HITCH_HISTORY_FRAMES frames. Every hitch is logged with the stage that grew the most over its own
+// median; the first one after a cooldown also gets a Chrome trace of the history window: the CPU
+// profiler zones, one event per frame with its stage and GPU pass timings, and the frame time against
+// the median as a counter track. GPU timings resolve MAX_FRAMES_IN_FLIGHT frames late, so the trace is
+// written that many frames after the hitch.
+// The history lives in fixed arrays, only hitches allocate (log line, trace file).
+class HitchDetector {
+public:
+    HitchDetector(double thresholdMultiple, std::filesystem::path outputDirectory);
+
+    // Once per rendered frame, with CpuProfiler::now() timestamps around the whole loop iteration.
+    // gpuFrameNumber is the GpuProfiler frame recorded in it, empty when drawFrame returned early.
+    void endFrame(std::uint64_t startNs,
+                  std::uint64_t endNs,
+                  double animateMs,
+                  const FrameStageTimings& stages,
+                  std::optional<std::uint64_t> gpuFrameNumber);
+
+    // From the GpuProfiler results callback
+    void recordGpuTimings(std::uint64_t gpuFrameNumber, const GpuPassTimings& timings);
+
+    // Writes a trace that is still waiting for its GPU timings (at shutdown, after resolvePendingFrames)
+    void flush();
+
+    [[nodiscard]] auto hitchCount() const -> std::uint32_t { return m_hitchCount; }
+
+    static auto stageName(FrameStage stage) -> const char*;
+
+private:
+    struct FrameRecord {
+        std::uint64_t frame = 0;
+        std::uint64_t startNs = 0;
+        std::uint64_t endNs = 0;
+        double frameMs = 0.0;
+        double medianMs = 0.0;  // Of the frames before this one, 0 until HITCH_MIN_FRAMES
+        std::array<double, FRAME_STAGE_COUNT> stageMs{};
+        std::optional<std::uint64_t> gpuFrameNumber;
+        bool gpuResolved = false;
+        GpuPassTimings gpuMs{};
+        bool hitch = false;
+    };
+
+    double m_thresholdMultiple;
+    std::filesystem::path m_outputDirectory;
+
+    std::array<FrameRecord, HITCH_HISTORY_FRAMES> m_history{};
+    std::array<double, HITCH_HISTORY_FRAMES> m_medianScratch{};
+    std::uint64_t m_frameCount = 0;
+
+    std::uint32_t m_hitchCount = 0;
+    std::uint32_t m_tracesWritten = 0;
+    std::optional<std::uint64_t> m_pendingTrace;  // Hitch frame whose trace waits for GPU timings
+    std::uint64_t m_cooldownEnd = 0;              // First frame that may start another trace
+
+    [[nodiscard]] auto historySize() const -> std::size_t;
+
+    // Median over the history, of the frame time or of one stage
+    [[nodiscard]] auto medianFrameMs() -> double;
+    [[nodiscard]] auto medianStageMs(FrameStage stage) -> double;
+
+    [[nodiscard]] auto slowestStage(const FrameRecord& record) -> FrameStage;
+
+    void writeTrace(std::uint64_t hitchFrame);
+};
@@ -6,6 +6,7 @@
 #include <vulkan/vulkan_core.h>
 #include <vulkan/vulkan_raii.hpp>
 
+#include "MemoryTracker.hpp"
 #include "SharedTypes.hpp"
 
 class VulkanCore;
@@ -17,6 +18,7 @@ public:
     explicit ImageManager(VulkanCore& vulkanCore, CommandManager& commandManager, BufferManager& bufferManager);
 
     void createImage(
+        MemoryCategory category,
         std::uint32_t width,
         std::uint32_t height,
         std::uint32_t mipLevels,
@@ -29,11 +31,22 @@ public:
         vk::raii::DeviceMemory& imageMemory
         ) const;
 
+    // Device-local 3D image without mips, e.g. the irradiance probe volume
+    void createVolumeImage(
+        MemoryCategory category,
+        vk::Extent3D extent,
+        vk::Format format,
+        vk::ImageUsageFlags usage,
+        vk::raii::Image& image,
+        vk::raii::DeviceMemory& imageMemory
+        ) const;
+
     vk::raii::ImageView createImageView(
         const vk::raii::Image& image,
         vk::Format format,
         vk::ImageAspectFlags aspectFlags,
-        std::uint32_t mipLevels
+        std::uint32_t mipLevels,
+        vk::ImageViewType viewType = vk::ImageViewType::e2D
         ) const;
 
     vk::raii::Sampler createSampler(bool anisotropy) const;
@@ -41,6 +54,7 @@ public:
     vk::raii::Sampler createPostProcessingSampler() const;
 
     void createImageFromTexture(
+        MemoryCategory category,
         const Texture& texture,
         vk::raii::Image& image,
         vk::raii::ImageView& imageView,
@@ -90,4 +104,13 @@ private:
     VulkanCore& m_vulkanCore;
     CommandManager& m_commandManager;
     BufferManager& m_bufferManager;
+
+    // Allocates, binds and registers the memory of a freshly created image
+    void allocateImageMemory(
+        MemoryCategory category,
+        const vk::ImageCreateInfo& imageInfo,
+        vk::MemoryPropertyFlags properties,
+        const vk::raii::Image& image,
+        vk::raii::DeviceMemory& imageMemory
+        ) const;
 };
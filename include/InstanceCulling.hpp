@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "SharedTypes.hpp"
+#include "FrustumCulling.hpp"
+#include "Scene.hpp"
+
+// CPU frustum culling behind the indirect draw rebuild (ResourceManager::rebuildIndirectDrawCommands).
+//
+// Appends one draw command per visible instance in [firstInstance, endInstance) to `draws`, and the material
+// pipeline it draws with (materialPipelineIndices[mesh material]) to `drawPipelines`. Blended instances beyond
+// maxTransparent are dropped; transparentCount carries the running count across calls.
+void cullInstances(const Scene& scene, const Frustum& frustum,
+                   std::uint32_t firstInstance, std::uint32_t endInstance,
+                   const std::vector<std::uint32_t>& materialPipelineIndices,
+                   std::uint32_t maxTransparent, std::uint32_t& transparentCount,
+                   std::vector<DrawIndexedIndirectCommand>& draws,
+                   std::vector<std::uint32_t>& drawPipelines);
+
+// Same for a sorted list of instances, e.g. the current segment of a PotentiallyVisibleSet
+void cullInstances(const Scene& scene, const Frustum& frustum,
+                   std::span<const std::uint32_t> candidateInstances,
+                   const std::vector<std::uint32_t>& materialPipelineIndices,
+                   std::uint32_t maxTransparent, std::uint32_t& transparentCount,
+                   std::vector<DrawIndexedIndirectCommand>& draws,
+                   std::vector<std::uint32_t>& drawPipelines);
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// Small fixed-size worker pool for load-time work (scene parsing, texture decode, audio, pipelines).
+// Per frame it runs the --export encoders (FrameExporter) and the SceneBvh build of the first free camera
+// pick, whose parallelFor blocks that frame until the mesh BVHs are done.
+class JobSystem {
+public:
+    // 0 = hardware_concurrency - 1, clamped to [1, JOB_SYSTEM_MAX_WORKERS]
+    explicit JobSystem(std::uint32_t workerCount = 0);
+
+    ~JobSystem();
+
+    JobSystem(const JobSystem&) = delete;
+    auto operator=(const JobSystem&) -> JobSystem& = delete;
+
+    // Runs fn on a worker; exceptions are rethrown by future::get()
+    template <typename Fn>
+    auto submit(Fn&& fn) -> std::future<std::invoke_result_t<Fn>> {
+        using Result = std::invoke_result_t<Fn>;
+        auto task = std::make_shared<std::packaged_task<Result()>>(std::forward<Fn>(fn));
+        auto future = task->get_future();
+        enqueue([task] { (*task)(); });
+        return future;
+    }
+
+    // Calls fn(i) for every i in [0, count). The calling thread takes part, so this is safe to
+    // call from inside a job. The first exception thrown by fn is rethrown after all items ran.
+    template <typename Fn>
+    void parallelFor(std::size_t count, Fn&& fn);
+
+    [[nodiscard]] auto workerCount() const -> std::uint32_t { return static_cast<std::uint32_t>(m_workers.size()); }
+
+private:
+    std::vector<std::thread> m_workers;
+    std::deque<std::function<void()>> m_queue;
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+    bool m_stopping = false;
+
+    void enqueue(std::function<void()> job);
+
+    void workerLoop();
+};
+
+template <typename Fn>
+void JobSystem::parallelFor(const std::size_t count, Fn&& fn) {
+    if (count == 0) {
+        return;
+    }
+
+    // Helpers may start after the caller already finished every item, so the shared state
+    // must outlive this call and helpers must not touch fn unless they claimed an item
+    struct State {
+        std::atomic<std::size_t> next{0};
+        std::atomic<std::size_t> completed{0};
+        std::size_t count = 0;
+        std::function<void(std::size_t)> body;
+        std::mutex mutex;
+        std::condition_variable done;
+        std::exception_ptr error;
+    };
+
+    auto state = std::make_shared<State>();
+    state->count = count;
+    state->body = [&fn](const std::size_t i) { fn(i); };
+
+    const auto runItems = [](State& s) {
+        for (std::size_t i = s.next.fetch_add(1); i < s.count; i = s.next.fetch_add(1)) {
+            try {
+                s.body(i);
+            } catch (...) {
+                const std::lock_guard lock(s.mutex);
+                if (!s.error) {
+                    s.error = std::current_exception();
+                }
+            }
+
+            if (s.completed.fetch_add(1) + 1 == s.count) {
+                const std::lock_guard lock(s.mutex);
+                s.done.notify_all();
+            }
+        }
+    };
+
+    const auto helpers = std::min<std::size_t>(m_workers.size(), count - 1);
+    for (std::size_t i = 0; i < helpers; i++) {
+        enqueue([state, runItems] { runItems(*state); });
+    }
+
+    runItems(*state);
+
+    std::unique_lock lock(state->mutex);
+    state->done.wait(lock, [&state] { return state->completed.load() == state->count; });
+
+    if (state->error) {
+        std::rethrow_exception(state->error);
+    }
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstddef>
+#include <memory_resource>
+
+// Bump allocator for short-lived temporaries, used through std::pmr containers:
+//
+//   std::pmr::vector<glm::mat4> worldMats(nodeCount, glm::mat4(1.0f), &frameArena);
+//
+// Allocations come from one contiguous block and deallocate() does nothing; everything is released at once
+// by reset(). Requests that do not fit are served by the upstream resource for the rest of the cycle, and the
+// next reset() grows the block to the high-water mark, so a steady workload stops touching the heap after its
+// first cycle. Not thread safe, each arena belongs to one thread.
+class LinearArena final : public std::pmr::memory_resource {
+public:
+    explicit LinearArena(std::size_t initialCapacity,
+                         std::pmr::memory_resource* upstream = std::pmr::new_delete_resource());
+    ~LinearArena() override;
+
+    LinearArena(const LinearArena&) = delete;
+    auto operator=(const LinearArena&) -> LinearArena& = delete;
+
+    // Invalidates everything allocated since the previous reset
+    void reset();
+
+    // reset() and hand the block back to the upstream resource (e.g. once loading is done). The high-water mark
+    // is forgotten too, so the next use starts from a small block again.
+    void release();
+
+    [[nodiscard]] auto used() const -> std::size_t { return m_offset + m_overflowBytes; }
+    [[nodiscard]] auto capacity() const -> std::size_t { return m_capacity; }
+    [[nodiscard]] auto highWater() const -> std::size_t { return m_highWater; }
+
+private:
+    auto do_allocate(std::size_t bytes, std::size_t alignment) -> void* override;
+    void do_deallocate(void* /*p*/, std::size_t /*bytes*/, std::size_t /*alignment*/) override {}
+    auto do_is_equal(const std::pmr::memory_resource& other) const noexcept -> bool override {
+        return this == &other;
+    }
+
+    // Header in front of every upstream allocation made while the block was full
+    struct OverflowBlock {
+        OverflowBlock* next;
+        std::size_t size;
+        std::size_t alignment;
+    };
+
+    std::pmr::memory_resource* m_upstream;
+
+    std::byte* m_block = nullptr;
+    std::size_t m_capacity = 0;
+    std::size_t m_offset = 0;
+
+    OverflowBlock* m_overflow = nullptr;
+    std::size_t m_overflowBytes = 0;
+    std::size_t m_highWater = 0;
+
+    void freeOverflow();
+};
@@ -0,0 +1,140 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+
+// Live per-frame metrics in a named shared memory segment (POSIX shm_open, a named file mapping on Windows),
+// for dashboards that watch running instances without parsing stdout:
+//
+//   CyberpunkCityDemo --live-metrics cyberpunk_metrics
+//   LiveMetricsReader --name cyberpunk_metrics --csv kiosk.csv
+//
+// The segment holds one LiveMetricsBlock: a header written once, then the latest LiveMetricsFrame
+// behind a seqlock. The writer never waits; readers retry while the sequence is odd or changed
+// during their copy. The layout is shared by both sides, bump LIVE_METRICS_VERSION when it changes.
+
+constexpr std::uint32_t LIVE_METRICS_MAGIC = 0x4D4C5643;  // "CVLM"
+constexpr std::uint32_t LIVE_METRICS_VERSION = 1;
+constexpr std::size_t LIVE_METRICS_MAX_GPU_PASSES = 16;
+constexpr std::size_t LIVE_METRICS_NAME_LENGTH = 24;
+constexpr std::uint64_t LIVE_METRICS_NONE = ~0ULL;        // Frame number of results that have not arrived yet
+constexpr const char* LIVE_METRICS_DEFAULT_NAME = "cyberpunk_metrics";
+
+struct LiveMetricsFrame {
+    std::uint64_t frameNumber = 0;
+    std::uint64_t timestampNs = 0;  // Steady clock of the writer, for rates and staleness
+
+    // CPU stages of the main loop in milliseconds (see FrameStageTimings)
+    double frameMs = 0.0;
+    double animateMs = 0.0;
+    double fenceWaitMs = 0.0;
+    double acquireMs = 0.0;
+    double sceneUpdateMs = 0.0;
+    double recordMs = 0.0;
+    double submitMs = 0.0;
+    double presentMs = 0.0;
+
+    // GPU pass timings resolve MAX_FRAMES_IN_FLIGHT frames late, gpuFrameNumber says which frame they are from.
+    // NaN for passes that did not run, names are in the block header.
+    std::uint64_t gpuFrameNumber = LIVE_METRICS_NONE;
+    double gpuPassMs[LIVE_METRICS_MAX_GPU_PASSES] = {};
+
+    // Culling result the frame drew with
+    std::uint32_t drawCalls = 0;         // Multi-draw-indirect calls (one per material pipeline range)
+    std::uint32_t visibleInstances = 0;  // Indirect draw commands
+    std::uint64_t visibleTriangles = 0;
+
+    // Ray counter totals, only in --ray-counters / --ray-candidates runs (rayFrameNumber stays NONE otherwise)
+    std::uint64_t rayFrameNumber = LIVE_METRICS_NONE;
+    std::uint64_t shadowRays = 0;
+    std::uint64_t reflectionRays = 0;
+    std::uint64_t candidateIterations = 0;
+
+    // MemoryTracker totals, the budget of the device-local heaps refreshes every LIVE_METRICS_BUDGET_INTERVAL frames
+    std::uint64_t memoryTrackedBytes = 0;
+    std::uint64_t memoryPeakBytes = 0;
+    std::uint64_t memoryBudgetBytes = 0;  // 0 without VK_EXT_memory_budget
+    std::uint64_t memoryUsageBytes = 0;
+
+    std::uint64_t tlasUpdates = 0;  // TLAS refits recorded since startup
+};
+
+struct LiveMetricsBlock {
+    std::uint32_t magic;
+    std::uint32_t version;
+    std::uint32_t processId;
+    std::uint32_t gpuPassCount;
+    char gpuPassNames[LIVE_METRICS_MAX_GPU_PASSES][LIVE_METRICS_NAME_LENGTH];
+
+    std::atomic<std::uint64_t> sequence;  // Odd while the writer is updating frame
+    LiveMetricsFrame frame;
+};
+
+// Both processes touch the sequence, it must not hide a lock inside the process that created it
+static_assert(std::atomic<std::uint64_t>::is_always_lock_free);
+
+// A named shared memory mapping. The creating side removes the name again when it is destroyed.
+class SharedMemorySegment {
+public:
+    // Throws when the name already exists, two creators must not share (and overwrite) one segment
+    static auto create(const std::string& name, std::size_t size) -> SharedMemorySegment;
+    static auto open(const std::string& name, std::size_t size) -> SharedMemorySegment;
+
+    [[nodiscard]] static auto exists(const std::string& name) -> bool;
+
+    // Removes the name of a segment whose creator is gone (POSIX segments outlive a crashed process)
+    static void remove(const std::string& name);
+
+    SharedMemorySegment(SharedMemorySegment&& other) noexcept;
+    auto operator=(SharedMemorySegment&& other) noexcept -> SharedMemorySegment&;
+    SharedMemorySegment(const SharedMemorySegment&) = delete;
+    auto operator=(const SharedMemorySegment&) -> SharedMemorySegment& = delete;
+    ~SharedMemorySegment();
+
+    [[nodiscard]] auto data() const -> void* { return m_data; }
+
+private:
+    SharedMemorySegment() = default;
+
+    void release();
+
+    std::string m_name;
+    void* m_data = nullptr;
+    std::size_t m_size = 0;
+    bool m_owner = false;
+#ifdef _WIN32
+    void* m_mapping = nullptr;
+#endif
+};
+
+// Render thread side: publish() is a pair of atomic stores around a copy, it never blocks or allocates
+class LiveMetricsWriter {
+public:
+    LiveMetricsWriter(const std::string& name, std::span<const char* const> gpuPassNames);
+
+    void publish(const LiveMetricsFrame& frame);
+
+private:
+    SharedMemorySegment m_segment;
+    LiveMetricsBlock* m_block;
+};
+
+class LiveMetricsReader {
+public:
+    // Throws when no writer has created the segment or its layout version differs
+    explicit LiveMetricsReader(const std::string& name);
+
+    // Copies the latest frame, false when the writer kept it busy for every retry
+    [[nodiscard]] auto read(LiveMetricsFrame& frame) const -> bool;
+
+    [[nodiscard]] auto processId() const -> std::uint32_t { return m_block->processId; }
+    [[nodiscard]] auto gpuPassCount() const -> std::uint32_t { return m_block->gpuPassCount; }
+    [[nodiscard]] auto gpuPassName(std::uint32_t pass) const -> std::string;
+
+private:
+    SharedMemorySegment m_segment;
+    const LiveMetricsBlock* m_block;
+};
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <vulkan/vulkan_raii.hpp>
+
+// What a device memory allocation holds. Every BufferManager/ImageManager allocation is tagged with one.
+enum class MemoryCategory : std::uint8_t {
+    Geometry,                  // Vertex, index, UV and mesh buffers
+    Materials,
+    TextureBaseColor,
+    TextureMetallicRoughness,
+    TextureNormal,
+    TextureEmissive,
+    TextureOcclusion,
+    TextureSkybox,
+    ProbeVolume,               // Irradiance probe textures of --probes
+    Blas,
+    Tlas,                      // TLAS storage and its per-frame instance buffers
+    AccelerationScratch,       // BLAS/TLAS build scratch
+    RenderTargets,             // Swapchain-sized attachments, post-processing and debug images
+    Staging,                   // Upload staging (ring and one-shot copies)
+    PerFrame,                  // Per-frame uniforms, instance/light/draw buffers and readbacks
+    ExportReadback,            // Host readback ring of --export
+    PvsBake,                   // Visibility bitsets and readback of --bake-pvs
+    Count,
+};
+
+constexpr std::size_t MEMORY_CATEGORY_COUNT = static_cast<std::size_t>(MemoryCategory::Count);
+
+struct MemoryCategoryStats {
+    std::uint64_t currentBytes = 0;
+    std::uint64_t peakBytes = 0;
+    std::uint32_t liveAllocations = 0;
+    std::uint32_t totalAllocations = 0;  // Including the ones released since
+};
+
+// One memory heap: what the tracker attributes to it against what the driver reports.
+// budgetBytes/usageBytes come from VK_EXT_memory_budget and are 0 when the device lacks it.
+struct MemoryHeapReport {
+    std::uint32_t heapIndex = 0;
+    bool deviceLocal = false;
+    std::uint64_t sizeBytes = 0;
+    std::uint64_t trackedBytes = 0;
+    std::uint64_t budgetBytes = 0;
+    std::uint64_t usageBytes = 0;  // Whole process, including allocations the tracker does not see
+};
+
+// VK_EXT_memory_budget numbers of all device-local heaps together
+struct MemoryBudget {
+    std::uint64_t budgetBytes = 0;
+    std::uint64_t usageBytes = 0;
+};
+
+// Device memory accounting per category and heap. Allocations are registered by handle when they are
+// made; vk::raii::DeviceMemory frees itself without telling anyone, so memory that is freed before
+// shutdown (staging, build scratch) goes through release(). Everything else is counted until the
+// device is destroyed. Thread safe, allocations are rare enough for a mutex.
+class MemoryTracker {
+public:
+    MemoryTracker(const vk::raii::PhysicalDevice& physicalDevice, bool memoryBudgetSupported);
+
+    void recordAllocation(vk::DeviceMemory memory, MemoryCategory category, vk::DeviceSize size,
+                          std::uint32_t memoryTypeIndex);
+
+    // Unregisters the allocation and frees it
+    void release(vk::raii::DeviceMemory& memory);
+
+    [[nodiscard]] auto getCategoryStats(MemoryCategory category) const -> MemoryCategoryStats;
+    [[nodiscard]] auto getCurrentBytes() const -> std::uint64_t;
+    [[nodiscard]] auto getPeakBytes() const -> std::uint64_t;
+
+    // Queries the driver's budget for every heap (cheap, but not free: call it for reports, not per frame)
+    [[nodiscard]] auto queryHeaps() const -> std::vector<MemoryHeapReport>;
+
+    // Allocation free, all zero without VK_EXT_memory_budget
+    [[nodiscard]] auto queryDeviceLocalBudget() const -> MemoryBudget;
+
+    void printSummary() const;
+    void writeJson(const std::string& path) const;
+
+    static auto categoryName(MemoryCategory category) -> const char*;
+
+private:
+    struct Allocation {
+        MemoryCategory category;
+        vk::DeviceSize size;
+        std::uint32_t heapIndex;
+    };
+
+    const vk::raii::PhysicalDevice& m_physicalDevice;
+    bool m_memoryBudgetSupported = false;
+    std::array<std::uint32_t, VK_MAX_MEMORY_TYPES> m_typeHeaps{};
+
+    mutable std::mutex m_mutex;
+    std::unordered_map<vk::DeviceMemory, Allocation> m_allocations;
+    std::array<MemoryCategoryStats, MEMORY_CATEGORY_COUNT> m_categories{};
+    std::array<std::uint64_t, VK_MAX_MEMORY_HEAPS> m_heapBytes{};
+    std::uint64_t m_currentBytes = 0;
+    std::uint64_t m_peakBytes = 0;
+
+    void forget(vk::DeviceMemory memory);
+};
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <vector>
+#include <vulkan/vulkan_raii.hpp>
+
+class VulkanCore;
+class JobSystem;
+
+// vk::PipelineCache persisted to disk between runs.
+//
+// The file name and header are keyed by the device UUID, driver UUID and pipeline cache UUID;
+// a cache written by another GPU or driver version (or a corrupted file) is discarded and the
+// pipelines are compiled from scratch. The header also remembers how long the last cold start took
+// so a warm start can report the difference.
+class PipelineCache {
+public:
+    // ignoreExisting: start cold even if a valid cache file exists (it is still rewritten)
+    PipelineCache(VulkanCore& vulkanCore, JobSystem& jobSystem, bool ignoreExisting);
+
+    // Thread safe, may be called from several workers at once
+    auto createGraphicsPipeline(const vk::GraphicsPipelineCreateInfo& createInfo) const -> vk::raii::Pipeline;
+
+    // Runs independent pipeline builders concurrently on the job system and accounts their wall time
+    void buildInParallel(const std::vector<std::function<void()>>& builders);
+
+    // Writes the current cache contents (including everything compiled this run) back to disk
+    void save() const;
+
+    void printReport() const;
+
+    [[nodiscard]] auto isWarm() const -> bool { return m_warm; }
+
+private:
+    VulkanCore& m_vulkanCore;
+    JobSystem& m_jobSystem;
+
+    vk::raii::PipelineCache m_cache = nullptr;
+    std::filesystem::path m_path;
+
+    bool m_warm = false;
+    std::size_t m_loadedBytes = 0;
+    double m_previousColdMs = 0.0;  // From the file header, 0 if never measured
+
+    double m_creationMs = 0.0;
+    mutable std::atomic<std::uint32_t> m_pipelineCount{0};
+
+    struct DeviceKey {
+        std::uint32_t vendorID;
+        std::uint32_t deviceID;
+        std::uint32_t driverVersion;
+        std::array<std::uint8_t, VK_UUID_SIZE> deviceUUID;
+        std::array<std::uint8_t, VK_UUID_SIZE> driverUUID;
+        std::array<std::uint8_t, VK_UUID_SIZE> pipelineCacheUUID;
+    };
+
+    DeviceKey m_key{};
+
+    void queryDeviceKey();
+
+    // Returns the Vulkan cache blob if the file exists and belongs to this device and driver
+    auto loadValidatedBlob() -> std::vector<std::uint8_t>;
+};
@@ -10,13 +10,24 @@
 #include "BufferManager.hpp"
 #include "Shader.hpp"
 
+class GpuProfiler;
+class PipelineCache;
+
+// Debug views: a per-pixel counter image the composite pass shows as a heatmap instead of the tonemapped image
+struct DebugHeatmap {
+    const vk::raii::ImageView& countsView;  // r32ui, General layout
+    float maxCount;                         // Count at the hot end of the ramp
+};
+
 class PostProcessingStack {
 public:
     PostProcessingStack(VulkanCore& vulkanCore,
                         ResourceManager& resourceManager,
                         SwapChain& swapChain,
                         ImageManager& imageManager,
-                        BufferManager& bufferManager);
+                        BufferManager& bufferManager,
+                        GpuProfiler& gpuProfiler,
+                        PipelineCache& pipelineCache);
 
     ~PostProcessingStack() = default;
 
@@ -27,11 +38,8 @@ public:
                              const vk::raii::ImageView& targetImageView,
                              vk::raii::CommandBuffer const& cmd,
                              BloomParameters bloomParams,
-                             uint32_t frameIndex);
-
-    void updateDescriptorSets(const vk::raii::ImageView& resolvedImageView, 
-                              const vk::raii::ImageView& velocityImageView,  // TAA: velocity buffer
-                              uint32_t frameIndex);
+                             uint32_t frameIndex,
+                             const DebugHeatmap* heatmap = nullptr);  // Debug views: heatmap instead of composite
 
 private:
     VulkanCore& m_vulkanCore;
@@ -39,6 +47,8 @@ private:
     SwapChain& m_swapChain;
     ImageManager& m_imageManager;
     BufferManager& m_bufferManager;
+    GpuProfiler& m_gpuProfiler;
+    PipelineCache& m_pipelineCache;
 
     vk::raii::DescriptorPool m_descriptorPool = nullptr;
 
@@ -60,8 +70,6 @@ private:
     std::vector<vk::raii::ImageView> m_brightPassImageViews;
     vk::raii::DescriptorSetLayout m_brightPassDescriptorSetLayout = nullptr;
     vk::raii::DescriptorSetLayout m_hdrTransferDescriptorSetLayout = nullptr;
-    std::vector<vk::raii::DescriptorSet> m_hdrTransferDescriptorSets;
-    std::vector<vk::raii::DescriptorSet> m_brightPassDescriptorSets;
     std::vector<vk::raii::DescriptorSet> m_compositeDescriptorSets;
     vk::raii::PipelineLayout m_hdrTransferPipelineLayout = nullptr;
     vk::raii::PipelineLayout m_brightPassPipelineLayout = nullptr;
@@ -83,6 +91,12 @@ private:
     vk::raii::PipelineLayout m_compositePipelineLayout = nullptr;
     vk::raii::Pipeline m_compositePipeline = nullptr;
 
+    // Debug view heatmap, drawn in the composite pass instead of the tonemapped image (push descriptors)
+    std::unique_ptr<Shader> m_heatmapFragmentShader = nullptr;
+    vk::raii::DescriptorSetLayout m_heatmapDescriptorSetLayout = nullptr;
+    vk::raii::PipelineLayout m_heatmapPipelineLayout = nullptr;
+    vk::raii::Pipeline m_heatmapPipeline = nullptr;
+
     vk::raii::Sampler m_sampler = nullptr;
     
     // TAA Resources
@@ -98,8 +112,7 @@ private:
     std::vector<vk::raii::DeviceMemory> m_taaOutputImageMemories;
     std::vector<vk::raii::ImageView> m_taaOutputImageViews;
     
-    vk::raii::DescriptorSetLayout m_taaDescriptorSetLayout = nullptr;
-    std::vector<vk::raii::DescriptorSet> m_taaDescriptorSets;
+    vk::raii::DescriptorSetLayout m_taaDescriptorSetLayout = nullptr;  // Push descriptors, like HDR transfer and bright pass
     vk::raii::PipelineLayout m_taaPipelineLayout = nullptr;
     vk::raii::Pipeline m_taaPipeline = nullptr;
     
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <span>
+#include <vector>
+
+#include "Scene.hpp"
+
+// Potentially visible sets of the static instances along the cinematic camera path, baked by PvsBaker
+// (--bake-pvs) and loaded with --pvs. The looping animation is cut into segments of PVS_SEGMENT_SECONDS,
+// each holding every static instance some camera sample in that segment could see. Frustum culling then
+// only tests the current segment's instances. Each set is stored as a bitset over the static instance
+// range, run-length encoded (alternating runs of hidden and visible instances as LEB128 varints).
+class PotentiallyVisibleSet {
+public:
+    // Empty, segments are added by the baker
+    PotentiallyVisibleSet(const Scene& scene, float loopDuration, float segmentDuration);
+
+    // Throws when the file is unreadable or was baked for a different scene or animation
+    static auto load(const std::filesystem::path& path, const Scene& scene, float loopDuration) -> PotentiallyVisibleSet;
+
+    void save(const std::filesystem::path& path) const;
+
+    // visibleBits: one bit per instance, only the static range is stored
+    void addSegment(std::span<const std::uint32_t> visibleBits);
+
+    // Segment of an animation time, wrapped like Animator::animate
+    [[nodiscard]] auto segmentAt(float time) const -> std::uint32_t;
+
+    // Replaces instances with the sorted static instance indices of a segment
+    void decodeSegment(std::uint32_t segment, std::vector<std::uint32_t>& instances) const;
+
+    [[nodiscard]] auto segmentCount() const -> std::uint32_t {
+        return static_cast<std::uint32_t>(m_offsets.size() - 1);
+    }
+
+    [[nodiscard]] auto segmentDuration() const -> float { return m_segmentDuration; }
+    [[nodiscard]] auto staticInstanceCount() const -> std::uint32_t { return m_staticInstanceCount; }
+    [[nodiscard]] auto encodedBytes() const -> std::size_t { return m_data.size(); }
+
+private:
+    std::uint32_t m_instanceCount = 0;
+    std::uint32_t m_staticInstanceCount = 0;
+    std::uint64_t m_sceneHash = 0;
+    float m_loopDuration = 0.0f;
+    float m_segmentDuration = 0.0f;
+
+    std::vector<std::uint64_t> m_offsets{0};  // Segment i is m_data[m_offsets[i], m_offsets[i + 1])
+    std::vector<std::uint8_t> m_data;
+};
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <glm/glm.hpp>
+
+#include "ProbeVolume.hpp"
+#include "Scene.hpp"
+#include "SceneBvh.hpp"
+
+class JobSystem;
+
+// Offline irradiance probe bake (--bake-probes). Runs on the CPU through SceneBvh, so it needs neither the GPU
+// scene nor ray tracing hardware. The grid covers the world bounds of the static instances (the sky sphere
+// excluded) every PROBE_GRID_SPACING units, coarser on axes that would exceed PROBE_GRID_MAX_RESOLUTION.
+//
+// Each probe traces PROBE_BAKE_SAMPLES paths, starting along spherical Fibonacci directions, through the static
+// geometry as Lambertian surfaces: a path collects the emission of what it hits, weighted by the albedo of the
+// surfaces before, and ends in the sky texture or after PROBE_BAKE_BOUNCES cosine-sampled bounces. Like the sky
+// lookup it replaces, the volume only carries sky and emissive light; punctual lights are shaded per pixel.
+// Probes whose paths mostly start on backfaces sit inside geometry and take the average of their valid
+// neighbours instead, so they do not leak darkness into the surfaces around them.
+class ProbeBaker {
+public:
+    // scene must stay unchanged during bake()
+    ProbeBaker(const Scene& scene, JobSystem& jobSystem);
+
+    auto bake() -> ProbeVolume;
+
+private:
+    const Scene& m_scene;
+    JobSystem& m_jobSystem;
+    SceneBvh m_bvh;  // Static instances only, the animated ones are elsewhere most of the time
+
+    std::array<float, 256> m_srgbToLinear{};
+
+    struct ProbeResult {
+        ProbeVolume::Coefficients coefficients;
+        bool valid;
+    };
+
+    // What a path sees where it hits a surface
+    struct SurfaceHit {
+        glm::vec3 position;
+        glm::vec3 normal;  // Geometric, facing the ray
+        glm::vec3 albedo;
+        glm::vec3 emission;
+        bool backface;     // The ray hit the side the shading normal points away from
+    };
+
+    [[nodiscard]] auto bakeProbe(glm::vec3 position, std::uint32_t seed) const -> ProbeResult;
+    [[nodiscard]] auto resolveHit(const Ray& ray, const RayHit& hit) const -> SurfaceHit;
+    [[nodiscard]] auto skyRadiance(glm::vec3 direction) const -> glm::vec3;
+
+    // Nearest texel of mip 0 in linear color, wrapping like the material samplers (white when not loaded)
+    [[nodiscard]] auto sampleTexture(const Texture& texture, glm::vec2 uv) const -> glm::vec4;
+};
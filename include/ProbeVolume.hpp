@@ -0,0 +1,63 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <filesystem>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "Scene.hpp"
+
+// Irradiance probes on a regular grid over the static city, baked by ProbeBaker (--bake-probes) and loaded with
+// --probes. Each probe stores the irradiance arriving from every direction as L1 spherical harmonics, already
+// convolved with the cosine lobe and divided by pi, so that per color channel E(n) / pi = c.x + dot(c.yzw, n)
+// where c is the channel's coefficient vector. The shader interpolates the coefficients of the eight probes
+// around a surface trilinearly, straight from the hardware sampler.
+class ProbeVolume {
+public:
+    // Red, green and blue coefficient vectors of one probe: constant band, then the x, y and z linear bands
+    using Coefficients = std::array<glm::vec4, 3>;
+
+    // All probes dark, the baker fills them in. origin is the position of probe (0, 0, 0).
+    ProbeVolume(const Scene& scene, glm::uvec3 dimensions, glm::vec3 origin, glm::vec3 spacing);
+
+    // Throws when the file is unreadable or was baked for a different scene
+    static auto load(const std::filesystem::path& path, const Scene& scene) -> ProbeVolume;
+
+    void save(const std::filesystem::path& path) const;
+
+    [[nodiscard]] auto dimensions() const -> glm::uvec3 { return m_dimensions; }
+    [[nodiscard]] auto origin() const -> glm::vec3 { return m_origin; }
+    [[nodiscard]] auto spacing() const -> glm::vec3 { return m_spacing; }
+    [[nodiscard]] auto probeCount() const -> std::size_t { return m_probes.size(); }
+
+    // Probes are stored x fastest, then y, then z, the texel order of the 3D textures
+    [[nodiscard]] auto probeIndex(const glm::uvec3 cell) const -> std::size_t {
+        return (static_cast<std::size_t>(cell.z) * m_dimensions.y + cell.y) * m_dimensions.x + cell.x;
+    }
+
+    [[nodiscard]] auto probeCell(std::size_t index) const -> glm::uvec3;
+
+    [[nodiscard]] auto probePosition(const glm::uvec3 cell) const -> glm::vec3 {
+        return m_origin + glm::vec3(cell) * m_spacing;
+    }
+
+    [[nodiscard]] auto probe(const std::size_t index) const -> const Coefficients& { return m_probes[index]; }
+    [[nodiscard]] auto probe(const std::size_t index) -> Coefficients& { return m_probes[index]; }
+
+    // 3D texture coordinate of a world position is position * textureScale() + textureBias(). Every probe sits
+    // at a texel center, the outermost ones half a texel inside [0, 1].
+    [[nodiscard]] auto textureScale() const -> glm::vec3;
+    [[nodiscard]] auto textureBias() const -> glm::vec3;
+
+    // Coefficient vectors of one color channel as RGBA16F texels (four halfs per probe) in probe order
+    void packChannel(std::uint32_t channel, std::vector<std::uint16_t>& texels) const;
+
+private:
+    glm::uvec3 m_dimensions{0};
+    glm::vec3 m_origin{0.0f};
+    glm::vec3 m_spacing{1.0f};
+    std::uint64_t m_sceneHash = 0;
+
+    std::vector<Coefficients> m_probes;
+};
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <memory>
+#include <tiny_gltf.h>
+#include <vulkan/vulkan_raii.hpp>
+
+#include "PotentiallyVisibleSet.hpp"
+#include "Scene.hpp"
+#include "Shader.hpp"
+
+class VulkanCore;
+class CommandManager;
+class BufferManager;
+class ResourceManager;
+class Animator;
+class LinearArena;
+
+// Offline PVS bake (--bake-pvs). Samples the cinematic camera PVS_SAMPLES_PER_SEGMENT times per segment and
+// traces one ray per pixel of a widened frustum against the scene TLAS (pvs_visibility.comp.slang). A segment's
+// set is every static instance one of its rays reached. Instances the rays cannot see at all (TLAS mask 0)
+// are added to every segment, so the runtime never culls something the bake could not judge.
+class PvsBaker {
+public:
+    PvsBaker(VulkanCore& vulkanCore,
+             CommandManager& commandManager,
+             BufferManager& bufferManager,
+             ResourceManager& resourceManager);
+
+    // The scene resources must be allocated. Moves the scene's camera and animated instances.
+    auto bake(const tinygltf::Model& model, Scene& scene, Animator& animator, LinearArena& arena) -> PotentiallyVisibleSet;
+
+private:
+    VulkanCore& m_vulkanCore;
+    CommandManager& m_commandManager;
+    BufferManager& m_bufferManager;
+    ResourceManager& m_resourceManager;
+
+    std::unique_ptr<Shader> m_visibilityShader = nullptr;
+    vk::raii::DescriptorSetLayout m_descriptorSetLayout = nullptr;
+    vk::raii::PipelineLayout m_pipelineLayout = nullptr;
+    vk::raii::Pipeline m_pipeline = nullptr;
+
+    void createPipeline();
+};
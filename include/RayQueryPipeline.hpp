@@ -3,11 +3,15 @@
 #include <vector>
 #include <array>
 #include <cstdint>
+#include <functional>
 #include <vulkan/vulkan_raii.hpp>
 #include <vulkan/vulkan_enums.hpp>
 #include <glm/glm.hpp>
 
+#include "CommandLine.hpp"
+#include "constants.hpp"
 #include "Shader.hpp"
+#include "SharedTypes.hpp"
 
 class VulkanCore;
 class ResourceManager;
@@ -16,8 +20,21 @@ class SwapChain;
 class ImageManager;
 class BufferManager;
 class PostProcessingStack;
+class GpuProfiler;
+class PipelineCache;
+class FrameExporter;
 struct Scene;
 
+// CPU time spent in each stage of the last drawFrame() call, in milliseconds
+struct FrameStageTimings {
+    double fenceWaitMs = 0.0;
+    double acquireMs = 0.0;
+    double sceneUpdateMs = 0.0;
+    double recordMs = 0.0;
+    double submitMs = 0.0;
+    double presentMs = 0.0;
+};
+
 class RayQueryPipeline {
 public:
     explicit RayQueryPipeline(VulkanCore& vulkanCore,
@@ -26,11 +43,35 @@ public:
                               SwapChain& swapChain,
                               ImageManager& imageManager,
                               BufferManager& bufferManager,
-                              PostProcessingStack& postProcessingPipeline);
+                              PostProcessingStack& postProcessingPipeline,
+                              GpuProfiler& gpuProfiler,
+                              PipelineCache& pipelineCache,
+                              DebugView debugView = DebugView::None);
 
     ~RayQueryPipeline() = default;
 
-    void drawFrame(Scene& scene, float animationTime);
+    // False when the swapchain image could not be acquired (out of date): nothing was recorded or submitted,
+    // and getLastFrameTimings() does not describe a frame
+    [[nodiscard]] bool drawFrame(Scene& scene, float animationTime);
+
+    // Compiles the specialized pipelines for the material permutations the loaded scene uses
+    // (ResourceManager::getMaterialPipelineKeys), must run after the scene resources are allocated
+    void createMaterialPipelines(const std::vector<MaterialPipelineKey>& keys);
+
+    [[nodiscard]] const FrameStageTimings& getLastFrameTimings() const { return m_lastFrameTimings; }
+
+    // Ray counter views: called with the ray totals of every finished frame, read back MAX_FRAMES_IN_FLIGHT
+    // frames late after the in-flight fence wait (frameNumber counts recorded frames, like GpuProfiler's)
+    using RayCounterCallback = std::function<void(std::uint64_t frameNumber, const RayCounterTotals& totals)>;
+
+    [[nodiscard]] bool isCountingRays() const { return m_debugCounters == DEBUG_COUNTERS_RAYS; }
+    void setRayCounterCallback(RayCounterCallback callback) { m_rayCounterCallback = std::move(callback); }
+
+    // Reads the totals of every frame still pending. The device must be idle (e.g. at shutdown).
+    void resolvePendingRayCounters();
+
+    // Offline export: headless frames are copied into the exporter's readback ring (null = off)
+    void setFrameExporter(FrameExporter* exporter) { m_frameExporter = exporter; }
     
     // TAA: Get current frame's jitter offset (in pixels)
     [[nodiscard]] glm::vec2 getJitterOffset() const { return m_jitterOffset; }
@@ -48,17 +89,51 @@ private:
     ImageManager& m_imageManager;
     BufferManager& m_bufferManager;
     PostProcessingStack& m_postProcessingPipeline;
+    GpuProfiler& m_gpuProfiler;
+    PipelineCache& m_pipelineCache;
 
     std::vector<Shader> m_shaders;
 
     std::uint32_t m_currentFrame{0};
     std::uint32_t m_semaphoreIndex{0};
 
+    FrameStageTimings m_lastFrameTimings{};
+
+    // Debug views: the scene pipelines count into the per-frame counter images and ray totals buffer
+    // (set 3, pushed every frame) and the composite pass shows one of the images as a heatmap.
+    // Counters a view does not use shrink to 1x1 images, set 3 still needs valid descriptors.
+    DebugView m_debugView = DebugView::None;
+    std::uint32_t m_debugCounters = DEBUG_COUNTERS_NONE;  // Specialization constant 1 of the fragment shader
+    vk::raii::DescriptorSetLayout m_debugCounterDescriptorSetLayout = nullptr;
+    std::vector<vk::raii::Image> m_pixelCountImages;  // Fragments (overdraw) or rays per pixel
+    std::vector<vk::raii::DeviceMemory> m_pixelCountImageMemories;
+    std::vector<vk::raii::ImageView> m_pixelCountImageViews;
+    std::vector<vk::raii::Image> m_candidateCountImages;  // Proceed() trips per pixel
+    std::vector<vk::raii::DeviceMemory> m_candidateCountImageMemories;
+    std::vector<vk::raii::ImageView> m_candidateCountImageViews;
+
+    // Ray totals: device-local atomics, copied into a persistently mapped buffer of the same frame slot
+    std::vector<vk::raii::Buffer> m_rayTotalsBuffers;
+    std::vector<vk::raii::DeviceMemory> m_rayTotalsBufferMemories;
+    std::vector<vk::raii::Buffer> m_rayTotalsReadbackBuffers;
+    std::vector<vk::raii::DeviceMemory> m_rayTotalsReadbackMemories;
+    std::vector<void*> m_rayTotalsReadbackMapped;
+    std::array<std::uint64_t, MAX_FRAMES_IN_FLIGHT> m_rayTotalsFrameNumbers{};
+    std::array<bool, MAX_FRAMES_IN_FLIGHT> m_rayTotalsPending{};
+    std::uint64_t m_recordedFrames = 0;
+    RayCounterCallback m_rayCounterCallback;
+
+    FrameExporter* m_frameExporter = nullptr;
+
     vk::SampleCountFlagBits m_msaaSamples = vk::SampleCountFlagBits::e1;
     vk::raii::PipelineLayout m_pipelineLayout = nullptr;
     vk::raii::Pipeline m_opaquePipeline = nullptr;
     vk::raii::Pipeline m_transparentPipeline = nullptr;
 
+    // Indexed like the material pipeline keys; the handles fall back to the generic pipelines above
+    std::vector<vk::raii::Pipeline> m_materialPipelines;
+    std::vector<vk::Pipeline> m_materialPipelineHandles;
+
     vk::raii::Image m_colorImage = nullptr;
     vk::raii::DeviceMemory m_colorImageMemory = nullptr;
     vk::raii::ImageView m_colorImageView = nullptr;
@@ -92,10 +167,12 @@ private:
     void createShaderModules();
     void pickMsaaSamples();
     void createGraphicsPipeline();
+    auto createScenePipeline(const MaterialPipelineKey& key) const -> vk::raii::Pipeline;
     void createColorResources();
     void createResolveResources();
     void createDepthResources();
     void createVelocityResources();  // TAA: Create velocity buffer
+    void createDebugCounterResources();
     void initializeImageLayouts();
     void createSyncObjects();
     
@@ -106,4 +183,11 @@ private:
     static float halton(std::uint32_t index, std::uint32_t base);
 
     void recordCommandBuffer(const Scene& scene, std::uint32_t imageIndex);
+
+    // Clears the counters of the current frame before the scene passes, and after them makes the
+    // images visible to the heatmap and copies the ray totals out for readback
+    void recordDebugCounterClears(const vk::raii::CommandBuffer& cmd);
+    void recordDebugCounterResolve(const vk::raii::CommandBuffer& cmd);
+
+    void resolveRayCounters(std::uint32_t frameIndex);
 };
@@ -1,18 +1,25 @@
 #pragma once
 
+#include <array>
 #include <cstddef>
 #include <vector>
 #include <vulkan/vulkan.hpp>
 #include <vulkan/vulkan_enums.hpp>
 #include <vulkan/vulkan_raii.hpp>
 
+#include "constants.hpp"
 #include "SharedTypes.hpp"
 #include "Scene.hpp"
+#include "StagingRing.hpp"
+#include "VersionedBuffer.hpp"
 
 class VulkanCore;
 class CommandManager;
 class BufferManager;
 class ImageManager;
+class PotentiallyVisibleSet;
+class ProbeVolume;
+class TextureStreamer;
 
 struct AllocatedBuffer {
     vk::raii::Buffer& buffer;
@@ -33,7 +40,7 @@ struct AllocatedDescriptorSetLayouts {
 
 struct AllocatedDescriptorSets {
     std::vector<vk::raii::DescriptorSet>& globalSets;
-    std::vector<vk::raii::DescriptorSet>& materialSets;
+    vk::raii::DescriptorSet& materialSet;  // Shared by all frames in flight (materials + bindless texture table)
     std::vector<vk::raii::DescriptorSet>& lightSets;
 };
 
@@ -65,7 +72,7 @@ public:
     [[nodiscard]] auto getDescriptorSets() -> AllocatedDescriptorSets {
         return {
             .globalSets = m_globalDescriptorSets,
-            .materialSets = m_materialDescriptorSets,
+            .materialSet = m_materialDescriptorSet,
             .lightSets = m_lightingDescriptorSets,
         };
     }
@@ -90,23 +97,84 @@ public:
         return m_transparentDrawCount;
     }
 
+    // Material pipeline ranges and triangles of the last culling pass
+    [[nodiscard]] auto getDrawCallCount() const -> std::uint32_t {
+        return m_drawCallCount;
+    }
+
+    [[nodiscard]] auto getVisibleTriangleCount() const -> std::uint64_t {
+        return m_visibleTriangleCount;
+    }
+
+    // TLAS refits recorded since the scene was uploaded
+    [[nodiscard]] auto getTlasUpdateCount() const -> std::uint64_t {
+        return m_tlasUpdateCount;
+    }
+
     [[nodiscard]] auto getTransparentDrawOffset() const -> vk::DeviceSize {
         return m_opaqueDrawCount * sizeof(DrawIndexedIndirectCommand);
     }
 
+    // Material pipelines used by the loaded scene, opaque keys first (valid after allocateSceneResources)
+    [[nodiscard]] auto getMaterialPipelineKeys() const -> const std::vector<MaterialPipelineKey>& {
+        return m_materialPipelineKeys;
+    }
+
+    // The frame's indirect buffer grouped by material pipeline, opaque ranges before transparent ones
+    [[nodiscard]] auto getDrawRanges(const std::uint32_t frameIdx) const -> const std::vector<IndirectDrawRange>& {
+        return m_drawRanges[frameIdx];
+    }
+
     void allocateSceneResources(const Scene& scene);
+
+    // Size of the images the scene is rendered into, for the TAA jitter and the shaders' screenSize
+    void setRenderExtent(const vk::Extent2D extent) { m_renderExtent = extent; }
+
+    // Static instances are culled from the PVS segment of the frame's animation time instead of the whole
+    // static range (nullptr = off, e.g. for the free camera). Must outlive its use.
+    void setPotentiallyVisibleSet(const PotentiallyVisibleSet* pvs);
+
+    // The material textures (except emissive) are created by and streamed through streamer (nullptr = fully
+    // uploaded at load). Set before allocateSceneResources(), must outlive the scene resources.
+    void setTextureStreamer(TextureStreamer* streamer) { m_textureStreamer = streamer; }
+
+    // Indirect diffuse comes from these baked irradiance probes instead of the sky texture (nullptr = off).
+    // Set before allocateSceneResources(), must outlive the scene resources.
+    void setProbeVolume(const ProbeVolume* probeVolume) { m_probeVolume = probeVolume; }
+
+    // For the PVS bake, which traces the static instances of the initial TLAS
+    [[nodiscard]] auto getTlas(const std::uint32_t frameIdx) const -> const vk::raii::AccelerationStructureKHR& {
+        return m_tlasHandles[frameIdx];
+    }
+
+    [[nodiscard]] auto getTlasInstances() const -> const std::vector<vk::AccelerationStructureInstanceKHR>& {
+        return m_blasInstances;
+    }
+
+    // Adds a texture to the bindless table and returns its index for Material::*TexIndex. The slot is written
+    // with update-after-bind, so frames in flight are unaffected; a full table grows into a new set.
+    auto registerTexture(const vk::raii::ImageView& imageView, const vk::raii::Sampler& sampler) -> std::int32_t;
     void updateSceneResources(const Scene& scene, float time, std::uint32_t frameIdx, glm::vec2 jitterOffset = glm::vec2(0.0f));
     
+    // Record the copies of the scene buffer updates staged by updateSceneResources(); must come first in the frame
+    void recordUploads(const vk::CommandBuffer& cmd);
+
     // Record TLAS update commands into the provided command buffer (if needed)
     void recordTLASUpdate(const vk::CommandBuffer& cmd, const Scene& scene, bool initialBuild, std::uint32_t frameIdx);
 
+    [[nodiscard]] auto getStagingRing() const -> const StagingRing& { return m_stagingRing; }
+
 private:
     VulkanCore& m_vulkanCore;
     CommandManager& m_commandManager;
     BufferManager& m_bufferManager;
     ImageManager& m_imageManager;
 
+    // Instances, lights, TLAS instances and indirect draws are device-local; their per-frame changes go through here
+    StagingRing m_stagingRing;
+
     vk::raii::Sampler m_skyboxSampler = nullptr;
+    vk::raii::Sampler m_probeVolumeSampler = nullptr;
     vk::raii::Sampler m_baseColorTextureSampler = nullptr;
     vk::raii::Sampler m_metallicRoughnessTextureSampler = nullptr;
     vk::raii::Sampler m_normalTextureSampler = nullptr;
@@ -114,6 +182,7 @@ private:
     vk::raii::Sampler m_occlusionTextureSampler = nullptr;
 
     AllocatedTextureImage m_skyboxImage;
+    std::array<AllocatedTextureImage, 3> m_probeVolumeImages;  // Red, green and blue SH coefficients
     std::vector<AllocatedTextureImage> m_baseColorTextureImages;
     std::vector<AllocatedTextureImage> m_metallicTextureImages;
     std::vector<AllocatedTextureImage> m_normalTextureImages;
@@ -127,9 +196,35 @@ private:
     vk::raii::DescriptorSetLayout m_lightDescriptorSetLayout = nullptr;
 
     std::vector<vk::raii::DescriptorSet> m_globalDescriptorSets;
-    std::vector<vk::raii::DescriptorSet> m_materialDescriptorSets;
     std::vector<vk::raii::DescriptorSet> m_lightingDescriptorSets;
 
+    // Material set: material buffer, skybox, probe volume and the bindless texture table. It lives in its own
+    // update-after-bind pool sized for the current table capacity.
+    vk::raii::DescriptorPool m_materialDescriptorPool = nullptr;
+    vk::raii::DescriptorSet m_materialDescriptorSet = nullptr;
+    std::uint32_t m_textureTableCapacity{0};
+    std::uint32_t m_textureTableSize{0};
+
+    // Scene texture (per type, as referenced by Scene::materials) => texture table index, -1 if not uploaded
+    struct TextureTableIndices {
+        std::vector<std::int32_t> baseColor;
+        std::vector<std::int32_t> metallicRoughness;
+        std::vector<std::int32_t> normal;
+        std::vector<std::int32_t> emissive;
+        std::vector<std::int32_t> occlusion;
+    };
+
+    TextureTableIndices m_textureTableIndices;
+
+    // Sets replaced by a grown table, kept until the frames that may still reference them have finished
+    struct RetiredTextureTable {
+        vk::raii::DescriptorPool pool;
+        vk::raii::DescriptorSet set;
+        std::uint32_t framesLeft;
+    };
+
+    std::vector<RetiredTextureTable> m_retiredTextureTables;
+
     vk::raii::Buffer m_vertexBuffer = nullptr;
     vk::raii::DeviceMemory m_vertexBufferMemory = nullptr;
 
@@ -150,9 +245,12 @@ private:
     vk::raii::Buffer m_uvBuffer = nullptr;
     vk::raii::DeviceMemory m_uvBufferMemory = nullptr;
 
-    std::vector<vk::raii::Buffer> m_materialBuffers;
-    std::vector<vk::raii::DeviceMemory> m_materialBuffersMemory;
-    std::vector<void*> m_materialBuffersMapped;
+    // Materials never change after loading, all frames read the same device-local buffer
+    vk::raii::Buffer m_materialBuffer = nullptr;
+    vk::raii::DeviceMemory m_materialBufferMemory = nullptr;
+
+    // Scene::materials with texture indices translated to texture table indices
+    std::vector<Material> m_gpuMaterials;
 
     std::vector<vk::raii::Buffer> m_pointLightBuffers;
     std::vector<vk::raii::DeviceMemory> m_pointLightBuffersMemory;
@@ -164,18 +262,62 @@ private:
     std::vector<vk::raii::Buffer> m_indirectDrawBuffers;
     std::vector<vk::raii::DeviceMemory> m_indirectDrawBuffersMemory;
     std::vector<void*> m_indirectDrawBuffersMapped;
+    std::uint32_t m_indirectDrawCapacity{0};
     std::uint32_t m_indirectDrawCount{0};
     std::uint32_t m_opaqueDrawCount{0};
     std::uint32_t m_transparentDrawCount{0};
+    std::uint32_t m_drawCallCount{0};
+    std::uint64_t m_visibleTriangleCount{0};
+    std::uint64_t m_tlasUpdateCount{0};
+
+    // Material permutations: pipeline per (feature bits, blend mode) and the pipeline each material draws with
+    std::vector<MaterialPipelineKey> m_materialPipelineKeys;
+    std::vector<std::uint32_t> m_materialPipelineIndices;
+    std::vector<std::vector<IndirectDrawRange>> m_drawRanges;
+
+    // Reused between rebuilds so bucketing the visible draws does not allocate every frame
+    std::vector<DrawIndexedIndirectCommand> m_visibleDraws;
+    std::vector<std::uint32_t> m_visibleDrawPipelines;
+
+    // Culling result of the static instance range, valid for m_staticCullViewProj
+    std::vector<DrawIndexedIndirectCommand> m_staticVisibleDraws;
+    std::vector<std::uint32_t> m_staticVisibleDrawPipelines;
+    std::uint32_t m_staticTransparentCount{0};
+    glm::mat4 m_staticCullViewProj{0.0f};
+    std::uint32_t m_staticCullPvsSegment{~0U};
+    bool m_staticCullValid{false};
+
+    // Potentially visible set (setPotentiallyVisibleSet), segments are decoded as the animation reaches them
+    static constexpr std::uint32_t NO_PVS_SEGMENT = ~0U;
+    const PotentiallyVisibleSet* m_pvs{nullptr};
+    std::vector<std::uint32_t> m_pvsInstances;  // Decoded static instances of m_pvsDecodedSegment
+    std::uint32_t m_pvsDecodedSegment{NO_PVS_SEGMENT};
+
+    TextureStreamer* m_textureStreamer{nullptr};
+    const ProbeVolume* m_probeVolume{nullptr};
+    std::vector<std::uint32_t> m_pipelineDrawCounts;
     
     std::vector<glm::mat4> m_cachedCameraViewProj;
+    std::vector<std::uint32_t> m_cachedPvsSegments;
     std::vector<bool> m_indirectDrawBuffersInitialized;
+
+    // Generation each frame slot's copy last received from the scene, so only changed elements are uploaded.
+    // The indirect draws and the TLAS instances follow instanceGenerations as well (rebuild / refit on change)
+    VersionedBuffer m_instanceVersions;
+    VersionedBuffer m_pointLightVersions;
+    VersionedBuffer m_spotLightVersions;
+    VersionedBuffer m_blasInstanceVersions;
+    VersionedBuffer m_indirectDrawVersions;
     
     // TAA: Previous frame matrices for velocity calculation (per-frame to handle multiple frames in flight)
     // Each frame index stores its own previous matrices to avoid cross-frame interference
     std::vector<glm::mat4> m_prevViewMatrices;
     std::vector<glm::mat4> m_prevProjMatrices;
     std::vector<bool> m_frameInitialized;
+    vk::Extent2D m_renderExtent{
+        .width = static_cast<std::uint32_t>(WINDOW_WIDTH),
+        .height = static_cast<std::uint32_t>(WINDOW_HEIGHT),
+    };
 
     std::vector<vk::AccelerationStructureInstanceKHR> m_blasInstances;
 
@@ -183,7 +325,8 @@ private:
     // With multiple frames in flight, sharing these can cause GPU races and VK_ERROR_DEVICE_LOST.
     std::vector<vk::raii::Buffer> m_blasInstancesBuffers;
     std::vector<vk::raii::DeviceMemory> m_blasInstancesMemories;
-    std::vector<void*> m_blasInstancesBuffersMapped;
+    std::vector<void*> m_blasInstancesBuffersMapped;  // Only mapped when the staging ring writes in place
+    std::vector<bool> m_tlasUpdatePending;            // Instance transforms staged for this frame, refit the TLAS
 
     std::vector<vk::raii::Buffer> m_blasBuffers;
     std::vector<vk::raii::DeviceMemory> m_blasMemories;
@@ -208,12 +351,20 @@ private:
     void createUVBuffer(const Scene& scene);
     void createMaterialBuffers(const Scene& scene);
     void createLightBuffers(const Scene& scene);
+    void assignMaterialPipelines(const Scene& scene);
     void createIndirectDrawBuffers(const Scene& scene);
     void createTextureImages(const Scene& scene);
     void createSkyboxImage(const Scene& scene);
+    void createProbeVolumeImages();
+    void createTextureTable(const Scene& scene);
+    void growTextureTable(std::uint32_t minCapacity);
+    void registerTextures(const std::vector<AllocatedTextureImage>& textureImages,
+                          const vk::raii::Sampler& sampler,
+                          std::vector<std::int32_t>& outIndices);
+    void releaseRetiredTextureTables();
 
     void createGlobalDescriptorSets(const Scene& scene);
-    void createMaterialDescriptorSets(const Scene& scene);
+    void writeMaterialDescriptorSet();
     void createLightingDescriptorSets(const Scene& scene);
     void createAccelerationStructures(const Scene& scene);
     void createBLAS(const Scene& scene);
@@ -221,9 +372,11 @@ private:
     void createTLAS();
 
     void updateUniformBuffer(const Scene& scene, float time, std::uint32_t frameIdx, glm::vec2 jitterOffset);
-    void updateTopLevelAccelerationStructures(const Scene& scene, bool initialBuild, std::uint32_t frameIdx);
+    void updateBlasInstances(const Scene& scene, std::uint32_t frameIdx);
     void updateInstanceBuffers(const Scene& scene, std::uint32_t frameIdx);
-    void updateMaterialBuffers(const Scene& scene, std::uint32_t frameIdx);
+    void remapMaterialTextures(const Scene& scene);
     void updateLightBuffers(const Scene& scene, std::uint32_t frameIdx);
-    void updateIndirectDrawBuffers(const Scene& scene, std::uint32_t frameIdx);
+    void updateIndirectDrawBuffers(const Scene& scene, float time, std::uint32_t frameIdx);
+    void rebuildIndirectDrawCommands(const Scene& scene, const glm::mat4& viewProj, std::uint32_t pvsSegment,
+                                     std::uint32_t frameIdx);
 };
@@ -7,6 +7,7 @@
 
 #include "SharedTypes.hpp"
 #include "FrustumCulling.hpp"
+#include "VersionedBuffer.hpp"
 
 struct CameraParameters {
     float yfov;
@@ -90,7 +91,18 @@ struct Scene {
     // Each node with a mesh may have multiple instances (one per primitive)
     std::vector<std::int32_t> nodeToInstanceIndex;
 
+    // Instances are partitioned by the loader: [0, firstDynamicInstance) are static, the animated ones follow
+    // contiguously. dynamicInstanceNodes holds the glTF node of each animated instance, in the same order
+    std::uint32_t firstDynamicInstance{0};
+    std::vector<std::int32_t> dynamicInstanceNodes;
+
     // For indirect drawing: track which instances use which mesh
     // Key: meshIndex, Value: vector of instance indices
     std::vector<std::vector<std::uint32_t>> meshToInstanceIndices;
+
+    // Change generations of the arrays mirrored on the GPU every frame. Reset by the loader,
+    // anything that modifies an element afterwards (the animator) must mark it changed
+    GenerationTracker instanceGenerations;
+    GenerationTracker pointLightGenerations;
+    GenerationTracker spotLightGenerations;
 };
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "Scene.hpp"
+
+class JobSystem;
+
+struct Ray {
+    glm::vec3 origin{0.0f};
+    float tMin = 0.0f;
+    glm::vec3 direction{0.0f, 0.0f, -1.0f};  // Need not be normalized, t is measured in its length
+    float tMax = std::numeric_limits<float>::infinity();
+    std::uint32_t mask = 0xFF;  // Instances whose SceneBvh::instanceMask() shares no bit are skipped, as in the ray queries
+};
+
+struct RayHit {
+    static constexpr std::uint32_t NO_INSTANCE = std::numeric_limits<std::uint32_t>::max();
+
+    float t = std::numeric_limits<float>::infinity();
+    std::uint32_t instance = NO_INSTANCE;
+    std::uint32_t triangle = 0;    // Triangle of the instance's mesh, its indices start at indices[baseIndex + 3 * triangle]
+    glm::vec2 barycentrics{0.0f};  // Weights of the triangle's second and third vertex
+
+    [[nodiscard]] auto hit() const -> bool { return instance != NO_INSTANCE; }
+};
+
+// CPU ray casting over the scene geometry, for work that cannot (or should not) go through the GPU ray queries:
+// free camera picking, and baking on machines without ray tracing hardware.
+//
+// Two levels like the GPU acceleration structures: one BVH per mesh over its triangles, built in parallel at
+// construction, and one over the instances, rebuilt by updateInstances() when they move. Both are split with
+// binned SAH and then collapsed into 4-wide nodes, whose child bounds are stored per axis so one ray tests all
+// four children in a single (vectorizable) loop. Every triangle is opaque and double sided.
+class SceneBvh {
+public:
+    // scene must not change its meshes or geometry while the BVH is in use
+    SceneBvh(const Scene& scene, JobSystem& jobSystem);
+
+    // Rebuilds the instance level from the current instance transforms. Only the first instanceCount instances
+    // are included (e.g. scene.firstDynamicInstance for the static city alone).
+    void updateInstances(const Scene& scene,
+                         std::uint32_t instanceCount = std::numeric_limits<std::uint32_t>::max());
+
+    // Closest hit in [tMin, tMax]
+    [[nodiscard]] auto castRay(const Ray& ray) const -> RayHit;
+
+    // Whether anything is hit in [tMin, tMax], stops at the first hit
+    [[nodiscard]] auto occluded(const Ray& ray) const -> bool;
+
+    // Batches spread over the job system in chunks of BVH_RAYS_PER_JOB, results[i] belongs to rays[i]
+    void castRays(std::span<const Ray> rays, std::span<RayHit> hits) const;
+    void occludedRays(std::span<const Ray> rays, std::span<std::uint8_t> occluded) const;
+
+    // Ray mask (AS_*_OBJECT_MASK) of an instance, shared with the TLAS so both see the same instances
+    [[nodiscard]] static auto instanceMask(const Scene& scene, const Instance& instance) -> std::uint32_t;
+
+    [[nodiscard]] auto triangleCount() const -> std::size_t { return m_triangleCount; }
+
+    [[nodiscard]] auto nodeCount() const -> std::size_t { return m_meshNodeCount + m_instanceNodes.size(); }
+
+    // Four children; a lane is a leaf when count > 0 (first = its first primitive), an inner node when
+    // count = 0 (first = node index), and empty when its bounds lie at infinity
+    struct alignas(64) WideNode {
+        std::array<float, 4> minX, minY, minZ;
+        std::array<float, 4> maxX, maxY, maxZ;
+        std::array<std::uint32_t, 4> first;
+        std::array<std::uint32_t, 4> count;
+    };
+
+private:
+    JobSystem& m_jobSystem;
+
+    // Precomputed for the Möller-Trumbore test
+    struct Triangle {
+        glm::vec3 v0;
+        glm::vec3 edge1;
+        glm::vec3 edge2;
+        std::uint32_t index;  // Triangle of the mesh
+    };
+
+    struct MeshBvh {
+        std::vector<WideNode> nodes;
+        std::vector<Triangle> triangles;  // In leaf order
+        glm::vec3 boundsMin{0.0f};
+        glm::vec3 boundsMax{0.0f};
+    };
+
+    std::vector<MeshBvh> m_meshes;
+    std::size_t m_triangleCount = 0;
+    std::size_t m_meshNodeCount = 0;
+
+    struct BvhInstance {
+        glm::mat4 worldToObject;
+        std::uint32_t instance;
+        std::uint32_t mesh;
+        std::uint32_t mask;
+    };
+
+    std::vector<WideNode> m_instanceNodes;
+    std::vector<BvhInstance> m_instances;  // In leaf order, only instances a ray can hit
+
+    template <bool AnyHit>
+    auto trace(const Ray& ray, RayHit& hit) const -> bool;
+};
@@ -0,0 +1,9 @@
+#pragma once
+
+#include <cstdint>
+
+#include "Scene.hpp"
+
+// FNV-1a over the meshes and transforms of the static instances [0, firstDynamicInstance). Baked data that
+// depends on the static city (--bake-probes, --bake-pvs) stores it and is rejected when the city changes.
+auto hashStaticScene(const Scene& scene) -> std::uint64_t;
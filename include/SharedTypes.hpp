@@ -1,6 +1,7 @@
 #pragma once
 
 #include <vector>
+#include <memory_resource>
 #include <cstdint>
 #include <vulkan/vulkan.hpp>
 #include <glm/ext/matrix_float4x4.hpp>
@@ -30,6 +31,30 @@ struct TAAPushConstant {
     float _padding;
 };
 
+struct HeatmapPushConstant {
+    float maxCount;
+};
+
+// PVS bake (pvs_visibility.comp.slang): one ray per pixel of a camera sample
+struct PvsBakePushConstant {
+    glm::mat4 inverseViewProjection;
+    glm::vec3 origin;
+    float maxDistance;
+    std::uint32_t width;
+    std::uint32_t height;
+    std::uint32_t firstWord;  // Start of the sample's segment bitset in the visibility buffer
+    std::uint32_t _padding;
+};
+
+// Frame totals of the ray counters (DebugCounterData.rayTotals, indexed by RAY_TOTAL_* in constants.slang).
+// 32-bit atomics on the GPU: they wrap past 2^32 per frame, far above what one frame traces.
+struct RayCounterTotals {
+    std::uint32_t shadowRays;
+    std::uint32_t reflectionRays;
+    std::uint32_t candidateIterations;
+    std::uint32_t tracingFragments;  // Fragments that traced at least one ray
+};
+
 struct alignas(16) Material {
     glm::vec4 baseColorFactor;
 
@@ -52,6 +77,54 @@ struct alignas(16) Material {
     std::int32_t padding1;
 };
 
+// Material feature bits, fed to the fragment shader as specialization constant 0 (mirrored in constants.slang).
+// Every feature a material lacks lets the compiler drop the corresponding branch and texture fetch.
+constexpr std::uint32_t MATERIAL_FEATURE_BASE_COLOR_TEXTURE = 1u << 0;
+constexpr std::uint32_t MATERIAL_FEATURE_METALLIC_ROUGHNESS_TEXTURE = 1u << 1;
+constexpr std::uint32_t MATERIAL_FEATURE_NORMAL_TEXTURE = 1u << 2;
+constexpr std::uint32_t MATERIAL_FEATURE_EMISSIVE_TEXTURE = 1u << 3;
+constexpr std::uint32_t MATERIAL_FEATURE_OCCLUSION_TEXTURE = 1u << 4;
+constexpr std::uint32_t MATERIAL_FEATURE_ALPHA_MASK = 1u << 5;
+constexpr std::uint32_t MATERIAL_FEATURE_RECEIVES_LIGHTING = 1u << 6;
+constexpr std::uint32_t MATERIAL_FEATURE_REFLECTIVE = 1u << 7;
+
+// Specialization value of the generic pipeline: every feature is decided at runtime from the material
+constexpr std::uint32_t MATERIAL_PERMUTATION_DYNAMIC = 0xFFFFFFFFu;
+
+inline auto getMaterialPermutation(const Material& material) -> std::uint32_t {
+    std::uint32_t permutation = 0;
+    if (material.baseColorTexIndex >= 0) permutation |= MATERIAL_FEATURE_BASE_COLOR_TEXTURE;
+    if (material.metallicRoughnessTexIndex >= 0) permutation |= MATERIAL_FEATURE_METALLIC_ROUGHNESS_TEXTURE;
+    if (material.normalTexIndex >= 0) permutation |= MATERIAL_FEATURE_NORMAL_TEXTURE;
+    if (material.emissiveTexIndex >= 0) permutation |= MATERIAL_FEATURE_EMISSIVE_TEXTURE;
+    if (material.occlusionTexIndex >= 0) permutation |= MATERIAL_FEATURE_OCCLUSION_TEXTURE;
+    if (material.alphaMode == 2) permutation |= MATERIAL_FEATURE_ALPHA_MASK;
+    if (material.receivesLighting != 0) permutation |= MATERIAL_FEATURE_RECEIVES_LIGHTING;
+    if (material.reflective != 0) permutation |= MATERIAL_FEATURE_REFLECTIVE;
+    return permutation;
+}
+
+// Per-pixel counters written by the scene pipelines, specialization constant 1 of the fragment shader
+// (mirrored in constants.slang)
+constexpr std::uint32_t DEBUG_COUNTERS_NONE = 0;
+constexpr std::uint32_t DEBUG_COUNTERS_FRAGMENTS = 1;
+constexpr std::uint32_t DEBUG_COUNTERS_RAYS = 2;
+
+// One graphics pipeline of the main pass: a material permutation in either the opaque or the blended variant
+struct MaterialPipelineKey {
+    std::uint32_t permutation;
+    bool transparent;
+
+    auto operator==(const MaterialPipelineKey&) const -> bool = default;
+};
+
+// Contiguous run of indirect draw commands that share one material pipeline
+struct IndirectDrawRange {
+    std::uint32_t pipelineIndex;  // Into ResourceManager::getMaterialPipelineKeys()
+    std::uint32_t firstCommand;
+    std::uint32_t commandCount;
+};
+
 struct Texture {
     vk::Format format;
     std::uint32_t mipLevels;
@@ -109,9 +182,10 @@ struct Vertex {
     }
 };
 
+// Vertex and index data of one primitive while loading, allocated from the loader's arena
 struct Geometry {
-    std::vector<Vertex> vertices;
-    std::vector<std::uint32_t> indices;
+    std::pmr::vector<Vertex> vertices;
+    std::pmr::vector<std::uint32_t> indices;
 };
 
 // padding confirmed, do not touch or it will break! ✅
@@ -191,5 +265,10 @@ struct alignas(16) UniformBufferObject {
     glm::vec3 fogColor;
     float fogDensity;
     glm::vec2 screenSize;    // TAA: Screen dimensions for velocity calculation
-    glm::vec2 _padding3;
+    std::uint32_t probeVolumeEnabled{0};  // 1 - indirect diffuse from the irradiance probes (--probes), 0 - sky only
+    float _padding3;
+    glm::vec3 probeVolumeScale{0.0f};     // Probe texture coordinate = world position * scale + bias
+    float _padding4;
+    glm::vec3 probeVolumeBias{0.0f};
+    float _padding5;
 };
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <vulkan/vulkan.hpp>
+#include <vulkan/vulkan_raii.hpp>
+
+class VulkanCore;
+class BufferManager;
+
+// Upload path for device-local buffers the CPU changes every frame (instances, lights, TLAS instances,
+// indirect draws).
+//
+// The CPU asks stage() for a pointer, writes only what changed into a host-visible staging buffer (one per
+// frame in flight), and recordUploads() turns the staged ranges into copyBuffer regions at the start of the
+// frame's command buffer. Adjacent ranges of the same buffer are merged into one region.
+//
+// On ReBAR and UMA devices, where all of VRAM is host visible, the destination buffers are allocated
+// host-visible device-local and stage() returns their persistent mapping instead, so nothing is copied.
+class StagingRing {
+public:
+    StagingRing(VulkanCore& vulkanCore, BufferManager& bufferManager);
+
+    // Memory properties for buffers updated through stage()
+    [[nodiscard]] auto getTargetMemoryProperties() const -> vk::MemoryPropertyFlags;
+
+    // True when destination buffers are written in place (ReBAR / UMA)
+    [[nodiscard]] auto isDirect() const -> bool { return m_direct; }
+
+    // (Re)creates the per-frame staging buffers. The capacity must cover the largest possible upload of one frame,
+    // maxStagesPerFrame bounds the stage() calls per frame: the bookkeeping is reserved for it up front and must
+    // not grow afterwards (asserted in debug builds)
+    void allocate(vk::DeviceSize capacityPerFrame, std::size_t maxStagesPerFrame);
+
+    // Starts collecting the uploads of a frame whose previous use of the slot has completed (fence waited)
+    void beginFrame(std::uint32_t frameIdx);
+
+    // Returns where to write `size` bytes that must end up at `dstOffset` in `dst`.
+    // dstMapped is the persistent mapping of dst, only used (and only required) in direct mode.
+    auto stage(vk::Buffer dst, void* dstMapped, vk::DeviceSize dstOffset, vk::DeviceSize size) -> void*;
+
+    // Records the staged copies of the current frame followed by a barrier that makes them visible to
+    // indirect draws, shaders and acceleration structure builds
+    void recordUploads(const vk::CommandBuffer& cmd);
+
+    [[nodiscard]] auto getLastUploadBytes() const -> vk::DeviceSize { return m_lastUploadBytes; }
+    [[nodiscard]] auto getLastCopyRegions() const -> std::uint32_t { return m_lastCopyRegions; }
+
+private:
+    VulkanCore& m_vulkanCore;
+    BufferManager& m_bufferManager;
+
+    bool m_direct = false;
+
+    std::vector<vk::raii::Buffer> m_stagingBuffers;
+    std::vector<vk::raii::DeviceMemory> m_stagingBuffersMemory;
+    std::vector<std::byte*> m_stagingBuffersMapped;
+    vk::DeviceSize m_capacity = 0;
+
+    std::uint32_t m_frameIdx = 0;
+    vk::DeviceSize m_cursor = 0;
+
+    struct PendingCopy {
+        vk::Buffer dst;
+        vk::BufferCopy region;
+    };
+
+    // Reused every frame, reserved in allocate()
+    std::vector<PendingCopy> m_pendingCopies;
+    std::vector<vk::BufferCopy> m_regionScratch;
+
+    vk::DeviceSize m_lastUploadBytes = 0;
+    std::uint32_t m_lastCopyRegions = 0;
+
+    void detectDirectWrites();
+};
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <initializer_list>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Records the startup phases (window, device, pipelines, scene load, ...) with the thread they ran on
+// and the phases they waited for, then reports the critical path: the chain of phases that actually
+// determined when the first frame could start.
+class StartupTimeline {
+public:
+    using PhaseId = std::size_t;
+
+    StartupTimeline();
+
+    // Thread safe; dependencies are phases whose results this phase needs
+    auto begin(std::string name, std::string thread, std::initializer_list<PhaseId> dependencies = {}) -> PhaseId;
+
+    void end(PhaseId phase);
+
+    // Times the phase for the lifetime of the scope
+    class Scope {
+    public:
+        Scope(StartupTimeline& timeline, std::string name, std::string thread,
+              std::initializer_list<PhaseId> dependencies = {});
+        ~Scope();
+
+        Scope(const Scope&) = delete;
+        auto operator=(const Scope&) -> Scope& = delete;
+
+        [[nodiscard]] auto id() const -> PhaseId { return m_phase; }
+
+    private:
+        StartupTimeline& m_timeline;
+        PhaseId m_phase;
+    };
+
+    void printReport() const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Phase {
+        std::string name;
+        std::string thread;
+        std::vector<PhaseId> dependencies;
+        Clock::time_point start;
+        Clock::time_point end;
+        bool finished = false;
+    };
+
+    Clock::time_point m_origin;
+    std::vector<Phase> m_phases;
+    mutable std::mutex m_mutex;
+
+    [[nodiscard]] auto criticalPath() const -> std::vector<PhaseId>;
+};
@@ -9,7 +9,14 @@ struct GLFWwindow;
 
 class SwapChain {
 public:
-    explicit SwapChain(VulkanCore& vulkanCore, GLFWwindow* window);
+    // A null window creates a headless "swapchain": a ring of HEADLESS_IMAGE_COUNT offscreen
+    // images of offscreenExtent that are handed out round-robin instead of being acquired/presented
+    SwapChain(VulkanCore& vulkanCore, GLFWwindow* window, vk::Extent2D offscreenExtent);
+
+    [[nodiscard]] auto isHeadless() const -> bool { return m_headless; }
+
+    // Headless only: index of the next offscreen image in the ring
+    auto nextOffscreenImage() -> std::uint32_t;
 
     [[nodiscard]] auto getImages() const -> const std::vector<vk::Image>& { return m_swapChainImages; }
     [[nodiscard]] auto getFormat() const -> vk::Format { return m_swapChainImageFormat; }
@@ -30,8 +37,16 @@ private:
     vk::Format m_swapChainImageFormat;
     vk::Extent2D m_swapChainExtent;
 
+    // Headless: backing storage for m_swapChainImages
+    bool m_headless = false;
+    std::uint32_t m_nextOffscreenImage = 0;
+    std::vector<vk::raii::Image> m_offscreenImages;
+    std::vector<vk::raii::DeviceMemory> m_offscreenImageMemories;
+
     void createSwapChain(GLFWwindow* window);
 
+    void createOffscreenImages(vk::Extent2D extent);
+
     void createImageViews();
 
     [[nodiscard]] auto chooseSurfaceFormat() const -> vk::SurfaceFormatKHR;
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <memory_resource>
+#include <vector>
+#include <tiny_gltf.h>
+
+#include "Scene.hpp"
+
+class TextureStreamer;
+
+// Decides which texture mips the camera will need and when (--stream-textures). The cinematic camera is sampled
+// ahead along its animation (Animator::sampleCamera) up to TEXTURE_PREFETCH_LOOKAHEAD_SECONDS; for every instance
+// in a sample's (slightly widened) frustum, the finest mip its textures will be sampled at is estimated from
+// the distance, the viewport height and the UV density of its mesh, and requested with the sample's time as
+// deadline. The free camera has no future, so only its current view is requested.
+//
+// Only textures are planned: the geometry is uploaded whole at load and shared by the BLAS, so it has nothing
+// to stream.
+class TexturePrefetchPlanner {
+public:
+    // Textures must have been added to streamer. viewportHeight is the rendered height in pixels.
+    TexturePrefetchPlanner(const Scene& scene, TextureStreamer& streamer, std::uint32_t viewportHeight);
+
+    // Requests along the path up to time + lookahead, a few camera samples per call so a frame stays cheap.
+    // followPath = false (free camera) only requests the scene's current camera. Temporaries come from memory.
+    void update(const tinygltf::Model& model, const Scene& scene, float time, bool followPath,
+                std::pmr::memory_resource& memory);
+
+    // Requests the whole lookahead window from time at once (startup, followed by TextureStreamer::flush())
+    void prime(const tinygltf::Model& model, const Scene& scene, float time, std::pmr::memory_resource& memory);
+
+private:
+    TextureStreamer& m_streamer;
+    float m_viewportHeight;
+
+    // Texture coordinates per object-space unit of each mesh, sqrt(uv area / surface area) over its triangles
+    std::vector<float> m_meshUvDensity;
+
+    // Streamed texture ids of each material (TextureStreamer::NOT_STREAMED where it has none)
+    std::vector<std::array<std::uint32_t, 4>> m_materialTextures;
+
+    // Finest mip of every streamed texture within one camera sample, reused between samples
+    std::vector<std::uint32_t> m_sampleMips;
+
+    // The path is requested up to here, the next samples continue after it
+    float m_plannedUntil = -1.0f;
+    float m_lastTime = 0.0f;
+
+    // Requests the mips a camera at its pose needs, due at time
+    void evaluate(const Scene& scene, const CameraParameters& camera, float time);
+};
@@ -0,0 +1,182 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <limits>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <vulkan/vulkan_raii.hpp>
+
+#include "MemoryTracker.hpp"
+#include "SharedTypes.hpp"
+#include "constants.hpp"
+
+class VulkanCore;
+class CommandManager;
+class BufferManager;
+class ImageManager;
+class JobSystem;
+struct AllocatedTextureImage;
+
+// Mip streaming of the material textures (--stream-textures). Every texture is allocated with its full mip
+// chain, but only the levels up to TEXTURE_STREAMING_RESIDENT_SIZE are uploaded at load. Levels finer than
+// the resident one hold upsampled copies of it, so the image views and the bindless table never change and
+// a texture that is not there yet is blurry rather than missing.
+//
+// Requests (from TexturePrefetchPlanner) name a texture, the finest level it will need and the animation time
+// it will be needed at. Textures are refined one level at a time, earliest deadline first: a streaming thread
+// box-filters the next level from the CPU image, and the frame uploads at most TEXTURE_STREAMING_UPLOAD_BUDGET
+// bytes through its own staging buffer. A level that fits the frame's budget is copied into the image at
+// once. A larger one is gathered in row bands in a device-local assembly buffer over several frames and
+// copied into the image after its last band, so a sampled level never mixes new and placeholder rows. Once
+// a level is complete, the finer placeholder levels are blitted from it. Levels are never evicted.
+class TextureStreamer {
+public:
+    static constexpr std::uint32_t NOT_STREAMED = std::numeric_limits<std::uint32_t>::max();
+
+    TextureStreamer(VulkanCore& vulkanCore,
+                    CommandManager& commandManager,
+                    BufferManager& bufferManager,
+                    ImageManager& imageManager,
+                    JobSystem& jobSystem);  // Filters the resident tails and primed levels at load
+
+    ~TextureStreamer();
+
+    TextureStreamer(const TextureStreamer&) = delete;
+    auto operator=(const TextureStreamer&) -> TextureStreamer& = delete;
+
+    // Creates the images of a scene texture array with only their resident tail uploaded. textures must
+    // outlive the streamer, later levels are filtered from it.
+    void addTextures(MemoryCategory category, const std::vector<Texture>& textures,
+                     std::vector<AllocatedTextureImage>& images);
+
+    // Streamed texture of textures[index] (an array passed to addTextures), NOT_STREAMED otherwise
+    [[nodiscard]] auto textureId(const std::vector<Texture>& textures, std::size_t index) const -> std::uint32_t;
+
+    [[nodiscard]] auto textureCount() const -> std::uint32_t { return static_cast<std::uint32_t>(m_textures.size()); }
+
+    // Largest side and mip count of a streamed texture
+    [[nodiscard]] auto textureSize(const std::uint32_t texture) const -> std::uint32_t {
+        return std::max(m_textures[texture].width, m_textures[texture].height);
+    }
+
+    [[nodiscard]] auto textureMipLevels(const std::uint32_t texture) const -> std::uint32_t {
+        return m_textures[texture].mipLevels;
+    }
+
+    // Level mip of texture will be sampled at animation time
+    void request(std::uint32_t texture, std::uint32_t mip, float time);
+
+    // Uploads everything requested so far before returning (startup, before the first frame)
+    void flush();
+
+    // The frame slot's previous use has completed (fence waited). Fills its staging buffer with the next
+    // bands, time is the frame's animation time, for the late counters.
+    void beginFrame(std::uint32_t frameIdx, float time);
+
+    // Records the copies staged by beginFrame() and the blits of completed levels
+    void recordUploads(const vk::CommandBuffer& cmd);
+
+    void printReport() const;
+
+private:
+    VulkanCore& m_vulkanCore;
+    CommandManager& m_commandManager;
+    BufferManager& m_bufferManager;
+    ImageManager& m_imageManager;
+    JobSystem& m_jobSystem;
+
+    struct StreamedTexture {
+        const Texture* source = nullptr;  // Level 0 on the CPU
+        vk::Image image;
+        std::uint32_t width = 0;
+        std::uint32_t height = 0;
+        std::uint32_t mipLevels = 1;
+        std::uint32_t bytesPerPixel = 4;
+        std::uint32_t residentMip = 0;  // Finest level holding its own texels
+        std::uint32_t targetMip = 0;    // Finest level requested so far
+        float deadline = 0.0f;          // When targetMip is needed
+        bool inFlight = false;          // A level of it is being prepared or uploaded
+    };
+
+    std::vector<StreamedTexture> m_textures;
+
+    // Arrays passed to addTextures() and the id of their first texture
+    struct TextureArray {
+        const std::vector<Texture>* textures;
+        std::uint32_t firstId;
+    };
+
+    std::vector<TextureArray> m_arrays;
+
+    // A level filtered on the streaming thread, then uploaded band by band
+    struct PreparedLevel {
+        enum class State : std::uint8_t { Free, Queued, Ready, Uploading };
+
+        std::atomic<State> state{State::Free};
+        std::uint32_t texture = 0;
+        std::uint32_t level = 0;
+        std::uint32_t nextRow = 0;
+        std::vector<std::uint8_t> pixels;  // Grows to the largest level it held, reused afterwards
+    };
+
+    std::array<PreparedLevel, TEXTURE_STREAMING_PREPARED_LEVELS> m_prepared;
+
+    std::thread m_thread;
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    bool m_stopping = false;
+
+    std::vector<vk::raii::Buffer> m_stagingBuffers;
+    std::vector<vk::raii::DeviceMemory> m_stagingBuffersMemory;
+    std::vector<std::uint8_t*> m_stagingBuffersMapped;
+    std::uint32_t m_frameIdx = 0;
+
+    // Staged by beginFrame(), recorded by recordUploads()
+    struct PendingBand {
+        std::uint32_t texture;
+        std::uint32_t level;
+        std::uint32_t firstRow;
+        std::uint32_t rowCount;
+        vk::DeviceSize bufferOffset;
+        bool completesLevel;
+        bool assembled;  // Goes through the assembly buffer rather than straight into the image
+    };
+
+    std::vector<PendingBand> m_pendingBands;
+
+    // One level larger than what is left of a frame's budget at a time, sized for the largest streamed level
+    static constexpr std::size_t NO_PREPARED_LEVEL = std::numeric_limits<std::size_t>::max();
+    vk::raii::Buffer m_assemblyBuffer{nullptr};
+    vk::raii::DeviceMemory m_assemblyMemory{nullptr};
+    vk::DeviceSize m_assemblyBytes = 0;
+    std::size_t m_assembling = NO_PREPARED_LEVEL;  // Index into m_prepared
+
+    std::uint64_t m_uploadedLevels = 0;
+    std::uint64_t m_uploadedBytes = 0;
+    std::uint64_t m_lateFrames = 0;   // Frames where a texture was still coarser than needed
+    float m_maxLateness = 0.0f;       // Longest a texture was behind its deadline (animation seconds)
+
+    void threadLoop();
+
+    // Queues the next level of the most urgent textures on the streaming thread
+    void scheduleLevels();
+
+    [[nodiscard]] static auto levelBytes(const StreamedTexture& texture, std::uint32_t level) -> vk::DeviceSize;
+
+    // Box-filters level of texture from the CPU image into out
+    static void filterLevel(const StreamedTexture& texture, std::uint32_t level, std::uint8_t* out);
+
+    static void recordLevelBarrier(const vk::CommandBuffer& cmd, vk::Image image, std::uint32_t baseLevel,
+                                   std::uint32_t levelCount, vk::ImageLayout oldLayout, vk::ImageLayout newLayout);
+
+    // Level was just written (TransferDst). Rebuilds the levels between it and oldResident by downsampling and
+    // the finer ones by upsampling it, then returns every level in [0, oldResident) to ShaderReadOnly.
+    // otherLayout is the current layout of those other levels.
+    static void recordResidencyChange(const vk::CommandBuffer& cmd, const StreamedTexture& texture, std::uint32_t level,
+                                      std::uint32_t oldResident, vk::ImageLayout otherLayout);
+};
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+#include "constants.hpp"
+
+// Change generations of a CPU-side array that is mirrored into GPU buffers (Scene::instances, lights, ...).
+//
+// Whoever writes an element calls markChanged(), which stamps it with a new generation. The GPU copies remember
+// the generation they last received (VersionedBuffer below) and only pull the elements stamped after it.
+class GenerationTracker {
+public:
+    // The array was (re)filled with `elementCount` elements: all of them count as changed.
+    // Elements before `firstMutable` are not expected to change afterwards and are skipped when scanning
+    void reset(const std::size_t elementCount, const std::size_t firstMutable = 0) {
+        m_current++;
+        m_resetGeneration = m_current;
+        m_firstMutable = std::min(firstMutable, elementCount);
+        m_generations.assign(elementCount, m_current);
+    }
+
+    void markChanged(const std::size_t index) {
+        m_generations[index] = ++m_current;
+        m_firstMutable = std::min(m_firstMutable, index);
+    }
+
+    void markAllChanged() {
+        m_current++;
+        m_firstMutable = 0;
+        std::fill(m_generations.begin(), m_generations.end(), m_current);
+    }
+
+    [[nodiscard]] auto current() const -> std::uint64_t { return m_current; }
+    [[nodiscard]] auto size() const -> std::size_t { return m_generations.size(); }
+
+    // Calls writeRange(first, count) for every run of consecutive elements changed after generation `since`
+    template <typename WriteRange>
+    void forEachChangedRange(const std::uint64_t since, WriteRange&& writeRange) const {
+        const std::size_t count = m_generations.size();
+
+        // A copy older than the last reset has not seen the immutable part either
+        if (since < m_resetGeneration) {
+            if (count > 0) {
+                writeRange(std::size_t{0}, count);
+            }
+            return;
+        }
+
+        std::size_t i = m_firstMutable;
+        while (i < count) {
+            if (m_generations[i] <= since) {
+                i++;
+                continue;
+            }
+
+            const std::size_t first = i;
+            while (i < count && m_generations[i] > since) {
+                i++;
+            }
+            writeRange(first, i - first);
+        }
+    }
+
+private:
+    // Never restarts, so generations handed out before a reset() are always older than the ones after it
+    std::uint64_t m_current = 0;
+    std::uint64_t m_resetGeneration = 0;
+    std::size_t m_firstMutable = 0;
+    std::vector<std::uint64_t> m_generations;
+};
+
+// Per-frame-in-flight view of a GenerationTracker: each frame slot owns its own GPU copy of the array and
+// remembers the generation that copy last received, so a change reaches every slot exactly once.
+class VersionedBuffer {
+public:
+    // The GPU copies were just created from the current contents of source
+    void reset(const GenerationTracker& source) {
+        m_elementCount = source.size();
+        m_received.fill(source.current());
+    }
+
+    [[nodiscard]] auto isStale(const GenerationTracker& source, const std::uint32_t frameIdx) const -> bool {
+        return m_received[frameIdx] != source.current();
+    }
+
+    void markSynced(const GenerationTracker& source, const std::uint32_t frameIdx) {
+        m_received[frameIdx] = source.current();
+    }
+
+    // Calls writeRange(first, count) for every run of elements the frame's copy has not received yet.
+    // Returns whether anything was written.
+    template <typename WriteRange>
+    auto sync(const GenerationTracker& source, const std::uint32_t frameIdx, WriteRange&& writeRange) -> bool {
+        if (!isStale(source, frameIdx)) {
+            return false;
+        }
+        if (source.size() != m_elementCount) {
+            throw std::runtime_error("versioned buffer is out of sync with its source, reallocate the scene resources!");
+        }
+
+        bool written = false;
+        source.forEachChangedRange(m_received[frameIdx], [&](const std::size_t first, const std::size_t count) {
+            writeRange(first, count);
+            written = true;
+        });
+
+        markSynced(source, frameIdx);
+        return written;
+    }
+
+private:
+    std::size_t m_elementCount = 0;
+    std::array<std::uint64_t, MAX_FRAMES_IN_FLIGHT> m_received{};
+};
@@ -2,10 +2,13 @@
 
 #include <optional>
 #include <cstdint>
+#include <memory>
 #include <vector>
 #include <vulkan/vulkan.hpp>
 #include <vulkan/vulkan_raii.hpp>
 
+#include "MemoryTracker.hpp"
+
 struct GLFWwindow;
 
 struct QueueFamilyIndices {
@@ -22,6 +25,8 @@ struct QueueFamilyIndices {
 
 class VulkanCore {
 public:
+    // Pass a null window for headless rendering: no surface is created and the
+    // swapchain extension is not required, present queue aliases the graphics queue
     explicit VulkanCore(GLFWwindow* window);
 
     static std::uint32_t version() { return VK_API_VERSION_1_4; }
@@ -32,6 +37,12 @@ public:
     QueueFamilyIndices queueFamilyIndices() const { return m_queueFamilyIndices; }
     vk::raii::Queue& graphicsQueue() { return m_graphicsQueue; }
     vk::raii::Queue& presentQueue() { return m_presentQueue; }
+    bool isHeadless() const { return m_headless; }
+    // Optional feature, enabled when the device has it (GpuProfiler pipeline statistics)
+    bool supportsPipelineStatistics() const { return m_pipelineStatisticsSupported; }
+    // Optional extension, MemoryTracker reports heap budgets when it is present
+    bool supportsMemoryBudget() const { return m_memoryBudgetSupported; }
+    MemoryTracker& memoryTracker() const { return *m_memoryTracker; }
 
     auto findSupportedFormat(
         const std::vector<vk::Format>& candidates,
@@ -67,7 +78,7 @@ private:
         const QueueFamilyIndices& queueFamilyIndices) -> std::vector<
         vk::DeviceQueueCreateInfo>;
 
-    static auto buildFeatureChain() -> vk::StructureChain<
+    auto buildFeatureChain() const -> vk::StructureChain<
         vk::PhysicalDeviceFeatures2,
         vk::PhysicalDeviceVulkan13Features,
         vk::PhysicalDeviceVulkan12Features,
@@ -77,6 +88,11 @@ private:
         vk::PhysicalDeviceClusterAccelerationStructureFeaturesNV,
         vk::PhysicalDeviceRayQueryFeaturesKHR>;
 
+    bool m_headless = false;
+    bool m_pipelineStatisticsSupported = false;
+    bool m_memoryBudgetSupported = false;
+    std::vector<const char*> m_deviceExtensions;
+
     vk::raii::Context m_context;
     vk::raii::Instance m_instance = nullptr;
     vk::raii::DebugUtilsMessengerEXT m_debugMessenger = nullptr;
@@ -86,4 +102,5 @@ private:
     vk::raii::Queue m_graphicsQueue = nullptr;
     vk::raii::Queue m_presentQueue = nullptr;
     vk::raii::Device m_device = nullptr;
+    std::unique_ptr<MemoryTracker> m_memoryTracker;
 };
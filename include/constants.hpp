@@ -14,13 +14,111 @@ constexpr const char* WINDOW_TITLE = "Cyberpunk City Demo";
 
 constexpr std::uint32_t MAX_FRAMES_IN_FLIGHT = 2;
 constexpr std::uint32_t MAX_SCENE_OBJECTS = 100;
-constexpr std::size_t MAX_TEXTURES_PER_TYPE = 1024;
+
+// Bindless texture table (all material textures in one array, shared by every frame in flight)
+constexpr std::uint32_t TEXTURE_TABLE_MAX_SIZE = 16384;         // Upper bound of the variable-count binding, mirrored in constants.slang
+constexpr std::uint32_t TEXTURE_TABLE_INITIAL_CAPACITY = 256;   // Descriptors allocated up front, doubled whenever the table fills up
 
 static constexpr auto PREFERRED_COLOR_FORMAT = vk::Format::eB8G8R8A8Srgb;
 static constexpr auto PREFERRED_COLOR_SPACE = vk::ColorSpaceKHR::eSrgbNonlinear;
 static constexpr auto PREFERRED_PRESENTATION_MODE = vk::PresentModeKHR::eMailbox;
 static constexpr auto PREFERRED_IMAGE_COUNT = 3U;
 
+// Headless (offscreen) rendering
+static constexpr auto HEADLESS_IMAGE_COUNT = PREFERRED_IMAGE_COUNT; // Offscreen ring size, must be >= MAX_FRAMES_IN_FLIGHT
+constexpr std::uint32_t HEADLESS_DEFAULT_FRAME_COUNT = 600;          // Frames rendered when --frames is not given
+
+// Offline export (--export): finished frames are read back through a host buffer ring and encoded on workers
+constexpr std::uint32_t EXPORT_MAX_ENCODERS = 6;             // Readback buffers beyond MAX_FRAMES_IN_FLIGHT, one per frame being encoded
+constexpr std::uint32_t EXPORT_MAX_SUPERSAMPLE = 4;          // --export-supersample renders at up to 4x4 the output size
+constexpr int EXPORT_PNG_COMPRESSION_LEVEL = 2;              // stb_image_write zlib level (its default is 8), lower encodes faster
+
+// Parallel export (--export-workers): the frame range is split into chunks rendered by worker processes
+constexpr std::uint32_t EXPORT_CHUNKS_PER_WORKER = 4;        // Default chunk size: range / (workers x 4), smaller chunks balance better and retry less
+constexpr std::uint32_t EXPORT_CHUNK_MAX_ATTEMPTS = 3;       // Worker launches per chunk before its frames are reported missing
+constexpr double EXPORT_PROGRESS_INTERVAL_SECONDS = 5.0;     // Time between the coordinator's progress lines
+
+// GPU timestamp profiler
+constexpr bool GPU_PROFILER_ENABLED = true;                  // Timestamp queries around every render pass
+constexpr bool GPU_PROFILER_CONSOLE_OUTPUT = false;          // Print rolling pass averages with the FPS line
+constexpr std::uint32_t GPU_PROFILER_HISTORY_LENGTH = 120;   // Frames in the rolling average window
+
+// Debug views (--overdraw, --ray-counters, --ray-candidates): per-pixel counters shown as a heatmap instead of the scene
+static constexpr vk::Format DEBUG_COUNTER_FORMAT = vk::Format::eR32Uint;  // Atomic counter per pixel, mirrored in the shaders
+constexpr float OVERDRAW_HEATMAP_MAX_COUNT = 8.0f;                         // Fragments per pixel at the hot end of the ramp
+constexpr float RAY_COUNT_HEATMAP_MAX_COUNT = 16.0f;                       // Shadow + reflection rays per pixel
+constexpr float RAY_CANDIDATE_HEATMAP_MAX_COUNT = 32.0f;                   // Ray query Proceed() trips per pixel
+
+// Benchmark mode
+constexpr std::uint32_t BENCHMARK_DEFAULT_FRAME_COUNT = 1800; // 30s of camera path at the default 1/60 step
+
+// Hitch detector (--hitch-threshold): traces of the frames around a frame that took a multiple of the running median
+constexpr std::uint32_t HITCH_HISTORY_FRAMES = 120;          // Median window and frames written per trace
+constexpr std::uint32_t HITCH_MIN_FRAMES = 30;               // Frames to fill the window before anything counts as a hitch
+constexpr double HITCH_MIN_FRAME_MS = 10.0;                  // Shorter frames are never hitches, whatever the median
+constexpr std::uint32_t HITCH_COOLDOWN_FRAMES = 120;         // Hitches this soon after a trace are only logged
+constexpr std::uint32_t HITCH_MAX_TRACES = 32;               // Traces written per run
+
+// Live metrics (--live-metrics): latest frame published to shared memory, see LiveMetrics.hpp
+constexpr std::uint32_t LIVE_METRICS_BUDGET_INTERVAL = 60;   // Frames between VK_EXT_memory_budget queries
+
+// Potentially visible sets along the cinematic camera path (--bake-pvs, --pvs)
+constexpr float PVS_SEGMENT_SECONDS = 0.5f;                 // Animation time covered by one visible set
+constexpr std::uint32_t PVS_SAMPLES_PER_SEGMENT = 9;         // Camera samples per segment, both ends included (every 1/16 s)
+constexpr std::uint32_t PVS_BAKE_WIDTH = 960;                // Rays per sample row, the height follows the camera aspect
+constexpr float PVS_BAKE_FOV_SCALE = 1.1f;                   // Widened bake frustum, covers the camera between samples
+constexpr std::uint32_t PVS_BAKE_SEGMENTS_PER_SUBMIT = 16;   // Segments traced per queue submission
+
+// Texture streaming (--stream-textures): mip levels are uploaded ahead of the cinematic camera, see TextureStreamer.hpp
+constexpr std::uint32_t TEXTURE_STREAMING_RESIDENT_SIZE = 64;                // Largest side of the mip every texture starts with
+constexpr vk::DeviceSize TEXTURE_STREAMING_UPLOAD_BUDGET = 8 * 1024 * 1024;  // Texel bytes uploaded per frame
+constexpr vk::DeviceSize TEXTURE_STREAMING_PRIME_BATCH = 64 * 1024 * 1024;   // Texel bytes per submission while priming
+constexpr std::uint32_t TEXTURE_STREAMING_PREPARED_LEVELS = 4;               // Mip levels filtered ahead on the streaming thread
+constexpr float TEXTURE_PREFETCH_LOOKAHEAD_SECONDS = 4.0f;   // Animation time the planner looks ahead of the camera
+constexpr float TEXTURE_PREFETCH_STEP_SECONDS = 0.125f;      // Camera samples along the lookahead
+constexpr std::uint32_t TEXTURE_PREFETCH_SAMPLES_PER_FRAME = 4;  // Bounds the planner's cost when the animation runs fast
+constexpr float TEXTURE_PREFETCH_FOV_SCALE = 1.15f;          // Widened sample frustum, covers the camera between samples
+
+// Ray masks of the TLAS instances (SceneBvh::instanceMask), as in shaders/common/constants.slang
+constexpr std::uint32_t AS_REFLECTIVE_OBJECT_MASK = 0x01;
+constexpr std::uint32_t AS_SHADOW_OBJECT_MASK = 0x02;
+
+// CPU ray casting (SceneBvh): two-level BVH over the scene geometry for picking and offline bakes
+constexpr std::uint32_t BVH_SAH_BINS = 16;                   // Centroid bins per axis evaluated at every split
+constexpr std::uint32_t BVH_MAX_LEAF_SIZE = 4;               // Triangles (or instances) a leaf may hold
+constexpr float BVH_NODE_COST = 1.0f;                        // SAH cost of a node visit relative to one primitive test
+constexpr std::uint32_t BVH_RAYS_PER_JOB = 64;               // Rays one job system item traces in SceneBvh::castRays()
+
+// Irradiance probe volume (--bake-probes, --probes): indirect diffuse baked on a grid over the static city
+constexpr float PROBE_GRID_SPACING = 4.0f;                   // World units between probes, widened on axes that exceed the cap
+constexpr std::uint32_t PROBE_GRID_MAX_RESOLUTION = 96;      // Probes per axis at most
+constexpr std::uint32_t PROBE_BAKE_SAMPLES = 256;            // Paths traced per probe (spherical Fibonacci directions)
+constexpr std::uint32_t PROBE_BAKE_BOUNCES = 2;              // Surface interactions per path after the first hit
+constexpr float PROBE_BAKE_RAY_OFFSET = 0.01f;               // Bounce rays start this far off the surface they leave
+constexpr float PROBE_BAKE_MAX_BACKFACE_FRACTION = 0.25f;    // More backface hits than this: the probe is inside geometry
+constexpr std::uint32_t PROBE_BAKE_PROBES_PER_JOB = 16;      // Probes one job system item bakes
+
+// Worker threads (startup loading, texture decode)
+constexpr std::uint32_t JOB_SYSTEM_MAX_WORKERS = 8;          // Upper bound, the pool uses hardware_concurrency - 1
+constexpr bool STARTUP_TIMELINE_OUTPUT = true;               // Print the startup critical path before the render loop
+
+// Persistent pipeline cache
+constexpr const char* PIPELINE_CACHE_DIRECTORY = "cache";   // Relative to the working directory, one file per device/driver
+
+// Per-frame scene buffers (device-local, CPU deltas go through a staging ring)
+constexpr bool UPLOAD_ALLOW_DIRECT_WRITES = true;                    // Write in place when all of VRAM is host visible (ReBAR/UMA)
+constexpr std::uint64_t UPLOAD_DIRECT_MIN_HEAP_SIZE = 256ULL << 20;  // Host-visible VRAM beyond the legacy 256 MiB BAR window means ReBAR
+constexpr std::uint64_t UPLOAD_STAGING_ALIGNMENT = 16;               // Offset alignment of staged ranges
+
+// Temporary memory (LinearArena blocks, grown to the high-water mark when a cycle overflows)
+constexpr std::size_t FRAME_ARENA_INITIAL_SIZE = 1 << 20;             // Per-frame temporaries (animation), reset every frame
+constexpr std::size_t LOADER_ARENA_INITIAL_SIZE = 32 << 20;           // Load-time temporaries (primitive geometry), freed after loading
+constexpr std::uint32_t BENCHMARK_ALLOCATION_GRACE_FRAMES = 8;        // Frames allowed to allocate (arena growth) before steady state
+
+// Material pipeline permutations (specialization constants per material feature set)
+constexpr bool MATERIAL_PERMUTATIONS_ENABLED = true;         // false: every material uses the generic uber shader
+constexpr std::uint32_t MAX_MATERIAL_PIPELINES = 64;         // Rarer permutations beyond this fall back to the uber shader
+
 constexpr std::size_t POST_PROCESSING_BLUR_STAGES = 2; // should be 2
 static constexpr std::uint32_t POST_PROCESSING_BLUR_PASSES = 4; // More passes = stronger, smoother blur (reduced from 3 with better kernel)
 static constexpr vk::Format POST_PROCESSING_IMAGE_FORMAT = vk::Format::eR16G16B16A16Sfloat;
@@ -29,6 +127,7 @@ static constexpr vk::Format POST_PROCESSING_IMAGE_FORMAT = vk::Format::eR16G16B1
 constexpr bool TAA_ENABLED = false;  // Enable TAA (disables MSAA when true)
 constexpr float TAA_BLEND_FACTOR = 0.2f;  // α: 0.2 = 80% history, 20% current (was 0.1 - increased for faster response)
 constexpr std::uint32_t TAA_JITTER_SEQUENCE_LENGTH = 16;  // Halton sequence length beforel repeat
+constexpr std::uint32_t TAA_EXPORT_PREROLL_FRAMES = TAA_ENABLED ? 16 : 0;  // Discarded frames before a mid-sequence export chunk, lets the history converge
 static constexpr vk::Format VELOCITY_BUFFER_FORMAT = vk::Format::eR16G16Sfloat;  // RG16F for motion vectors
 
 constexpr float GLTF_DIRECTIONAL_LIGHT_INTENSITY_CONVERSION_FACTOR = 50000.0;
@@ -0,0 +1,105 @@
+#include <algorithm>
+#include <cstdlib>
+#include <new>
+
+#include "AllocationCounter.hpp"
+
+namespace {
+thread_local std::uint64_t t_allocations = 0;
+} // namespace
+
+auto AllocationCounter::threadAllocations() -> std::uint64_t {
+    return t_allocations;
+}
+
+#if ALLOCATION_COUNTER_ENABLED
+
+namespace {
+auto countedAllocate(std::size_t size) -> void* {
+    t_allocations++;
+    if (size == 0) {
+        size = 1;
+    }
+    return std::malloc(size);
+}
+
+auto countedAllocateAligned(std::size_t size, const std::align_val_t alignment) -> void* {
+    t_allocations++;
+    const auto align = static_cast<std::size_t>(alignment);
+    // aligned_alloc wants a multiple of the alignment
+    size = (std::max<std::size_t>(size, 1) + align - 1) & ~(align - 1);
+#ifdef _WIN32
+    return _aligned_malloc(size, align);
+#else
+    return std::aligned_alloc(align, size);
+#endif
+}
+
+void freeAligned(void* p) {
+#ifdef _WIN32
+    _aligned_free(p);
+#else
+    std::free(p);
+#endif
+}
+} // namespace
+
+auto operator new(const std::size_t size) -> void* {
+    if (void* p = countedAllocate(size)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+auto operator new[](const std::size_t size) -> void* {
+    if (void* p = countedAllocate(size)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+auto operator new(const std::size_t size, const std::nothrow_t&) noexcept -> void* {
+    return countedAllocate(size);
+}
+
+auto operator new[](const std::size_t size, const std::nothrow_t&) noexcept -> void* {
+    return countedAllocate(size);
+}
+
+auto operator new(const std::size_t size, const std::align_val_t alignment) -> void* {
+    if (void* p = countedAllocateAligned(size, alignment)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+auto operator new[](const std::size_t size, const std::align_val_t alignment) -> void* {
+    if (void* p = countedAllocateAligned(size, alignment)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+auto operator new(const std::size_t size, const std::align_val_t alignment, const std::nothrow_t&) noexcept -> void* {
+    return countedAllocateAligned(size, alignment);
+}
+
+auto operator new[](const std::size_t size, const std::align_val_t alignment, const std::nothrow_t&) noexcept -> void* {
+    return countedAllocateAligned(size, alignment);
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { std::free(p); }
+
+void operator delete(void* p, std::align_val_t) noexcept { freeAligned(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { freeAligned(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { freeAligned(p); }
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept { freeAligned(p); }
+void operator delete(void* p, std::align_val_t, const std::nothrow_t&) noexcept { freeAligned(p); }
+void operator delete[](void* p, std::align_val_t, const std::nothrow_t&) noexcept { freeAligned(p); }
+
+#endif
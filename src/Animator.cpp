@@ -1,5 +1,6 @@
 #include <algorithm>
 #include <cmath>
+#include <cstring>
 #include <iostream>
 
 #include <glm/gtc/quaternion.hpp>
@@ -7,6 +8,7 @@
 
 #include "Animator.hpp"
 #include "constants.hpp"
+#include "CpuProfiler.hpp"
 
 namespace {
 inline void decomposeTRS(const glm::mat4& M, glm::vec3& T, glm::quat& R, glm::vec3& S) {
@@ -171,8 +173,8 @@ inline glm::quat sampleQuat(const tinygltf::AnimationSampler& samp, const tinygl
 void computeNodeWorldMatrixAnimated(const tinygltf::Model& model,
                                     const int nodeIndex,
                                     const glm::mat4& parentMatrix,
-                                    const std::vector<glm::mat4>& localMatrices,
-                                    std::vector<glm::mat4>& outMatrices) {
+                                    const std::pmr::vector<glm::mat4>& localMatrices,
+                                    std::pmr::vector<glm::mat4>& outMatrices) {
     const auto& node = model.nodes[nodeIndex];
 
     const glm::mat4 local = localMatrices[static_cast<std::size_t>(nodeIndex)];
@@ -185,9 +187,41 @@ void computeNodeWorldMatrixAnimated(const tinygltf::Model& model,
     }
 }
 
+// Static transform of a node, before animation
+void restPose(const tinygltf::Node& node, glm::vec3& T, glm::quat& R, glm::vec3& S) {
+    T = glm::vec3(0.0f);
+    R = glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
+    S = glm::vec3(1.0f);
+
+    // Match GLTFLoader behavior: matrix takes precedence over TRS
+    if (node.matrix.size() == 16) {
+        // Node has explicit matrix - decompose it
+        glm::mat4 M = glm::make_mat4x4(node.matrix.data());
+        decomposeTRS(M, T, R, S);
+    } else {
+        // Node uses TRS components
+        if (node.translation.size() == 3) {
+            T = glm::vec3(node.translation[0], node.translation[1], node.translation[2]);
+        }
+        if (node.rotation.size() == 4) {
+            R = glm::quat(
+                static_cast<float>(node.rotation[3]), // w
+                static_cast<float>(node.rotation[0]), // x
+                static_cast<float>(node.rotation[1]), // y
+                static_cast<float>(node.rotation[2])  // z
+            );
+        }
+        if (node.scale.size() == 3) {
+            S = glm::vec3(node.scale[0], node.scale[1], node.scale[2]);
+        }
+    }
+
+    R = glm::normalize(R);
+}
+
 // Find root nodes (nodes that are not children of any other node)
-std::vector<int> findRootNodes(const tinygltf::Model& model) {
-    std::vector<bool> isChild(model.nodes.size(), false);
+std::pmr::vector<int> findRootNodes(const tinygltf::Model& model, std::pmr::memory_resource& memory) {
+    std::pmr::vector<bool> isChild(model.nodes.size(), false, &memory);
     for (const auto& node : model.nodes) {
         for (const int childIdx : node.children) {
             if (childIdx >= 0 && static_cast<std::size_t>(childIdx) < model.nodes.size()) {
@@ -195,7 +229,7 @@ std::vector<int> findRootNodes(const tinygltf::Model& model) {
             }
         }
     }
-    std::vector<int> roots;
+    std::pmr::vector<int> roots(&memory);
     for (std::size_t i = 0; i < model.nodes.size(); ++i) {
         if (!isChild[i]) {
             roots.push_back(static_cast<int>(i));
@@ -205,7 +239,10 @@ std::vector<int> findRootNodes(const tinygltf::Model& model) {
 }
 } // namespace
 
-void Animator::animate(const tinygltf::Model& model, Scene& scene, float time) {
+void Animator::animate(const tinygltf::Model& model, Scene& scene, float time,
+                       std::pmr::memory_resource& frameMemory) {
+    PROFILE_ZONE("Animator::animate");
+
     const std::size_t nodeCount = model.nodes.size();
     if (nodeCount == 0) return;
 
@@ -215,51 +252,16 @@ void Animator::animate(const tinygltf::Model& model, Scene& scene, float time) {
     }
 
     // Prepare default TRS per node (from node's static transform)
-    std::vector<glm::vec3> translations(nodeCount, glm::vec3(0.0f));
-    std::vector<glm::quat> rotations(nodeCount, glm::quat(1.0f, 0.0f, 0.0f, 0.0f));
-    std::vector<glm::vec3> scales(nodeCount, glm::vec3(1.0f));
+    std::pmr::vector<glm::vec3> translations(nodeCount, glm::vec3(0.0f), &frameMemory);
+    std::pmr::vector<glm::quat> rotations(nodeCount, glm::quat(1.0f, 0.0f, 0.0f, 0.0f), &frameMemory);
+    std::pmr::vector<glm::vec3> scales(nodeCount, glm::vec3(1.0f), &frameMemory);
     
     for (std::size_t i = 0; i < nodeCount; ++i) {
-        const auto& node = model.nodes[i];
-        glm::vec3 T(0.0f), S(1.0f);
-        glm::quat R(1.0f, 0.0f, 0.0f, 0.0f);
-
-        // Match GLTFLoader behavior: matrix takes precedence over TRS
-        if (node.matrix.size() == 16) {
-            // Node has explicit matrix - decompose it
-            glm::mat4 M = glm::make_mat4x4(node.matrix.data());
-            decomposeTRS(M, T, R, S);
-        } else {
-            // Node uses TRS components
-            if (node.translation.size() == 3) {
-                T = glm::vec3(node.translation[0], node.translation[1], node.translation[2]);
-            }
-            if (node.rotation.size() == 4) {
-                R = glm::quat(
-                    static_cast<float>(node.rotation[3]), // w
-                    static_cast<float>(node.rotation[0]), // x
-                    static_cast<float>(node.rotation[1]), // y
-                    static_cast<float>(node.rotation[2])  // z
-                );
-            }
-            if (node.scale.size() == 3) {
-                S = glm::vec3(node.scale[0], node.scale[1], node.scale[2]);
-            }
-        }
-
-        translations[i] = T;
-        rotations[i] = glm::normalize(R);
-        scales[i] = S;
-    }
-
-    // Find the maximum duration across all animations for synchronized looping
-    float maxDuration = 0.0f;
-    for (const auto& animation : model.animations) {
-        const float duration = getAnimationDuration(animation, model);
-        maxDuration = std::max(maxDuration, duration);
+        restPose(model.nodes[i], translations[i], rotations[i], scales[i]);
     }
 
     // Use global time synchronized across all animations
+    const float maxDuration = loopDuration(model);
     const float globalTime = maxDuration > 0.0f ? std::fmod(std::max(time, 0.0f), maxDuration) : 0.0f;
 
     // Apply animations: sample each channel at synchronized global time
@@ -282,7 +284,7 @@ void Animator::animate(const tinygltf::Model& model, Scene& scene, float time) {
     }
 
     // Build local matrices
-    std::vector<glm::mat4> localMats(nodeCount);
+    std::pmr::vector<glm::mat4> localMats(nodeCount, &frameMemory);
     for (std::size_t i = 0; i < nodeCount; ++i) {
         glm::mat4 T = glm::translate(glm::mat4(1.0f), translations[i]);
         glm::mat4 R = glm::mat4_cast(glm::normalize(rotations[i]));
@@ -291,28 +293,26 @@ void Animator::animate(const tinygltf::Model& model, Scene& scene, float time) {
     }
 
     // Compute world matrices - only process actual root nodes
-    std::vector<glm::mat4> worldMats(nodeCount, glm::mat4(1.0f));
-    const auto rootNodes = findRootNodes(model);
+    std::pmr::vector<glm::mat4> worldMats(nodeCount, glm::mat4(1.0f), &frameMemory);
+    const auto rootNodes = findRootNodes(model, frameMemory);
     for (const int rootIdx : rootNodes) {
         computeNodeWorldMatrixAnimated(model, rootIdx, glm::mat4(1.0f), localMats, worldMats);
     }
 
-    // Update mesh instances using the node-to-instance mapping
-    for (std::size_t nodeIdx = 0; nodeIdx < nodeCount; ++nodeIdx) {
-        const auto& node = model.nodes[nodeIdx];
-        if (node.mesh >= 0 && static_cast<std::size_t>(nodeIdx) < scene.nodeToInstanceIndex.size()) {
-            const std::int32_t firstInstanceIdx = scene.nodeToInstanceIndex[nodeIdx];
-            if (firstInstanceIdx >= 0) {
-                // Update all instances (primitives) for this node
-                const auto primCount = model.meshes[static_cast<std::size_t>(node.mesh)].primitives.size();
-                for (std::size_t p = 0; p < primCount; ++p) {
-                    const std::size_t instanceIdx = static_cast<std::size_t>(firstInstanceIdx) + p;
-                    if (instanceIdx < scene.instances.size()) {
-                        scene.instances[instanceIdx].transform = worldMats[nodeIdx];
-                        scene.instances[instanceIdx].inverseTransform = glm::inverse(worldMats[nodeIdx]);
-                    }
-                }
-            }
+    // Update the animated instances, which the loader grouped at the end of the instance array
+    for (std::size_t i = 0; i < scene.dynamicInstanceNodes.size(); ++i) {
+        const std::int32_t nodeIdx = scene.dynamicInstanceNodes[i];
+        const std::size_t instanceIdx = scene.firstDynamicInstance + i;
+        if (nodeIdx < 0 || static_cast<std::size_t>(nodeIdx) >= nodeCount) {
+            continue;
+        }
+
+        // Instances the animation does not move this frame keep their matrix and are not uploaded again
+        const glm::mat4& world = worldMats[static_cast<std::size_t>(nodeIdx)];
+        if (scene.instances[instanceIdx].transform != world) {
+            scene.instances[instanceIdx].transform = world;
+            scene.instances[instanceIdx].inverseTransform = glm::inverse(world);
+            scene.instanceGenerations.markChanged(instanceIdx);
         }
     }
 
@@ -354,7 +354,7 @@ void Animator::animate(const tinygltf::Model& model, Scene& scene, float time) {
                 const std::int32_t castsShadows = pointLight.castsShadows;
                 const std::int32_t animated = pointLight.animated;
                 
-                pointLight = {
+                const PointLight updated{
                     .position = glm::vec3(world[3]),
                     .intensity = static_cast<float>(light.intensity / GLTF_POINT_LIGHT_INTENSITY_CONVERSION_FACTOR),
                     .color = glm::vec3(light.color[0], light.color[1], light.color[2]),
@@ -362,6 +362,11 @@ void Animator::animate(const tinygltf::Model& model, Scene& scene, float time) {
                     .castsShadows = castsShadows,
                     .animated = animated,
                 };
+                // The light structs have no implicit padding, so a byte compare is exact
+                if (std::memcmp(&pointLight, &updated, sizeof(PointLight)) != 0) {
+                    pointLight = updated;
+                    scene.pointLightGenerations.markChanged(pointIdx);
+                }
             }
             ++pointIdx;
         } else if (light.type == "spot") {
@@ -372,7 +377,7 @@ void Animator::animate(const tinygltf::Model& model, Scene& scene, float time) {
                 const std::int32_t animated = spotLight.animated;
                 
                 glm::vec3 forward = glm::normalize(glm::vec3(world * glm::vec4(0, 0, -1, 0)));
-                spotLight = {
+                const SpotLight updated{
                     .position = glm::vec3(world[3]),
                     .intensity = static_cast<float>(light.intensity / GLTF_SPOT_LIGHT_INTENSITY_CONVERSION_FACTOR),
                     .direction = -forward,
@@ -382,8 +387,87 @@ void Animator::animate(const tinygltf::Model& model, Scene& scene, float time) {
                     .castsShadows = castsShadows,
                     .animated = animated,
                 };
+                if (std::memcmp(&spotLight, &updated, sizeof(SpotLight)) != 0) {
+                    spotLight = updated;
+                    scene.spotLightGenerations.markChanged(spotIdx);
+                }
             }
             ++spotIdx;
         }
     }
 }
+
+auto Animator::loopDuration(const tinygltf::Model& model) -> float {
+    // The maximum duration across all animations, for synchronized looping
+    float maxDuration = 0.0f;
+    for (const auto& animation : model.animations) {
+        maxDuration = std::max(maxDuration, getAnimationDuration(animation, model));
+    }
+    return maxDuration;
+}
+
+auto Animator::sampleCamera(const tinygltf::Model& model, const float time, std::pmr::memory_resource& memory,
+                            CameraParameters& camera) -> bool {
+    const std::size_t nodeCount = model.nodes.size();
+
+    // animate() takes the last camera node
+    int cameraNode = -1;
+    for (std::size_t nodeIdx = 0; nodeIdx < nodeCount; ++nodeIdx) {
+        if (model.nodes[nodeIdx].camera >= 0) {
+            cameraNode = static_cast<int>(nodeIdx);
+        }
+    }
+    if (cameraNode < 0) {
+        return false;
+    }
+
+    std::pmr::vector<int> parents(nodeCount, -1, &memory);
+    for (std::size_t nodeIdx = 0; nodeIdx < nodeCount; ++nodeIdx) {
+        for (const int childIdx : model.nodes[nodeIdx].children) {
+            if (childIdx >= 0 && static_cast<std::size_t>(childIdx) < nodeCount) {
+                parents[childIdx] = static_cast<int>(nodeIdx);
+            }
+        }
+    }
+
+    const float maxDuration = loopDuration(model);
+    const float globalTime = maxDuration > 0.0f ? std::fmod(std::max(time, 0.0f), maxDuration) : 0.0f;
+
+    // Only the camera node and its ancestors, from the camera up
+    glm::mat4 world(1.0f);
+    for (int nodeIdx = cameraNode; nodeIdx >= 0; nodeIdx = parents[nodeIdx]) {
+        glm::vec3 T;
+        glm::quat R;
+        glm::vec3 S;
+        restPose(model.nodes[nodeIdx], T, R, S);
+
+        for (const auto& animation : model.animations) {
+            for (const auto& channel : animation.channels) {
+                if (channel.target_node != nodeIdx) continue;
+                const auto& samp = animation.samplers[channel.sampler];
+
+                if (channel.target_path == "translation") {
+                    T = sampleVec3(samp, model, globalTime);
+                } else if (channel.target_path == "rotation") {
+                    R = sampleQuat(samp, model, globalTime);
+                } else if (channel.target_path == "scale") {
+                    S = sampleVec3(samp, model, globalTime);
+                }
+            }
+        }
+
+        const glm::mat4 local = glm::translate(glm::mat4(1.0f), T) * glm::mat4_cast(glm::normalize(R)) *
+                                glm::scale(glm::mat4(1.0f), S);
+        world = local * world;
+    }
+
+    const tinygltf::Camera& cam = model.cameras[model.nodes[cameraNode].camera];
+    camera = {
+        .yfov = static_cast<float>(cam.perspective.yfov),
+        .aspectRatio = static_cast<float>(cam.perspective.aspectRatio),
+        .znear = static_cast<float>(cam.perspective.znear),
+        .zfar = static_cast<float>(cam.perspective.zfar),
+        .model = world,
+    };
+    return true;
+}
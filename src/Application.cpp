@@ -2,6 +2,13 @@
 #include <filesystem>
 #include <thread>
 #include <chrono>
+#include <atomic>
+#include <csignal>
+#include <optional>
+#include <array>
+#include <algorithm>
+#include <string>
+#include <cmath>
 #include <glm/gtc/matrix_transform.hpp>
 
 // Include miniaudio implementation in this ONE cpp file only
@@ -23,24 +30,195 @@
 #include "BufferManager.hpp"
 #include "PostProcessingStack.hpp"
 #include "Animator.hpp"
+#include "BenchmarkRecorder.hpp"
+#include "GpuProfiler.hpp"
+#include "HitchDetector.hpp"
+#include "LiveMetrics.hpp"
+#include "FrameExporter.hpp"
+#include "CpuProfiler.hpp"
+#include "PipelineCache.hpp"
+#include "LinearArena.hpp"
+#include "AllocationCounter.hpp"
+#include "PotentiallyVisibleSet.hpp"
+#include "PvsBaker.hpp"
+#include "ProbeBaker.hpp"
+#include "ProbeVolume.hpp"
+#include "SceneBvh.hpp"
+#include "TextureStreamer.hpp"
+#include "TexturePrefetchPlanner.hpp"
 
-Application::Application() : m_audioEngine(nullptr), m_backgroundMusic(nullptr) {
-    createWindow();
-    initVulkanCore();
-    
-    m_audioEngine = new ma_engine();
-    ma_engine_config engineConfig = ma_engine_config_init();
-    
-    if (ma_engine_init(&engineConfig, m_audioEngine) != MA_SUCCESS) {
-        std::cerr << "Failed to initialize audio engine" << std::endl;
-        delete m_audioEngine;
-        m_audioEngine = nullptr;
+namespace {
+// Headless runs have no window to close, Ctrl+C requests a clean shutdown instead
+std::atomic<bool> g_interruptRequested{false};
+
+void onInterrupt(int /*signal*/) {
+    g_interruptRequested.store(true);
+}
+
+double secondsSinceStart() {
+    static const auto start = std::chrono::steady_clock::now();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Metric indices into the BenchmarkRecorder, registered once before the first frame
+struct BenchmarkMetrics {
+    std::size_t frame;
+    std::size_t animate;
+    std::size_t fenceWait;
+    std::size_t acquire;
+    std::size_t sceneUpdate;
+    std::size_t record;
+    std::size_t submit;
+    std::size_t present;
+
+    BenchmarkMetrics(BenchmarkRecorder& recorder, const bool rayCounters, const bool textureStreaming)
+        : frame(recorder.metric("cpu.frame")),
+          animate(recorder.metric("cpu.animate")),
+          fenceWait(recorder.metric("cpu.fence_wait")),
+          acquire(recorder.metric("cpu.acquire")),
+          sceneUpdate(recorder.metric("cpu.scene_update")),
+          record(recorder.metric("cpu.record")),
+          submit(recorder.metric("cpu.submit")),
+          present(recorder.metric("cpu.present")) {
+        for (std::size_t pass = 0; pass < GPU_PASS_COUNT; pass++) {
+            gpuPasses[pass] = recorder.metric(std::string("gpu.") + GpuProfiler::passName(static_cast<GpuPass>(pass)));
+        }
+        for (std::size_t i = 0; i < STATISTICS_PASSES.size(); i++) {
+            const std::string prefix = std::string("gpu.") + GpuProfiler::passName(STATISTICS_PASSES[i]) + ".";
+            passStatistics[i] = {
+                .vertexInvocations = recorder.metric(prefix + "vertex_invocations"),
+                .clippingPrimitives = recorder.metric(prefix + "clipping_primitives"),
+                .fragmentInvocations = recorder.metric(prefix + "fragment_invocations"),
+                .overdraw = recorder.metric(prefix + "overdraw"),
+            };
+        }
+        sceneOverdraw = recorder.metric("gpu.scene.overdraw");
+        if (textureStreaming) {
+            texturePrefetch = recorder.metric("cpu.texture_prefetch");
+        }
+        if (rayCounters) {
+            rays = RayMetrics{
+                .shadowRays = recorder.metric("gpu.rays.shadow"),
+                .reflectionRays = recorder.metric("gpu.rays.reflection"),
+                .candidateIterations = recorder.metric("gpu.rays.candidate_iterations"),
+                .tracingFragments = recorder.metric("gpu.rays.tracing_fragments"),
+                .raysPerPixel = recorder.metric("gpu.rays.per_pixel"),
+                .candidatesPerRay = recorder.metric("gpu.rays.candidates_per_ray"),
+            };
+        }
     }
 
-    m_backgroundMusic = new ma_sound();
+    std::array<std::size_t, GPU_PASS_COUNT> gpuPasses{};
+
+    // Pipeline statistics of the scene passes, overdraw = fragment shader invocations per pixel
+    static constexpr std::array STATISTICS_PASSES = {GpuPass::Opaque, GpuPass::Transparent};
+    struct PassStatistics {
+        std::size_t vertexInvocations;
+        std::size_t clippingPrimitives;
+        std::size_t fragmentInvocations;
+        std::size_t overdraw;
+    };
+    std::array<PassStatistics, STATISTICS_PASSES.size()> passStatistics{};
+    std::size_t sceneOverdraw = 0;
+
+    // Ray counter totals of the scene passes, only registered in --ray-counters / --ray-candidates runs
+    struct RayMetrics {
+        std::size_t shadowRays;
+        std::size_t reflectionRays;
+        std::size_t candidateIterations;
+        std::size_t tracingFragments;
+        std::size_t raysPerPixel;
+        std::size_t candidatesPerRay;
+    };
+    std::optional<RayMetrics> rays;
+
+    // TexturePrefetchPlanner::update, only registered in --stream-textures runs
+    std::optional<std::size_t> texturePrefetch;
+};
+
+// Free camera picking: what the centre of the screen (the captured cursor) points at
+void printPick(const Scene& scene, const SceneBvh& bvh) {
+    const Ray ray{
+        .origin = scene.camera.getPosition(),
+        .tMin = scene.camera.znear,
+        .direction = scene.camera.getForward(),
+        .tMax = scene.camera.zfar,
+    };
+
+    const RayHit hit = bvh.castRay(ray);
+    if (!hit.hit()) {
+        std::cout << "[Pick] Nothing within " << scene.camera.zfar << " units" << std::endl;
+        return;
+    }
+
+    const Instance& instance = scene.instances[hit.instance];
+    const glm::vec3 point = ray.origin + ray.direction * hit.t;
+    std::cout << "[Pick] Instance " << hit.instance << (instance.animated != 0 ? " (animated)" : "") << ", mesh "
+              << instance.meshIndex << ", material " << scene.meshes[instance.meshIndex].materialIndex << ", triangle "
+              << hit.triangle << " at " << hit.t << " units (" << point.x << ", " << point.y << ", " << point.z << ")"
+              << std::endl;
+}
+} // namespace
+
+Application::Application(const LaunchOptions& options)
+    : m_options(options),
+      m_audioEngine(nullptr),
+      m_backgroundMusic(nullptr),
+      m_jobSystem(std::make_unique<JobSystem>()) {
+    if (m_options.benchmark && m_options.frameCount == 0) {
+        m_options.frameCount = BENCHMARK_DEFAULT_FRAME_COUNT;
+    }
+
+    if (m_options.headless) {
+        if (m_options.frameCount == 0) {
+            m_options.frameCount = HEADLESS_DEFAULT_FRAME_COUNT;
+        }
+        std::signal(SIGINT, onInterrupt);
+    } else {
+        const StartupTimeline::Scope phase(m_startup, "window", "main");
+        createWindow();
+    }
+
+    if (!m_options.exportPath.empty()) {
+        m_exportPrerollFrames = std::min(m_options.exportFirstFrame, TAA_EXPORT_PREROLL_FRAMES);
+        m_options.frameCount += m_exportPrerollFrames;
+    }
+
+    StartupTimeline::PhaseId vulkanCorePhase = 0;
+    {
+        const StartupTimeline::Scope phase(m_startup, "vulkan_core", "main");
+        vulkanCorePhase = phase.id();
+        initVulkanCore();
+    }
+
+    // Texture settings depend on the VRAM queried above, so the scene load starts right after
+    startSceneLoad(vulkanCorePhase);
+
+    // No audio device is expected on headless build servers, and benchmarks run without sound
+    if (!m_options.headless && !m_options.benchmark) {
+        StartupTimeline::PhaseId audioEnginePhase = 0;
+        {
+            const StartupTimeline::Scope phase(m_startup, "audio_engine", "main");
+            audioEnginePhase = phase.id();
+            initAudio();
+        }
+        startMusicLoad(audioEnginePhase);
+    }
 }
 
 Application::~Application() {
+    // run() threw before taking the scene, the loader job still uses m_jobSystem and m_startup. Wait for it
+    // before anything else is torn down (its result, or its exception, is dropped with the future).
+    if (m_sceneLoad.valid()) {
+        m_sceneLoad.wait();
+    }
+
+    // run() did not get to the music (threw early), it may still be initializing on a worker
+    if (m_musicLoad.valid() && !m_musicLoad.get()) {
+        delete m_backgroundMusic;
+        m_backgroundMusic = nullptr;
+    }
+
     if (m_backgroundMusic) {
         ma_sound_uninit(m_backgroundMusic);
         delete m_backgroundMusic;
@@ -55,26 +233,116 @@ Application::~Application() {
         glfwDestroyWindow(m_window);
     }
 
-    glfwTerminate();
+    if (!m_options.headless) {
+        glfwTerminate();
+    }
+}
+
+void Application::initAudio() {
+    m_audioEngine = new ma_engine();
+    ma_engine_config engineConfig = ma_engine_config_init();
+    
+    if (ma_engine_init(&engineConfig, m_audioEngine) != MA_SUCCESS) {
+        std::cerr << "Failed to initialize audio engine" << std::endl;
+        delete m_audioEngine;
+        m_audioEngine = nullptr;
+    }
+
+    m_backgroundMusic = new ma_sound();
+}
+
+void Application::startSceneLoad(const StartupTimeline::PhaseId vulkanCorePhase) {
+    const std::string& scenePath = m_options.scenePath;
+    if (!std::filesystem::exists(scenePath)) {
+        throw std::runtime_error("Scene file not found: " + scenePath);
+    }
+
+    m_sceneLoadPhase = m_startup.begin("scene_load", "worker", {vulkanCorePhase});
+    m_sceneLoad = m_jobSystem->submit([this, scenePath] {
+        PROFILE_ZONE("Application::sceneLoad");
+
+        GLTFLoader gltfLoader(*m_jobSystem);
+        auto loaded = gltfLoader.load(scenePath);
+        m_startup.end(m_sceneLoadPhase);
+        return loaded;
+    });
+}
+
+void Application::startMusicLoad(const StartupTimeline::PhaseId audioEnginePhase) {
+    if (!m_audioEngine || !m_backgroundMusic) {
+        return;
+    }
+
+    m_musicLoadPhase = m_startup.begin("music_load", "worker", {audioEnginePhase});
+    m_musicLoad = m_jobSystem->submit([this] {
+        PROFILE_ZONE("Application::musicLoad");
+
+        const bool loaded = ma_sound_init_from_file(m_audioEngine, "assets/soundtrack_2.mp3",
+                                                    MA_SOUND_FLAG_STREAM, NULL, NULL,
+                                                    m_backgroundMusic) == MA_SUCCESS;
+        m_startup.end(m_musicLoadPhase);
+        return loaded;
+    });
+}
+
+bool Application::shouldExit(const std::uint32_t renderedFrames) const {
+    if (m_options.frameCount > 0 && renderedFrames >= m_options.frameCount) {
+        return true;
+    }
+
+    if (m_options.headless) {
+        return g_interruptRequested.load();
+    }
+
+    return glfwWindowShouldClose(m_window);
 }
 
 void Application::run() {
-    GLTFLoader gltfLoader;
+    PROFILE_THREAD_NAME("Main");
+
+    auto phase = m_startup.begin("device_resources", "main");
     Animator animator;
     CommandManager commandManager(*m_vulkanCore);
     BufferManager bufferManager(*m_vulkanCore, commandManager);
     ImageManager imageManager(*m_vulkanCore, commandManager, bufferManager);
     ResourceManager resourceManager(*m_vulkanCore, commandManager, bufferManager, imageManager);
-    SwapChain swapChain(*m_vulkanCore, m_window);
+    m_startup.end(phase);
+
+    phase = m_startup.begin("swapchain", "main");
+    // Exports render at the export size times the supersampling factor, other headless runs at the window size
+    vk::Extent2D offscreenExtent{
+        .width = static_cast<std::uint32_t>(WINDOW_WIDTH),
+        .height = static_cast<std::uint32_t>(WINDOW_HEIGHT),
+    };
+    if (!m_options.exportPath.empty()) {
+        if (m_options.exportWidth > 0) {
+            offscreenExtent = vk::Extent2D{.width = m_options.exportWidth, .height = m_options.exportHeight};
+        }
+        offscreenExtent.width *= m_options.exportSupersample;
+        offscreenExtent.height *= m_options.exportSupersample;
+    }
+    SwapChain swapChain(*m_vulkanCore, m_window, offscreenExtent);  // null window => offscreen image ring
+    resourceManager.setRenderExtent(swapChain.getExtent());
+    GpuProfiler gpuProfiler(*m_vulkanCore);
+    m_startup.end(phase);
     
+    phase = m_startup.begin("pipeline_cache_load", "main");
+    PipelineCache pipelineCache(*m_vulkanCore, *m_jobSystem, m_options.resetPipelineCache);
+    m_startup.end(phase);
+
+    phase = m_startup.begin("post_processing_pipelines", "main");
     PostProcessingStack postProcessingStack(
         *m_vulkanCore, 
         resourceManager, 
         swapChain, 
         imageManager, 
-        bufferManager
+        bufferManager,
+        gpuProfiler,
+        pipelineCache
     );
+    m_startup.end(phase);
 
+    phase = m_startup.begin("ray_query_pipeline", "main");
     RayQueryPipeline rayQueryPipeline(
         *m_vulkanCore,
         resourceManager, 
@@ -82,32 +350,94 @@ void Application::run() {
         swapChain, 
         imageManager,
         bufferManager,
-        postProcessingStack
+        postProcessingStack,
+        gpuProfiler,
+        pipelineCache,
+        m_options.debugView
         );
-    
-    const std::string scenePath = "assets/scene_full.glb";
-    if (!std::filesystem::exists(scenePath)) {
-        throw std::runtime_error("Scene file not found: " + scenePath);
+    m_startup.end(phase);
+
+    phase = m_startup.begin("wait_scene_load", "main", {m_sceneLoadPhase});
+    auto loaded = m_sceneLoad.get();
+    m_startup.end(phase);
+
+    // Probe bake: traced on the CPU, so nothing needs to reach the GPU
+    if (!m_options.bakeProbesPath.empty()) {
+        ProbeBaker(loaded->scene, *m_jobSystem).bake().save(m_options.bakeProbesPath);
+        std::cout << "[Probes] Wrote " << m_options.bakeProbesPath << std::endl;
+        return;
+    }
+
+    std::optional<ProbeVolume> probeVolume;
+    if (!m_options.probesPath.empty()) {
+        probeVolume.emplace(ProbeVolume::load(m_options.probesPath, loaded->scene));
+        resourceManager.setProbeVolume(&*probeVolume);
+        std::cout << "[Probes] Loaded " << probeVolume->probeCount() << " probes from " << m_options.probesPath << std::endl;
+    }
+
+    // Reads the textures of loaded->scene on its thread, so it is declared (and destroyed) after it
+    std::optional<TextureStreamer> textureStreamer;
+    if (m_options.streamTextures && m_options.bakePvsPath.empty()) {
+        textureStreamer.emplace(*m_vulkanCore, commandManager, bufferManager, imageManager, *m_jobSystem);
+        resourceManager.setTextureStreamer(&*textureStreamer);
     }
 
-    auto loaded = gltfLoader.load(scenePath);
+    phase = m_startup.begin("scene_upload", "main");
     resourceManager.allocateSceneResources(loaded->scene);
+    m_startup.end(phase);
 
-    if (m_audioEngine && m_backgroundMusic) {
-        if (ma_sound_init_from_file(m_audioEngine, "assets/soundtrack_2.mp3", 
-                                     MA_SOUND_FLAG_STREAM, NULL, NULL, 
-                                     m_backgroundMusic) == MA_SUCCESS) {
+    // Specialized pipelines depend on which material permutations the scene actually uses
+    phase = m_startup.begin("material_pipelines", "main");
+    rayQueryPipeline.createMaterialPipelines(resourceManager.getMaterialPipelineKeys());
+    m_startup.end(phase);
+
+    // Persist right away so a crash later in the run still leaves a warm cache for the next start
+    phase = m_startup.begin("pipeline_cache_save", "main");
+    pipelineCache.save();
+    m_startup.end(phase);
+
+    if (m_musicLoad.valid()) {
+        phase = m_startup.begin("wait_music_load", "main", {m_musicLoadPhase});
+        const bool musicLoaded = m_musicLoad.get();
+        m_startup.end(phase);
+
+        if (musicLoaded) {
             ma_sound_set_looping(m_backgroundMusic, MA_TRUE);  // Loop forever
             ma_sound_start(m_backgroundMusic);
         } else {
+            // Nothing to uninit later
+            delete m_backgroundMusic;
+            m_backgroundMusic = nullptr;
             std::cerr << "Failed to load music file (assets/soundtrack_2.mp3)" << std::endl;
         }
     }
 
-    const double startTime = glfwGetTime();
+    if constexpr (STARTUP_TIMELINE_OUTPUT) {
+        m_startup.printReport();
+    }
+    pipelineCache.printReport();
+    m_vulkanCore->memoryTracker().printSummary();
+
+    // PVS bake: replaces the render loop, the baker animates the camera path itself
+    if (!m_options.bakePvsPath.empty()) {
+        LinearArena bakeArena(FRAME_ARENA_INITIAL_SIZE);
+        PvsBaker baker(*m_vulkanCore, commandManager, bufferManager, resourceManager);
+        baker.bake(loaded->model, loaded->scene, animator, bakeArena).save(m_options.bakePvsPath);
+        std::cout << "[PVS] Wrote " << m_options.bakePvsPath << std::endl;
+        return;
+    }
+
+    std::optional<PotentiallyVisibleSet> pvs;
+    if (!m_options.pvsPath.empty()) {
+        pvs.emplace(PotentiallyVisibleSet::load(m_options.pvsPath, loaded->scene, Animator::loopDuration(loaded->model)));
+        std::cout << "[PVS] Loaded " << pvs->segmentCount() << " segments from " << m_options.pvsPath << std::endl;
+    }
+
+    const double startTime = secondsSinceStart();
     double lastTime = startTime;
     double lastFPSTime = startTime;
     int frameCount = 0;
+    std::uint32_t renderedFrames = 0;
     
     // Frame pacing: target 60 FPS (16.67ms per frame)
     const double targetFrameTime = 1.0 / 60.0;
@@ -116,20 +446,176 @@ void Application::run() {
     // Initialize free camera
     m_freeCamera.setPosition(loaded->scene.camera.getPosition());
 
-    std::cout << "[Render] Entering render loop..." << std::endl;
+    // Temporaries of one frame, reset at the start of the next
+    LinearArena frameArena(FRAME_ARENA_INITIAL_SIZE);
+
+    // CPU ray casting for free camera picking, built on first use
+    std::optional<SceneBvh> sceneBvh;
+
+    // Benchmark: heap allocations of the render thread in frames past the grace period
+    const std::uint32_t allocationGraceFrames = std::max(m_options.warmupFrames, BENCHMARK_ALLOCATION_GRACE_FRAMES);
+    std::uint64_t steadyStateAllocations = 0;
+    std::uint32_t allocatingFrames = 0;
+    std::optional<std::uint32_t> firstAllocatingFrame;
+
+    // Benchmark: fixed-step replay of the cinematic path with per-frame stage timings
+    std::optional<BenchmarkRecorder> benchmark;
+    std::optional<BenchmarkMetrics> benchmarkMetrics;
+    if (m_options.benchmark) {
+        benchmark.emplace(m_options.frameCount);
+        benchmark->setWarmupFrames(m_options.warmupFrames);
+        benchmarkMetrics.emplace(*benchmark, rayQueryPipeline.isCountingRays(), textureStreamer.has_value());
+    }
+
+    // Offline export: every frame is read back a few frames late and encoded on the job system's workers
+    std::optional<FrameExporter> frameExporter;
+    if (!m_options.exportPath.empty()) {
+        frameExporter.emplace(*m_vulkanCore, bufferManager, *m_jobSystem, m_options.exportPath, swapChain.getExtent(),
+                              swapChain.getFormat(), m_options.exportSupersample, m_options.fixedTimeStep,
+                              m_options.exportFirstFrame);
+    }
+    const std::uint32_t firstAnimationFrame = m_options.exportFirstFrame - m_exportPrerollFrames;
+    const bool fixedStep = m_options.benchmark || frameExporter.has_value();
+
+    // Hitch detector: traces of the frames around frames that take a multiple of the running median
+    std::optional<HitchDetector> hitchDetector;
+    if (m_options.hitchThreshold > 0.0) {
+        hitchDetector.emplace(m_options.hitchThreshold, m_options.hitchDirectory);
+        std::cout << "[Hitch] Tracing frames slower than " << m_options.hitchThreshold << "x the median into "
+                  << m_options.hitchDirectory << std::endl;
+    }
+
+    // Live metrics: the latest frame in shared memory for external dashboards
+    std::optional<LiveMetricsWriter> liveMetrics;
+    LiveMetricsFrame liveFrame{};
+    if (!m_options.liveMetricsName.empty()) {
+        static_assert(GPU_PASS_COUNT <= LIVE_METRICS_MAX_GPU_PASSES);
+        std::array<const char*, GPU_PASS_COUNT> passNames{};
+        for (std::size_t pass = 0; pass < GPU_PASS_COUNT; pass++) {
+            passNames[pass] = GpuProfiler::passName(static_cast<GpuPass>(pass));
+        }
+        liveMetrics.emplace(m_options.liveMetricsName, passNames);
+        std::cout << "[LiveMetrics] Publishing frames to shared memory '" << m_options.liveMetricsName << "'" << std::endl;
+    }
+
+    const auto extent = swapChain.getExtent();
+    const double pixelCount = static_cast<double>(extent.width) * static_cast<double>(extent.height);
+
+    // GPU queries resolve MAX_FRAMES_IN_FLIGHT frames late, file them under the frame they belong to
+    if (benchmark || hitchDetector || liveMetrics) {
+        gpuProfiler.setResultsCallback([&benchmark, &benchmarkMetrics, &hitchDetector, &liveMetrics, &liveFrame, pixelCount](
+                                           const std::uint64_t frameNumber,
+                                           const GpuPassTimings& timings,
+                                           const GpuPassStatistics& statistics) {
+            if (hitchDetector) {
+                hitchDetector->recordGpuTimings(frameNumber, timings);
+            }
+            if (liveMetrics) {
+                liveFrame.gpuFrameNumber = frameNumber;
+                std::ranges::copy(timings, liveFrame.gpuPassMs);
+            }
+            if (!benchmark) {
+                return;
+            }
+
+            const auto frame = static_cast<std::uint32_t>(frameNumber);
+            for (std::size_t pass = 0; pass < GPU_PASS_COUNT; pass++) {
+                if (!std::isnan(timings[pass])) {
+                    benchmark->recordAt(benchmarkMetrics->gpuPasses[pass], frame, timings[pass]);
+                }
+            }
+
+            std::uint64_t sceneFragments = 0;
+            bool sceneMeasured = false;
+            for (std::size_t i = 0; i < BenchmarkMetrics::STATISTICS_PASSES.size(); i++) {
+                const auto& passStatistics = statistics[static_cast<std::size_t>(BenchmarkMetrics::STATISTICS_PASSES[i])];
+                if (!passStatistics.valid) {
+                    continue;
+                }
+
+                const auto& metrics = benchmarkMetrics->passStatistics[i];
+                benchmark->recordAt(metrics.vertexInvocations, frame, static_cast<double>(passStatistics.vertexInvocations));
+                benchmark->recordAt(metrics.clippingPrimitives, frame, static_cast<double>(passStatistics.clippingPrimitives));
+                benchmark->recordAt(metrics.fragmentInvocations, frame, static_cast<double>(passStatistics.fragmentInvocations));
+                benchmark->recordAt(metrics.overdraw, frame, static_cast<double>(passStatistics.fragmentInvocations) / pixelCount);
+
+                sceneFragments += passStatistics.fragmentInvocations;
+                sceneMeasured = true;
+            }
+            if (sceneMeasured) {
+                benchmark->recordAt(benchmarkMetrics->sceneOverdraw, frame, static_cast<double>(sceneFragments) / pixelCount);
+            }
+        });
+    }
+
+    if (rayQueryPipeline.isCountingRays() && (benchmark || liveMetrics)) {
+        rayQueryPipeline.setRayCounterCallback([&benchmark, &benchmarkMetrics, &liveMetrics, &liveFrame, pixelCount](
+                                                   const std::uint64_t frameNumber,
+                                                   const RayCounterTotals& totals) {
+            if (liveMetrics) {
+                liveFrame.rayFrameNumber = frameNumber;
+                liveFrame.shadowRays = totals.shadowRays;
+                liveFrame.reflectionRays = totals.reflectionRays;
+                liveFrame.candidateIterations = totals.candidateIterations;
+            }
+            if (!benchmark) {
+                return;
+            }
+
+            const auto frame = static_cast<std::uint32_t>(frameNumber);
+            const auto& metrics = *benchmarkMetrics->rays;
+            const auto rays = static_cast<double>(totals.shadowRays) + static_cast<double>(totals.reflectionRays);
+
+            benchmark->recordAt(metrics.shadowRays, frame, static_cast<double>(totals.shadowRays));
+            benchmark->recordAt(metrics.reflectionRays, frame, static_cast<double>(totals.reflectionRays));
+            benchmark->recordAt(metrics.candidateIterations, frame, static_cast<double>(totals.candidateIterations));
+            benchmark->recordAt(metrics.tracingFragments, frame, static_cast<double>(totals.tracingFragments));
+            benchmark->recordAt(metrics.raysPerPixel, frame, rays / pixelCount);
+            if (rays > 0.0) {
+                benchmark->recordAt(metrics.candidatesPerRay, frame, static_cast<double>(totals.candidateIterations) / rays);
+            }
+        });
+    }
+
+    if (benchmark) {
+        std::cout << "[Benchmark] " << m_options.frameCount << " frames at a fixed step of "
+                  << m_options.fixedTimeStep << "s" << std::endl;
+    }
+
+    // The first frames' mips are uploaded before the loop, later ones stream in ahead of the camera
+    std::optional<TexturePrefetchPlanner> texturePlanner;
+    if (textureStreamer) {
+        const float firstFrameTime = fixedStep ? static_cast<float>(firstAnimationFrame * m_options.fixedTimeStep) : 0.0f;
+        texturePlanner.emplace(loaded->scene, *textureStreamer, swapChain.getExtent().height);
+        texturePlanner->prime(loaded->model, loaded->scene, firstFrameTime, frameArena);
+        textureStreamer->flush();
+    }
+
+    std::cout << "[Render] Entering render loop" << (m_options.headless ? " (headless)" : "") << "..." << std::endl;
     
-    while (!glfwWindowShouldClose(m_window)) {
-        glfwPollEvents();
+    while (!shouldExit(renderedFrames)) {
+        PROFILE_ZONE("Frame");
+        const std::uint64_t frameStartNs = CpuProfiler::now();
+
+        frameArena.reset();
+        const std::uint64_t allocationsAtFrameStart = AllocationCounter::threadAllocations();
+
+        if (!m_options.headless) {
+            glfwPollEvents();
+        }
         
-        const double currentTime = glfwGetTime();
+        const auto frameCpuStart = std::chrono::steady_clock::now();
+        const double currentTime = secondsSinceStart();
         const double deltaTime = currentTime - lastTime;
         lastTime = currentTime;
         
         // Frame pacing: limit frame rate to prevent queue buildup
         // The fence wait in drawFrame() already handles GPU sync, but we pace CPU-side
         // to prevent submitting too many frames ahead of the GPU
+        // Headless and benchmark runs render as fast as the device allows
         const double elapsedSinceFrameStart = currentTime - frameStartTime;
-        if (elapsedSinceFrameStart < targetFrameTime) {
+        const bool pacingEnabled = !m_options.headless && !m_options.benchmark;
+        if (pacingEnabled && elapsedSinceFrameStart < targetFrameTime) {
             // Sleep to avoid busy-waiting (only if significant time remaining)
             const double sleepTime = (targetFrameTime - elapsedSinceFrameStart) * 1000.0;
             if (sleepTime > 1.0) {  // Only sleep if more than 1ms
@@ -139,7 +625,9 @@ void Application::run() {
         frameStartTime = currentTime;
         
         // Toggle camera mode with F key (debounced)
-        bool fKeyDown = glfwGetKey(m_window, GLFW_KEY_F) == GLFW_PRESS;
+        // (the benchmark always follows the cinematic path)
+        bool fKeyDown = !m_options.headless && !m_options.benchmark &&
+                        glfwGetKey(m_window, GLFW_KEY_F) == GLFW_PRESS;
         if (fKeyDown && !m_fKeyPressed) {
             m_useFreeCam = !m_useFreeCam;
             
@@ -148,7 +636,7 @@ void Application::run() {
                 m_freeCamera.setPosition(loaded->scene.camera.getPosition());
                 // Capture mouse
                 glfwSetInputMode(m_window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
-                std::cout << "Free Camera: ENABLED (WASD=move, Mouse=look, Shift=sprint, F=toggle)" << std::endl;
+                std::cout << "Free Camera: ENABLED (WASD=move, Mouse=look, Shift=sprint, Click=pick, F=toggle)" << std::endl;
                 m_freeCamera.resetMouse(m_window);
             } else {
                 // Switched back to animated camera
@@ -158,17 +646,128 @@ void Application::run() {
         }
         m_fKeyPressed = fKeyDown;
 
-        const float animationTime = static_cast<float>(currentTime - startTime);
+        // Benchmark and export frames advance by a fixed step so every run samples the same camera positions
+        const float animationTime = fixedStep
+                                        ? static_cast<float>((firstAnimationFrame + renderedFrames) * m_options.fixedTimeStep)
+                                        : static_cast<float>(currentTime - startTime);
         
+        const auto animateStart = std::chrono::steady_clock::now();
         if (m_useFreeCam) {
             m_freeCamera.update(m_window, static_cast<float>(deltaTime));
             loaded->scene.camera.model = m_freeCamera.getModelMatrix();
         } else {
-            animator.animate(loaded->model, loaded->scene, animationTime);
+            animator.animate(loaded->model, loaded->scene, animationTime, frameArena);
+        }
+        const auto animateEnd = std::chrono::steady_clock::now();
+
+        // Timed on its own, cpu.animate stays comparable with and without --stream-textures
+        double texturePrefetchMs = 0.0;
+        if (texturePlanner) {
+            const auto prefetchStart = std::chrono::steady_clock::now();
+            texturePlanner->update(loaded->model, loaded->scene, animationTime, !m_useFreeCam, frameArena);
+            texturePrefetchMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - prefetchStart).count();
+        }
+
+        // Left click in free camera mode picks on the CPU; the BVH is built on the first click, later clicks
+        // only rebuild its instance level (animated instances moved while the path was playing)
+        const bool pickDown = m_useFreeCam && glfwGetMouseButton(m_window, GLFW_MOUSE_BUTTON_LEFT) == GLFW_PRESS;
+        if (pickDown && !m_pickPressed) {
+            if (sceneBvh) {
+                sceneBvh->updateInstances(loaded->scene);
+            } else {
+                const auto buildStart = std::chrono::steady_clock::now();
+                sceneBvh.emplace(loaded->scene, *m_jobSystem);
+                std::cout << "[Pick] Built the scene BVH (" << sceneBvh->triangleCount() << " triangles, "
+                          << sceneBvh->nodeCount() << " nodes) in "
+                          << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - buildStart).count()
+                          << " ms" << std::endl;
+            }
+            printPick(loaded->scene, *sceneBvh);
         }
+        m_pickPressed = pickDown;
         
-        rayQueryPipeline.drawFrame(loaded->scene, animationTime);
+        // The preroll frames are rendered but not read back
+        if (frameExporter && renderedFrames == m_exportPrerollFrames) {
+            rayQueryPipeline.setFrameExporter(&*frameExporter);
+        }
+
+        // The sets only cover views along the cinematic path
+        resourceManager.setPotentiallyVisibleSet(pvs && !m_useFreeCam ? &*pvs : nullptr);
+
+        const std::uint64_t gpuFrameNumber = gpuProfiler.getNextFrameNumber();
+        if (!rayQueryPipeline.drawFrame(loaded->scene, animationTime)) {
+            // Nothing was submitted: no timings to record, and the next iteration renders the same animation frame
+            continue;
+        }
+        renderedFrames++;
+
+        if (benchmark) {
+            using Milliseconds = std::chrono::duration<double, std::milli>;
+            const auto& stages = rayQueryPipeline.getLastFrameTimings();
+
+            benchmark->record(benchmarkMetrics->frame,
+                              Milliseconds(std::chrono::steady_clock::now() - frameCpuStart).count());
+            benchmark->record(benchmarkMetrics->animate, Milliseconds(animateEnd - animateStart).count());
+            if (benchmarkMetrics->texturePrefetch) {
+                benchmark->record(*benchmarkMetrics->texturePrefetch, texturePrefetchMs);
+            }
+            benchmark->record(benchmarkMetrics->fenceWait, stages.fenceWaitMs);
+            benchmark->record(benchmarkMetrics->acquire, stages.acquireMs);
+            benchmark->record(benchmarkMetrics->sceneUpdate, stages.sceneUpdateMs);
+            benchmark->record(benchmarkMetrics->record, stages.recordMs);
+            benchmark->record(benchmarkMetrics->submit, stages.submitMs);
+            benchmark->record(benchmarkMetrics->present, stages.presentMs);
+            benchmark->endFrame();
+
+            const std::uint64_t frameAllocations = AllocationCounter::threadAllocations() - allocationsAtFrameStart;
+            if (frameAllocations > 0 && renderedFrames > allocationGraceFrames) {
+                steadyStateAllocations += frameAllocations;
+                allocatingFrames++;
+                if (!firstAllocatingFrame) {
+                    firstAllocatingFrame = renderedFrames - 1;
+                }
+            }
+        }
         
+        if (liveMetrics) {
+            const auto& stages = rayQueryPipeline.getLastFrameTimings();
+            const MemoryTracker& memoryTracker = m_vulkanCore->memoryTracker();
+            const std::uint64_t frameNumber = renderedFrames - 1;
+
+            liveFrame.frameNumber = frameNumber;
+            liveFrame.timestampNs = CpuProfiler::now();
+            liveFrame.frameMs = static_cast<double>(liveFrame.timestampNs - frameStartNs) / 1e6;
+            liveFrame.animateMs = std::chrono::duration<double, std::milli>(animateEnd - animateStart).count();
+            liveFrame.fenceWaitMs = stages.fenceWaitMs;
+            liveFrame.acquireMs = stages.acquireMs;
+            liveFrame.sceneUpdateMs = stages.sceneUpdateMs;
+            liveFrame.recordMs = stages.recordMs;
+            liveFrame.submitMs = stages.submitMs;
+            liveFrame.presentMs = stages.presentMs;
+            liveFrame.drawCalls = resourceManager.getDrawCallCount();
+            liveFrame.visibleInstances = resourceManager.getIndirectDrawCount();
+            liveFrame.visibleTriangles = resourceManager.getVisibleTriangleCount();
+            liveFrame.memoryTrackedBytes = memoryTracker.getCurrentBytes();
+            liveFrame.memoryPeakBytes = memoryTracker.getPeakBytes();
+            if (frameNumber % LIVE_METRICS_BUDGET_INTERVAL == 0) {
+                const MemoryBudget budget = memoryTracker.queryDeviceLocalBudget();
+                liveFrame.memoryBudgetBytes = budget.budgetBytes;
+                liveFrame.memoryUsageBytes = budget.usageBytes;
+            }
+            liveFrame.tlasUpdates = resourceManager.getTlasUpdateCount();
+
+            liveMetrics->publish(liveFrame);
+        }
+
+        // After the allocation check: a hitch log line or trace is not a steady-state allocation
+        if (hitchDetector) {
+            const bool recorded = gpuProfiler.getNextFrameNumber() != gpuFrameNumber;
+            hitchDetector->endFrame(frameStartNs, CpuProfiler::now(),
+                                    std::chrono::duration<double, std::milli>(animateEnd - animateStart).count(),
+                                    rayQueryPipeline.getLastFrameTimings(),
+                                    recorded ? std::optional(gpuFrameNumber) : std::nullopt);
+        }
+
         // FPS Counter (update every second)
         frameCount++;
         if (currentTime - lastFPSTime >= 1.0) {
@@ -179,12 +778,75 @@ void Application::run() {
             std::cout << "FPS: " << static_cast<int>(fps) 
                       << " | Avg: " << avgFrameTime << "ms" 
                       << " | Last: " << lastDeltaMs << "ms" << std::endl;
+
+            if constexpr (GPU_PROFILER_CONSOLE_OUTPUT) {
+                gpuProfiler.printAverages();
+            }
             frameCount = 0;
             lastFPSTime = currentTime;
         }
     }
 
     m_vulkanCore->device().waitIdle();
+    gpuProfiler.resolvePendingFrames();
+    rayQueryPipeline.resolvePendingRayCounters();
+    if (frameExporter) {
+        rayQueryPipeline.setFrameExporter(nullptr);
+        frameExporter->finish();
+    }
+    gpuProfiler.setResultsCallback(nullptr);
+    if (hitchDetector) {
+        hitchDetector->flush();
+        std::cout << "[Hitch] " << hitchDetector->hitchCount() << " hitches in " << renderedFrames << " frames" << std::endl;
+    }
+
+    const double wallClockSeconds = secondsSinceStart() - startTime;
+    std::cout << "[Render] Rendered " << renderedFrames << " frames in " << wallClockSeconds << "s" << std::endl;
+    if (textureStreamer) {
+        textureStreamer->printReport();
+    }
+
+    if (benchmark) {
+        const BenchmarkInfo info{
+            .deviceName = std::string(m_vulkanCore->physicalDevice().getProperties().deviceName.data()),
+            .scenePath = m_options.scenePath,
+            .width = extent.width,
+            .height = extent.height,
+            .headless = m_options.headless,
+            .fixedTimeStep = m_options.fixedTimeStep,
+            .warmupFrames = m_options.warmupFrames,
+            .wallClockSeconds = wallClockSeconds,
+        };
+
+        benchmark->printSummary();
+        benchmark->writeReport(m_options.benchmarkOutput, info);
+
+        if constexpr (AllocationCounter::enabled()) {
+            std::cout << "[Benchmark] Frame arena high-water mark: " << frameArena.highWater() / 1024 << " KiB, "
+                      << "steady-state heap allocations: " << steadyStateAllocations << std::endl;
+        } else {
+            std::cerr << "[Benchmark] Allocation check skipped, built with ENABLE_ALLOCATION_COUNTER=OFF" << std::endl;
+        }
+    }
+
+    if (!m_options.memoryReportPath.empty()) {
+        m_vulkanCore->memoryTracker().writeJson(m_options.memoryReportPath);
+    }
+
+    if (!m_options.tracePath.empty()) {
+        if constexpr (CPU_PROFILER_ENABLED) {
+            CpuProfiler::writeChromeTrace(m_options.tracePath);
+        } else {
+            std::cerr << "[Profiler] --trace ignored, built with ENABLE_CPU_PROFILER=OFF" << std::endl;
+        }
+    }
+
+    // Everything is written, but a steady-state frame that touched the heap fails the benchmark
+    if (steadyStateAllocations > 0) {
+        throw std::runtime_error("[Benchmark] " + std::to_string(steadyStateAllocations) +
+                                 " heap allocations in " + std::to_string(allocatingFrames) +
+                                 " steady-state frames (first in frame " + std::to_string(*firstAllocatingFrame) + ")");
+    }
 }
 
 void Application::createWindow() {
@@ -0,0 +1,177 @@
+#include <algorithm>
+#include <cmath>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+
+#include "BenchmarkRecorder.hpp"
+
+namespace {
+constexpr double kNotRecorded = std::numeric_limits<double>::quiet_NaN();
+
+// Linear interpolation between closest ranks, input must be sorted
+double percentile(const std::vector<double>& sorted, const double p) {
+    if (sorted.empty()) {
+        return 0.0;
+    }
+    const double rank = p * static_cast<double>(sorted.size() - 1);
+    const auto lower = static_cast<std::size_t>(std::floor(rank));
+    const auto upper = std::min(lower + 1, sorted.size() - 1);
+    const double fraction = rank - static_cast<double>(lower);
+    return sorted[lower] + (sorted[upper] - sorted[lower]) * fraction;
+}
+
+std::string escapeJson(const std::string& value) {
+    std::string escaped;
+    escaped.reserve(value.size());
+    for (const char c : value) {
+        if (c == '"' || c == '\\') {
+            escaped.push_back('\\');
+        }
+        escaped.push_back(c);
+    }
+    return escaped;
+}
+} // namespace
+
+BenchmarkRecorder::BenchmarkRecorder(const std::uint32_t expectedFrames) : m_expectedFrames(expectedFrames) {
+}
+
+auto BenchmarkRecorder::metric(const std::string_view name) -> std::size_t {
+    for (std::size_t i = 0; i < m_metrics.size(); i++) {
+        if (m_metrics[i].name == name) {
+            return i;
+        }
+    }
+
+    Metric newMetric{.name = std::string(name)};
+    newMetric.values.assign(std::max(m_expectedFrames, m_currentFrame + 1), kNotRecorded);
+    m_metrics.push_back(std::move(newMetric));
+    return m_metrics.size() - 1;
+}
+
+void BenchmarkRecorder::record(const std::size_t metricIndex, const double valueMs) {
+    recordAt(metricIndex, m_currentFrame, valueMs);
+}
+
+void BenchmarkRecorder::recordAt(const std::size_t metricIndex, const std::uint32_t frame, const double valueMs) {
+    auto& values = m_metrics[metricIndex].values;
+    if (frame >= values.size()) {
+        // Ran past the expected frame count, only happens if the caller under-reserved
+        values.resize(frame + 1, kNotRecorded);
+    }
+    values[frame] = valueMs;
+}
+
+void BenchmarkRecorder::endFrame() {
+    m_currentFrame++;
+}
+
+auto BenchmarkRecorder::statistics(const std::size_t metricIndex) const -> BenchmarkStatistics {
+    const auto& values = m_metrics[metricIndex].values;
+    const auto end = std::min<std::size_t>(m_currentFrame, values.size());
+
+    std::vector<double> sorted;
+    sorted.reserve(end);
+    for (std::size_t frame = m_warmupFrames; frame < end; frame++) {
+        if (!std::isnan(values[frame])) {
+            sorted.push_back(values[frame]);
+        }
+    }
+
+    if (sorted.empty()) {
+        return {};
+    }
+
+    std::ranges::sort(sorted);
+
+    return {
+        .samples = sorted.size(),
+        .min = sorted.front(),
+        .max = sorted.back(),
+        .mean = std::accumulate(sorted.begin(), sorted.end(), 0.0) / static_cast<double>(sorted.size()),
+        .p50 = percentile(sorted, 0.50),
+        .p95 = percentile(sorted, 0.95),
+        .p99 = percentile(sorted, 0.99),
+    };
+}
+
+void BenchmarkRecorder::writeReport(const std::string& basePath, const BenchmarkInfo& info) const {
+    writeJson(basePath + ".json", info);
+    writeCsv(basePath + ".csv");
+
+    std::cout << "[Benchmark] Report written to " << basePath << ".json and " << basePath << ".csv" << std::endl;
+}
+
+void BenchmarkRecorder::writeJson(const std::string& path, const BenchmarkInfo& info) const {
+    std::ofstream file(path);
+    if (!file) {
+        throw std::runtime_error("Failed to open benchmark report for writing: " + path);
+    }
+
+    file << "{\n";
+    file << "  \"device\": \"" << escapeJson(info.deviceName) << "\",\n";
+    file << "  \"scene\": \"" << escapeJson(info.scenePath) << "\",\n";
+    file << "  \"resolution\": [" << info.width << ", " << info.height << "],\n";
+    file << "  \"headless\": " << (info.headless ? "true" : "false") << ",\n";
+    file << "  \"fixedTimeStep\": " << std::format("{:.6f}", info.fixedTimeStep) << ",\n";
+    file << "  \"frames\": " << m_currentFrame << ",\n";
+    file << "  \"warmupFrames\": " << info.warmupFrames << ",\n";
+    file << "  \"wallClockSeconds\": " << std::format("{:.3f}", info.wallClockSeconds) << ",\n";
+    file << "  \"metrics\": {";
+
+    for (std::size_t i = 0; i < m_metrics.size(); i++) {
+        const auto stats = statistics(i);
+        file << (i == 0 ? "\n" : ",\n");
+        file << std::format(
+            "    \"{}\": {{ \"samples\": {}, \"min\": {:.4f}, \"mean\": {:.4f}, \"p50\": {:.4f}, "
+            "\"p95\": {:.4f}, \"p99\": {:.4f}, \"max\": {:.4f} }}",
+            escapeJson(m_metrics[i].name), stats.samples, stats.min, stats.mean, stats.p50, stats.p95, stats.p99,
+            stats.max);
+    }
+
+    file << "\n  }\n}\n";
+}
+
+void BenchmarkRecorder::writeCsv(const std::string& path) const {
+    std::ofstream file(path);
+    if (!file) {
+        throw std::runtime_error("Failed to open benchmark report for writing: " + path);
+    }
+
+    file << "frame";
+    for (const auto& metric : m_metrics) {
+        file << "," << metric.name;
+    }
+    file << "\n";
+
+    for (std::uint32_t frame = 0; frame < m_currentFrame; frame++) {
+        file << frame;
+        for (const auto& metric : m_metrics) {
+            file << ",";
+            if (frame < metric.values.size() && !std::isnan(metric.values[frame])) {
+                file << std::format("{:.4f}", metric.values[frame]);
+            }
+        }
+        file << "\n";
+    }
+}
+
+void BenchmarkRecorder::printSummary() const {
+    std::cout << std::format("[Benchmark] {} frames ({} warmup)\n", m_currentFrame, m_warmupFrames);
+    std::cout << std::format("  {:<36} {:>9} {:>9} {:>9} {:>9} {:>9}\n", "metric (ms or count)", "min", "mean", "p50",
+                             "p95", "p99");
+
+    for (std::size_t i = 0; i < m_metrics.size(); i++) {
+        const auto stats = statistics(i);
+        if (stats.samples == 0) {
+            continue;
+        }
+        std::cout << std::format("  {:<36} {:>9.3f} {:>9.3f} {:>9.3f} {:>9.3f} {:>9.3f}\n", m_metrics[i].name,
+                                 stats.min, stats.mean, stats.p50, stats.p95, stats.p99);
+    }
+    std::cout << std::flush;
+}
@@ -12,6 +12,7 @@ BufferManager::BufferManager(
 
 
 void BufferManager::createBuffer(
+    const MemoryCategory category,
     const vk::DeviceSize size,
     const vk::BufferUsageFlags usage,
     const vk::MemoryPropertyFlags properties,
@@ -46,6 +47,9 @@ void BufferManager::createBuffer(
         memoryAllocateInfo.pNext = &memoryAllocateFlagsInfo;
     }
 
+    MemoryTracker& memoryTracker = m_vulkanCore.memoryTracker();
+    memoryTracker.release(bufferMemory);
+
     try {
         bufferMemory = vk::raii::DeviceMemory(m_vulkanCore.device(), memoryAllocateInfo);
         buffer.bindMemory(*bufferMemory, 0);
@@ -53,20 +57,25 @@ void BufferManager::createBuffer(
         const float sizeMB = static_cast<float>(memoryRequirements.size) / (1024.0f * 1024.0f);
         std::string memType = (properties & vk::MemoryPropertyFlagBits::eDeviceLocal) ? "Device Local" : "Host Visible";
         std::cerr << "[GPU Memory] ERROR: Out of device memory while allocating buffer!" << std::endl;
-        std::cerr << "  - Buffer size: " << sizeMB << " MB" << std::endl;
+        std::cerr << "  - Buffer size: " << sizeMB << " MB (" << MemoryTracker::categoryName(category) << ")" << std::endl;
         std::cerr << "  - Memory type: " << memType << std::endl;
+        memoryTracker.printSummary();
         throw;
     }
 
+    memoryTracker.recordAllocation(*bufferMemory, category, memoryRequirements.size, memoryAllocateInfo.memoryTypeIndex);
+
     if (data != nullptr) {
         vk::raii::Buffer stagingBuffer = nullptr;
         vk::raii::DeviceMemory stagingBufferMemory = nullptr;
         createStagingBuffer(size, stagingBuffer, stagingBufferMemory, data);
         copyBuffer(stagingBuffer, buffer, size);
+        memoryTracker.release(stagingBufferMemory);
     }
 }
 
 void BufferManager::createBuffer(
+    const MemoryCategory category,
     vk::DeviceSize size,
     vk::BufferUsageFlags usage,
     vk::MemoryPropertyFlags properties,
@@ -74,6 +83,7 @@ void BufferManager::createBuffer(
     vk::raii::DeviceMemory& bufferMemory
     ) {
     createBuffer(
+        category,
         size,
         usage,
         properties,
@@ -106,8 +116,13 @@ void BufferManager::createStagingBuffer(
             vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent),
     };
 
+    MemoryTracker& memoryTracker = m_vulkanCore.memoryTracker();
+    memoryTracker.release(bufferMemory);
+
     bufferMemory = vk::raii::DeviceMemory(m_vulkanCore.device(), memoryAllocateInfo);
     buffer.bindMemory(*bufferMemory, 0);
+    memoryTracker.recordAllocation(*bufferMemory, MemoryCategory::Staging, memoryRequirements.size,
+                                   memoryAllocateInfo.memoryTypeIndex);
 
     if (data != nullptr) {
         void* dataMemory = bufferMemory.mapMemory(0, size);
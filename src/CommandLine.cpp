@@ -0,0 +1,199 @@
+#include <charconv>
+#include <filesystem>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+#include "CommandLine.hpp"
+#include "constants.hpp"
+
+namespace {
+auto requireValue(const int argc, char** argv, int& i) -> std::string_view {
+    if (i + 1 >= argc) {
+        throw std::runtime_error("Missing value for command line option " + std::string(argv[i]));
+    }
+    return argv[++i];
+}
+
+auto parseDouble(const std::string_view option, const std::string_view value) -> double {
+    try {
+        return std::stod(std::string(value));
+    } catch (const std::exception&) {
+        throw std::runtime_error("Invalid value '" + std::string(value) + "' for " + std::string(option));
+    }
+}
+
+// The whole value must be digits: no sign (stoul would wrap "-1"), no trailing junk, no overflow
+auto parseUnsigned(const std::string_view option, const std::string_view value) -> std::uint32_t {
+    std::uint32_t parsed = 0;
+    const char* end = value.data() + value.size();
+    const auto [ptr, error] = std::from_chars(value.data(), end, parsed);
+    if (value.empty() || value.front() == '-' || error != std::errc{} || ptr != end) {
+        throw std::runtime_error("Invalid value '" + std::string(value) + "' for " + std::string(option));
+    }
+    return parsed;
+}
+
+// "<width>x<height>"
+void parseSize(const std::string_view option, const std::string_view value, std::uint32_t& width, std::uint32_t& height) {
+    const auto separator = value.find('x');
+    if (separator == std::string_view::npos) {
+        throw std::runtime_error("Invalid value '" + std::string(value) + "' for " + std::string(option) + ", expected WxH");
+    }
+    width = parseUnsigned(option, value.substr(0, separator));
+    height = parseUnsigned(option, value.substr(separator + 1));
+    if (width == 0 || height == 0) {
+        throw std::runtime_error(std::string(option) + " must not be empty");
+    }
+}
+
+void selectDebugView(LaunchOptions& options, const DebugView view) {
+    if (options.debugView != DebugView::None && options.debugView != view) {
+        throw std::runtime_error("--overdraw, --ray-counters and --ray-candidates are mutually exclusive");
+    }
+    options.debugView = view;
+}
+} // namespace
+
+auto parseCommandLine(const int argc, char** argv) -> LaunchOptions {
+    LaunchOptions options{};
+
+    for (int i = 1; i < argc; i++) {
+        const std::string_view arg = argv[i];
+
+        if (arg == "--headless") {
+            options.headless = true;
+        } else if (arg == "--frames") {
+            options.frameCount = parseUnsigned(arg, requireValue(argc, argv, i));
+        } else if (arg == "--scene") {
+            options.scenePath = requireValue(argc, argv, i);
+        } else if (arg == "--benchmark") {
+            options.benchmark = true;
+        } else if (arg == "--fixed-step") {
+            options.fixedTimeStep = parseDouble(arg, requireValue(argc, argv, i));
+            if (options.fixedTimeStep <= 0.0) {
+                throw std::runtime_error("--fixed-step must be positive");
+            }
+        } else if (arg == "--warmup") {
+            options.warmupFrames = parseUnsigned(arg, requireValue(argc, argv, i));
+        } else if (arg == "--benchmark-out") {
+            options.benchmarkOutput = requireValue(argc, argv, i);
+        } else if (arg == "--trace") {
+            options.tracePath = requireValue(argc, argv, i);
+        } else if (arg == "--hitch-threshold") {
+            options.hitchThreshold = parseDouble(arg, requireValue(argc, argv, i));
+            if (options.hitchThreshold <= 1.0) {
+                throw std::runtime_error("--hitch-threshold must be greater than 1");
+            }
+        } else if (arg == "--hitch-dir") {
+            options.hitchDirectory = requireValue(argc, argv, i);
+        } else if (arg == "--export") {
+            options.exportPath = requireValue(argc, argv, i);
+        } else if (arg == "--export-size") {
+            parseSize(arg, requireValue(argc, argv, i), options.exportWidth, options.exportHeight);
+        } else if (arg == "--export-supersample") {
+            options.exportSupersample = parseUnsigned(arg, requireValue(argc, argv, i));
+            if (options.exportSupersample < 1 || options.exportSupersample > EXPORT_MAX_SUPERSAMPLE) {
+                throw std::runtime_error("--export-supersample must be between 1 and " + std::to_string(EXPORT_MAX_SUPERSAMPLE));
+            }
+        } else if (arg == "--first-frame") {
+            options.exportFirstFrame = parseUnsigned(arg, requireValue(argc, argv, i));
+        } else if (arg == "--export-workers") {
+            options.exportWorkers = parseUnsigned(arg, requireValue(argc, argv, i));
+        } else if (arg == "--export-chunk") {
+            options.exportChunkFrames = parseUnsigned(arg, requireValue(argc, argv, i));
+            if (options.exportChunkFrames == 0) {
+                throw std::runtime_error("--export-chunk must be positive");
+            }
+        } else if (arg == "--bake-pvs") {
+            options.bakePvsPath = requireValue(argc, argv, i);
+        } else if (arg == "--pvs") {
+            options.pvsPath = requireValue(argc, argv, i);
+        } else if (arg == "--bake-probes") {
+            options.bakeProbesPath = requireValue(argc, argv, i);
+        } else if (arg == "--probes") {
+            options.probesPath = requireValue(argc, argv, i);
+        } else if (arg == "--stream-textures") {
+            options.streamTextures = true;
+        } else if (arg == "--live-metrics") {
+            options.liveMetricsName = requireValue(argc, argv, i);
+        } else if (arg == "--memory-report") {
+            options.memoryReportPath = requireValue(argc, argv, i);
+        } else if (arg == "--overdraw") {
+            selectDebugView(options, DebugView::Overdraw);
+        } else if (arg == "--ray-counters") {
+            selectDebugView(options, DebugView::RayCount);
+        } else if (arg == "--ray-candidates") {
+            selectDebugView(options, DebugView::RayCandidates);
+        } else if (arg == "--reset-pipeline-cache") {
+            options.resetPipelineCache = true;
+        } else if (arg == "--help" || arg == "-h") {
+            options.showHelp = true;
+        } else {
+            throw std::runtime_error("Unknown command line option: " + std::string(arg));
+        }
+    }
+
+    if (!options.exportPath.empty()) {
+        // Readback and encoding would show up in the frame times, and encoder jobs allocate
+        if (options.benchmark) {
+            throw std::runtime_error("--export and --benchmark are mutually exclusive");
+        }
+        // Several processes cannot append to one stream
+        if (options.exportWorkers > 0 && std::filesystem::path(options.exportPath).extension() == ".y4m") {
+            throw std::runtime_error("--export-workers needs a PNG directory, not a Y4M file");
+        }
+        options.headless = true;
+    } else if (options.exportFirstFrame > 0 || options.exportWorkers > 0 || options.exportChunkFrames > 0) {
+        throw std::runtime_error("--first-frame, --export-workers and --export-chunk need --export");
+    }
+
+    if (!options.bakePvsPath.empty()) {
+        if (options.benchmark || !options.exportPath.empty() || !options.pvsPath.empty()) {
+            throw std::runtime_error("--bake-pvs exits after the bake, it cannot be combined with --benchmark, --export or --pvs");
+        }
+        options.headless = true;
+    }
+
+    if (!options.bakeProbesPath.empty()) {
+        if (options.benchmark || !options.exportPath.empty() || !options.bakePvsPath.empty() || !options.probesPath.empty()) {
+            throw std::runtime_error("--bake-probes exits after the bake, it cannot be combined with --benchmark, --export, --bake-pvs or --probes");
+        }
+        options.headless = true;
+    }
+
+    return options;
+}
+
+void printUsage(const char* executableName) {
+    std::cout << "Usage: " << executableName << " [options]\n"
+              << "  --headless        Render offscreen without a window (no surface/swapchain/present)\n"
+              << "  --frames <n>      Exit after rendering n frames\n"
+              << "  --scene <path>    glTF binary scene to load (default: assets/scene_full.glb)\n"
+              << "  --benchmark       Deterministic camera-path replay, writes a frame-time report\n"
+              << "  --fixed-step <s>  Animation time step per benchmark or export frame (default: 1/60)\n"
+              << "  --warmup <n>      Benchmark frames excluded from the statistics (default: 0)\n"
+              << "  --benchmark-out <base>  Report path without extension (default: benchmark)\n"
+              << "  --trace <path>    Write CPU profiling zones as Chrome trace JSON on exit\n"
+              << "  --hitch-threshold <x>   Trace the frames around frames slower than x times the running median\n"
+              << "  --hitch-dir <dir>       Directory for hitch traces (default: hitches)\n"
+              << "  --export <dir|file.y4m>  Render headless at the fixed step and write every frame as PNG or Y4M\n"
+              << "  --export-size <WxH>      Exported frame size (default: 1920x1080)\n"
+              << "  --export-supersample <n> Render at n x n the export size and filter down (1-4, default: 1)\n"
+              << "  --first-frame <n>        Start the export at frame n of the fixed-step sequence (default: 0)\n"
+              << "  --export-workers <n>     Split the export across n worker processes (PNG directory only)\n"
+              << "  --export-chunk <n>       Frames per worker launch (default: range / (4 x workers))\n"
+              << "  --bake-pvs <path>       Bake potentially visible sets along the camera path into path and exit\n"
+              << "  --pvs <path>            Cull static instances from a baked PVS file (cinematic camera only)\n"
+              << "  --bake-probes <path>    Bake irradiance probes over the static city into path and exit (CPU)\n"
+              << "  --probes <path>         Light indirect diffuse from a baked probe file instead of the sky texture\n"
+              << "  --stream-textures       Stream texture mips in ahead of the camera path instead of loading them all\n"
+              << "  --live-metrics <name>   Publish per-frame metrics to a shared memory segment (see LiveMetricsReader)\n"
+              << "  --memory-report <path>  Write device memory per category and heap budgets as JSON on exit\n"
+              << "  --overdraw        Show fragments per pixel of the scene passes as a heatmap\n"
+              << "  --ray-counters    Show shadow and reflection rays per pixel as a heatmap, report ray totals\n"
+              << "  --ray-candidates  Show ray query candidate iterations per pixel as a heatmap, report ray totals\n"
+              << "  --reset-pipeline-cache  Ignore the on-disk pipeline cache and compile every pipeline cold\n"
+              << "  --help, -h        Show this message\n";
+}
@@ -7,24 +7,19 @@ CommandManager::CommandManager(VulkanCore& vulkanCore) : m_vulkanCore{vulkanCore
     createCommandBuffers();
 }
 
-void CommandManager::immediateSubmit(std::function<void(vk::CommandBuffer)>&& function) const {
-    const vk::CommandBufferAllocateInfo allocInfo{
-        .commandPool = *m_commandPool,
-        .level = vk::CommandBufferLevel::ePrimary,
-        .commandBufferCount = 1
-    };
-
-    const vk::raii::CommandBuffers commandBuffers(m_vulkanCore.device(), allocInfo);
-    vk::CommandBuffer cmd = *commandBuffers.front();
+auto CommandManager::beginImmediate() const -> vk::CommandBuffer {
+    const vk::CommandBuffer cmd = *m_immediateCommandBuffer;
 
     constexpr vk::CommandBufferBeginInfo beginInfo{
         .flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit
     };
 
+    // The pool allows individual resets, begin() implicitly resets the previous recording
     cmd.begin(beginInfo);
+    return cmd;
+}
 
-    function(cmd);
-
+void CommandManager::endImmediate(const vk::CommandBuffer cmd) const {
     cmd.end();
 
     const vk::SubmitInfo submitInfo{
@@ -55,4 +50,12 @@ void CommandManager::createCommandBuffers() {
     };
 
     m_commandBuffers = vk::raii::CommandBuffers(m_vulkanCore.device(), allocInfo);
+
+    const vk::CommandBufferAllocateInfo immediateAllocInfo{
+        .commandPool = m_commandPool,
+        .level = vk::CommandBufferLevel::ePrimary,
+        .commandBufferCount = 1,
+    };
+
+    m_immediateCommandBuffer = std::move(vk::raii::CommandBuffers(m_vulkanCore.device(), immediateAllocInfo).front());
 }
@@ -0,0 +1,167 @@
+#include <algorithm>
+#include <array>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+
+#include "CpuProfiler.hpp"
+
+namespace {
+// Fields are relaxed atomics so a snapshot taken mid-run (HitchDetector) reads them without a data race;
+// whether the three values belong together is decided by the ring's head afterwards
+struct ZoneSlot {
+    std::atomic<const char*> name{nullptr};
+    std::atomic<std::uint64_t> startNs{0};
+    std::atomic<std::uint64_t> endNs{0};
+};
+
+// One ring per thread, all in static storage so recording never allocates.
+// Only the owning thread writes; readers use `head` to detect entries that were overwritten while copying.
+struct ThreadRing {
+    std::array<ZoneSlot, CPU_PROFILER_EVENTS_PER_THREAD> events{};
+    std::atomic<std::uint64_t> head{0};
+    std::atomic<const char*> name{nullptr};
+};
+
+std::array<ThreadRing, CPU_PROFILER_MAX_THREADS> g_rings;
+std::atomic<std::uint32_t> g_registeredThreads{0};
+
+// Index of the calling thread's ring, CPU_PROFILER_MAX_THREADS if the table is full
+auto threadRingIndex() -> std::uint32_t {
+    thread_local const std::uint32_t index = [] {
+        const auto claimed = g_registeredThreads.fetch_add(1, std::memory_order_relaxed);
+        return claimed < CPU_PROFILER_MAX_THREADS ? claimed : static_cast<std::uint32_t>(CPU_PROFILER_MAX_THREADS);
+    }();
+    return index;
+}
+
+auto escapeJson(const char* value) -> std::string {
+    std::string escaped;
+    for (const char* c = value; *c != '\0'; c++) {
+        if (*c == '"' || *c == '\\') {
+            escaped.push_back('\\');
+        }
+        escaped.push_back(*c);
+    }
+    return escaped;
+}
+} // namespace
+
+void CpuProfiler::record(const char* name, const std::uint64_t startNs, const std::uint64_t endNs) {
+    const auto ringIndex = threadRingIndex();
+    if (ringIndex >= CPU_PROFILER_MAX_THREADS) {
+        return;
+    }
+
+    auto& ring = g_rings[ringIndex];
+    const auto head = ring.head.load(std::memory_order_relaxed);
+    auto& slot = ring.events[head % CPU_PROFILER_EVENTS_PER_THREAD];
+    slot.name.store(name, std::memory_order_relaxed);
+    slot.startNs.store(startNs, std::memory_order_relaxed);
+    slot.endNs.store(endNs, std::memory_order_relaxed);
+    ring.head.store(head + 1, std::memory_order_release);
+}
+
+void CpuProfiler::setThreadName(const char* name) {
+    const auto ringIndex = threadRingIndex();
+    if (ringIndex < CPU_PROFILER_MAX_THREADS) {
+        g_rings[ringIndex].name.store(name, std::memory_order_relaxed);
+    }
+}
+
+auto CpuProfiler::threadName(const std::uint32_t threadIndex) -> const char* {
+    if (threadIndex >= CPU_PROFILER_MAX_THREADS) {
+        return nullptr;
+    }
+    return g_rings[threadIndex].name.load(std::memory_order_relaxed);
+}
+
+auto CpuProfiler::snapshot(const std::uint64_t sinceNs) -> std::vector<CpuTraceEvent> {
+    std::vector<CpuTraceEvent> result;
+
+    const auto threadCount = std::min<std::uint32_t>(g_registeredThreads.load(std::memory_order_relaxed),
+                                                     CPU_PROFILER_MAX_THREADS);
+
+    for (std::uint32_t threadIdx = 0; threadIdx < threadCount; threadIdx++) {
+        const auto& ring = g_rings[threadIdx];
+
+        const auto headBefore = ring.head.load(std::memory_order_acquire);
+        const auto available = std::min<std::uint64_t>(headBefore, CPU_PROFILER_EVENTS_PER_THREAD);
+        const auto first = headBefore - available;
+        const auto copyStart = result.size();
+
+        for (std::uint64_t i = first; i < headBefore; i++) {
+            const auto& slot = ring.events[i % CPU_PROFILER_EVENTS_PER_THREAD];
+            result.push_back({.name = slot.name.load(std::memory_order_relaxed),
+                              .startNs = slot.startNs.load(std::memory_order_relaxed),
+                              .endNs = slot.endNs.load(std::memory_order_relaxed),
+                              .threadIndex = threadIdx});
+        }
+
+        // Anything the writer lapped while we were copying may be torn, drop it. The fence orders the slot
+        // reads before the head read. Event headAfter - N may be mid-write too: the writer fills slot
+        // head % N before it publishes head + 1, so only events after it are complete.
+        std::atomic_thread_fence(std::memory_order_acquire);
+        const auto headAfter = ring.head.load(std::memory_order_relaxed);
+        const auto firstValid = headAfter >= CPU_PROFILER_EVENTS_PER_THREAD
+                                    ? headAfter - CPU_PROFILER_EVENTS_PER_THREAD + 1
+                                    : 0;
+        const auto torn = firstValid > first ? std::min(firstValid - first, available) : 0;
+        result.erase(result.begin() + static_cast<std::ptrdiff_t>(copyStart),
+                     result.begin() + static_cast<std::ptrdiff_t>(copyStart + torn));
+    }
+
+    std::erase_if(result, [sinceNs](const CpuTraceEvent& event) {
+        return event.endNs < sinceNs || event.name == nullptr;
+    });
+
+    return result;
+}
+
+void CpuProfiler::writeChromeTrace(const std::string& path, const std::uint64_t sinceNs) {
+    std::ofstream file(path);
+    if (!file) {
+        throw std::runtime_error("Failed to open trace file for writing: " + path);
+    }
+
+    file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+
+    bool first = true;
+    const auto zoneCount = writeChromeTraceEvents(file, sinceNs, first);
+
+    file << "\n]}\n";
+
+    std::cout << "[Profiler] Wrote " << zoneCount << " CPU zones to " << path << std::endl;
+}
+
+auto CpuProfiler::writeChromeTraceEvents(std::ostream& out, const std::uint64_t sinceNs, bool& first) -> std::size_t {
+    const auto events = snapshot(sinceNs);
+
+    const auto separator = [&first, &out] {
+        if (!first) {
+            out << ",\n";
+        }
+        first = false;
+    };
+
+    // Thread name metadata
+    const auto threadCount = std::min<std::uint32_t>(g_registeredThreads.load(std::memory_order_relaxed),
+                                                     CPU_PROFILER_MAX_THREADS);
+    for (std::uint32_t threadIdx = 0; threadIdx < threadCount; threadIdx++) {
+        const char* name = threadName(threadIdx);
+        separator();
+        out << std::format(R"({{"name":"thread_name","ph":"M","pid":1,"tid":{},"args":{{"name":"{}"}}}})",
+                           threadIdx, name ? escapeJson(name) : std::format("Thread {}", threadIdx));
+    }
+
+    // Complete events, timestamps in microseconds
+    for (const auto& event : events) {
+        separator();
+        out << std::format(R"({{"name":"{}","ph":"X","pid":1,"tid":{},"ts":{:.3f},"dur":{:.3f}}})",
+                           escapeJson(event.name), event.threadIndex, static_cast<double>(event.startNs) / 1000.0,
+                           static_cast<double>(event.endNs - event.startNs) / 1000.0);
+    }
+
+    return events.size();
+}
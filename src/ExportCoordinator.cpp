@@ -0,0 +1,446 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <format>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <signal.h>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char** environ;
+#endif
+
+#include "ExportCoordinator.hpp"
+#include "FrameExporter.hpp"
+#include "constants.hpp"
+
+namespace {
+constexpr auto POLL_INTERVAL = std::chrono::milliseconds(200);
+constexpr std::size_t MAX_REPORTED_GAPS = 10;
+
+// Ctrl+C reaches the workers too (same process group), they finish their frames in flight and exit early.
+// The coordinator stops starting chunks and reports what is missing.
+std::atomic<bool> g_interruptRequested{false};
+
+void onInterrupt(int /*signal*/) {
+    g_interruptRequested.store(true);
+}
+
+auto formatDuration(const double seconds) -> std::string {
+    const auto total = static_cast<long long>(seconds + 0.5);
+    return total >= 60 ? std::format("{}m{:02}s", total / 60, total % 60) : std::format("{}s", total);
+}
+
+auto frameRange(const std::uint32_t first, const std::uint32_t count) -> std::string {
+    return count == 1 ? std::to_string(first) : std::format("{}-{}", first, first + count - 1);
+}
+
+// Software rasterizers (lavapipe) start one thread per core in every process, split the cores between the
+// workers instead. An explicit LP_NUM_THREADS is left alone.
+void limitRasterizerThreads(const std::uint32_t workers) {
+    if (std::getenv("LP_NUM_THREADS") != nullptr) {
+        return;
+    }
+    const auto threads = std::to_string(std::max(1U, std::thread::hardware_concurrency() / workers));
+#ifdef _WIN32
+    _putenv_s("LP_NUM_THREADS", threads.c_str());
+#else
+    setenv("LP_NUM_THREADS", threads.c_str(), 0);
+#endif
+}
+
+#ifdef _WIN32
+// CommandLineToArgvW rules: backslashes are literal unless they precede a quote
+auto quoteArgument(const std::string& argument) -> std::string {
+    if (!argument.empty() && argument.find_first_of(" \t\"") == std::string::npos) {
+        return argument;
+    }
+
+    std::string quoted = "\"";
+    std::size_t backslashes = 0;
+    for (const char c : argument) {
+        if (c == '\\') {
+            backslashes++;
+            continue;
+        }
+        quoted.append(c == '"' ? backslashes * 2 + 1 : backslashes, '\\');
+        quoted += c;
+        backslashes = 0;
+    }
+    quoted.append(backslashes * 2, '\\');
+    quoted += '"';
+    return quoted;
+}
+#endif
+
+// A worker process with stdout and stderr redirected into a log file
+class WorkerProcess {
+public:
+    WorkerProcess(const std::string& executable,
+                  const std::vector<std::string>& arguments,
+                  const std::filesystem::path& logPath) {
+#ifdef _WIN32
+        std::string commandLine = quoteArgument(executable);
+        for (const auto& argument : arguments) {
+            commandLine += ' ' + quoteArgument(argument);
+        }
+
+        SECURITY_ATTRIBUTES security{
+            .nLength = sizeof(SECURITY_ATTRIBUTES),
+            .lpSecurityDescriptor = nullptr,
+            .bInheritHandle = TRUE,
+        };
+        const HANDLE log = CreateFileW(logPath.c_str(), GENERIC_WRITE, FILE_SHARE_READ, &security, CREATE_ALWAYS,
+                                       FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (log == INVALID_HANDLE_VALUE) {
+            throw std::runtime_error("Failed to create worker log " + logPath.string());
+        }
+
+        STARTUPINFOA startup{};
+        startup.cb = sizeof(STARTUPINFOA);
+        startup.dwFlags = STARTF_USESTDHANDLES;
+        startup.hStdInput = GetStdHandle(STD_INPUT_HANDLE);
+        startup.hStdOutput = log;
+        startup.hStdError = log;
+
+        PROCESS_INFORMATION process{};
+        const BOOL created = CreateProcessA(nullptr, commandLine.data(), nullptr, nullptr, TRUE, 0, nullptr, nullptr,
+                                            &startup, &process);
+        CloseHandle(log);
+        if (!created) {
+            throw std::runtime_error("Failed to start worker " + executable + " (error " +
+                                     std::to_string(GetLastError()) + ")");
+        }
+        CloseHandle(process.hThread);
+        m_process = process.hProcess;
+#else
+        std::vector<char*> argv;
+        argv.push_back(const_cast<char*>(executable.c_str()));
+        for (const auto& argument : arguments) {
+            argv.push_back(const_cast<char*>(argument.c_str()));
+        }
+        argv.push_back(nullptr);
+
+        const std::string log = logPath.string();
+        posix_spawn_file_actions_t actions;
+        posix_spawn_file_actions_init(&actions);
+        posix_spawn_file_actions_addopen(&actions, STDOUT_FILENO, log.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        posix_spawn_file_actions_adddup2(&actions, STDOUT_FILENO, STDERR_FILENO);
+
+        const int result = posix_spawnp(&m_pid, executable.c_str(), &actions, nullptr, argv.data(), environ);
+        posix_spawn_file_actions_destroy(&actions);
+        if (result != 0) {
+            throw std::runtime_error("Failed to start worker " + executable + ": " + std::strerror(result));
+        }
+#endif
+    }
+
+    // A worker still running when the coordinator gives up (an exception) is killed, not orphaned
+    ~WorkerProcess() {
+#ifdef _WIN32
+        if (m_process != nullptr) {
+            TerminateProcess(m_process, 1);
+            WaitForSingleObject(m_process, INFINITE);
+            CloseHandle(m_process);
+        }
+#else
+        if (m_pid > 0) {
+            kill(m_pid, SIGTERM);
+            int status = 0;
+            waitpid(m_pid, &status, 0);
+        }
+#endif
+    }
+
+    WorkerProcess(const WorkerProcess&) = delete;
+    auto operator=(const WorkerProcess&) -> WorkerProcess& = delete;
+
+    // Exit code once the worker has exited, 128 + the signal number when it was killed
+    auto poll() -> std::optional<int> {
+#ifdef _WIN32
+        if (WaitForSingleObject(m_process, 0) != WAIT_OBJECT_0) {
+            return std::nullopt;
+        }
+        DWORD exitCode = 0;
+        GetExitCodeProcess(m_process, &exitCode);
+        CloseHandle(m_process);
+        m_process = nullptr;
+        return static_cast<int>(exitCode);
+#else
+        int status = 0;
+        const pid_t result = waitpid(m_pid, &status, WNOHANG);
+        if (result == 0) {
+            return std::nullopt;
+        }
+        m_pid = -1;
+        if (result < 0) {
+            return -1;
+        }
+        return WIFEXITED(status) ? WEXITSTATUS(status) : 128 + WTERMSIG(status);
+#endif
+    }
+
+private:
+#ifdef _WIN32
+    HANDLE m_process = nullptr;
+#else
+    pid_t m_pid = -1;
+#endif
+};
+} // namespace
+
+ExportCoordinator::ExportCoordinator(const LaunchOptions& options, std::string executable)
+    : m_options(options),
+      m_executable(std::move(executable)),
+      m_outputDirectory(m_options.exportPath),
+      m_logDirectory(m_outputDirectory / "worker_logs") {
+    if (m_options.frameCount == 0) {
+        m_options.frameCount = HEADLESS_DEFAULT_FRAME_COUNT;
+    }
+
+    const std::uint32_t workers = m_options.exportWorkers;
+    const std::uint32_t chunkFrames = m_options.exportChunkFrames > 0
+                                          ? m_options.exportChunkFrames
+                                          : std::max(1U, (m_options.frameCount + workers * EXPORT_CHUNKS_PER_WORKER - 1) /
+                                                             (workers * EXPORT_CHUNKS_PER_WORKER));
+
+    const std::uint32_t end = m_options.exportFirstFrame + m_options.frameCount;
+    for (std::uint32_t first = m_options.exportFirstFrame; first < end; first += chunkFrames) {
+        m_chunks.push_back(Chunk{.firstFrame = first, .frameCount = std::min(chunkFrames, end - first)});
+    }
+}
+
+void ExportCoordinator::run() {
+    std::filesystem::create_directories(m_logDirectory);
+    limitRasterizerThreads(m_options.exportWorkers);
+    std::signal(SIGINT, onInterrupt);
+
+    std::cout << std::format("[Export] Frames {} in {} chunks on {} worker processes, logs in {}",
+                             frameRange(m_options.exportFirstFrame, m_options.frameCount), m_chunks.size(),
+                             m_options.exportWorkers, m_logDirectory.string())
+              << std::endl;
+
+    struct Worker {
+        std::size_t chunk;
+        std::filesystem::path logPath;
+        std::unique_ptr<WorkerProcess> process;
+    };
+    std::vector<Worker> running;
+
+    // Retried chunks go to the back, the others keep their turn
+    std::deque<std::size_t> pending;
+    for (std::size_t i = 0; i < m_chunks.size(); i++) {
+        pending.push_back(i);
+    }
+
+    std::uint32_t launches = 0;
+    std::uint32_t retries = 0;
+    const auto start = std::chrono::steady_clock::now();
+    auto lastReport = start;
+
+    while (!running.empty() || (!pending.empty() && !g_interruptRequested.load())) {
+        while (!pending.empty() && running.size() < m_options.exportWorkers && !g_interruptRequested.load()) {
+            const std::size_t index = pending.front();
+            pending.pop_front();
+            Chunk& chunk = m_chunks[index];
+
+            // A retry resumes at the first frame the failed worker did not write. A chunk that is complete
+            // by then is never relaunched, a worker given --frames 0 would render the default frame count.
+            const std::uint32_t first = chunk.attempts == 0 ? chunk.firstFrame : firstMissingFrame(chunk);
+            const std::uint32_t end = chunk.firstFrame + chunk.frameCount;
+            if (first == end) {
+                chunk.done = true;
+                continue;
+            }
+            chunk.attempts++;
+            launches++;
+
+            auto logPath = m_logDirectory / std::format("chunk_{:06}_{}.log", chunk.firstFrame, chunk.attempts);
+            auto process = std::make_unique<WorkerProcess>(m_executable, workerArguments(first, end - first), logPath);
+            running.push_back(Worker{.chunk = index, .logPath = std::move(logPath), .process = std::move(process)});
+        }
+
+        std::this_thread::sleep_for(POLL_INTERVAL);
+
+        for (auto it = running.begin(); it != running.end();) {
+            const auto exitCode = it->process->poll();
+            if (!exitCode) {
+                ++it;
+                continue;
+            }
+
+            Chunk& chunk = m_chunks[it->chunk];
+            const std::uint32_t missing = chunk.frameCount - framesOnDisk(chunk);
+            if (missing == 0) {
+                // Every frame is on disk, a failure after the last one (e.g. at teardown) costs no retry
+                if (*exitCode != 0) {
+                    std::cout << std::format("[Export] Worker for frames {} wrote every frame but failed (exit code "
+                                             "{}), see {}",
+                                             frameRange(chunk.firstFrame, chunk.frameCount), *exitCode,
+                                             it->logPath.string())
+                              << std::endl;
+                }
+                chunk.done = true;
+            } else {
+                std::cout << std::format("[Export] Worker for frames {} {} with {} frames missing, see {}",
+                                         frameRange(chunk.firstFrame, chunk.frameCount),
+                                         *exitCode == 0 ? std::string("stopped early")
+                                                        : std::format("failed (exit code {})", *exitCode),
+                                         missing, it->logPath.string())
+                          << std::endl;
+
+                if (!g_interruptRequested.load() && chunk.attempts < EXPORT_CHUNK_MAX_ATTEMPTS) {
+                    pending.push_back(it->chunk);
+                    retries++;
+                }
+            }
+            it = running.erase(it);
+        }
+
+        const auto now = std::chrono::steady_clock::now();
+        if (std::chrono::duration<double>(now - lastReport).count() >= EXPORT_PROGRESS_INTERVAL_SECONDS) {
+            lastReport = now;
+
+            std::uint32_t written = 0;
+            for (const auto& chunk : m_chunks) {
+                written += chunk.done ? chunk.frameCount : 0;
+            }
+            for (const auto& worker : running) {
+                written += framesOnDisk(m_chunks[worker.chunk]);
+            }
+
+            const double seconds = std::chrono::duration<double>(now - start).count();
+            const double fps = static_cast<double>(written) / seconds;
+            std::cout << std::format("[Export] {}/{} frames ({:.1f}%), {} workers running, {:.1f} fps",
+                                     written, m_options.frameCount,
+                                     100.0 * static_cast<double>(written) / static_cast<double>(m_options.frameCount),
+                                     running.size(), fps);
+            if (fps > 0.0) {
+                std::cout << ", " << formatDuration(static_cast<double>(m_options.frameCount - written) / fps) << " left";
+            }
+            std::cout << std::endl;
+        }
+    }
+
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    const std::uint32_t missing = verifySequence();
+
+    if (g_interruptRequested.load()) {
+        throw std::runtime_error(std::format("Export interrupted with {} of {} frames missing", missing,
+                                             m_options.frameCount));
+    }
+    if (missing > 0) {
+        throw std::runtime_error(std::format("{} of {} frames still missing after {} attempts per chunk", missing,
+                                             m_options.frameCount, EXPORT_CHUNK_MAX_ATTEMPTS));
+    }
+
+    std::cout << std::format("[Export] All {} frames written to {} in {} ({:.1f} fps), {} worker launches, {} retries",
+                             m_options.frameCount, m_outputDirectory.string(), formatDuration(seconds),
+                             static_cast<double>(m_options.frameCount) / seconds, launches, retries)
+              << std::endl;
+}
+
+auto ExportCoordinator::workerArguments(const std::uint32_t firstFrame, const std::uint32_t frameCount) const
+    -> std::vector<std::string> {
+    std::vector<std::string> arguments{
+        "--scene", m_options.scenePath,
+        "--export", m_options.exportPath,
+        "--export-supersample", std::to_string(m_options.exportSupersample),
+        "--fixed-step", std::format("{}", m_options.fixedTimeStep),  // Shortest representation that round-trips
+        "--first-frame", std::to_string(firstFrame),
+        "--frames", std::to_string(frameCount),
+    };
+
+    if (m_options.exportWidth > 0) {
+        arguments.emplace_back("--export-size");
+        arguments.push_back(std::format("{}x{}", m_options.exportWidth, m_options.exportHeight));
+    }
+
+    // Changes the lighting, so every chunk must use it
+    if (!m_options.probesPath.empty()) {
+        arguments.emplace_back("--probes");
+        arguments.push_back(m_options.probesPath);
+    }
+
+    switch (m_options.debugView) {
+        case DebugView::Overdraw: arguments.emplace_back("--overdraw"); break;
+        case DebugView::RayCount: arguments.emplace_back("--ray-counters"); break;
+        case DebugView::RayCandidates: arguments.emplace_back("--ray-candidates"); break;
+        case DebugView::None: break;
+    }
+
+    return arguments;
+}
+
+auto ExportCoordinator::frameExists(const std::uint32_t frame) const -> bool {
+    std::error_code error;
+    return std::filesystem::exists(FrameExporter::framePath(m_outputDirectory, frame), error);
+}
+
+auto ExportCoordinator::firstMissingFrame(const Chunk& chunk) const -> std::uint32_t {
+    const std::uint32_t end = chunk.firstFrame + chunk.frameCount;
+    for (std::uint32_t frame = chunk.firstFrame; frame < end; frame++) {
+        if (!frameExists(frame)) {
+            return frame;
+        }
+    }
+    return end;
+}
+
+auto ExportCoordinator::framesOnDisk(const Chunk& chunk) const -> std::uint32_t {
+    std::uint32_t count = 0;
+    for (std::uint32_t frame = chunk.firstFrame; frame < chunk.firstFrame + chunk.frameCount; frame++) {
+        count += frameExists(frame) ? 1 : 0;
+    }
+    return count;
+}
+
+auto ExportCoordinator::verifySequence() const -> std::uint32_t {
+    // Frames are renamed into place once complete, a .tmp is what a killed worker was writing
+    std::error_code error;
+    for (const auto& entry : std::filesystem::directory_iterator(m_outputDirectory, error)) {
+        if (entry.path().extension() == ".tmp" && entry.path().filename().string().starts_with("frame_")) {
+            std::filesystem::remove(entry.path(), error);
+        }
+    }
+
+    std::vector<std::pair<std::uint32_t, std::uint32_t>> gaps;  // First frame and length of each missing run
+    std::uint32_t missing = 0;
+    const std::uint32_t end = m_options.exportFirstFrame + m_options.frameCount;
+    for (std::uint32_t frame = m_options.exportFirstFrame; frame < end; frame++) {
+        if (frameExists(frame)) {
+            continue;
+        }
+        if (!gaps.empty() && gaps.back().first + gaps.back().second == frame) {
+            gaps.back().second++;
+        } else {
+            gaps.emplace_back(frame, 1);
+        }
+        missing++;
+    }
+
+    for (std::size_t i = 0; i < std::min(gaps.size(), MAX_REPORTED_GAPS); i++) {
+        std::cout << "[Export] Missing frames " << frameRange(gaps[i].first, gaps[i].second) << std::endl;
+    }
+    if (gaps.size() > MAX_REPORTED_GAPS) {
+        std::cout << "[Export] ... and " << gaps.size() - MAX_REPORTED_GAPS << " more gaps" << std::endl;
+    }
+    return missing;
+}
@@ -0,0 +1,410 @@
+#include <algorithm>
+#include <cmath>
+#include <exception>
+#include <format>
+#include <iostream>
+#include <stdexcept>
+#include <utility>
+#include <stb_image_write.h>
+
+#include "BufferManager.hpp"
+#include "CpuProfiler.hpp"
+#include "FrameExporter.hpp"
+#include "JobSystem.hpp"
+#include "VulkanCore.hpp"
+
+namespace {
+constexpr vk::MemoryPropertyFlags HOST_CACHED = vk::MemoryPropertyFlagBits::eHostVisible |
+                                                vk::MemoryPropertyFlagBits::eHostCached;
+constexpr vk::MemoryPropertyFlags HOST_COHERENT = vk::MemoryPropertyFlagBits::eHostVisible |
+                                                  vk::MemoryPropertyFlagBits::eHostCoherent;
+
+// BT.709 luma of gamma-encoded components
+float luma(const float r, const float g, const float b) {
+    return 0.2126f * r + 0.7152f * g + 0.0722f * b;
+}
+
+// Limited range: luma 16-235, chroma 16-240 around 128
+std::uint8_t limitedLuma(const float y) {
+    return static_cast<std::uint8_t>(16.0f + y * (219.0f / 255.0f) + 0.5f);
+}
+
+std::uint8_t limitedChroma(const float c) {
+    return static_cast<std::uint8_t>(std::clamp(128.0f + c * (224.0f / 255.0f) + 0.5f, 0.0f, 255.0f));
+}
+} // namespace
+
+FrameExporter::FrameExporter(VulkanCore& vulkanCore,
+                             BufferManager& bufferManager,
+                             JobSystem& jobSystem,
+                             std::filesystem::path outputPath,
+                             const vk::Extent2D renderExtent,
+                             const vk::Format format,
+                             const std::uint32_t supersample,
+                             const double frameTime,
+                             const std::uint64_t firstFrame)
+    : m_vulkanCore(vulkanCore),
+      m_jobSystem(jobSystem),
+      m_outputPath(std::move(outputPath)),
+      m_format(m_outputPath.extension() == ".y4m" ? Format::Y4m : Format::Png),
+      m_renderExtent(renderExtent),
+      m_outputExtent{.width = renderExtent.width / supersample, .height = renderExtent.height / supersample},
+      m_supersample(supersample),
+      m_firstFrame(firstFrame) {
+    switch (format) {
+        case vk::Format::eB8G8R8A8Srgb:
+        case vk::Format::eB8G8R8A8Unorm:
+            m_bgra = true;
+            break;
+        case vk::Format::eR8G8B8A8Srgb:
+        case vk::Format::eR8G8B8A8Unorm:
+            m_bgra = false;
+            break;
+        default:
+            throw std::runtime_error("Frame export needs an 8-bit RGBA or BGRA image, not " + vk::to_string(format));
+    }
+
+    if (m_format == Format::Y4m && (m_outputExtent.width % 2 != 0 || m_outputExtent.height % 2 != 0)) {
+        throw std::runtime_error("Y4M export (4:2:0) needs an even output size");
+    }
+
+    for (std::size_t i = 0; i < m_srgbToLinear.size(); i++) {
+        const float c = static_cast<float>(i) / 255.0f;
+        m_srgbToLinear[i] = c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+    }
+    for (std::size_t i = 0; i < m_linearToSrgb.size(); i++) {
+        const float l = static_cast<float>(i) / static_cast<float>(m_linearToSrgb.size() - 1);
+        const float c = l <= 0.0031308f ? l * 12.92f : 1.055f * std::pow(l, 1.0f / 2.4f) - 0.055f;
+        m_linearToSrgb[i] = static_cast<std::uint8_t>(c * 255.0f + 0.5f);
+    }
+
+    // The workers read every byte; uncached (write-combined) host memory is very slow to read from the CPU
+    const auto memProperties = m_vulkanCore.physicalDevice().getMemoryProperties();
+    m_hostCached = false;
+    for (std::uint32_t i = 0; i < memProperties.memoryTypeCount; i++) {
+        if ((memProperties.memoryTypes[i].propertyFlags & HOST_CACHED) == HOST_CACHED) {
+            m_hostCached = true;
+        }
+    }
+
+    // One buffer per frame in flight, plus one per frame the workers may be encoding at the same time
+    const std::uint32_t encoders = std::clamp(m_jobSystem.workerCount(), 1U, EXPORT_MAX_ENCODERS);
+    const vk::DeviceSize readbackSize = static_cast<vk::DeviceSize>(m_renderExtent.width) * m_renderExtent.height * 4;
+    const std::size_t outputPixels = static_cast<std::size_t>(m_outputExtent.width) * m_outputExtent.height;
+
+    m_readbacks.resize(MAX_FRAMES_IN_FLIGHT + encoders);
+    for (auto& readback : m_readbacks) {
+        bufferManager.createBuffer(
+            MemoryCategory::ExportReadback,
+            readbackSize,
+            vk::BufferUsageFlagBits::eTransferDst,
+            m_hostCached ? HOST_CACHED : HOST_COHERENT,
+            readback.buffer,
+            readback.memory
+        );
+        readback.mapped = static_cast<const std::uint8_t*>(readback.memory.mapMemory(0, readbackSize));
+        readback.rgb.resize(outputPixels * 3);
+        if (m_format == Format::Y4m) {
+            readback.yuv.resize(outputPixels * 3 / 2);
+        }
+    }
+
+    if (m_format == Format::Png) {
+        std::filesystem::create_directories(m_outputPath);
+        stbi_write_png_compression_level = EXPORT_PNG_COMPRESSION_LEVEL;
+    } else {
+        if (m_outputPath.has_parent_path()) {
+            std::filesystem::create_directories(m_outputPath.parent_path());
+        }
+        m_y4m.open(m_outputPath, std::ios::binary);
+        if (!m_y4m) {
+            throw std::runtime_error("Failed to open export stream for writing: " + m_outputPath.string());
+        }
+
+        // Exact for integer frame rates, microsecond steps otherwise
+        const double rate = 1.0 / frameTime;
+        const bool integerRate = std::abs(rate - std::round(rate)) < 1e-3;
+        const long long numerator = integerRate ? std::llround(rate) : 1000000LL;
+        const long long denominator = integerRate ? 1LL : std::llround(frameTime * 1e6);
+
+        // C420jpeg: chroma sited between the luma samples (2x2 averages). BT.709 matrix, limited range.
+        m_y4m << std::format("YUV4MPEG2 W{} H{} F{}:{} Ip A1:1 C420jpeg XCOLORRANGE=LIMITED\n", m_outputExtent.width,
+                             m_outputExtent.height, numerator, denominator);
+    }
+
+    std::cout << std::format("[Export] {}x{} {} to {} (rendered at {}x{}, {} readback buffers in {} memory)",
+                             m_outputExtent.width, m_outputExtent.height,
+                             m_format == Format::Png ? "PNG frames" : "Y4M video", m_outputPath.string(),
+                             m_renderExtent.width, m_renderExtent.height, m_readbacks.size(),
+                             m_hostCached ? "host cached" : "host coherent")
+              << std::endl;
+}
+
+FrameExporter::~FrameExporter() {
+    waitForEncoders();
+}
+
+void FrameExporter::recordCopy(const vk::raii::CommandBuffer& cmd, const vk::Image image, const std::uint32_t frameIndex) {
+    if (m_recordedFrames == 0) {
+        m_start = std::chrono::steady_clock::now();
+    }
+
+    const auto index = static_cast<std::uint32_t>(m_recordedFrames % m_readbacks.size());
+    Readback& readback = m_readbacks[index];
+
+    // The GPU finished with this buffer MAX_FRAMES_IN_FLIGHT frames ago at the latest, only its encode may still run
+    if (readback.encode.valid()) {
+        if (readback.encode.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+            PROFILE_ZONE("FrameExporter::waitForEncoder");
+            const auto waitStart = std::chrono::steady_clock::now();
+            readback.encode.wait();
+            m_stalls++;
+            m_stallMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - waitStart).count();
+        }
+        readback.encode.get();  // Rethrows a failed encode
+    }
+    readback.frame = m_recordedFrames++;
+
+    cmd.copyImageToBuffer(
+        image,
+        vk::ImageLayout::eTransferSrcOptimal,
+        *readback.buffer,
+        vk::BufferImageCopy{
+            .bufferOffset = 0,
+            .bufferRowLength = 0,
+            .bufferImageHeight = 0,
+            .imageSubresource = {
+                .aspectMask = vk::ImageAspectFlagBits::eColor,
+                .mipLevel = 0,
+                .baseArrayLayer = 0,
+                .layerCount = 1,
+            },
+            .imageOffset = {0, 0, 0},
+            .imageExtent = {m_renderExtent.width, m_renderExtent.height, 1},
+        });
+
+    // Makes the copy visible to the host once the frame's fence signals
+    const vk::MemoryBarrier2 readbackBarrier{
+        .srcStageMask = vk::PipelineStageFlagBits2::eCopy,
+        .srcAccessMask = vk::AccessFlagBits2::eTransferWrite,
+        .dstStageMask = vk::PipelineStageFlagBits2::eHost,
+        .dstAccessMask = vk::AccessFlagBits2::eHostRead,
+    };
+
+    cmd.pipelineBarrier2(vk::DependencyInfo{
+        .memoryBarrierCount = 1,
+        .pMemoryBarriers = &readbackBarrier,
+    });
+
+    m_inFlight[frameIndex] = index;
+}
+
+void FrameExporter::resolve(const std::uint32_t frameIndex) {
+    if (!m_inFlight[frameIndex]) {
+        return;
+    }
+    Readback& readback = m_readbacks[*m_inFlight[frameIndex]];
+    m_inFlight[frameIndex].reset();
+
+    if (m_hostCached) {
+        m_vulkanCore.device().invalidateMappedMemoryRanges(vk::MappedMemoryRange{
+            .memory = *readback.memory,
+            .offset = 0,
+            .size = vk::WholeSize,
+        });
+    }
+
+    readback.encode = m_jobSystem.submit([this, &readback] { encode(readback); });
+}
+
+void FrameExporter::finish() {
+    // Oldest frame first, Y4M workers append in the order their jobs were submitted
+    while (true) {
+        std::optional<std::uint32_t> oldest;
+        for (std::uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
+            if (m_inFlight[i] && (!oldest || m_readbacks[*m_inFlight[i]].frame < m_readbacks[*m_inFlight[*oldest]].frame)) {
+                oldest = i;
+            }
+        }
+        if (!oldest) {
+            break;
+        }
+        resolve(*oldest);
+    }
+
+    for (auto& readback : m_readbacks) {
+        if (readback.encode.valid()) {
+            readback.encode.get();
+        }
+    }
+
+    if (m_format == Format::Y4m) {
+        m_y4m.flush();
+        if (!m_y4m) {
+            throw std::runtime_error("Failed to write export stream: " + m_outputPath.string());
+        }
+        m_y4m.close();
+    }
+
+    if (m_recordedFrames == 0) {
+        std::cout << "[Export] No frames rendered" << std::endl;
+        return;
+    }
+
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - m_start).count();
+    std::cout << std::format("[Export] Wrote {} frames to {} in {:.1f}s ({:.1f} fps), waited for the encoders {} times "
+                             "({:.0f} ms)",
+                             m_recordedFrames, m_outputPath.string(), seconds,
+                             static_cast<double>(m_recordedFrames) / seconds, m_stalls, m_stallMs)
+              << std::endl;
+}
+
+void FrameExporter::encode(Readback& readback) {
+    PROFILE_ZONE("FrameExporter::encode");
+
+    if (m_format == Format::Png) {
+        convertToRgb(readback);
+        writePng(readback);
+        return;
+    }
+
+    // Later frames wait for this one's turn, it has to pass even when the conversion fails
+    std::exception_ptr error;
+    try {
+        convertToRgb(readback);
+        convertToYuv(readback);
+    } catch (...) {
+        error = std::current_exception();
+    }
+
+    appendY4m(readback, error == nullptr);
+
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+void FrameExporter::convertToRgb(Readback& readback) const {
+    const std::size_t red = m_bgra ? 2 : 0;
+    const std::size_t blue = m_bgra ? 0 : 2;
+    const std::size_t width = m_outputExtent.width;
+    const std::size_t height = m_outputExtent.height;
+    const std::uint8_t* source = readback.mapped;
+    std::uint8_t* rgb = readback.rgb.data();
+
+    if (m_supersample == 1) {
+        for (std::size_t pixel = 0; pixel < width * height; pixel++) {
+            rgb[pixel * 3 + 0] = source[pixel * 4 + red];
+            rgb[pixel * 3 + 1] = source[pixel * 4 + 1];
+            rgb[pixel * 3 + 2] = source[pixel * 4 + blue];
+        }
+        return;
+    }
+
+    // Box filter over supersample x supersample rendered pixels
+    const std::size_t factor = m_supersample;
+    const std::size_t sourcePitch = static_cast<std::size_t>(m_renderExtent.width) * 4;
+    const float scale = static_cast<float>(m_linearToSrgb.size() - 1) / static_cast<float>(factor * factor);
+    const auto encodeLinear = [this, scale](const float sum) {
+        return m_linearToSrgb[std::min(static_cast<std::size_t>(sum * scale + 0.5f), m_linearToSrgb.size() - 1)];
+    };
+
+    for (std::size_t y = 0; y < height; y++) {
+        for (std::size_t x = 0; x < width; x++) {
+            float r = 0.0f;
+            float g = 0.0f;
+            float b = 0.0f;
+            for (std::size_t sy = 0; sy < factor; sy++) {
+                const std::uint8_t* row = source + (y * factor + sy) * sourcePitch + x * factor * 4;
+                for (std::size_t sx = 0; sx < factor; sx++) {
+                    const std::uint8_t* texel = row + sx * 4;
+                    r += m_srgbToLinear[texel[red]];
+                    g += m_srgbToLinear[texel[1]];
+                    b += m_srgbToLinear[texel[blue]];
+                }
+            }
+
+            std::uint8_t* out = rgb + (y * width + x) * 3;
+            out[0] = encodeLinear(r);
+            out[1] = encodeLinear(g);
+            out[2] = encodeLinear(b);
+        }
+    }
+}
+
+auto FrameExporter::framePath(const std::filesystem::path& directory, const std::uint64_t frame) -> std::filesystem::path {
+    return directory / std::format("frame_{:06}.png", frame);
+}
+
+void FrameExporter::writePng(const Readback& readback) const {
+    const auto path = framePath(m_outputPath, m_firstFrame + readback.frame);
+    auto tempPath = path;
+    tempPath += ".tmp";
+    const auto width = static_cast<int>(m_outputExtent.width);
+    const auto height = static_cast<int>(m_outputExtent.height);
+
+    if (stbi_write_png(tempPath.string().c_str(), width, height, 3, readback.rgb.data(), width * 3) == 0) {
+        throw std::runtime_error("Failed to write exported frame: " + tempPath.string());
+    }
+    std::filesystem::rename(tempPath, path);
+}
+
+void FrameExporter::convertToYuv(Readback& readback) const {
+    const std::size_t width = m_outputExtent.width;
+    const std::size_t height = m_outputExtent.height;
+    const std::uint8_t* rgb = readback.rgb.data();
+    std::uint8_t* lumaPlane = readback.yuv.data();
+    std::uint8_t* cbPlane = lumaPlane + width * height;
+    std::uint8_t* crPlane = cbPlane + width * height / 4;
+
+    for (std::size_t pixel = 0; pixel < width * height; pixel++) {
+        const std::uint8_t* in = rgb + pixel * 3;
+        lumaPlane[pixel] = limitedLuma(luma(in[0], in[1], in[2]));
+    }
+
+    // One chroma sample from the average of each 2x2 block
+    for (std::size_t y = 0; y < height / 2; y++) {
+        for (std::size_t x = 0; x < width / 2; x++) {
+            float r = 0.0f;
+            float g = 0.0f;
+            float b = 0.0f;
+            for (std::size_t sy = 0; sy < 2; sy++) {
+                for (std::size_t sx = 0; sx < 2; sx++) {
+                    const std::uint8_t* in = rgb + ((y * 2 + sy) * width + x * 2 + sx) * 3;
+                    r += in[0];
+                    g += in[1];
+                    b += in[2];
+                }
+            }
+            r *= 0.25f;
+            g *= 0.25f;
+            b *= 0.25f;
+
+            const float y709 = luma(r, g, b);
+            cbPlane[y * (width / 2) + x] = limitedChroma((b - y709) / 1.8556f);
+            crPlane[y * (width / 2) + x] = limitedChroma((r - y709) / 1.5748f);
+        }
+    }
+}
+
+void FrameExporter::appendY4m(const Readback& readback, const bool converted) {
+    std::unique_lock lock(m_y4mMutex);
+    m_y4mTurn.wait(lock, [this, &readback] { return m_y4mNextFrame == readback.frame; });
+
+    if (converted) {
+        m_y4m << "FRAME\n";
+        m_y4m.write(reinterpret_cast<const char*>(readback.yuv.data()), static_cast<std::streamsize>(readback.yuv.size()));
+    }
+    m_y4mNextFrame++;
+
+    lock.unlock();
+    m_y4mTurn.notify_all();
+}
+
+void FrameExporter::waitForEncoders() {
+    for (auto& readback : m_readbacks) {
+        if (readback.encode.valid()) {
+            readback.encode.wait();
+        }
+    }
+}
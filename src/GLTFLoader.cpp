@@ -2,11 +2,14 @@
 #include <memory>
 #include <cstdint>
 #include <limits>
+#include <stdexcept>
 #include <glm/glm.hpp>
 
 #include "constants.hpp"
 #include "SharedTypes.hpp"
 #include "GLTFLoader.hpp"
+#include "CpuProfiler.hpp"
+#include "JobSystem.hpp"
 
 inline float lux_to_radiance(float lux, float radius) {
     constexpr float lumenToWatt = 683.0f;
@@ -19,19 +22,38 @@ inline float lux_to_radiance(float lux, float radius) {
     return lux / (lumenToWatt * area);
 }
 
-GLTFLoader::GLTFLoader() {
+GLTFLoader::GLTFLoader(JobSystem& jobSystem) : m_jobSystem(jobSystem) {
 }
 
 std::unique_ptr<LoadedGLTF> GLTFLoader::load(const std::string& path) {
+    PROFILE_ZONE("GLTFLoader::load");
+
     tinygltf::TinyGLTF loader;
     tinygltf::Model model;
 
     std::string err;
     std::string warn;
 
+    // Images are only captured while parsing and decoded on the workers afterwards
+    m_encodedImages.clear();
+    loader.SetImageLoader(&GLTFLoader::deferImageDecode, this);
+
+    {
+        PROFILE_ZONE("GLTFLoader::parseBinary");
+        if (!loader.LoadBinaryFromFile(&model, &err, &warn, path)) {
+            throw std::runtime_error("Failed to load glTF " + path + ": " + err);
+        }
+    }
+
+    return loadModel(std::move(model));
+}
+
+std::unique_ptr<LoadedGLTF> GLTFLoader::loadModel(tinygltf::Model model) {
+    PROFILE_ZONE("GLTFLoader::loadModel");
+
     LoadedGLTF loaded;
 
-    loader.LoadBinaryFromFile(&model, &err, &warn, path);
+    decodeImages(model);
 
     computeWorldMatrices(model);
     computePrimitiveToGeometryMapping(model);
@@ -39,21 +61,30 @@ std::unique_ptr<LoadedGLTF> GLTFLoader::load(const std::string& path) {
     loadMaterialsAndTextures(model, loaded.scene);
     loadMeshes(model, loaded.scene);
     loadNodes(model, loaded.scene);
+    partitionDynamicInstances(model, loaded.scene);
 
     // Build mesh-to-instance mapping for indirect drawing
     buildMeshToInstanceMapping(loaded.scene);
 
+    loaded.scene.instanceGenerations.reset(loaded.scene.instances.size(), loaded.scene.firstDynamicInstance);
+    loaded.scene.pointLightGenerations.reset(loaded.scene.pointLights.size());
+    loaded.scene.spotLightGenerations.reset(loaded.scene.spotLights.size());
+
     // Store the model for animation
     loaded.model = std::move(model);
 
+    m_loadArena.release();
+
     return std::make_unique<LoadedGLTF>(std::move(loaded));
 }
 
 void GLTFLoader::computeWorldMatrices(const tinygltf::Model& model) {
+    PROFILE_ZONE("GLTFLoader::computeWorldMatrices");
+
     m_nodeWorldMatrices = std::vector(model.nodes.size(), glm::mat4(1.0f));
 
     // Find root nodes (nodes that are not children of any other node)
-    std::vector<bool> isChild(model.nodes.size(), false);
+    std::pmr::vector<bool> isChild(model.nodes.size(), false, &m_loadArena);
     for (const auto& node : model.nodes) {
         for (const int childIdx : node.children) {
             if (childIdx >= 0 && static_cast<std::size_t>(childIdx) < model.nodes.size()) {
@@ -71,6 +102,8 @@ void GLTFLoader::computeWorldMatrices(const tinygltf::Model& model) {
 }
 
 void GLTFLoader::computePrimitiveToGeometryMapping(const tinygltf::Model& model) {
+    PROFILE_ZONE("GLTFLoader::computePrimitiveToGeometryMapping");
+
     m_gltfPrimitiveToEngineGeometry.clear();
     m_gltfPrimitiveToEngineGeometry.resize(model.meshes.size());
 
@@ -88,15 +121,21 @@ void GLTFLoader::computePrimitiveToGeometryMapping(const tinygltf::Model& model)
 }
 
 void GLTFLoader::loadMeshes(const tinygltf::Model& model, Scene& scene) {
-    std::vector<Geometry> geometry;
+    PROFILE_ZONE("GLTFLoader::loadMeshes");
+
+    std::pmr::vector<Geometry> geometry(&m_loadArena);
+    std::size_t primitiveCount = 0;
+    for (const auto& mesh : model.meshes) {
+        primitiveCount += mesh.primitives.size();
+    }
+    geometry.reserve(primitiveCount);
 
     // Extract geometry from glTF
     for (std::size_t meshIdx = 0; meshIdx < model.meshes.size(); meshIdx++) {
         const auto& mesh = model.meshes[meshIdx];
         for (std::size_t primIdx = 0; primIdx < mesh.primitives.size(); primIdx++) {
             const auto& prim = mesh.primitives[primIdx];
-            auto parsedMesh = loadPrimitive(prim, model);
-            geometry.emplace_back(parsedMesh);
+            geometry.emplace_back(loadPrimitive(prim, model));
         }
     }
 
@@ -146,6 +185,8 @@ void GLTFLoader::loadMeshes(const tinygltf::Model& model, Scene& scene) {
 }
 
 void GLTFLoader::loadMaterialsAndTextures(const tinygltf::Model& model, Scene& scene) {
+    PROFILE_ZONE("GLTFLoader::loadMaterialsAndTextures");
+
     scene.baseColorTextures.clear();
     scene.metallicRoughnessTextures.clear();
     scene.normalTextures.clear();
@@ -216,19 +257,68 @@ void GLTFLoader::loadMaterialsAndTextures(const tinygltf::Model& model, Scene& s
             }
         }
 
-        loadTextureMap(pbr.baseColorTexture.index, m_gltfBaseColorTextureMap, scene.baseColorTextures, parsedMaterial.baseColorTexIndex, model);
-        loadTextureMap(pbr.metallicRoughnessTexture.index, m_gltfMetallicTextureMap, scene.metallicRoughnessTextures, parsedMaterial.metallicRoughnessTexIndex, model);
-        loadTextureMap(gltfMat.normalTexture.index, m_gltfNormalTextureMap, scene.normalTextures, parsedMaterial.normalTexIndex, model);
+        loadTextureMap(pbr.baseColorTexture.index, m_gltfBaseColorTextureMap, scene.baseColorTextures, parsedMaterial.baseColorTexIndex);
+        loadTextureMap(pbr.metallicRoughnessTexture.index, m_gltfMetallicTextureMap, scene.metallicRoughnessTextures, parsedMaterial.metallicRoughnessTexIndex);
+        loadTextureMap(gltfMat.normalTexture.index, m_gltfNormalTextureMap, scene.normalTextures, parsedMaterial.normalTexIndex);
         
         // Skip emissive textures if configured (GPU compatibility mode)
         if (g_textureConfig.skipEmissiveTextures) {
             parsedMaterial.emissiveTexIndex = -1;
         } else {
-            loadTextureMap(gltfMat.emissiveTexture.index, m_gltfEmissiveTextureMap, scene.emissiveTextures, parsedMaterial.emissiveTexIndex, model);
+            loadTextureMap(gltfMat.emissiveTexture.index, m_gltfEmissiveTextureMap, scene.emissiveTextures, parsedMaterial.emissiveTexIndex);
         }
         
-        loadTextureMap(gltfMat.occlusionTexture.index, m_gltfOcclusionTextureMap, scene.occlusionTextures, parsedMaterial.occlusionTexIndex, model);
+        loadTextureMap(gltfMat.occlusionTexture.index, m_gltfOcclusionTextureMap, scene.occlusionTextures, parsedMaterial.occlusionTexIndex);
     }
+
+    // Slots are assigned in material order above, the (downscaling) copies run in parallel
+    m_jobSystem.parallelFor(m_pendingTextures.size(), [this, &model](const std::size_t i) {
+        const auto& pending = m_pendingTextures[i];
+        (*pending.textures)[pending.slot] = loadTexture(model.textures[pending.gltfTexIndex], model);
+    });
+    m_pendingTextures.clear();
+}
+
+bool GLTFLoader::deferImageDecode(tinygltf::Image* /*image*/,
+                                  const int imageIndex,
+                                  std::string* /*err*/,
+                                  std::string* /*warn*/,
+                                  const int requestedWidth,
+                                  const int requestedHeight,
+                                  const unsigned char* bytes,
+                                  const int size,
+                                  void* userData) {
+    auto* self = static_cast<GLTFLoader*>(userData);
+    self->m_encodedImages.push_back({
+        .imageIndex = imageIndex,
+        .requestedWidth = requestedWidth,
+        .requestedHeight = requestedHeight,
+        .bytes = std::vector<unsigned char>(bytes, bytes + size),
+    });
+    return true;
+}
+
+void GLTFLoader::decodeImages(tinygltf::Model& model) {
+    PROFILE_ZONE("GLTFLoader::decodeImages");
+
+    m_jobSystem.parallelFor(m_encodedImages.size(), [this, &model](const std::size_t i) {
+        PROFILE_ZONE("GLTFLoader::decodeImage");
+
+        auto& encoded = m_encodedImages[i];
+        std::string err;
+        std::string warn;
+
+        // tinygltf's own stb_image path, the same decoder LoadBinaryFromFile would have used
+        if (!tinygltf::LoadImageData(&model.images[encoded.imageIndex], encoded.imageIndex, &err, &warn,
+                                     encoded.requestedWidth, encoded.requestedHeight, encoded.bytes.data(),
+                                     static_cast<int>(encoded.bytes.size()), nullptr)) {
+            throw std::runtime_error("Failed to decode glTF image " + std::to_string(encoded.imageIndex) + ": " + err);
+        }
+
+        encoded.bytes = {};
+    });
+
+    m_encodedImages.clear();
 }
 
 Texture GLTFLoader::loadTexture(const tinygltf::Texture& texture, const tinygltf::Model& model) {
@@ -282,12 +372,10 @@ Texture GLTFLoader::loadTexture(const tinygltf::Texture& texture, const tinygltf
     };
 }
 
-template <typename T>
 void GLTFLoader::loadTextureMap(const int gltfTexIndex,
                                 std::map<std::uint32_t, std::uint32_t>& gltfTextureMap,
-                                std::vector<T>& sceneTextures,
-                                std::int32_t& parsedMaterialTexIndex,
-                                const tinygltf::Model& model) {
+                                std::vector<Texture>& sceneTextures,
+                                std::int32_t& parsedMaterialTexIndex) {
     if (gltfTexIndex < 0) {
         return;
     }
@@ -298,12 +386,15 @@ void GLTFLoader::loadTextureMap(const int gltfTexIndex,
         const auto newArrayIndex = sceneTextures.size();
         gltfTextureMap[gltfTexIndex] = newArrayIndex;
         parsedMaterialTexIndex = newArrayIndex;
-        sceneTextures.emplace_back(loadTexture(model.textures[gltfTexIndex], model));
+        sceneTextures.emplace_back();
+        m_pendingTextures.push_back({.textures = &sceneTextures, .slot = newArrayIndex, .gltfTexIndex = gltfTexIndex});
     }
 }
 
 
 void GLTFLoader::loadNodes(const tinygltf::Model& model, Scene& scene) {
+    PROFILE_ZONE("GLTFLoader::loadNodes");
+
     scene.pointLights.clear();
     scene.spotLights.clear();
     
@@ -512,7 +603,10 @@ void GLTFLoader::loadSkySphereNode(const tinygltf::Node& node, const tinygltf::M
 }
 
 Geometry GLTFLoader::loadPrimitive(const tinygltf::Primitive& prim, const tinygltf::Model& model) {
-    Geometry parsedMesh;
+    Geometry parsedMesh{
+        .vertices = std::pmr::vector<Vertex>(&m_loadArena),
+        .indices = std::pmr::vector<std::uint32_t>(&m_loadArena),
+    };
     
     auto posIt = prim.attributes.find("POSITION");
     auto normIt = prim.attributes.find("NORMAL");
@@ -673,12 +767,77 @@ glm::mat4 GLTFLoader::getLocalTransform(const tinygltf::Node& node) {
     return M;
 }
 
+void GLTFLoader::partitionDynamicInstances(const tinygltf::Model& model, Scene& scene) {
+    PROFILE_ZONE("GLTFLoader::partitionDynamicInstances");
+
+    const std::size_t instanceCount = scene.instances.size();
+
+    // Owning node of every instance (a node's primitives are consecutive and share its animated flag)
+    std::pmr::vector<std::int32_t> instanceNodes(instanceCount, -1, &m_loadArena);
+    for (std::size_t nodeIdx = 0; nodeIdx < scene.nodeToInstanceIndex.size(); nodeIdx++) {
+        const std::int32_t firstInstanceIdx = scene.nodeToInstanceIndex[nodeIdx];
+        if (firstInstanceIdx < 0) {
+            continue;
+        }
+        const auto primCount = m_gltfPrimitiveToEngineGeometry[model.nodes[nodeIdx].mesh].size();
+        for (std::size_t p = 0; p < primCount; p++) {
+            instanceNodes[static_cast<std::size_t>(firstInstanceIdx) + p] = static_cast<std::int32_t>(nodeIdx);
+        }
+    }
+
+    // Stable partition: static instances keep their relative order, the animated ones follow contiguously
+    std::pmr::vector<std::size_t> order(&m_loadArena);
+    order.reserve(instanceCount);
+    for (std::size_t i = 0; i < instanceCount; i++) {
+        if (scene.instances[i].animated == 0) {
+            order.push_back(i);
+        }
+    }
+    const std::size_t staticCount = order.size();
+    for (std::size_t i = 0; i < instanceCount; i++) {
+        if (scene.instances[i].animated != 0) {
+            order.push_back(i);
+        }
+    }
+
+    std::vector<Instance> partitioned;
+    partitioned.reserve(instanceCount);
+    std::pmr::vector<std::int32_t> oldToNew(instanceCount, -1, &m_loadArena);
+    scene.dynamicInstanceNodes.clear();
+    scene.dynamicInstanceNodes.reserve(instanceCount - staticCount);
+
+    for (std::size_t newIdx = 0; newIdx < instanceCount; newIdx++) {
+        const std::size_t oldIdx = order[newIdx];
+        oldToNew[oldIdx] = static_cast<std::int32_t>(newIdx);
+        partitioned.push_back(scene.instances[oldIdx]);
+        if (newIdx >= staticCount) {
+            scene.dynamicInstanceNodes.push_back(instanceNodes[oldIdx]);
+        }
+    }
+
+    scene.instances = std::move(partitioned);
+    scene.firstDynamicInstance = static_cast<std::uint32_t>(staticCount);
+
+    for (auto& instanceIdx : scene.nodeToInstanceIndex) {
+        if (instanceIdx >= 0) {
+            instanceIdx = oldToNew[static_cast<std::size_t>(instanceIdx)];
+        }
+    }
+    if (scene.skySphereInstanceIndex >= 0 && static_cast<std::size_t>(scene.skySphereInstanceIndex) < instanceCount) {
+        scene.skySphereInstanceIndex = oldToNew[static_cast<std::size_t>(scene.skySphereInstanceIndex)];
+    }
+
+    std::cout << "[GLTFLoader] Instances: " << staticCount << " static, " << instanceCount - staticCount
+              << " animated" << std::endl;
+}
+
 void GLTFLoader::buildMeshToInstanceMapping(Scene& scene) {
+    PROFILE_ZONE("GLTFLoader::buildMeshToInstanceMapping");
+
     scene.meshToInstanceIndices.clear();
     scene.meshToInstanceIndices.resize(scene.meshes.size());
 
-    // Build the mapping without reordering instances
-    // This preserves the original instance order and keeps nodeToInstanceIndex valid
+    // Runs after partitionDynamicInstances(), the indices are the final (partitioned) ones
     for (std::uint32_t instanceIdx = 0; instanceIdx < scene.instances.size(); instanceIdx++) {
         const auto& instance = scene.instances[instanceIdx];
         if (instance.meshIndex >= 0 && instance.meshIndex < static_cast<std::int32_t>(scene.meshes.size())) {
@@ -0,0 +1,334 @@
+#include <algorithm>
+#include <cmath>
+#include <format>
+#include <iostream>
+#include <limits>
+#include <string>
+
+#include "GpuProfiler.hpp"
+#include "VulkanCore.hpp"
+
+namespace {
+constexpr std::uint32_t kQueriesPerPool = static_cast<std::uint32_t>(GPU_PASS_COUNT) * 2;
+
+constexpr auto queryIndex(const GpuPass pass, const bool end) -> std::uint32_t {
+    return static_cast<std::uint32_t>(pass) * 2 + (end ? 1 : 0);
+}
+
+constexpr auto passBit(const GpuPass pass) -> std::uint32_t {
+    return 1U << static_cast<std::uint32_t>(pass);
+}
+
+constexpr double kNotMeasured = std::numeric_limits<double>::quiet_NaN();
+
+// Results come back in bit order: vertex invocations, clipping invocations, clipping primitives, fragment invocations
+constexpr vk::QueryPipelineStatisticFlags kStatisticFlags = vk::QueryPipelineStatisticFlagBits::eVertexShaderInvocations
+                                                            | vk::QueryPipelineStatisticFlagBits::eClippingInvocations
+                                                            | vk::QueryPipelineStatisticFlagBits::eClippingPrimitives
+                                                            | vk::QueryPipelineStatisticFlagBits::eFragmentShaderInvocations;
+constexpr std::uint32_t kStatisticCount = 4;
+constexpr std::uint32_t kStatisticsQueriesPerPool = static_cast<std::uint32_t>(GPU_PASS_COUNT);
+constexpr std::size_t kStatisticsStride = kStatisticCount + 1;  // counters followed by the availability word
+} // namespace
+
+GpuProfiler::GpuProfiler(VulkanCore& vulkanCore) : m_vulkanCore(vulkanCore) {
+    m_latestTimings.fill(kNotMeasured);
+
+    if constexpr (GPU_PROFILER_ENABLED) {
+        createQueryPools();
+        createStatisticsQueryPools();
+    }
+}
+
+void GpuProfiler::createQueryPools() {
+    const auto properties = m_vulkanCore.physicalDevice().getProperties();
+    const auto queueFamilies = m_vulkanCore.physicalDevice().getQueueFamilyProperties();
+    const auto graphicsFamily = m_vulkanCore.queueFamilyIndices().graphicsFamily.value();
+    const auto validBits = queueFamilies[graphicsFamily].timestampValidBits;
+
+    if (validBits == 0 || properties.limits.timestampPeriod <= 0.0f) {
+        std::cout << "[GPU Profiler] Timestamps not supported on the graphics queue, profiler disabled" << std::endl;
+        return;
+    }
+
+    m_timestampPeriodNs = static_cast<double>(properties.limits.timestampPeriod);
+    m_timestampMask = validBits >= 64 ? ~0ULL : ((1ULL << validBits) - 1ULL);
+
+    const vk::QueryPoolCreateInfo poolInfo{
+        .queryType = vk::QueryType::eTimestamp,
+        .queryCount = kQueriesPerPool,
+    };
+
+    for (std::uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
+        m_queryPools.emplace_back(m_vulkanCore.device(), poolInfo);
+    }
+
+    m_readback.resize(static_cast<std::size_t>(kQueriesPerPool) * 2);
+    m_enabled = true;
+}
+
+void GpuProfiler::createStatisticsQueryPools() {
+    if (!m_vulkanCore.supportsPipelineStatistics()) {
+        std::cout << "[GPU Profiler] Pipeline statistics queries not supported, overdraw counters disabled" << std::endl;
+        return;
+    }
+
+    const vk::QueryPoolCreateInfo poolInfo{
+        .queryType = vk::QueryType::ePipelineStatistics,
+        .queryCount = kStatisticsQueriesPerPool,
+        .pipelineStatistics = kStatisticFlags,
+    };
+
+    for (std::uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
+        m_statisticsQueryPools.emplace_back(m_vulkanCore.device(), poolInfo);
+    }
+
+    m_statisticsReadback.resize(static_cast<std::size_t>(kStatisticsQueriesPerPool) * kStatisticsStride);
+    m_statisticsEnabled = true;
+}
+
+void GpuProfiler::beginFrame(const vk::raii::CommandBuffer& cmd, const std::uint32_t frameIndex) {
+    if (!m_enabled && !m_statisticsEnabled) {
+        return;
+    }
+
+    // The caller waited on this slot's in-flight fence, so the previous results are final
+    if (m_poolPending[frameIndex]) {
+        resolveFrame(frameIndex);
+    }
+
+    m_currentFrameIndex = frameIndex;
+    m_writtenPasses[frameIndex] = 0;
+    m_writtenStatistics[frameIndex] = 0;
+    m_poolFrameNumbers[frameIndex] = m_frameNumber++;
+    m_poolPending[frameIndex] = true;
+
+    if (m_enabled) {
+        cmd.resetQueryPool(*m_queryPools[frameIndex], 0, kQueriesPerPool);
+    }
+    if (m_statisticsEnabled) {
+        cmd.resetQueryPool(*m_statisticsQueryPools[frameIndex], 0, kStatisticsQueriesPerPool);
+    }
+}
+
+void GpuProfiler::beginPass(const vk::raii::CommandBuffer& cmd, const GpuPass pass) {
+    if (!m_enabled) {
+        return;
+    }
+
+    cmd.writeTimestamp2(vk::PipelineStageFlagBits2::eTopOfPipe, *m_queryPools[m_currentFrameIndex],
+                        queryIndex(pass, false));
+}
+
+void GpuProfiler::endPass(const vk::raii::CommandBuffer& cmd, const GpuPass pass) {
+    if (!m_enabled) {
+        return;
+    }
+
+    cmd.writeTimestamp2(vk::PipelineStageFlagBits2::eAllCommands, *m_queryPools[m_currentFrameIndex],
+                        queryIndex(pass, true));
+    m_writtenPasses[m_currentFrameIndex] |= passBit(pass);
+}
+
+void GpuProfiler::beginStatistics(const vk::raii::CommandBuffer& cmd, const GpuPass pass) {
+    if (!m_statisticsEnabled) {
+        return;
+    }
+
+    cmd.beginQuery(*m_statisticsQueryPools[m_currentFrameIndex], static_cast<std::uint32_t>(pass), {});
+}
+
+void GpuProfiler::endStatistics(const vk::raii::CommandBuffer& cmd, const GpuPass pass) {
+    if (!m_statisticsEnabled) {
+        return;
+    }
+
+    cmd.endQuery(*m_statisticsQueryPools[m_currentFrameIndex], static_cast<std::uint32_t>(pass));
+    m_writtenStatistics[m_currentFrameIndex] |= passBit(pass);
+}
+
+void GpuProfiler::resolvePendingFrames() {
+    if (!m_enabled && !m_statisticsEnabled) {
+        return;
+    }
+
+    // Resolve in submission order so callbacks see increasing frame numbers
+    for (std::uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
+        std::uint32_t oldest = MAX_FRAMES_IN_FLIGHT;
+        for (std::uint32_t frame = 0; frame < MAX_FRAMES_IN_FLIGHT; frame++) {
+            if (m_poolPending[frame] &&
+                (oldest == MAX_FRAMES_IN_FLIGHT || m_poolFrameNumbers[frame] < m_poolFrameNumbers[oldest])) {
+                oldest = frame;
+            }
+        }
+
+        if (oldest == MAX_FRAMES_IN_FLIGHT) {
+            break;
+        }
+        resolveFrame(oldest);
+    }
+}
+
+void GpuProfiler::resolveFrame(const std::uint32_t frameIndex) {
+    m_poolPending[frameIndex] = false;
+
+    GpuPassTimings timings{};
+    timings.fill(kNotMeasured);
+
+    GpuPassStatistics statistics{};
+
+    if (m_enabled) {
+        resolveTimings(frameIndex, timings);
+    }
+    if (m_statisticsEnabled) {
+        resolveStatistics(frameIndex, statistics);
+    }
+
+    m_latestTimings = timings;
+    m_latestStatistics = statistics;
+
+    if (m_resultsCallback) {
+        m_resultsCallback(m_poolFrameNumbers[frameIndex], timings, statistics);
+    }
+}
+
+void GpuProfiler::resolveTimings(const std::uint32_t frameIndex, GpuPassTimings& timings) {
+    // No eWait: results that are not available yet are reported as such instead of stalling
+    const auto result = (*m_vulkanCore.device()).getQueryPoolResults(
+        *m_queryPools[frameIndex],
+        0,
+        kQueriesPerPool,
+        m_readback.size() * sizeof(std::uint64_t),
+        m_readback.data(),
+        sizeof(std::uint64_t) * 2,
+        vk::QueryResultFlagBits::e64 | vk::QueryResultFlagBits::eWithAvailability);
+
+    if (result != vk::Result::eSuccess && result != vk::Result::eNotReady) {
+        return;
+    }
+
+    const auto written = m_writtenPasses[frameIndex];
+    for (std::size_t passIdx = 0; passIdx < GPU_PASS_COUNT; passIdx++) {
+        const auto pass = static_cast<GpuPass>(passIdx);
+        if ((written & passBit(pass)) == 0) {
+            continue;
+        }
+
+        const auto beginQuery = queryIndex(pass, false);
+        const auto endQuery = queryIndex(pass, true);
+        const bool available = m_readback[beginQuery * 2 + 1] != 0 && m_readback[endQuery * 2 + 1] != 0;
+        if (!available) {
+            continue;
+        }
+
+        const auto begin = m_readback[beginQuery * 2] & m_timestampMask;
+        const auto end = m_readback[endQuery * 2] & m_timestampMask;
+        const auto ticks = (end - begin) & m_timestampMask;  // tolerate counter wrap-around
+        const double ms = static_cast<double>(ticks) * m_timestampPeriodNs / 1.0e6;
+
+        timings[passIdx] = ms;
+
+        m_history[passIdx][m_historyCursor[passIdx]] = ms;
+        m_historyCursor[passIdx] = (m_historyCursor[passIdx] + 1) % GPU_PROFILER_HISTORY_LENGTH;
+        m_historyCount[passIdx] = std::min(m_historyCount[passIdx] + 1, GPU_PROFILER_HISTORY_LENGTH);
+    }
+}
+
+void GpuProfiler::resolveStatistics(const std::uint32_t frameIndex, GpuPassStatistics& statistics) {
+    const auto result = (*m_vulkanCore.device()).getQueryPoolResults(
+        *m_statisticsQueryPools[frameIndex],
+        0,
+        kStatisticsQueriesPerPool,
+        m_statisticsReadback.size() * sizeof(std::uint64_t),
+        m_statisticsReadback.data(),
+        sizeof(std::uint64_t) * kStatisticsStride,
+        vk::QueryResultFlagBits::e64 | vk::QueryResultFlagBits::eWithAvailability);
+
+    if (result != vk::Result::eSuccess && result != vk::Result::eNotReady) {
+        return;
+    }
+
+    const auto written = m_writtenStatistics[frameIndex];
+    for (std::size_t passIdx = 0; passIdx < GPU_PASS_COUNT; passIdx++) {
+        const auto pass = static_cast<GpuPass>(passIdx);
+        const std::uint64_t* counters = &m_statisticsReadback[passIdx * kStatisticsStride];
+        if ((written & passBit(pass)) == 0 || counters[kStatisticCount] == 0) {
+            continue;
+        }
+
+        statistics[passIdx] = {
+            .valid = true,
+            .vertexInvocations = counters[0],
+            .clippingInvocations = counters[1],
+            .clippingPrimitives = counters[2],
+            .fragmentInvocations = counters[3],
+        };
+    }
+}
+
+auto GpuProfiler::getAverageTimings() const -> GpuPassTimings {
+    GpuPassTimings averages{};
+    averages.fill(kNotMeasured);
+
+    for (std::size_t passIdx = 0; passIdx < GPU_PASS_COUNT; passIdx++) {
+        const auto count = m_historyCount[passIdx];
+        if (count == 0) {
+            continue;
+        }
+
+        double sum = 0.0;
+        for (std::uint32_t i = 0; i < count; i++) {
+            sum += m_history[passIdx][i];
+        }
+        averages[passIdx] = sum / static_cast<double>(count);
+    }
+
+    return averages;
+}
+
+void GpuProfiler::printAverages() const {
+    if (!m_enabled) {
+        return;
+    }
+
+    const auto averages = getAverageTimings();
+
+    std::string line = "GPU (avg ms):";
+    for (std::size_t passIdx = 0; passIdx < GPU_PASS_COUNT; passIdx++) {
+        if (std::isnan(averages[passIdx])) {
+            continue;
+        }
+        line += std::format(" | {} {:.3f}", passName(static_cast<GpuPass>(passIdx)), averages[passIdx]);
+    }
+
+    std::cout << line << std::endl;
+}
+
+auto GpuProfiler::passName(const GpuPass pass) -> const char* {
+    switch (pass) {
+        case GpuPass::Upload:
+            return "upload";
+        case GpuPass::TLASUpdate:
+            return "tlas_update";
+        case GpuPass::Opaque:
+            return "opaque";
+        case GpuPass::Transparent:
+            return "transparent";
+        case GpuPass::TAA:
+            return "taa";
+        case GpuPass::HDR:
+            return "hdr";
+        case GpuPass::BrightPass:
+            return "bright_pass";
+        case GpuPass::BlurHorizontal:
+            return "blur_horizontal";
+        case GpuPass::BlurVertical:
+            return "blur_vertical";
+        case GpuPass::Composite:
+            return "composite";
+        case GpuPass::Frame:
+            return "frame";
+        default:
+            return "unknown";
+    }
+}
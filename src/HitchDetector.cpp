@@ -0,0 +1,247 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <utility>
+
+#include "CpuProfiler.hpp"
+#include "HitchDetector.hpp"
+
+namespace {
+// Trace viewer thread id of the per-frame track, after every CPU profiler thread
+constexpr std::size_t FRAMES_TRACK_ID = CPU_PROFILER_MAX_THREADS;
+
+double toMicroseconds(const std::uint64_t ns) {
+    return static_cast<double>(ns) / 1000.0;
+}
+} // namespace
+
+HitchDetector::HitchDetector(const double thresholdMultiple, std::filesystem::path outputDirectory)
+    : m_thresholdMultiple(thresholdMultiple),
+      m_outputDirectory(std::move(outputDirectory)) {
+}
+
+void HitchDetector::endFrame(const std::uint64_t startNs,
+                             const std::uint64_t endNs,
+                             const double animateMs,
+                             const FrameStageTimings& stages,
+                             const std::optional<std::uint64_t> gpuFrameNumber) {
+    const double frameMs = static_cast<double>(endNs - startNs) / 1e6;
+
+    // Median of the frames before this one, so the hitch does not raise its own bar
+    const double medianMs = m_frameCount >= HITCH_MIN_FRAMES ? medianFrameMs() : 0.0;
+
+    FrameRecord& record = m_history[m_frameCount % HITCH_HISTORY_FRAMES];
+    record = FrameRecord{
+        .frame = m_frameCount,
+        .startNs = startNs,
+        .endNs = endNs,
+        .frameMs = frameMs,
+        .medianMs = medianMs,
+        .gpuFrameNumber = gpuFrameNumber,
+    };
+
+    auto& stageMs = record.stageMs;
+    stageMs[static_cast<std::size_t>(FrameStage::Animation)] = animateMs;
+    stageMs[static_cast<std::size_t>(FrameStage::FenceWait)] = stages.fenceWaitMs;
+    stageMs[static_cast<std::size_t>(FrameStage::Acquire)] = stages.acquireMs;
+    stageMs[static_cast<std::size_t>(FrameStage::SceneUpdate)] = stages.sceneUpdateMs;
+    stageMs[static_cast<std::size_t>(FrameStage::Record)] = stages.recordMs;
+    stageMs[static_cast<std::size_t>(FrameStage::Submit)] = stages.submitMs;
+    stageMs[static_cast<std::size_t>(FrameStage::Present)] = stages.presentMs;
+
+    double accounted = 0.0;
+    for (std::size_t stage = 0; stage < static_cast<std::size_t>(FrameStage::Other); stage++) {
+        accounted += stageMs[stage];
+    }
+    stageMs[static_cast<std::size_t>(FrameStage::Other)] = std::max(0.0, frameMs - accounted);
+
+    m_frameCount++;
+
+    if (medianMs > 0.0 && frameMs >= HITCH_MIN_FRAME_MS && frameMs > medianMs * m_thresholdMultiple) {
+        record.hitch = true;
+        m_hitchCount++;
+
+        const bool traced = !m_pendingTrace && record.frame >= m_cooldownEnd && m_tracesWritten < HITCH_MAX_TRACES;
+        if (traced) {
+            m_pendingTrace = record.frame;
+        }
+
+        const FrameStage stage = slowestStage(record);
+        std::cout << std::format("[Hitch] Frame {}: {:.2f} ms, {:.1f}x the {:.2f} ms median. Slowest stage: {} {:.2f} ms "
+                                 "(median {:.2f} ms){}",
+                                 record.frame, frameMs, frameMs / medianMs, medianMs, stageName(stage),
+                                 stageMs[static_cast<std::size_t>(stage)], medianStageMs(stage),
+                                 traced ? "" : ", no trace (cooldown or trace limit)")
+                  << std::endl;
+    }
+
+    if (m_pendingTrace && m_frameCount > *m_pendingTrace + MAX_FRAMES_IN_FLIGHT) {
+        writeTrace(*m_pendingTrace);
+    }
+}
+
+void HitchDetector::recordGpuTimings(const std::uint64_t gpuFrameNumber, const GpuPassTimings& timings) {
+    // Newest first, the frame is at most a few records back
+    const std::size_t size = historySize();
+    for (std::size_t i = 1; i <= size; i++) {
+        FrameRecord& record = m_history[(m_frameCount - i) % HITCH_HISTORY_FRAMES];
+        if (record.gpuFrameNumber == gpuFrameNumber) {
+            record.gpuMs = timings;
+            record.gpuResolved = true;
+            return;
+        }
+    }
+}
+
+void HitchDetector::flush() {
+    if (m_pendingTrace) {
+        writeTrace(*m_pendingTrace);
+    }
+}
+
+auto HitchDetector::historySize() const -> std::size_t {
+    return static_cast<std::size_t>(std::min<std::uint64_t>(m_frameCount, HITCH_HISTORY_FRAMES));
+}
+
+auto HitchDetector::medianFrameMs() -> double {
+    const std::size_t size = historySize();
+    for (std::size_t i = 0; i < size; i++) {
+        m_medianScratch[i] = m_history[i].frameMs;
+    }
+
+    const auto middle = m_medianScratch.begin() + static_cast<std::ptrdiff_t>(size / 2);
+    std::nth_element(m_medianScratch.begin(), middle, m_medianScratch.begin() + static_cast<std::ptrdiff_t>(size));
+    return *middle;
+}
+
+auto HitchDetector::medianStageMs(const FrameStage stage) -> double {
+    const std::size_t size = historySize();
+    for (std::size_t i = 0; i < size; i++) {
+        m_medianScratch[i] = m_history[i].stageMs[static_cast<std::size_t>(stage)];
+    }
+
+    const auto middle = m_medianScratch.begin() + static_cast<std::ptrdiff_t>(size / 2);
+    std::nth_element(m_medianScratch.begin(), middle, m_medianScratch.begin() + static_cast<std::ptrdiff_t>(size));
+    return *middle;
+}
+
+// The stage that grew the most over its own median, not the longest one (the fence wait is long in every
+// GPU-bound frame)
+auto HitchDetector::slowestStage(const FrameRecord& record) -> FrameStage {
+    FrameStage slowest = FrameStage::Other;
+    double largestGrowth = -1.0;
+    for (std::size_t i = 0; i < FRAME_STAGE_COUNT; i++) {
+        const auto stage = static_cast<FrameStage>(i);
+        const double growth = record.stageMs[i] - medianStageMs(stage);
+        if (growth > largestGrowth) {
+            largestGrowth = growth;
+            slowest = stage;
+        }
+    }
+    return slowest;
+}
+
+void HitchDetector::writeTrace(const std::uint64_t hitchFrame) {
+    m_pendingTrace.reset();
+    m_tracesWritten++;
+    m_cooldownEnd = hitchFrame + HITCH_COOLDOWN_FRAMES;
+
+    const std::size_t size = historySize();
+    const std::uint64_t firstFrame = m_frameCount - size;
+    const auto recordAt = [this](const std::uint64_t frame) -> const FrameRecord& {
+        return m_history[frame % HITCH_HISTORY_FRAMES];
+    };
+
+    const FrameRecord& hitch = recordAt(hitchFrame);
+    const FrameStage slowest = slowestStage(hitch);
+
+    // A diagnostics failure must not take the kiosk down, it is only logged
+    try {
+        std::filesystem::create_directories(m_outputDirectory);
+
+        const auto timestamp = std::chrono::floor<std::chrono::seconds>(std::chrono::system_clock::now());
+        const auto path = m_outputDirectory / std::format("hitch_{:%Y%m%d_%H%M%S}_frame{}.json", timestamp, hitchFrame);
+
+        std::ofstream file(path);
+        if (!file) {
+            throw std::runtime_error("Failed to open hitch trace for writing: " + path.string());
+        }
+
+        file << "{\"displayTimeUnit\":\"ms\",\n\"otherData\":{";
+        file << std::format(R"("hitch_frame":{},"frame_ms":{:.3f},"median_ms":{:.3f},"threshold":{},"slowest_stage":"{}")",
+                            hitchFrame, hitch.frameMs, hitch.medianMs, m_thresholdMultiple, stageName(slowest));
+        for (std::size_t i = 0; i < FRAME_STAGE_COUNT; i++) {
+            const auto stage = static_cast<FrameStage>(i);
+            file << std::format(R"(,"{}_ms":{:.3f},"{}_median_ms":{:.3f})", stageName(stage), hitch.stageMs[i],
+                                stageName(stage), medianStageMs(stage));
+        }
+        file << "},\n\"traceEvents\":[\n";
+
+        bool first = true;
+        const auto separator = [&first, &file] {
+            if (!first) {
+                file << ",\n";
+            }
+            first = false;
+        };
+
+        const auto zoneCount = CpuProfiler::writeChromeTraceEvents(file, recordAt(firstFrame).startNs, first);
+
+        separator();
+        file << std::format(R"({{"name":"thread_name","ph":"M","pid":1,"tid":{},"args":{{"name":"Frames"}}}})",
+                            FRAMES_TRACK_ID);
+
+        for (std::uint64_t frame = firstFrame; frame < m_frameCount; frame++) {
+            const FrameRecord& record = recordAt(frame);
+
+            std::string args = std::format(R"("frame_ms":{:.3f})", record.frameMs);
+            for (std::size_t i = 0; i < FRAME_STAGE_COUNT; i++) {
+                args += std::format(R"(,"{}_ms":{:.3f})", stageName(static_cast<FrameStage>(i)), record.stageMs[i]);
+            }
+            if (record.gpuResolved) {
+                for (std::size_t pass = 0; pass < GPU_PASS_COUNT; pass++) {
+                    if (!std::isnan(record.gpuMs[pass])) {
+                        args += std::format(R"(,"gpu.{}_ms":{:.3f})", GpuProfiler::passName(static_cast<GpuPass>(pass)),
+                                            record.gpuMs[pass]);
+                    }
+                }
+            }
+
+            separator();
+            file << std::format(R"({{"name":"{} {}","ph":"X","pid":1,"tid":{},"ts":{:.3f},"dur":{:.3f},"args":{{{}}}}})",
+                                record.hitch ? "Hitch" : "Frame", record.frame, FRAMES_TRACK_ID,
+                                toMicroseconds(record.startNs), toMicroseconds(record.endNs - record.startNs), args);
+
+            // Frame time against the median as a counter track
+            separator();
+            file << std::format(R"({{"name":"frame_ms","ph":"C","pid":1,"ts":{:.3f},"args":{{"frame":{:.3f},"median":{:.3f}}}}})",
+                                toMicroseconds(record.startNs), record.frameMs, record.medianMs);
+        }
+
+        file << "\n]}\n";
+
+        std::cout << "[Hitch] Wrote " << size << " frames and " << zoneCount << " CPU zones to " << path.string()
+                  << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << "[Hitch] " << e.what() << std::endl;
+    }
+}
+
+auto HitchDetector::stageName(const FrameStage stage) -> const char* {
+    switch (stage) {
+        case FrameStage::Animation: return "animation";
+        case FrameStage::FenceWait: return "fence_wait";
+        case FrameStage::Acquire: return "acquire";
+        case FrameStage::SceneUpdate: return "scene_update";
+        case FrameStage::Record: return "record";
+        case FrameStage::Submit: return "submit";
+        case FrameStage::Present: return "present";
+        case FrameStage::Other: return "other";
+        case FrameStage::Count: break;
+    }
+    return "unknown";
+}
@@ -5,12 +5,6 @@
 #include "BufferManager.hpp"
 #include <iostream>
 
-// Global memory tracking
-namespace {
-    std::size_t g_totalAllocatedMemory = 0;
-    std::size_t g_peakMemoryUsage = 0;
-}
-
 ImageManager::ImageManager(VulkanCore& vulkanCore, CommandManager& commandManager, BufferManager& bufferManager) :
     m_vulkanCore{vulkanCore},
     m_commandManager{commandManager},
@@ -18,6 +12,7 @@ ImageManager::ImageManager(VulkanCore& vulkanCore, CommandManager& commandManage
 }
 
 void ImageManager::createImage(
+    const MemoryCategory category,
     const std::uint32_t width,
     const std::uint32_t height,
     const uint32_t mipLevels,
@@ -42,43 +37,79 @@ void ImageManager::createImage(
     };
 
     image = vk::raii::Image(m_vulkanCore.device(), imageInfo);
+    allocateImageMemory(category, imageInfo, properties, image, imageMemory);
+}
+
+void ImageManager::createVolumeImage(
+    const MemoryCategory category,
+    const vk::Extent3D extent,
+    const vk::Format format,
+    const vk::ImageUsageFlags usage,
+    vk::raii::Image& image,
+    vk::raii::DeviceMemory& imageMemory
+    ) const {
+    const vk::ImageCreateInfo imageInfo{
+        .imageType = vk::ImageType::e3D,
+        .format = format,
+        .extent = extent,
+        .mipLevels = 1,
+        .arrayLayers = 1,
+        .samples = vk::SampleCountFlagBits::e1,
+        .tiling = vk::ImageTiling::eOptimal,
+        .usage = usage,
+        .sharingMode = vk::SharingMode::eExclusive,
+    };
+
+    image = vk::raii::Image(m_vulkanCore.device(), imageInfo);
+    allocateImageMemory(category, imageInfo, vk::MemoryPropertyFlagBits::eDeviceLocal, image, imageMemory);
+}
 
+void ImageManager::allocateImageMemory(
+    const MemoryCategory category,
+    const vk::ImageCreateInfo& imageInfo,
+    const vk::MemoryPropertyFlags properties,
+    const vk::raii::Image& image,
+    vk::raii::DeviceMemory& imageMemory
+    ) const {
     const vk::MemoryRequirements memRequirements = image.getMemoryRequirements();
     const vk::MemoryAllocateInfo allocInfo{
         .allocationSize = memRequirements.size,
         .memoryTypeIndex = m_vulkanCore.findMemoryType(memRequirements.memoryTypeBits, properties),
     };
 
+    MemoryTracker& memoryTracker = m_vulkanCore.memoryTracker();
+    memoryTracker.release(imageMemory);
+
     try {
         imageMemory = vk::raii::DeviceMemory(m_vulkanCore.device(), allocInfo);
         image.bindMemory(imageMemory, 0);
-        
-        // Track memory usage
-        g_totalAllocatedMemory += memRequirements.size;
-        if (g_totalAllocatedMemory > g_peakMemoryUsage) {
-            g_peakMemoryUsage = g_totalAllocatedMemory;
-        }
     } catch (const vk::OutOfDeviceMemoryError& e) {
         const float sizeMB = static_cast<float>(memRequirements.size) / (1024.0f * 1024.0f);
         std::cerr << "[GPU Memory] ERROR: Out of device memory while allocating image!" << std::endl;
-        std::cerr << "  - Image size: " << width << "x" << height << std::endl;
-        std::cerr << "  - Mip levels: " << mipLevels << std::endl;
+        std::cerr << "  - Image size: " << imageInfo.extent.width << "x" << imageInfo.extent.height;
+        if (imageInfo.extent.depth > 1) {
+            std::cerr << "x" << imageInfo.extent.depth;
+        }
+        std::cerr << " (" << MemoryTracker::categoryName(category) << ")" << std::endl;
+        std::cerr << "  - Mip levels: " << imageInfo.mipLevels << std::endl;
         std::cerr << "  - Memory required: " << sizeMB << " MB" << std::endl;
-        std::cerr << "  - Total memory already allocated: " 
-                  << (static_cast<float>(g_totalAllocatedMemory) / (1024.0f * 1024.0f)) << " MB" << std::endl;
+        memoryTracker.printSummary();
         throw;
     }
+
+    memoryTracker.recordAllocation(*imageMemory, category, memRequirements.size, allocInfo.memoryTypeIndex);
 }
 
 vk::raii::ImageView ImageManager::createImageView(
     const vk::raii::Image& image,
     const vk::Format format,
     const vk::ImageAspectFlags aspectFlags,
-    const std::uint32_t mipLevels
+    const std::uint32_t mipLevels,
+    const vk::ImageViewType viewType
     ) const {
     vk::ImageViewCreateInfo viewInfo{
         .image = image,
-        .viewType = vk::ImageViewType::e2D,
+        .viewType = viewType,
         .format = format,
         .subresourceRange = {
             .aspectMask = aspectFlags,
@@ -152,11 +183,13 @@ vk::raii::Sampler ImageManager::createPostProcessingSampler() const {
     return vk::raii::Sampler(m_vulkanCore.device(), samplerCreateInfo);
 }
 
-void ImageManager::createImageFromTexture(const Texture& texture,
+void ImageManager::createImageFromTexture(const MemoryCategory category,
+                                          const Texture& texture,
                                           vk::raii::Image& image,
                                           vk::raii::ImageView& imageView,
                                           vk::raii::DeviceMemory& imageMemory) const {
     createImage(
+        category,
         texture.width,
         texture.height,
         texture.mipLevels,
@@ -185,6 +218,7 @@ void ImageManager::createImageFromTexture(const Texture& texture,
         const vk::DeviceSize imageSize = texture.image.size();
 
         m_bufferManager.createBuffer(
+            MemoryCategory::Staging,
             imageSize,
             vk::BufferUsageFlagBits::eTransferSrc,
             vk::MemoryPropertyFlagBits::eHostVisible |
@@ -203,8 +237,8 @@ void ImageManager::createImageFromTexture(const Texture& texture,
             texture.width,
             texture.height
             );
-        
-        // stagingBuffer and stagingBufferMemory are destroyed here when leaving scope
+
+        m_vulkanCore.memoryTracker().release(stagingBufferMemory);
     }
 
     if (texture.mipLevels > 1) {
@@ -0,0 +1,106 @@
+#include <algorithm>
+#include <cmath>
+#include <ranges>
+#include <glm/glm.hpp>
+
+#include "InstanceCulling.hpp"
+
+namespace {
+// Instances is any range of instance indices
+template <typename Instances>
+void cullInstanceRange(const Scene& scene, const Frustum& frustum,
+                       const Instances& instanceIndices,
+                       const std::vector<std::uint32_t>& materialPipelineIndices,
+                       const std::uint32_t maxTransparent, std::uint32_t& transparentCount,
+                       std::vector<DrawIndexedIndirectCommand>& draws,
+                       std::vector<std::uint32_t>& drawPipelines) {
+    // Cache scene data pointers to reduce pointer chasing
+    const Instance* instances = scene.instances.data();
+    const Mesh* meshes = scene.meshes.data();
+    const Material* materials = scene.materials.data();
+    const std::uint32_t meshCount = static_cast<std::uint32_t>(scene.meshes.size());
+    const std::uint32_t materialCount = static_cast<std::uint32_t>(scene.materials.size());
+
+    const auto& planes = frustum.planes;
+
+    for (const std::uint32_t instanceIdx : instanceIndices) {
+        const auto& instance = instances[instanceIdx];
+        
+        const std::int32_t meshIdx = instance.meshIndex;
+        if (meshIdx < 0 || meshIdx >= static_cast<std::int32_t>(meshCount)) {
+            continue;
+        }
+        
+        const auto& mesh = meshes[meshIdx];
+        const std::int32_t matIdx = mesh.materialIndex;
+        
+        if (matIdx < 0 || matIdx >= static_cast<std::int32_t>(materialCount)) {
+            continue;
+        }
+        
+        // Frustum culling
+        const glm::vec3 localCenter = (mesh.boundingBoxMin + mesh.boundingBoxMax) * 0.5f;
+        const glm::vec3 boxExtents = mesh.boundingBoxMax - mesh.boundingBoxMin;
+        const float localRadius = glm::length(boxExtents) * 0.5f;
+        const glm::vec3 worldCenter = glm::vec3(instance.transform * glm::vec4(localCenter, 1.0f));
+        
+        const glm::vec3 col0 = instance.transform[0];
+        const glm::vec3 col1 = instance.transform[1];
+        const glm::vec3 col2 = instance.transform[2];
+        const float scale0Sq = glm::dot(col0, col0);
+        const float scale1Sq = glm::dot(col1, col1);
+        const float scale2Sq = glm::dot(col2, col2);
+        const float maxScaleSq = glm::max(scale0Sq, glm::max(scale1Sq, scale2Sq));
+        const float worldRadius = localRadius * std::sqrt(maxScaleSq);
+        
+        bool visible = true;
+        for (int i = 0; i < 5; ++i) {
+            const float dist = glm::dot(planes[i].normal, worldCenter) + planes[i].distance;
+            if (dist < -worldRadius) {
+                visible = false;
+                break;
+            }
+        }
+        
+        if (!visible) {
+            continue;
+        }
+
+        if (materials[matIdx].alphaMode == 1) {
+            if (transparentCount >= maxTransparent) {
+                continue;
+            }
+            transparentCount++;
+        }
+        
+        draws.push_back({
+            .indexCount = mesh.indexCount,
+            .instanceCount = 1,
+            .firstIndex = mesh.baseIndex,
+            .vertexOffset = static_cast<std::int32_t>(mesh.baseVertex),
+            .firstInstance = instanceIdx
+        });
+        drawPipelines.push_back(materialPipelineIndices[matIdx]);
+    }
+}
+} // namespace
+
+void cullInstances(const Scene& scene, const Frustum& frustum,
+                   const std::uint32_t firstInstance, const std::uint32_t endInstance,
+                   const std::vector<std::uint32_t>& materialPipelineIndices,
+                   const std::uint32_t maxTransparent, std::uint32_t& transparentCount,
+                   std::vector<DrawIndexedIndirectCommand>& draws,
+                   std::vector<std::uint32_t>& drawPipelines) {
+    cullInstanceRange(scene, frustum, std::views::iota(firstInstance, std::max(firstInstance, endInstance)),
+                      materialPipelineIndices, maxTransparent, transparentCount, draws, drawPipelines);
+}
+
+void cullInstances(const Scene& scene, const Frustum& frustum,
+                   const std::span<const std::uint32_t> candidateInstances,
+                   const std::vector<std::uint32_t>& materialPipelineIndices,
+                   const std::uint32_t maxTransparent, std::uint32_t& transparentCount,
+                   std::vector<DrawIndexedIndirectCommand>& draws,
+                   std::vector<std::uint32_t>& drawPipelines) {
+    cullInstanceRange(scene, frustum, candidateInstances, materialPipelineIndices, maxTransparent,
+                      transparentCount, draws, drawPipelines);
+}
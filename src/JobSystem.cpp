@@ -0,0 +1,58 @@
+#include <algorithm>
+
+#include "constants.hpp"
+#include "JobSystem.hpp"
+#include "CpuProfiler.hpp"
+
+JobSystem::JobSystem(std::uint32_t workerCount) {
+    if (workerCount == 0) {
+        const auto hardwareThreads = std::thread::hardware_concurrency();
+        workerCount = hardwareThreads > 1 ? hardwareThreads - 1 : 1;
+    }
+    workerCount = std::clamp(workerCount, 1U, JOB_SYSTEM_MAX_WORKERS);
+
+    m_workers.reserve(workerCount);
+    for (std::uint32_t i = 0; i < workerCount; i++) {
+        m_workers.emplace_back([this] { workerLoop(); });
+    }
+}
+
+JobSystem::~JobSystem() {
+    {
+        const std::lock_guard lock(m_mutex);
+        m_stopping = true;
+    }
+    m_condition.notify_all();
+
+    for (auto& worker : m_workers) {
+        worker.join();
+    }
+}
+
+void JobSystem::enqueue(std::function<void()> job) {
+    {
+        const std::lock_guard lock(m_mutex);
+        m_queue.push_back(std::move(job));
+    }
+    m_condition.notify_one();
+}
+
+void JobSystem::workerLoop() {
+    PROFILE_THREAD_NAME("Worker");
+
+    while (true) {
+        std::function<void()> job;
+        {
+            std::unique_lock lock(m_mutex);
+            m_condition.wait(lock, [this] { return m_stopping || !m_queue.empty(); });
+
+            // Drain the queue before exiting so no submitted future is left without a value
+            if (m_queue.empty()) {
+                return;
+            }
+            job = std::move(m_queue.front());
+            m_queue.pop_front();
+        }
+        job();
+    }
+}
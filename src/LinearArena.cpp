@@ -0,0 +1,85 @@
+#include <algorithm>
+#include <cstdint>
+
+#include "LinearArena.hpp"
+
+namespace {
+constexpr std::size_t BLOCK_ALIGNMENT = alignof(std::max_align_t);
+
+auto alignUp(const std::size_t value, const std::size_t alignment) -> std::size_t {
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+} // namespace
+
+LinearArena::LinearArena(const std::size_t initialCapacity, std::pmr::memory_resource* upstream)
+    : m_upstream(upstream), m_capacity(alignUp(initialCapacity, BLOCK_ALIGNMENT)) {
+    if (m_capacity > 0) {
+        m_block = static_cast<std::byte*>(m_upstream->allocate(m_capacity, BLOCK_ALIGNMENT));
+    }
+}
+
+LinearArena::~LinearArena() {
+    release();
+}
+
+auto LinearArena::do_allocate(const std::size_t bytes, const std::size_t alignment) -> void* {
+    if (m_block != nullptr) {
+        const auto base = reinterpret_cast<std::uintptr_t>(m_block);
+        const std::size_t offset = alignUp(base + m_offset, alignment) - base;
+        if (offset + bytes <= m_capacity) {
+            m_offset = offset + bytes;
+            m_highWater = std::max(m_highWater, used());
+            return m_block + offset;
+        }
+    }
+
+    // Block exhausted: serve this one from upstream and remember how much more the cycle needed
+    const std::size_t blockAlignment = std::max(alignment, alignof(OverflowBlock));
+    const std::size_t headerSize = alignUp(sizeof(OverflowBlock), blockAlignment);
+    const std::size_t size = headerSize + bytes;
+
+    auto* memory = static_cast<std::byte*>(m_upstream->allocate(size, blockAlignment));
+    auto* header = reinterpret_cast<OverflowBlock*>(memory);
+    *header = {.next = m_overflow, .size = size, .alignment = blockAlignment};
+    m_overflow = header;
+
+    m_overflowBytes += bytes + alignment;
+    m_highWater = std::max(m_highWater, used());
+    return memory + headerSize;
+}
+
+void LinearArena::freeOverflow() {
+    while (m_overflow != nullptr) {
+        OverflowBlock* next = m_overflow->next;
+        m_upstream->deallocate(m_overflow, m_overflow->size, m_overflow->alignment);
+        m_overflow = next;
+    }
+    m_overflowBytes = 0;
+}
+
+void LinearArena::reset() {
+    const bool overflowed = m_overflow != nullptr;
+    freeOverflow();
+    m_offset = 0;
+
+    // Grow once with some headroom instead of overflowing again every cycle
+    if (overflowed && m_highWater > m_capacity) {
+        if (m_block != nullptr) {
+            m_upstream->deallocate(m_block, m_capacity, BLOCK_ALIGNMENT);
+        }
+        m_capacity = alignUp(m_highWater + m_highWater / 2, BLOCK_ALIGNMENT);
+        m_block = static_cast<std::byte*>(m_upstream->allocate(m_capacity, BLOCK_ALIGNMENT));
+    }
+}
+
+void LinearArena::release() {
+    freeOverflow();
+    m_offset = 0;
+
+    if (m_block != nullptr) {
+        m_upstream->deallocate(m_block, m_capacity, BLOCK_ALIGNMENT);
+        m_block = nullptr;
+    }
+    m_capacity = 0;
+    m_highWater = 0;
+}
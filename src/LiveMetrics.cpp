@@ -0,0 +1,285 @@
+#include <algorithm>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <cerrno>
+#include <csignal>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "LiveMetrics.hpp"
+
+namespace {
+constexpr int READ_RETRIES = 64;
+
+#ifdef _WIN32
+auto mappingName(const std::string& name) -> std::string {
+    return "Local\\" + name;
+}
+
+auto currentProcessId() -> std::uint32_t {
+    return static_cast<std::uint32_t>(GetCurrentProcessId());
+}
+#else
+auto mappingName(const std::string& name) -> std::string {
+    return "/" + name;
+}
+
+auto currentProcessId() -> std::uint32_t {
+    return static_cast<std::uint32_t>(getpid());
+}
+#endif
+
+// One writer per name. A POSIX segment outlives a writer that crashed, so an existing one whose writer process
+// is gone is removed first; a segment of a running writer (or one still initializing, pid 0) makes create() throw.
+auto createWriterSegment(const std::string& name) -> SharedMemorySegment {
+#ifndef _WIN32
+    if (SharedMemorySegment::exists(name)) {
+        std::uint32_t writerProcessId = 0;
+        {
+            const auto existing = SharedMemorySegment::open(name, sizeof(LiveMetricsBlock));
+            writerProcessId = static_cast<const LiveMetricsBlock*>(existing.data())->processId;
+        }
+        if (writerProcessId != 0 && kill(static_cast<pid_t>(writerProcessId), 0) != 0 && errno == ESRCH) {
+            SharedMemorySegment::remove(name);
+        }
+    }
+#endif
+    return SharedMemorySegment::create(name, sizeof(LiveMetricsBlock));
+}
+} // namespace
+
+auto SharedMemorySegment::create(const std::string& name, const std::size_t size) -> SharedMemorySegment {
+    SharedMemorySegment segment;
+    segment.m_name = mappingName(name);
+    segment.m_size = size;
+
+#ifdef _WIN32
+    segment.m_mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, 0,
+                                           static_cast<DWORD>(size), segment.m_name.c_str());
+    if (segment.m_mapping == nullptr) {
+        throw std::runtime_error("Failed to create shared memory " + segment.m_name);
+    }
+    if (GetLastError() == ERROR_ALREADY_EXISTS) {
+        CloseHandle(std::exchange(segment.m_mapping, nullptr));
+        throw std::runtime_error("Shared memory " + segment.m_name + " is already in use by another process");
+    }
+    segment.m_owner = true;
+    segment.m_data = MapViewOfFile(segment.m_mapping, FILE_MAP_ALL_ACCESS, 0, 0, size);
+#else
+    const int fd = shm_open(segment.m_name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+    // Not the owner until the name is ours, a failed create must not unlink another process's segment
+    if (fd < 0 && errno == EEXIST) {
+        throw std::runtime_error("Shared memory " + segment.m_name + " is already in use by another process");
+    }
+    if (fd < 0) {
+        throw std::runtime_error("Failed to create shared memory " + segment.m_name + ": " + std::strerror(errno));
+    }
+    segment.m_owner = true;
+    if (ftruncate(fd, static_cast<off_t>(size)) != 0) {
+        close(fd);
+        throw std::runtime_error("Failed to size shared memory " + segment.m_name + ": " + std::strerror(errno));
+    }
+    void* data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    segment.m_data = data == MAP_FAILED ? nullptr : data;
+#endif
+
+    if (segment.m_data == nullptr) {
+        throw std::runtime_error("Failed to map shared memory " + segment.m_name);
+    }
+    return segment;
+}
+
+auto SharedMemorySegment::open(const std::string& name, const std::size_t size) -> SharedMemorySegment {
+    SharedMemorySegment segment;
+    segment.m_name = mappingName(name);
+    segment.m_size = size;
+
+    // Mapped writable although readers only load: 64-bit atomic loads may need write access on some CPUs
+#ifdef _WIN32
+    segment.m_mapping = OpenFileMappingA(FILE_MAP_ALL_ACCESS, FALSE, segment.m_name.c_str());
+    if (segment.m_mapping == nullptr) {
+        throw std::runtime_error("No shared memory named " + segment.m_name + " (is the demo running with --live-metrics?)");
+    }
+    segment.m_data = MapViewOfFile(segment.m_mapping, FILE_MAP_ALL_ACCESS, 0, 0, size);
+#else
+    const int fd = shm_open(segment.m_name.c_str(), O_RDWR, 0);
+    if (fd < 0) {
+        throw std::runtime_error("No shared memory named " + segment.m_name + " (is the demo running with --live-metrics?)");
+    }
+    struct stat info{};
+    if (fstat(fd, &info) != 0 || static_cast<std::size_t>(info.st_size) < size) {
+        close(fd);
+        throw std::runtime_error("Shared memory " + segment.m_name + " is smaller than the metrics block");
+    }
+    void* data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    segment.m_data = data == MAP_FAILED ? nullptr : data;
+#endif
+
+    if (segment.m_data == nullptr) {
+        throw std::runtime_error("Failed to map shared memory " + segment.m_name);
+    }
+    return segment;
+}
+
+auto SharedMemorySegment::exists(const std::string& name) -> bool {
+#ifdef _WIN32
+    const HANDLE mapping = OpenFileMappingA(FILE_MAP_READ, FALSE, mappingName(name).c_str());
+    if (mapping == nullptr) {
+        return false;
+    }
+    CloseHandle(mapping);
+    return true;
+#else
+    const int fd = shm_open(mappingName(name).c_str(), O_RDONLY, 0);
+    if (fd < 0) {
+        return false;
+    }
+    close(fd);
+    return true;
+#endif
+}
+
+void SharedMemorySegment::remove(const std::string& name) {
+#ifdef _WIN32
+    // Named mappings disappear with their last handle, nothing is left behind
+    (void)name;
+#else
+    shm_unlink(mappingName(name).c_str());
+#endif
+}
+
+SharedMemorySegment::SharedMemorySegment(SharedMemorySegment&& other) noexcept
+    : m_name(std::move(other.m_name)),
+      m_data(std::exchange(other.m_data, nullptr)),
+      m_size(other.m_size),
+      m_owner(std::exchange(other.m_owner, false))
+#ifdef _WIN32
+      , m_mapping(std::exchange(other.m_mapping, nullptr))
+#endif
+{
+}
+
+auto SharedMemorySegment::operator=(SharedMemorySegment&& other) noexcept -> SharedMemorySegment& {
+    if (this != &other) {
+        release();
+        m_name = std::move(other.m_name);
+        m_data = std::exchange(other.m_data, nullptr);
+        m_size = other.m_size;
+        m_owner = std::exchange(other.m_owner, false);
+#ifdef _WIN32
+        m_mapping = std::exchange(other.m_mapping, nullptr);
+#endif
+    }
+    return *this;
+}
+
+SharedMemorySegment::~SharedMemorySegment() {
+    release();
+}
+
+void SharedMemorySegment::release() {
+#ifdef _WIN32
+    // The mapping disappears with the last handle, readers keep it alive
+    if (m_data != nullptr) {
+        UnmapViewOfFile(m_data);
+    }
+    if (m_mapping != nullptr) {
+        CloseHandle(m_mapping);
+    }
+    m_mapping = nullptr;
+#else
+    if (m_data != nullptr) {
+        munmap(m_data, m_size);
+    }
+    if (m_owner) {
+        shm_unlink(m_name.c_str());
+    }
+#endif
+    m_data = nullptr;
+    m_owner = false;
+}
+
+LiveMetricsWriter::LiveMetricsWriter(const std::string& name, const std::span<const char* const> gpuPassNames)
+    : m_segment(createWriterSegment(name)),
+      m_block(new (m_segment.data()) LiveMetricsBlock{}) {
+    if (gpuPassNames.size() > LIVE_METRICS_MAX_GPU_PASSES) {
+        throw std::runtime_error("More GPU passes than LIVE_METRICS_MAX_GPU_PASSES");
+    }
+
+    m_block->processId = currentProcessId();
+    m_block->gpuPassCount = static_cast<std::uint32_t>(gpuPassNames.size());
+    for (std::size_t pass = 0; pass < gpuPassNames.size(); pass++) {
+        std::strncpy(m_block->gpuPassNames[pass], gpuPassNames[pass], LIVE_METRICS_NAME_LENGTH - 1);
+    }
+    m_block->frame = LiveMetricsFrame{};
+    m_block->sequence.store(0, std::memory_order_relaxed);
+
+    // Readers check the magic last, once everything else is in place
+    m_block->version = LIVE_METRICS_VERSION;
+    std::atomic_thread_fence(std::memory_order_release);
+    m_block->magic = LIVE_METRICS_MAGIC;
+}
+
+void LiveMetricsWriter::publish(const LiveMetricsFrame& frame) {
+    // Seqlock: odd while writing. The copy itself races with readers by design, they discard torn copies.
+    const auto sequence = m_block->sequence.load(std::memory_order_relaxed);
+    m_block->sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    std::memcpy(&m_block->frame, &frame, sizeof(LiveMetricsFrame));
+
+    m_block->sequence.store(sequence + 2, std::memory_order_release);
+}
+
+LiveMetricsReader::LiveMetricsReader(const std::string& name)
+    : m_segment(SharedMemorySegment::open(name, sizeof(LiveMetricsBlock))),
+      m_block(static_cast<const LiveMetricsBlock*>(m_segment.data())) {
+    if (m_block->magic != LIVE_METRICS_MAGIC) {
+        throw std::runtime_error("Shared memory " + name + " holds no live metrics (yet)");
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (m_block->version != LIVE_METRICS_VERSION) {
+        throw std::runtime_error("Live metrics layout version " + std::to_string(m_block->version) + ", expected " +
+                                 std::to_string(LIVE_METRICS_VERSION));
+    }
+}
+
+auto LiveMetricsReader::read(LiveMetricsFrame& frame) const -> bool {
+    for (int attempt = 0; attempt < READ_RETRIES; attempt++) {
+        const auto before = m_block->sequence.load(std::memory_order_acquire);
+        if ((before & 1) != 0) {
+            std::this_thread::yield();
+            continue;
+        }
+
+        std::memcpy(&frame, &m_block->frame, sizeof(LiveMetricsFrame));
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (m_block->sequence.load(std::memory_order_relaxed) == before) {
+            return true;
+        }
+    }
+    return false;
+}
+
+auto LiveMetricsReader::gpuPassName(const std::uint32_t pass) const -> std::string {
+    if (pass >= std::min<std::uint32_t>(m_block->gpuPassCount, LIVE_METRICS_MAX_GPU_PASSES)) {
+        return {};
+    }
+    const char* name = m_block->gpuPassNames[pass];
+    return {name, strnlen(name, LIVE_METRICS_NAME_LENGTH)};
+}
@@ -0,0 +1,231 @@
+#include <algorithm>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+
+#include "MemoryTracker.hpp"
+
+namespace {
+double toMegabytes(const std::uint64_t bytes) {
+    return static_cast<double>(bytes) / (1024.0 * 1024.0);
+}
+} // namespace
+
+MemoryTracker::MemoryTracker(const vk::raii::PhysicalDevice& physicalDevice, const bool memoryBudgetSupported)
+    : m_physicalDevice(physicalDevice),
+      m_memoryBudgetSupported(memoryBudgetSupported) {
+    const auto memProperties = m_physicalDevice.getMemoryProperties();
+    for (std::uint32_t i = 0; i < memProperties.memoryTypeCount; i++) {
+        m_typeHeaps[i] = memProperties.memoryTypes[i].heapIndex;
+    }
+}
+
+void MemoryTracker::recordAllocation(const vk::DeviceMemory memory,
+                                     const MemoryCategory category,
+                                     const vk::DeviceSize size,
+                                     const std::uint32_t memoryTypeIndex) {
+    const std::scoped_lock lock(m_mutex);
+
+    // A handle that is still registered was freed without release() and reused by the driver
+    forget(memory);
+
+    const std::uint32_t heapIndex = m_typeHeaps[memoryTypeIndex];
+    m_allocations.emplace(memory, Allocation{.category = category, .size = size, .heapIndex = heapIndex});
+
+    auto& stats = m_categories[static_cast<std::size_t>(category)];
+    stats.currentBytes += size;
+    stats.peakBytes = std::max(stats.peakBytes, stats.currentBytes);
+    stats.liveAllocations++;
+    stats.totalAllocations++;
+
+    m_heapBytes[heapIndex] += size;
+    m_currentBytes += size;
+    m_peakBytes = std::max(m_peakBytes, m_currentBytes);
+}
+
+void MemoryTracker::release(vk::raii::DeviceMemory& memory) {
+    {
+        const std::scoped_lock lock(m_mutex);
+        forget(*memory);
+    }
+    memory.clear();
+}
+
+void MemoryTracker::forget(const vk::DeviceMemory memory) {
+    const auto it = m_allocations.find(memory);
+    if (it == m_allocations.end()) {
+        return;
+    }
+
+    const Allocation& allocation = it->second;
+    auto& stats = m_categories[static_cast<std::size_t>(allocation.category)];
+    stats.currentBytes -= allocation.size;
+    stats.liveAllocations--;
+
+    m_heapBytes[allocation.heapIndex] -= allocation.size;
+    m_currentBytes -= allocation.size;
+
+    m_allocations.erase(it);
+}
+
+auto MemoryTracker::getCategoryStats(const MemoryCategory category) const -> MemoryCategoryStats {
+    const std::scoped_lock lock(m_mutex);
+    return m_categories[static_cast<std::size_t>(category)];
+}
+
+auto MemoryTracker::getCurrentBytes() const -> std::uint64_t {
+    const std::scoped_lock lock(m_mutex);
+    return m_currentBytes;
+}
+
+auto MemoryTracker::getPeakBytes() const -> std::uint64_t {
+    const std::scoped_lock lock(m_mutex);
+    return m_peakBytes;
+}
+
+auto MemoryTracker::queryHeaps() const -> std::vector<MemoryHeapReport> {
+    vk::PhysicalDeviceMemoryProperties memProperties;
+    vk::PhysicalDeviceMemoryBudgetPropertiesEXT budget{};
+
+    if (m_memoryBudgetSupported) {
+        const auto chain = m_physicalDevice.getMemoryProperties2<vk::PhysicalDeviceMemoryProperties2,
+                                                                 vk::PhysicalDeviceMemoryBudgetPropertiesEXT>();
+        memProperties = chain.get<vk::PhysicalDeviceMemoryProperties2>().memoryProperties;
+        budget = chain.get<vk::PhysicalDeviceMemoryBudgetPropertiesEXT>();
+    } else {
+        memProperties = m_physicalDevice.getMemoryProperties();
+    }
+
+    const std::scoped_lock lock(m_mutex);
+
+    std::vector<MemoryHeapReport> heaps;
+    heaps.reserve(memProperties.memoryHeapCount);
+    for (std::uint32_t i = 0; i < memProperties.memoryHeapCount; i++) {
+        heaps.push_back({
+            .heapIndex = i,
+            .deviceLocal = static_cast<bool>(memProperties.memoryHeaps[i].flags & vk::MemoryHeapFlagBits::eDeviceLocal),
+            .sizeBytes = memProperties.memoryHeaps[i].size,
+            .trackedBytes = m_heapBytes[i],
+            .budgetBytes = budget.heapBudget[i],
+            .usageBytes = budget.heapUsage[i],
+        });
+    }
+    return heaps;
+}
+
+auto MemoryTracker::queryDeviceLocalBudget() const -> MemoryBudget {
+    if (!m_memoryBudgetSupported) {
+        return {};
+    }
+
+    const auto chain = m_physicalDevice.getMemoryProperties2<vk::PhysicalDeviceMemoryProperties2,
+                                                             vk::PhysicalDeviceMemoryBudgetPropertiesEXT>();
+    const auto& memProperties = chain.get<vk::PhysicalDeviceMemoryProperties2>().memoryProperties;
+    const auto& budget = chain.get<vk::PhysicalDeviceMemoryBudgetPropertiesEXT>();
+
+    MemoryBudget total;
+    for (std::uint32_t i = 0; i < memProperties.memoryHeapCount; i++) {
+        if (memProperties.memoryHeaps[i].flags & vk::MemoryHeapFlagBits::eDeviceLocal) {
+            total.budgetBytes += budget.heapBudget[i];
+            total.usageBytes += budget.heapUsage[i];
+        }
+    }
+    return total;
+}
+
+void MemoryTracker::printSummary() const {
+    const auto heaps = queryHeaps();
+    const std::scoped_lock lock(m_mutex);
+
+    std::cout << std::format("[Memory] {:.1f} MB tracked (peak {:.1f} MB) in {} allocations\n",
+                             toMegabytes(m_currentBytes), toMegabytes(m_peakBytes), m_allocations.size());
+    std::cout << std::format("  {:<28} {:>10} {:>10} {:>7}\n", "category", "MB", "peak MB", "count");
+    for (std::size_t i = 0; i < MEMORY_CATEGORY_COUNT; i++) {
+        const auto& stats = m_categories[i];
+        if (stats.totalAllocations == 0) {
+            continue;
+        }
+        std::cout << std::format("  {:<28} {:>10.1f} {:>10.1f} {:>7}\n", categoryName(static_cast<MemoryCategory>(i)),
+                                 toMegabytes(stats.currentBytes), toMegabytes(stats.peakBytes), stats.liveAllocations);
+    }
+
+    for (const auto& heap : heaps) {
+        std::cout << std::format("  heap {} ({}): {:.1f} MB tracked", heap.heapIndex,
+                                 heap.deviceLocal ? "device local" : "host", toMegabytes(heap.trackedBytes));
+        if (m_memoryBudgetSupported) {
+            std::cout << std::format(", {:.1f} / {:.1f} MB budget used by the process", toMegabytes(heap.usageBytes),
+                                     toMegabytes(heap.budgetBytes));
+        }
+        std::cout << std::format(", {:.1f} MB heap\n", toMegabytes(heap.sizeBytes));
+    }
+    std::cout << std::flush;
+}
+
+void MemoryTracker::writeJson(const std::string& path) const {
+    const auto heaps = queryHeaps();
+
+    std::ofstream file(path);
+    if (!file) {
+        throw std::runtime_error("Failed to open memory report for writing: " + path);
+    }
+
+    const std::scoped_lock lock(m_mutex);
+
+    file << "{\n";
+    file << "  \"currentBytes\": " << m_currentBytes << ",\n";
+    file << "  \"peakBytes\": " << m_peakBytes << ",\n";
+    file << "  \"liveAllocations\": " << m_allocations.size() << ",\n";
+    file << "  \"memoryBudget\": " << (m_memoryBudgetSupported ? "true" : "false") << ",\n";
+    file << "  \"categories\": {";
+
+    for (std::size_t i = 0; i < MEMORY_CATEGORY_COUNT; i++) {
+        const auto& stats = m_categories[i];
+        file << (i == 0 ? "\n" : ",\n");
+        file << std::format(
+            "    \"{}\": {{ \"currentBytes\": {}, \"peakBytes\": {}, \"liveAllocations\": {}, \"totalAllocations\": {} }}",
+            categoryName(static_cast<MemoryCategory>(i)), stats.currentBytes, stats.peakBytes, stats.liveAllocations,
+            stats.totalAllocations);
+    }
+
+    file << "\n  },\n";
+    file << "  \"heaps\": [";
+
+    for (std::size_t i = 0; i < heaps.size(); i++) {
+        const auto& heap = heaps[i];
+        file << (i == 0 ? "\n" : ",\n");
+        file << std::format(
+            "    {{ \"index\": {}, \"deviceLocal\": {}, \"sizeBytes\": {}, \"trackedBytes\": {}, \"budgetBytes\": {}, "
+            "\"usageBytes\": {} }}",
+            heap.heapIndex, heap.deviceLocal ? "true" : "false", heap.sizeBytes, heap.trackedBytes, heap.budgetBytes,
+            heap.usageBytes);
+    }
+
+    file << "\n  ]\n}\n";
+
+    std::cout << "[Memory] Report written to " << path << std::endl;
+}
+
+auto MemoryTracker::categoryName(const MemoryCategory category) -> const char* {
+    switch (category) {
+        case MemoryCategory::Geometry: return "geometry";
+        case MemoryCategory::Materials: return "materials";
+        case MemoryCategory::TextureBaseColor: return "texture.base_color";
+        case MemoryCategory::TextureMetallicRoughness: return "texture.metallic_roughness";
+        case MemoryCategory::TextureNormal: return "texture.normal";
+        case MemoryCategory::TextureEmissive: return "texture.emissive";
+        case MemoryCategory::TextureOcclusion: return "texture.occlusion";
+        case MemoryCategory::TextureSkybox: return "texture.skybox";
+        case MemoryCategory::ProbeVolume: return "probe_volume";
+        case MemoryCategory::Blas: return "blas";
+        case MemoryCategory::Tlas: return "tlas";
+        case MemoryCategory::AccelerationScratch: return "acceleration_scratch";
+        case MemoryCategory::RenderTargets: return "render_targets";
+        case MemoryCategory::Staging: return "staging";
+        case MemoryCategory::PerFrame: return "per_frame";
+        case MemoryCategory::ExportReadback: return "export_readback";
+        case MemoryCategory::PvsBake: return "pvs_bake";
+        case MemoryCategory::Count: break;
+    }
+    return "unknown";
+}
@@ -0,0 +1,257 @@
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <system_error>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+#include "constants.hpp"
+#include "PipelineCache.hpp"
+#include "VulkanCore.hpp"
+#include "JobSystem.hpp"
+#include "CpuProfiler.hpp"
+
+namespace {
+constexpr std::uint32_t kFileMagic = 0x48435043;  // "CPCH"
+constexpr std::uint32_t kFileVersion = 1;
+
+// Our header in front of the blob returned by vkGetPipelineCacheData
+struct FileHeader {
+    std::uint32_t magic;
+    std::uint32_t version;
+    std::uint32_t vendorID;
+    std::uint32_t deviceID;
+    std::uint32_t driverVersion;
+    std::uint32_t reserved;
+    std::array<std::uint8_t, VK_UUID_SIZE> deviceUUID;
+    std::array<std::uint8_t, VK_UUID_SIZE> driverUUID;
+    std::array<std::uint8_t, VK_UUID_SIZE> pipelineCacheUUID;
+    std::uint64_t dataSize;
+    std::uint64_t dataHash;
+    double coldCreationMs;
+};
+
+// Layout of VkPipelineCacheHeaderVersionOne at the start of every Vulkan cache blob
+struct VulkanBlobHeader {
+    std::uint32_t headerSize;
+    std::uint32_t headerVersion;
+    std::uint32_t vendorID;
+    std::uint32_t deviceID;
+    std::array<std::uint8_t, VK_UUID_SIZE> pipelineCacheUUID;
+};
+
+std::uint64_t fnv1a(const std::uint8_t* data, const std::size_t size) {
+    std::uint64_t hash = 0xcbf29ce484222325ULL;
+    for (std::size_t i = 0; i < size; i++) {
+        hash ^= data[i];
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+auto currentProcessId() -> unsigned long {
+#ifdef _WIN32
+    return GetCurrentProcessId();
+#else
+    return static_cast<unsigned long>(getpid());
+#endif
+}
+
+template <std::size_t N>
+std::string hex(const std::array<std::uint8_t, N>& bytes, const std::size_t count) {
+    std::string result;
+    for (std::size_t i = 0; i < count && i < N; i++) {
+        result += std::format("{:02x}", bytes[i]);
+    }
+    return result;
+}
+} // namespace
+
+PipelineCache::PipelineCache(VulkanCore& vulkanCore, JobSystem& jobSystem, const bool ignoreExisting)
+    : m_vulkanCore(vulkanCore), m_jobSystem(jobSystem) {
+    PROFILE_ZONE("PipelineCache::load");
+
+    queryDeviceKey();
+
+    // One file per device + driver so switching GPUs or updating drivers never reuses a stale cache
+    m_path = std::filesystem::path(PIPELINE_CACHE_DIRECTORY) /
+             std::format("pipelines_{}_{}.bin", hex(m_key.deviceUUID, 8), hex(m_key.driverUUID, 8));
+
+    std::vector<std::uint8_t> blob;
+    if (!ignoreExisting) {
+        blob = loadValidatedBlob();
+    }
+
+    m_warm = !blob.empty();
+    m_loadedBytes = blob.size();
+
+    const vk::PipelineCacheCreateInfo createInfo{
+        .initialDataSize = blob.size(),
+        .pInitialData = blob.empty() ? nullptr : blob.data(),
+    };
+    m_cache = vk::raii::PipelineCache(m_vulkanCore.device(), createInfo);
+}
+
+void PipelineCache::queryDeviceKey() {
+    const auto chain = m_vulkanCore.physicalDevice()
+                           .getProperties2<vk::PhysicalDeviceProperties2, vk::PhysicalDeviceIDProperties>();
+    const auto& properties = chain.get<vk::PhysicalDeviceProperties2>().properties;
+    const auto& ids = chain.get<vk::PhysicalDeviceIDProperties>();
+
+    m_key.vendorID = properties.vendorID;
+    m_key.deviceID = properties.deviceID;
+    m_key.driverVersion = properties.driverVersion;
+    std::memcpy(m_key.deviceUUID.data(), ids.deviceUUID.data(), VK_UUID_SIZE);
+    std::memcpy(m_key.driverUUID.data(), ids.driverUUID.data(), VK_UUID_SIZE);
+    std::memcpy(m_key.pipelineCacheUUID.data(), properties.pipelineCacheUUID.data(), VK_UUID_SIZE);
+}
+
+auto PipelineCache::loadValidatedBlob() -> std::vector<std::uint8_t> {
+    std::ifstream file(m_path, std::ios::binary | std::ios::ate);
+    if (!file) {
+        return {};
+    }
+
+    const auto fileSize = static_cast<std::size_t>(file.tellg());
+    file.seekg(0);
+
+    const auto reject = [this](const char* reason) {
+        std::cout << "[PipelineCache] Ignoring " << m_path.string() << ": " << reason << std::endl;
+        return std::vector<std::uint8_t>{};
+    };
+
+    FileHeader header{};
+    if (fileSize < sizeof(FileHeader) || !file.read(reinterpret_cast<char*>(&header), sizeof(FileHeader))) {
+        return reject("truncated header");
+    }
+
+    if (header.magic != kFileMagic || header.version != kFileVersion) {
+        return reject("unknown format");
+    }
+
+    if (header.vendorID != m_key.vendorID || header.deviceID != m_key.deviceID ||
+        header.driverVersion != m_key.driverVersion || header.deviceUUID != m_key.deviceUUID ||
+        header.driverUUID != m_key.driverUUID || header.pipelineCacheUUID != m_key.pipelineCacheUUID) {
+        return reject("written by a different device or driver");
+    }
+
+    if (header.dataSize != fileSize - sizeof(FileHeader) || header.dataSize < sizeof(VulkanBlobHeader)) {
+        return reject("size mismatch");
+    }
+
+    std::vector<std::uint8_t> blob(header.dataSize);
+    if (!file.read(reinterpret_cast<char*>(blob.data()), static_cast<std::streamsize>(blob.size()))) {
+        return reject("truncated data");
+    }
+
+    if (fnv1a(blob.data(), blob.size()) != header.dataHash) {
+        return reject("checksum mismatch");
+    }
+
+    // The driver validates its own header as well, but a mismatch there would silently yield an empty cache
+    VulkanBlobHeader blobHeader{};
+    std::memcpy(&blobHeader, blob.data(), sizeof(VulkanBlobHeader));
+    if (blobHeader.headerVersion != static_cast<std::uint32_t>(vk::PipelineCacheHeaderVersion::eOne) ||
+        blobHeader.vendorID != m_key.vendorID || blobHeader.deviceID != m_key.deviceID ||
+        blobHeader.pipelineCacheUUID != m_key.pipelineCacheUUID) {
+        return reject("driver cache header mismatch");
+    }
+
+    m_previousColdMs = header.coldCreationMs;
+    return blob;
+}
+
+auto PipelineCache::createGraphicsPipeline(const vk::GraphicsPipelineCreateInfo& createInfo) const
+    -> vk::raii::Pipeline {
+    PROFILE_ZONE("PipelineCache::createGraphicsPipeline");
+
+    // Pipeline caches are internally synchronized, concurrent creation needs no locking
+    auto pipeline = vk::raii::Pipeline(m_vulkanCore.device(), m_cache, createInfo);
+    m_pipelineCount.fetch_add(1);
+    return pipeline;
+}
+
+void PipelineCache::buildInParallel(const std::vector<std::function<void()>>& builders) {
+    const auto start = std::chrono::steady_clock::now();
+
+    m_jobSystem.parallelFor(builders.size(), [&builders](const std::size_t i) {
+        builders[i]();
+    });
+
+    m_creationMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void PipelineCache::save() const {
+    PROFILE_ZONE("PipelineCache::save");
+
+    const auto data = m_cache.getData();
+
+    FileHeader header{
+        .magic = kFileMagic,
+        .version = kFileVersion,
+        .vendorID = m_key.vendorID,
+        .deviceID = m_key.deviceID,
+        .driverVersion = m_key.driverVersion,
+        .reserved = 0,
+        .deviceUUID = m_key.deviceUUID,
+        .driverUUID = m_key.driverUUID,
+        .pipelineCacheUUID = m_key.pipelineCacheUUID,
+        .dataSize = data.size(),
+        .dataHash = fnv1a(data.data(), data.size()),
+        // Keep the cold-start reference across warm runs
+        .coldCreationMs = m_warm ? m_previousColdMs : m_creationMs,
+    };
+
+    std::error_code error;
+    std::filesystem::create_directories(m_path.parent_path(), error);
+
+    // Write to a temporary file first so an interrupted save never leaves a torn cache behind. The name is
+    // per process, parallel export workers save the same cache concurrently and the last rename wins.
+    auto tempPath = m_path;
+    tempPath += std::format(".{}.tmp", currentProcessId());
+    {
+        std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+        if (!file) {
+            std::cerr << "[PipelineCache] Failed to write " << tempPath.string() << std::endl;
+            return;
+        }
+        file.write(reinterpret_cast<const char*>(&header), sizeof(FileHeader));
+        file.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+        if (!file) {
+            std::cerr << "[PipelineCache] Failed to write " << tempPath.string() << std::endl;
+            return;
+        }
+    }
+
+    std::filesystem::rename(tempPath, m_path, error);
+    if (error) {
+        std::cerr << "[PipelineCache] Failed to replace " << m_path.string() << ": " << error.message() << std::endl;
+    }
+}
+
+void PipelineCache::printReport() const {
+    const auto count = m_pipelineCount.load();
+
+    if (!m_warm) {
+        std::cout << std::format("[PipelineCache] Cold start: {} pipelines in {:.1f} ms\n", count, m_creationMs);
+    } else if (m_previousColdMs > 0.0) {
+        std::cout << std::format(
+            "[PipelineCache] Warm start ({} KiB loaded): {} pipelines in {:.1f} ms, cold start took {:.1f} ms "
+            "({:.1f}x faster)\n",
+            m_loadedBytes / 1024, count, m_creationMs, m_previousColdMs,
+            m_previousColdMs / std::max(m_creationMs, 1e-3));
+    } else {
+        std::cout << std::format("[PipelineCache] Warm start ({} KiB loaded): {} pipelines in {:.1f} ms\n",
+                                 m_loadedBytes / 1024, count, m_creationMs);
+    }
+    std::cout << std::flush;
+}
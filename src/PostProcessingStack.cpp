@@ -1,5 +1,7 @@
 #include <iostream>
 #include <array>
+#include <functional>
+#include <vector>
 
 #include "PostProcessingStack.hpp"
 #include "VulkanCore.hpp"
@@ -8,6 +10,8 @@
 #include "BufferManager.hpp"
 #include "Shader.hpp"
 #include "SharedTypes.hpp"
+#include "GpuProfiler.hpp"
+#include "PipelineCache.hpp"
 #include "constants.hpp"
 
 static const std::uint32_t RESOLVED_IMAGE_BINDING = 0;
@@ -17,12 +21,16 @@ PostProcessingStack::PostProcessingStack(VulkanCore& vulkanCore,
                                          ResourceManager& resourceManager,
                                          SwapChain& swapChain,
                                          ImageManager& imageManager,
-                                         BufferManager& bufferManager) 
+                                         BufferManager& bufferManager,
+                                         GpuProfiler& gpuProfiler,
+                                         PipelineCache& pipelineCache)
     : m_vulkanCore(vulkanCore),
       m_resourceManager(resourceManager),
       m_swapChain(swapChain),
       m_imageManager(imageManager),
-      m_bufferManager(bufferManager) {
+      m_bufferManager(bufferManager),
+      m_gpuProfiler(gpuProfiler),
+      m_pipelineCache(pipelineCache) {
     createShaderModules();
     createImages();
     createDescriptorPool();
@@ -43,6 +51,8 @@ void PostProcessingStack::createShaderModules() {
                                                     "shaders/postprocessing/gaussian_blur.frag.spv");
     m_compositeFragmentShader = std::make_unique<Shader>(m_vulkanCore.device(), vk::ShaderStageFlagBits::eFragment,
                                                          "shaders/postprocessing/composite.frag.spv");
+    m_heatmapFragmentShader = std::make_unique<Shader>(m_vulkanCore.device(), vk::ShaderStageFlagBits::eFragment,
+                                                       "shaders/postprocessing/count_heatmap.frag.spv");
     
     // TAA shader
     if constexpr (TAA_ENABLED) {
@@ -52,15 +62,23 @@ void PostProcessingStack::createShaderModules() {
 }
 
 void PostProcessingStack::createPipelines() {
+    // The passes share no state, so every pipeline is compiled on its own worker
+    std::vector<std::function<void()>> builders = {
+        [this] { m_hdrTransferPipeline = createPostProcessPipeline(*m_hdrFragmentShader, m_hdrTransferPipelineLayout, POST_PROCESSING_IMAGE_FORMAT); },
+        [this] { m_brightPassPipeline = createPostProcessPipeline(*m_brightPassFragmentShader, m_brightPassPipelineLayout, POST_PROCESSING_IMAGE_FORMAT); },
+        [this] { m_blurPipeline = createPostProcessPipeline(*m_blurFragmentShader, m_blurPipelineLayout, POST_PROCESSING_IMAGE_FORMAT); },
+        [this] { m_compositePipeline = createPostProcessPipeline(*m_compositeFragmentShader, m_compositePipelineLayout, m_swapChain.getFormat()); },
+        [this] { m_heatmapPipeline = createPostProcessPipeline(*m_heatmapFragmentShader, m_heatmapPipelineLayout, m_swapChain.getFormat()); },
+    };
+
     // TAA pipeline (before HDR transfer, operates on linear color)
     if constexpr (TAA_ENABLED) {
-        m_taaPipeline = createPostProcessPipeline(*m_taaFragmentShader, m_taaPipelineLayout, POST_PROCESSING_IMAGE_FORMAT);
+        builders.emplace_back([this] {
+            m_taaPipeline = createPostProcessPipeline(*m_taaFragmentShader, m_taaPipelineLayout, POST_PROCESSING_IMAGE_FORMAT);
+        });
     }
-    
-    m_hdrTransferPipeline = createPostProcessPipeline(*m_hdrFragmentShader, m_hdrTransferPipelineLayout, POST_PROCESSING_IMAGE_FORMAT);
-    m_brightPassPipeline = createPostProcessPipeline(*m_brightPassFragmentShader, m_brightPassPipelineLayout, POST_PROCESSING_IMAGE_FORMAT);
-    m_blurPipeline = createPostProcessPipeline(*m_blurFragmentShader, m_blurPipelineLayout, POST_PROCESSING_IMAGE_FORMAT);
-    m_compositePipeline = createPostProcessPipeline(*m_compositeFragmentShader, m_compositePipelineLayout, m_swapChain.getFormat());
+
+    m_pipelineCache.buildInParallel(builders);
 }
 
 void PostProcessingStack::createImages() {
@@ -74,6 +92,7 @@ void PostProcessingStack::createImages() {
             vk::raii::DeviceMemory taaHistoryMemory{nullptr};
             
             m_imageManager.createImage(
+                MemoryCategory::RenderTargets,
                 extent.width,
                 extent.height,
                 1,
@@ -100,6 +119,7 @@ void PostProcessingStack::createImages() {
             vk::raii::DeviceMemory taaOutputMemory{nullptr};
             
             m_imageManager.createImage(
+                MemoryCategory::RenderTargets,
                 extent.width,
                 extent.height,
                 1,
@@ -127,6 +147,7 @@ void PostProcessingStack::createImages() {
         vk::raii::DeviceMemory hdrImageMemory{nullptr};
 
         m_imageManager.createImage(
+            MemoryCategory::RenderTargets,
             extent.width,
             extent.height,
             1,
@@ -154,6 +175,7 @@ void PostProcessingStack::createImages() {
         vk::raii::DeviceMemory brightPassImageMemory{nullptr};
 
         m_imageManager.createImage(
+            MemoryCategory::RenderTargets,
             extent.width,
             extent.height,
             1,
@@ -182,6 +204,7 @@ void PostProcessingStack::createImages() {
             vk::raii::DeviceMemory blurImageMemory{nullptr};
 
             m_imageManager.createImage(
+                MemoryCategory::RenderTargets,
                 extent.width,
                 extent.height,
                 1,
@@ -208,20 +231,18 @@ void PostProcessingStack::createImages() {
 }
 
 void PostProcessingStack::createDescriptorPool() {
-    // TAA needs 3 samplers per frame: current color, history, velocity
-    const std::uint32_t taaDescriptorCount = TAA_ENABLED ? MAX_FRAMES_IN_FLIGHT * 3 : 0;
-    const std::uint32_t taaSetsCount = TAA_ENABLED ? MAX_FRAMES_IN_FLIGHT : 0;
-    
+    // Only the blur (2 per frame) and composite (1 per frame, 2 samplers) sets are allocated. TAA, HDR transfer
+    // and bright pass read images that change every frame and push their descriptors instead.
     std::array poolSizes = {
         vk::DescriptorPoolSize{
             .type = vk::DescriptorType::eCombinedImageSampler,
-            .descriptorCount = MAX_FRAMES_IN_FLIGHT * 4 + POST_PROCESSING_BLUR_STAGES + 3 + taaDescriptorCount,
+            .descriptorCount = MAX_FRAMES_IN_FLIGHT * 4,
         },
     };
 
     const vk::DescriptorPoolCreateInfo poolCreateInfo{
         .flags = vk::DescriptorPoolCreateFlagBits::eFreeDescriptorSet,
-        .maxSets = MAX_FRAMES_IN_FLIGHT * 5 + POST_PROCESSING_BLUR_STAGES + 2 + taaSetsCount,
+        .maxSets = MAX_FRAMES_IN_FLIGHT * 3,
         .poolSizeCount = static_cast<std::uint32_t>(poolSizes.size()),
         .pPoolSizes = poolSizes.data(),
     };
@@ -241,6 +262,7 @@ void PostProcessingStack::createDescriptorSetLayouts() {
     std::array hdrTransferBindings = {hdrTraansferResolvedImageBinding};
 
     const vk::DescriptorSetLayoutCreateInfo hdrTransferLayoutCreateInfo{
+        .flags = vk::DescriptorSetLayoutCreateFlagBits::ePushDescriptorKHR,
         .bindingCount = static_cast<std::uint32_t>(hdrTransferBindings.size()),
         .pBindings = hdrTransferBindings.data(),
     };
@@ -261,6 +283,7 @@ void PostProcessingStack::createDescriptorSetLayouts() {
     std::array brightPassBindings = {brightPassHdrImageBinding};
 
     const vk::DescriptorSetLayoutCreateInfo brightPassLayoutCreateInfo{
+        .flags = vk::DescriptorSetLayoutCreateFlagBits::ePushDescriptorKHR,
         .bindingCount = static_cast<std::uint32_t>(brightPassBindings.size()),
         .pBindings = brightPassBindings.data(),
     };
@@ -317,6 +340,26 @@ void PostProcessingStack::createDescriptorSetLayouts() {
         m_vulkanCore.device(),
         compositeLayoutCreateInfo
         );
+
+    // Debug view heatmap reads a counter image of the scene passes, which stays in General layout
+    constexpr vk::DescriptorSetLayoutBinding heatmapCountsBinding{
+        .binding = 0,
+        .descriptorType = vk::DescriptorType::eStorageImage,
+        .descriptorCount = 1,
+        .stageFlags = vk::ShaderStageFlagBits::eFragment,
+        .pImmutableSamplers = nullptr,
+    };
+
+    const vk::DescriptorSetLayoutCreateInfo heatmapLayoutCreateInfo{
+        .flags = vk::DescriptorSetLayoutCreateFlagBits::ePushDescriptorKHR,
+        .bindingCount = 1,
+        .pBindings = &heatmapCountsBinding,
+    };
+
+    m_heatmapDescriptorSetLayout = vk::raii::DescriptorSetLayout(
+        m_vulkanCore.device(),
+        heatmapLayoutCreateInfo
+        );
     
     // TAA descriptor set layout
     if constexpr (TAA_ENABLED) {
@@ -350,6 +393,7 @@ void PostProcessingStack::createDescriptorSetLayouts() {
         std::array taaBindings = {taaCurrentColorBinding, taaHistoryBinding, taaVelocityBinding};
         
         const vk::DescriptorSetLayoutCreateInfo taaLayoutCreateInfo{
+            .flags = vk::DescriptorSetLayoutCreateFlagBits::ePushDescriptorKHR,
             .bindingCount = static_cast<std::uint32_t>(taaBindings.size()),
             .pBindings = taaBindings.data(),
         };
@@ -362,49 +406,6 @@ void PostProcessingStack::createDescriptorSetLayouts() {
 }
 
 void PostProcessingStack::createDescriptorSets() {
-    std::vector<vk::DescriptorSetLayout> hdrTransferLayouts(MAX_FRAMES_IN_FLIGHT, *m_hdrTransferDescriptorSetLayout);
-    
-    const vk::DescriptorSetAllocateInfo hdrTransferDescriptorSetAllocInfo{
-        .descriptorPool = m_descriptorPool,
-        .descriptorSetCount = MAX_FRAMES_IN_FLIGHT,
-        .pSetLayouts = hdrTransferLayouts.data(),
-    };
-
-    // Allocate descriptor sets but don't initialize them yet - they'll be updated per-frame
-    // with the current resolved image view
-    m_hdrTransferDescriptorSets = m_vulkanCore.device().allocateDescriptorSets(hdrTransferDescriptorSetAllocInfo);
-
-    std::vector<vk::DescriptorSetLayout> brightPassLayouts(MAX_FRAMES_IN_FLIGHT, *m_brightPassDescriptorSetLayout);
-    
-    const vk::DescriptorSetAllocateInfo brightDescriptorSetAllocInfo{
-        .descriptorPool = m_descriptorPool,
-        .descriptorSetCount = MAX_FRAMES_IN_FLIGHT,
-        .pSetLayouts = brightPassLayouts.data(),
-    };
-
-    m_brightPassDescriptorSets =  m_vulkanCore.device().allocateDescriptorSets(brightDescriptorSetAllocInfo);
-
-    for (std::size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; ++i) {
-        vk::DescriptorImageInfo hdrImageIinfo{
-            .sampler = *m_sampler,
-            .imageView = *m_hdrImageViews[i],  // Fixed: use HDR image, not HDR transfer image
-            .imageLayout = vk::ImageLayout::eShaderReadOnlyOptimal,
-        };
-
-        std::array writeDescriptors = {
-            vk::WriteDescriptorSet{
-                .dstSet = m_brightPassDescriptorSets[i],
-                .dstBinding = 0,
-                .dstArrayElement = 0,
-                .descriptorCount = 1,
-                .descriptorType = vk::DescriptorType::eCombinedImageSampler,
-                .pImageInfo = &hdrImageIinfo,
-            },
-        };
-
-        m_vulkanCore.device().updateDescriptorSets(writeDescriptors, {});
-    }
-
     // We need descriptor sets for 2 blur passes (horizontal and vertical) for each frame
     std::vector<vk::DescriptorSetLayout> blurLayouts(MAX_FRAMES_IN_FLIGHT * 2, *m_blurDescriptorSetLayout);
 
@@ -502,19 +503,6 @@ void PostProcessingStack::createDescriptorSets() {
 
         m_vulkanCore.device().updateDescriptorSets(writeDescriptors, {});
     }
-    
-    // TAA descriptor sets (will be updated per-frame in updateDescriptorSets)
-    if constexpr (TAA_ENABLED) {
-        std::vector<vk::DescriptorSetLayout> taaLayouts(MAX_FRAMES_IN_FLIGHT, *m_taaDescriptorSetLayout);
-        
-        const vk::DescriptorSetAllocateInfo taaDescriptorSetAllocInfo{
-            .descriptorPool = m_descriptorPool,
-            .descriptorSetCount = MAX_FRAMES_IN_FLIGHT,
-            .pSetLayouts = taaLayouts.data(),
-        };
-        
-        m_taaDescriptorSets = m_vulkanCore.device().allocateDescriptorSets(taaDescriptorSetAllocInfo);
-    }
 }
 
 void PostProcessingStack::createPipelineLayouts() {
@@ -557,6 +545,21 @@ void PostProcessingStack::createPipelineLayouts() {
     };
 
     m_compositePipelineLayout = vk::raii::PipelineLayout(m_vulkanCore.device(), compositeInfo);
+
+    constexpr vk::PushConstantRange heatmapPushConstantRange{
+        .stageFlags = vk::ShaderStageFlagBits::eFragment,
+        .offset = 0,
+        .size = sizeof(HeatmapPushConstant),
+    };
+
+    const vk::PipelineLayoutCreateInfo heatmapInfo{
+        .setLayoutCount = 1,
+        .pSetLayouts = &*m_heatmapDescriptorSetLayout,
+        .pushConstantRangeCount = 1,
+        .pPushConstantRanges = &heatmapPushConstantRange,
+    };
+
+    m_heatmapPipelineLayout = vk::raii::PipelineLayout(m_vulkanCore.device(), heatmapInfo);
     
     // TAA pipeline layout
     if constexpr (TAA_ENABLED) {
@@ -666,110 +669,7 @@ vk::raii::Pipeline PostProcessingStack::createPostProcessPipeline(
         .layout = *pipelineLayout
     };
 
-    return vk::raii::Pipeline(m_vulkanCore.device(), nullptr, pipelineInfo);
-}
-
-void PostProcessingStack::updateDescriptorSets(const vk::raii::ImageView& resolvedImageView,
-                                               const vk::raii::ImageView& velocityImageView,
-                                               uint32_t frameIndex) {
-    std::vector<vk::WriteDescriptorSet> descriptorWrites;
-    
-    // All DescriptorImageInfo objects must outlive the updateDescriptorSets call
-    // so we declare them at function scope
-    
-    // TAA descriptor infos (only used when TAA_ENABLED)
-    vk::DescriptorImageInfo taaCurrentInfo{};
-    vk::DescriptorImageInfo taaHistoryInfo{};
-    vk::DescriptorImageInfo taaVelocityInfo{};
-    
-    // TAA descriptor set update
-    if constexpr (TAA_ENABLED) {
-        // Current color (from scene render)
-        taaCurrentInfo = {
-            .sampler = m_sampler,
-            .imageView = resolvedImageView,
-            .imageLayout = vk::ImageLayout::eShaderReadOnlyOptimal,
-        };
-        
-        // History buffer (previous frame's TAA output, or current if first frame)
-        taaHistoryInfo = {
-            .sampler = m_sampler,
-            .imageView = m_taaFirstFrame ? *resolvedImageView : *m_taaHistoryImageViews[frameIndex],
-            .imageLayout = vk::ImageLayout::eShaderReadOnlyOptimal,
-        };
-        
-        // Velocity buffer
-        taaVelocityInfo = {
-            .sampler = m_sampler,
-            .imageView = velocityImageView,
-            .imageLayout = vk::ImageLayout::eShaderReadOnlyOptimal,
-        };
-        
-        descriptorWrites.emplace_back(vk::WriteDescriptorSet{
-            .dstSet = m_taaDescriptorSets[frameIndex],
-            .dstBinding = 0,
-            .dstArrayElement = 0,
-            .descriptorCount = 1,
-            .descriptorType = vk::DescriptorType::eCombinedImageSampler,
-            .pImageInfo = &taaCurrentInfo,
-        });
-        
-        descriptorWrites.emplace_back(vk::WriteDescriptorSet{
-            .dstSet = m_taaDescriptorSets[frameIndex],
-            .dstBinding = 1,
-            .dstArrayElement = 0,
-            .descriptorCount = 1,
-            .descriptorType = vk::DescriptorType::eCombinedImageSampler,
-            .pImageInfo = &taaHistoryInfo,
-        });
-        
-        descriptorWrites.emplace_back(vk::WriteDescriptorSet{
-            .dstSet = m_taaDescriptorSets[frameIndex],
-            .dstBinding = 2,
-            .dstArrayElement = 0,
-            .descriptorCount = 1,
-            .descriptorType = vk::DescriptorType::eCombinedImageSampler,
-            .pImageInfo = &taaVelocityInfo,
-        });
-    }
-
-    // Update HDR transfer descriptor set
-    // When TAA is enabled, HDR transfer reads from TAA output instead of resolved image
-    const vk::DescriptorImageInfo hdrTransferInfo{
-        .sampler = m_sampler,
-        .imageView = TAA_ENABLED ? *m_taaOutputImageViews[frameIndex] : *resolvedImageView,
-        .imageLayout = vk::ImageLayout::eShaderReadOnlyOptimal,
-    };
-
-    vk::WriteDescriptorSet hdrTransferWrite{
-        .dstSet = m_hdrTransferDescriptorSets[frameIndex],
-        .dstBinding = 0,
-        .dstArrayElement = 0,
-        .descriptorCount = 1,
-        .descriptorType = vk::DescriptorType::eCombinedImageSampler,
-        .pImageInfo = &hdrTransferInfo,
-    };
-
-    descriptorWrites.emplace_back(hdrTransferWrite);
-
-    // Update bright pass descriptor set
-    const vk::DescriptorImageInfo brightInfo{
-        .sampler = m_sampler,
-        .imageView = TAA_ENABLED ? *m_taaOutputImageViews[frameIndex] : *resolvedImageView,
-        .imageLayout = vk::ImageLayout::eShaderReadOnlyOptimal,
-    };
-
-    vk::WriteDescriptorSet brightWrite{
-        .dstSet = m_brightPassDescriptorSets[frameIndex],
-        .dstBinding = RESOLVED_IMAGE_BINDING,
-        .dstArrayElement = 0,
-        .descriptorCount = 1,
-        .descriptorType = vk::DescriptorType::eCombinedImageSampler,
-        .pImageInfo = &brightInfo,
-    };
-
-    descriptorWrites.emplace_back(brightWrite);
-    m_vulkanCore.device().updateDescriptorSets(descriptorWrites, {});
+    return m_pipelineCache.createGraphicsPipeline(pipelineInfo);
 }
 
 void PostProcessingStack::recordCommandBuffer(const vk::raii::Image& resolvedImage,
@@ -779,7 +679,8 @@ void PostProcessingStack::recordCommandBuffer(const vk::raii::Image& resolvedIma
                                               const vk::raii::ImageView& targetImageView,
                                               vk::raii::CommandBuffer const& cmd,
                                               BloomParameters bloomParams,
-                                              uint32_t frameIndex) {
+                                              uint32_t frameIndex,
+                                              const DebugHeatmap* heatmap) {
 
     const auto extent = m_swapChain.getExtent();
 
@@ -835,15 +736,44 @@ void PostProcessingStack::recordCommandBuffer(const vk::raii::Image& resolvedIma
             ._padding = 0.0f,
         };
         
+        m_gpuProfiler.beginPass(cmd, GpuPass::TAA);
         cmd.beginRendering(taaRenderingInfo);
         cmd.bindPipeline(vk::PipelineBindPoint::eGraphics, *m_taaPipeline);
         cmd.setScissor(0, vk::Rect2D(vk::Offset2D(0, 0), extent));
         cmd.setViewport(0, vk::Viewport(0.0f, 0.0f, static_cast<float>(extent.width),
                                         static_cast<float>(extent.height), 0.0f, 1.0f));
-        cmd.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, *m_taaPipelineLayout, 0, *m_taaDescriptorSets[frameIndex], {});
+        const std::array taaInputs = {
+            // Current color (from scene render)
+            vk::DescriptorImageInfo{
+                .sampler = *m_sampler,
+                .imageView = *resolvedImageView,
+                .imageLayout = vk::ImageLayout::eShaderReadOnlyOptimal,
+            },
+            // History buffer (previous frame's TAA output, or current if first frame)
+            vk::DescriptorImageInfo{
+                .sampler = *m_sampler,
+                .imageView = m_taaFirstFrame ? *resolvedImageView : *m_taaHistoryImageViews[frameIndex],
+                .imageLayout = vk::ImageLayout::eShaderReadOnlyOptimal,
+            },
+            // Velocity buffer
+            vk::DescriptorImageInfo{
+                .sampler = *m_sampler,
+                .imageView = *velocityImageView,
+                .imageLayout = vk::ImageLayout::eShaderReadOnlyOptimal,
+            },
+        };
+        const vk::WriteDescriptorSet taaWrite{
+            .dstBinding = 0,
+            .dstArrayElement = 0,
+            .descriptorCount = static_cast<std::uint32_t>(taaInputs.size()),
+            .descriptorType = vk::DescriptorType::eCombinedImageSampler,
+            .pImageInfo = taaInputs.data(),
+        };
+        cmd.pushDescriptorSetKHR(vk::PipelineBindPoint::eGraphics, *m_taaPipelineLayout, 0, taaWrite);
         cmd.pushConstants<TAAPushConstant>(*m_taaPipelineLayout, vk::ShaderStageFlagBits::eFragment, 0, taaPushConstant);
         cmd.draw(3, 1, 0, 0);
         cmd.endRendering();
+        m_gpuProfiler.endPass(cmd, GpuPass::TAA);
         
         // Transition TAA output for reading by subsequent passes
         m_imageManager.transitionImageLayout(
@@ -887,15 +817,31 @@ void PostProcessingStack::recordCommandBuffer(const vk::raii::Image& resolvedIma
         .pColorAttachments = &hdrTransferColorAttachmentInfo,
     };
 
+    // HDR transfer and bright pass read the TAA output when TAA is enabled, the resolved scene image otherwise
+    const vk::DescriptorImageInfo sceneColorInfo{
+        .sampler = *m_sampler,
+        .imageView = TAA_ENABLED ? *m_taaOutputImageViews[frameIndex] : *resolvedImageView,
+        .imageLayout = vk::ImageLayout::eShaderReadOnlyOptimal,
+    };
+
+    const vk::WriteDescriptorSet sceneColorWrite{
+        .dstBinding = RESOLVED_IMAGE_BINDING,
+        .dstArrayElement = 0,
+        .descriptorCount = 1,
+        .descriptorType = vk::DescriptorType::eCombinedImageSampler,
+        .pImageInfo = &sceneColorInfo,
+    };
+
+    m_gpuProfiler.beginPass(cmd, GpuPass::HDR);
     cmd.beginRendering(hdrTransferRenderingInfo);
     cmd.bindPipeline(vk::PipelineBindPoint::eGraphics, *m_hdrTransferPipeline);
     cmd.setScissor(0, vk::Rect2D(vk::Offset2D(0, 0), extent));
     cmd.setViewport(0, vk::Viewport(0.0f, 0.0f, static_cast<float>(extent.width),
                                     static_cast<float>(extent.height), 0.0f, 1.0f));
-    cmd.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, *m_hdrTransferPipelineLayout, 0, *m_hdrTransferDescriptorSets[frameIndex],
-                           {});
+    cmd.pushDescriptorSetKHR(vk::PipelineBindPoint::eGraphics, *m_hdrTransferPipelineLayout, 0, sceneColorWrite);
     cmd.draw(3, 1, 0, 0);
     cmd.endRendering();
+    m_gpuProfiler.endPass(cmd, GpuPass::HDR);
 
     // Transition HDR image to shader read layout
     m_imageManager.transitionImageLayout(
@@ -953,16 +899,17 @@ void PostProcessingStack::recordCommandBuffer(const vk::raii::Image& resolvedIma
         .scale = bloomParams.scale,
     };
 
+    m_gpuProfiler.beginPass(cmd, GpuPass::BrightPass);
     cmd.beginRendering(brightPassRendering);
     cmd.bindPipeline(vk::PipelineBindPoint::eGraphics, *m_brightPassPipeline);
     cmd.setScissor(0, vk::Rect2D(vk::Offset2D(0, 0), extent));
     cmd.setViewport(0, vk::Viewport(0.0f, 0.0f, static_cast<float>(extent.width),
                                     static_cast<float>(extent.height), 0.0f, 1.0f));
-    cmd.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, *m_brightPassPipelineLayout, 0, *m_brightPassDescriptorSets[frameIndex],
-                           {});
+    cmd.pushDescriptorSetKHR(vk::PipelineBindPoint::eGraphics, *m_brightPassPipelineLayout, 0, sceneColorWrite);
     cmd.pushConstants<BloomPushConstant>(*m_brightPassPipelineLayout, vk::ShaderStageFlagBits::eFragment, 0, bloomPushConstant);
     cmd.draw(3, 1, 0, 0);
     cmd.endRendering();
+    m_gpuProfiler.endPass(cmd, GpuPass::BrightPass);
 
     // Transition bright pass image to shader read layout for blur pass
     m_imageManager.transitionImageLayout(
@@ -1008,6 +955,7 @@ void PostProcessingStack::recordCommandBuffer(const vk::raii::Image& resolvedIma
 
     bloomPushConstant.direction = glm::vec2(1.0f, 0.0f); // Horizontal
     
+    m_gpuProfiler.beginPass(cmd, GpuPass::BlurHorizontal);
     cmd.beginRendering(horizontalBlurRendering);
     cmd.bindPipeline(vk::PipelineBindPoint::eGraphics, *m_blurPipeline);
     cmd.setScissor(0, vk::Rect2D(vk::Offset2D(0, 0), extent));
@@ -1017,6 +965,7 @@ void PostProcessingStack::recordCommandBuffer(const vk::raii::Image& resolvedIma
     cmd.pushConstants<BloomPushConstant>(*m_blurPipelineLayout, vk::ShaderStageFlagBits::eFragment, 0, bloomPushConstant);
     cmd.draw(3, 1, 0, 0);
     cmd.endRendering();
+    m_gpuProfiler.endPass(cmd, GpuPass::BlurHorizontal);
 
     // transition the resulring horizontal blur image for vertical blur rendering
     m_imageManager.transitionImageLayout(
@@ -1061,6 +1010,7 @@ void PostProcessingStack::recordCommandBuffer(const vk::raii::Image& resolvedIma
 
     bloomPushConstant.direction = glm::vec2(0.0f, 1.0f); // Vertical
 
+    m_gpuProfiler.beginPass(cmd, GpuPass::BlurVertical);
     cmd.beginRendering(verticalBlurRendering);
     cmd.bindPipeline(vk::PipelineBindPoint::eGraphics, *m_blurPipeline);
     cmd.setScissor(0, vk::Rect2D(vk::Offset2D(0, 0), extent));
@@ -1070,6 +1020,7 @@ void PostProcessingStack::recordCommandBuffer(const vk::raii::Image& resolvedIma
     cmd.pushConstants<BloomPushConstant>(*m_blurPipelineLayout, vk::ShaderStageFlagBits::eFragment, 0, bloomPushConstant);
     cmd.draw(3, 1, 0, 0);
     cmd.endRendering();
+    m_gpuProfiler.endPass(cmd, GpuPass::BlurVertical);
 
     // Transition resulting vertical blur image to shader read layout for composite
     m_imageManager.transitionImageLayout(
@@ -1099,15 +1050,36 @@ void PostProcessingStack::recordCommandBuffer(const vk::raii::Image& resolvedIma
         .pColorAttachments = &compositeAttachmentInfo,
     };
 
+    m_gpuProfiler.beginPass(cmd, GpuPass::Composite);
     cmd.beginRendering(compositeRendering);
-    cmd.bindPipeline(vk::PipelineBindPoint::eGraphics, *m_compositePipeline);
     cmd.setScissor(0, vk::Rect2D(vk::Offset2D(0, 0), extent));
     cmd.setViewport(0, vk::Viewport(0.0f, 0.0f, static_cast<float>(extent.width),
                                     static_cast<float>(extent.height), 0.0f, 1.0f));
-    cmd.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, *m_compositePipelineLayout, 0, *m_compositeDescriptorSets[frameIndex], {});
-    cmd.pushConstants<BloomPushConstant>(*m_compositePipelineLayout, vk::ShaderStageFlagBits::eFragment, 0, bloomPushConstant);
+    if (heatmap != nullptr) {
+        const vk::DescriptorImageInfo heatmapCountsInfo{
+            .imageView = *heatmap->countsView,
+            .imageLayout = vk::ImageLayout::eGeneral,
+        };
+        const vk::WriteDescriptorSet heatmapCountsWrite{
+            .dstBinding = 0,
+            .dstArrayElement = 0,
+            .descriptorCount = 1,
+            .descriptorType = vk::DescriptorType::eStorageImage,
+            .pImageInfo = &heatmapCountsInfo,
+        };
+        const HeatmapPushConstant heatmapPushConstant{.maxCount = heatmap->maxCount};
+
+        cmd.bindPipeline(vk::PipelineBindPoint::eGraphics, *m_heatmapPipeline);
+        cmd.pushDescriptorSetKHR(vk::PipelineBindPoint::eGraphics, *m_heatmapPipelineLayout, 0, heatmapCountsWrite);
+        cmd.pushConstants<HeatmapPushConstant>(*m_heatmapPipelineLayout, vk::ShaderStageFlagBits::eFragment, 0, heatmapPushConstant);
+    } else {
+        cmd.bindPipeline(vk::PipelineBindPoint::eGraphics, *m_compositePipeline);
+        cmd.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, *m_compositePipelineLayout, 0, *m_compositeDescriptorSets[frameIndex], {});
+        cmd.pushConstants<BloomPushConstant>(*m_compositePipelineLayout, vk::ShaderStageFlagBits::eFragment, 0, bloomPushConstant);
+    }
     cmd.draw(3, 1, 0, 0);
     cmd.endRendering();
+    m_gpuProfiler.endPass(cmd, GpuPass::Composite);
     
     // TAA: Copy current TAA output to history buffer for next frame
     if constexpr (TAA_ENABLED) {
@@ -0,0 +1,170 @@
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <stdexcept>
+
+#include "PotentiallyVisibleSet.hpp"
+#include "SceneHash.hpp"
+
+namespace {
+constexpr std::uint32_t kFileMagic = 0x31535650;  // "PVS1"
+constexpr std::uint32_t kFileVersion = 1;
+
+struct FileHeader {
+    std::uint32_t magic;
+    std::uint32_t version;
+    std::uint32_t instanceCount;
+    std::uint32_t staticInstanceCount;
+    std::uint32_t segmentCount;
+    std::uint32_t reserved;
+    std::uint64_t sceneHash;
+    float loopDuration;
+    float segmentDuration;
+    std::uint64_t dataSize;
+};
+
+void writeVarint(std::vector<std::uint8_t>& data, std::uint32_t value) {
+    while (value >= 0x80) {
+        data.push_back(static_cast<std::uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+    data.push_back(static_cast<std::uint8_t>(value));
+}
+
+auto readVarint(const std::uint8_t*& cursor, const std::uint8_t* end) -> std::uint32_t {
+    std::uint32_t value = 0;
+    for (std::uint32_t shift = 0; cursor < end && shift < 35; shift += 7) {
+        const std::uint8_t byte = *cursor++;
+        value |= static_cast<std::uint32_t>(byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0) {
+            return value;
+        }
+    }
+    throw std::runtime_error("Corrupt PVS segment");
+}
+
+auto bitSet(const std::span<const std::uint32_t> bits, const std::uint32_t index) -> bool {
+    return (bits[index / 32] >> (index % 32) & 1U) != 0;
+}
+} // namespace
+
+PotentiallyVisibleSet::PotentiallyVisibleSet(const Scene& scene, const float loopDuration, const float segmentDuration)
+    : m_instanceCount(static_cast<std::uint32_t>(scene.instances.size())),
+      m_staticInstanceCount(std::min(scene.firstDynamicInstance, m_instanceCount)),
+      m_sceneHash(hashStaticScene(scene)),
+      m_loopDuration(loopDuration),
+      m_segmentDuration(segmentDuration) {}
+
+auto PotentiallyVisibleSet::load(const std::filesystem::path& path, const Scene& scene, const float loopDuration)
+    -> PotentiallyVisibleSet {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        throw std::runtime_error("Failed to open PVS file: " + path.string());
+    }
+
+    FileHeader header{};
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(FileHeader)) || header.magic != kFileMagic ||
+        header.version != kFileVersion || header.segmentCount == 0) {
+        throw std::runtime_error("Not a PVS file (or an older format): " + path.string());
+    }
+
+    const PotentiallyVisibleSet expected(scene, loopDuration, header.segmentDuration);
+    if (header.instanceCount != expected.m_instanceCount ||
+        header.staticInstanceCount != expected.m_staticInstanceCount || header.sceneHash != expected.m_sceneHash) {
+        throw std::runtime_error("PVS " + path.string() + " was baked for a different scene, rebake it with --bake-pvs");
+    }
+    if (std::abs(header.loopDuration - loopDuration) > 1e-4f) {
+        throw std::runtime_error("PVS " + path.string() + " was baked for a different camera animation, rebake it with --bake-pvs");
+    }
+    // segmentAt() divides by the duration and clamps to the last segment, both must match how the baker cut the loop
+    const auto expectedSegments = header.segmentDuration > 0.0f
+                                      ? std::max(1U, static_cast<std::uint32_t>(std::ceil(loopDuration / header.segmentDuration)))
+                                      : 0U;
+    if (!(header.segmentDuration > 0.0f) || header.segmentCount != expectedSegments) {
+        throw std::runtime_error("Corrupt PVS file (segment duration does not cover the loop): " + path.string());
+    }
+
+    PotentiallyVisibleSet pvs = expected;
+    pvs.m_offsets.resize(header.segmentCount + 1);
+    pvs.m_data.resize(header.dataSize);
+    file.read(reinterpret_cast<char*>(pvs.m_offsets.data()),
+              static_cast<std::streamsize>(pvs.m_offsets.size() * sizeof(std::uint64_t)));
+    file.read(reinterpret_cast<char*>(pvs.m_data.data()), static_cast<std::streamsize>(pvs.m_data.size()));
+    if (!file || pvs.m_offsets.front() != 0 || pvs.m_offsets.back() != header.dataSize ||
+        !std::is_sorted(pvs.m_offsets.begin(), pvs.m_offsets.end())) {
+        throw std::runtime_error("Truncated PVS file: " + path.string());
+    }
+    return pvs;
+}
+
+void PotentiallyVisibleSet::save(const std::filesystem::path& path) const {
+    if (path.has_parent_path()) {
+        std::filesystem::create_directories(path.parent_path());
+    }
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        throw std::runtime_error("Failed to open PVS file for writing: " + path.string());
+    }
+
+    const FileHeader header{
+        .magic = kFileMagic,
+        .version = kFileVersion,
+        .instanceCount = m_instanceCount,
+        .staticInstanceCount = m_staticInstanceCount,
+        .segmentCount = segmentCount(),
+        .reserved = 0,
+        .sceneHash = m_sceneHash,
+        .loopDuration = m_loopDuration,
+        .segmentDuration = m_segmentDuration,
+        .dataSize = m_data.size(),
+    };
+    file.write(reinterpret_cast<const char*>(&header), sizeof(FileHeader));
+    file.write(reinterpret_cast<const char*>(m_offsets.data()),
+               static_cast<std::streamsize>(m_offsets.size() * sizeof(std::uint64_t)));
+    file.write(reinterpret_cast<const char*>(m_data.data()), static_cast<std::streamsize>(m_data.size()));
+    if (!file) {
+        throw std::runtime_error("Failed to write PVS file: " + path.string());
+    }
+}
+
+void PotentiallyVisibleSet::addSegment(const std::span<const std::uint32_t> visibleBits) {
+    // Runs alternate between hidden and visible, starting with a (possibly empty) hidden run
+    bool visible = false;
+    std::uint32_t runStart = 0;
+    for (std::uint32_t instance = 0; instance < m_staticInstanceCount; instance++) {
+        if (bitSet(visibleBits, instance) != visible) {
+            writeVarint(m_data, instance - runStart);
+            runStart = instance;
+            visible = !visible;
+        }
+    }
+    writeVarint(m_data, m_staticInstanceCount - runStart);
+    m_offsets.push_back(m_data.size());
+}
+
+auto PotentiallyVisibleSet::segmentAt(const float time) const -> std::uint32_t {
+    const float wrapped = m_loopDuration > 0.0f ? std::fmod(std::max(time, 0.0f), m_loopDuration) : 0.0f;
+    const auto segment = static_cast<std::uint32_t>(wrapped / m_segmentDuration);
+    return std::min(segment, segmentCount() - 1);
+}
+
+void PotentiallyVisibleSet::decodeSegment(const std::uint32_t segment, std::vector<std::uint32_t>& instances) const {
+    instances.clear();
+
+    const std::uint8_t* cursor = m_data.data() + m_offsets[segment];
+    const std::uint8_t* end = m_data.data() + m_offsets[segment + 1];
+
+    bool visible = false;
+    std::uint32_t instance = 0;
+    while (cursor < end) {
+        const std::uint32_t run = std::min(readVarint(cursor, end), m_staticInstanceCount - instance);
+        if (visible) {
+            for (std::uint32_t i = 0; i < run; i++) {
+                instances.push_back(instance + i);
+            }
+        }
+        instance += run;
+        visible = !visible;
+    }
+}
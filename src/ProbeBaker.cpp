@@ -0,0 +1,322 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <format>
+#include <iostream>
+#include <limits>
+#include <stdexcept>
+#include <glm/gtc/constants.hpp>
+
+#include "ProbeBaker.hpp"
+#include "CpuProfiler.hpp"
+#include "FrustumCulling.hpp"
+#include "JobSystem.hpp"
+#include "constants.hpp"
+
+namespace {
+// PCG hash, one stream per probe keeps the bake deterministic whatever order the jobs run in
+auto pcgHash(const std::uint32_t value) -> std::uint32_t {
+    const std::uint32_t state = value * 747796405U + 2891336453U;
+    const std::uint32_t word = ((state >> ((state >> 28U) + 4U)) ^ state) * 277803737U;
+    return (word >> 22U) ^ word;
+}
+
+struct Random {
+    std::uint32_t state;
+
+    // Uniform in [0, 1)
+    auto next() -> float {
+        state = pcgHash(state);
+        return static_cast<float>(state >> 8U) * (1.0f / 16777216.0f);
+    }
+};
+
+// Direction i of n, spread evenly over the sphere
+auto sphericalFibonacci(const std::uint32_t i, const std::uint32_t n) -> glm::vec3 {
+    constexpr float GOLDEN_ANGLE = 2.39996323f;
+    const float y = 1.0f - (2.0f * static_cast<float>(i) + 1.0f) / static_cast<float>(n);
+    const float radius = std::sqrt(std::max(0.0f, 1.0f - y * y));
+    const float phi = GOLDEN_ANGLE * static_cast<float>(i);
+    return {radius * std::cos(phi), y, radius * std::sin(phi)};
+}
+
+// Cosine-weighted direction around normal; its pdf cancels the cos / pi of a Lambertian bounce
+auto cosineSample(const glm::vec3 normal, Random& random) -> glm::vec3 {
+    const float radius = std::sqrt(random.next());
+    const float phi = glm::two_pi<float>() * random.next();
+    const glm::vec3 helper = std::abs(normal.y) < 0.999f ? glm::vec3(0.0f, 1.0f, 0.0f) : glm::vec3(1.0f, 0.0f, 0.0f);
+    const glm::vec3 tangent = glm::normalize(glm::cross(helper, normal));
+    const glm::vec3 bitangent = glm::cross(normal, tangent);
+    return glm::normalize(tangent * (radius * std::cos(phi)) + bitangent * (radius * std::sin(phi)) +
+                          normal * std::sqrt(std::max(0.0f, 1.0f - radius * radius)));
+}
+} // namespace
+
+ProbeBaker::ProbeBaker(const Scene& scene, JobSystem& jobSystem)
+    : m_scene(scene),
+      m_jobSystem(jobSystem),
+      m_bvh(scene, jobSystem) {
+    m_bvh.updateInstances(scene, scene.firstDynamicInstance);
+
+    for (std::uint32_t i = 0; i < m_srgbToLinear.size(); i++) {
+        const float value = static_cast<float>(i) / 255.0f;
+        m_srgbToLinear[i] = value <= 0.04045f ? value / 12.92f : std::pow((value + 0.055f) / 1.055f, 2.4f);
+    }
+}
+
+auto ProbeBaker::bake() -> ProbeVolume {
+    PROFILE_ZONE("ProbeBaker::bake");
+    const auto start = std::chrono::steady_clock::now();
+
+    glm::vec3 boundsMin(std::numeric_limits<float>::infinity());
+    glm::vec3 boundsMax(-std::numeric_limits<float>::infinity());
+    const std::uint32_t staticCount =
+        std::min(m_scene.firstDynamicInstance, static_cast<std::uint32_t>(m_scene.instances.size()));
+    for (std::uint32_t i = 0; i < staticCount; i++) {
+        const Instance& instance = m_scene.instances[i];
+        if (static_cast<std::int32_t>(i) == m_scene.skySphereInstanceIndex || instance.meshIndex < 0 ||
+            instance.meshIndex >= static_cast<std::int32_t>(m_scene.meshes.size())) {
+            continue;
+        }
+        const Mesh& mesh = m_scene.meshes[instance.meshIndex];
+        const AABB world = AABB{mesh.boundingBoxMin, mesh.boundingBoxMax}.transform(instance.transform);
+        boundsMin = glm::min(boundsMin, world.min);
+        boundsMax = glm::max(boundsMax, world.max);
+    }
+    if (boundsMin.x > boundsMax.x) {
+        throw std::runtime_error("The scene has no static geometry to bake probes for");
+    }
+
+    const glm::vec3 extent = boundsMax - boundsMin;
+    glm::uvec3 dimensions;
+    glm::vec3 spacing;
+    for (glm::length_t axis = 0; axis < 3; axis++) {
+        const auto cells = static_cast<std::uint32_t>(std::ceil(extent[axis] / PROBE_GRID_SPACING));
+        dimensions[axis] = std::clamp(cells + 1, 2U, PROBE_GRID_MAX_RESOLUTION);
+        spacing[axis] = std::max(extent[axis] / static_cast<float>(dimensions[axis] - 1), 1e-3f);
+    }
+
+    ProbeVolume volume(m_scene, dimensions, boundsMin, spacing);
+    const std::size_t probeCount = volume.probeCount();
+    std::cout << std::format("[Probes] Baking {}x{}x{} probes, {} paths each, over {} triangles", dimensions.x,
+                             dimensions.y, dimensions.z, PROBE_BAKE_SAMPLES, m_bvh.triangleCount())
+              << std::endl;
+
+    std::vector<std::uint8_t> valid(probeCount, 0);
+    const std::size_t jobs = (probeCount + PROBE_BAKE_PROBES_PER_JOB - 1) / PROBE_BAKE_PROBES_PER_JOB;
+    m_jobSystem.parallelFor(jobs, [&](const std::size_t job) {
+        const std::size_t end = std::min(probeCount, (job + 1) * PROBE_BAKE_PROBES_PER_JOB);
+        for (std::size_t i = job * PROBE_BAKE_PROBES_PER_JOB; i < end; i++) {
+            const ProbeResult result = bakeProbe(volume.probePosition(volume.probeCell(i)), static_cast<std::uint32_t>(i));
+            volume.probe(i) = result.coefficients;
+            valid[i] = result.valid ? 1 : 0;
+        }
+    });
+
+    // Invalid probes take the average of their valid face neighbours, growing inwards pass by pass until no
+    // invalid probe borders a valid one (what remains is enclosed by geometry and never sampled from outside)
+    const auto invalidCount = static_cast<std::size_t>(std::ranges::count(valid, 0));
+    std::vector<std::size_t> filled;
+    do {
+        filled.clear();
+        for (std::size_t i = 0; i < probeCount; i++) {
+            if (valid[i] != 0) {
+                continue;
+            }
+
+            const glm::uvec3 cell = volume.probeCell(i);
+            ProbeVolume::Coefficients sum{};
+            std::uint32_t neighbours = 0;
+            for (glm::length_t axis = 0; axis < 3; axis++) {
+                for (const bool up : {false, true}) {
+                    if (up ? cell[axis] + 1 >= dimensions[axis] : cell[axis] == 0) {
+                        continue;
+                    }
+                    glm::uvec3 neighbourCell = cell;
+                    neighbourCell[axis] = up ? cell[axis] + 1 : cell[axis] - 1;
+                    const std::size_t neighbour = volume.probeIndex(neighbourCell);
+                    if (valid[neighbour] == 0) {
+                        continue;
+                    }
+                    for (std::uint32_t channel = 0; channel < 3; channel++) {
+                        sum[channel] += volume.probe(neighbour)[channel];
+                    }
+                    neighbours++;
+                }
+            }
+
+            if (neighbours > 0) {
+                for (std::uint32_t channel = 0; channel < 3; channel++) {
+                    volume.probe(i)[channel] = sum[channel] / static_cast<float>(neighbours);
+                }
+                filled.push_back(i);
+            }
+        }
+
+        for (const std::size_t i : filled) {
+            valid[i] = 1;
+        }
+    } while (!filled.empty());
+
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << std::format("[Probes] Baked {} probes ({:.2f} x {:.2f} x {:.2f} units apart) in {:.1f} s, "
+                             "{} inside geometry", probeCount, spacing.x, spacing.y, spacing.z, seconds, invalidCount)
+              << std::endl;
+    return volume;
+}
+
+auto ProbeBaker::bakeProbe(const glm::vec3 position, const std::uint32_t seed) const -> ProbeResult {
+    Random random{pcgHash(seed)};
+    const std::uint32_t skyInstance = m_scene.skySphereInstanceIndex >= 0
+                                          ? static_cast<std::uint32_t>(m_scene.skySphereInstanceIndex)
+                                          : RayHit::NO_INSTANCE;
+
+    glm::vec3 radianceSum(0.0f);
+    std::array<glm::vec3, 3> directionalSum{};  // Radiance times the x, y and z of its direction
+    std::uint32_t backfaces = 0;
+
+    for (std::uint32_t sample = 0; sample < PROBE_BAKE_SAMPLES; sample++) {
+        const glm::vec3 direction = sphericalFibonacci(sample, PROBE_BAKE_SAMPLES);
+        Ray ray{.origin = position, .tMin = 0.0f, .direction = direction};
+        glm::vec3 radiance(0.0f);
+        glm::vec3 throughput(1.0f);
+
+        for (std::uint32_t bounce = 0; bounce <= PROBE_BAKE_BOUNCES; bounce++) {
+            const RayHit hit = m_bvh.castRay(ray);
+            if (!hit.hit() || hit.instance == skyInstance) {
+                radiance += throughput * skyRadiance(ray.direction);
+                break;
+            }
+
+            const SurfaceHit surface = resolveHit(ray, hit);
+            if (surface.backface) {
+                // Nothing arrives from inside a mesh; seen straight from the probe, it counts against the probe
+                backfaces += bounce == 0 ? 1 : 0;
+                break;
+            }
+
+            radiance += throughput * surface.emission;
+            throughput *= surface.albedo;
+            ray = Ray{
+                .origin = surface.position + surface.normal * PROBE_BAKE_RAY_OFFSET,
+                .tMin = 0.0f,
+                .direction = cosineSample(surface.normal, random),
+            };
+        }
+
+        radianceSum += radiance;
+        for (glm::length_t axis = 0; axis < 3; axis++) {
+            directionalSum[axis] += radiance * direction[axis];
+        }
+    }
+
+    // The directions sample the sphere uniformly. Projected onto L1 SH and convolved with the cosine lobe / pi,
+    // that leaves the mean radiance as the constant band and twice the mean of radiance * direction as the
+    // linear bands: E(n) / pi = mean(L) + dot(2 * mean(L * d), n).
+    constexpr float weight = 1.0f / static_cast<float>(PROBE_BAKE_SAMPLES);
+    ProbeResult result{};
+    for (glm::length_t channel = 0; channel < 3; channel++) {
+        result.coefficients[channel] = glm::vec4(radianceSum[channel],
+                                                 2.0f * directionalSum[0][channel],
+                                                 2.0f * directionalSum[1][channel],
+                                                 2.0f * directionalSum[2][channel]) * weight;
+    }
+    result.valid = static_cast<float>(backfaces) <= PROBE_BAKE_MAX_BACKFACE_FRACTION * static_cast<float>(PROBE_BAKE_SAMPLES);
+    return result;
+}
+
+auto ProbeBaker::resolveHit(const Ray& ray, const RayHit& hit) const -> SurfaceHit {
+    const Instance& instance = m_scene.instances[hit.instance];
+    const Mesh& mesh = m_scene.meshes[instance.meshIndex];
+    const std::uint32_t firstIndex = mesh.baseIndex + 3 * hit.triangle;
+    const Vertex& v0 = m_scene.vertices[mesh.baseVertex + m_scene.indices[firstIndex]];
+    const Vertex& v1 = m_scene.vertices[mesh.baseVertex + m_scene.indices[firstIndex + 1]];
+    const Vertex& v2 = m_scene.vertices[mesh.baseVertex + m_scene.indices[firstIndex + 2]];
+    const float w0 = 1.0f - hit.barycentrics.x - hit.barycentrics.y;
+
+    const glm::mat3 normalMatrix = glm::transpose(glm::mat3(instance.inverseTransform));
+    const glm::vec3 faceNormal = normalMatrix * glm::cross(v1.position - v0.position, v2.position - v0.position);
+    const float faceNormalLength = glm::length(faceNormal);
+    const glm::vec3 geometric = faceNormalLength > 0.0f ? faceNormal / faceNormalLength : -ray.direction;
+    const glm::vec3 shading =
+        normalMatrix * (v0.normal * w0 + v1.normal * hit.barycentrics.x + v2.normal * hit.barycentrics.y);
+
+    SurfaceHit surface{
+        .position = ray.origin + ray.direction * hit.t,
+        .normal = glm::dot(geometric, ray.direction) > 0.0f ? -geometric : geometric,
+        .albedo = glm::vec3(1.0f),
+        .emission = glm::vec3(0.0f),
+        .backface = glm::dot(shading, ray.direction) > 0.0f,
+    };
+
+    if (mesh.materialIndex >= 0 && mesh.materialIndex < static_cast<std::int32_t>(m_scene.materials.size())) {
+        const Material& material = m_scene.materials[mesh.materialIndex];
+        const glm::vec2 uv = v0.texCoord * w0 + v1.texCoord * hit.barycentrics.x + v2.texCoord * hit.barycentrics.y;
+
+        glm::vec4 baseColor = material.baseColorFactor;
+        if (material.baseColorTexIndex >= 0 &&
+            material.baseColorTexIndex < static_cast<std::int32_t>(m_scene.baseColorTextures.size())) {
+            baseColor *= sampleTexture(m_scene.baseColorTextures[material.baseColorTexIndex], uv);
+        }
+        surface.albedo = glm::vec3(baseColor);
+
+        surface.emission = material.emissiveFactor;
+        if (material.emissiveTexIndex >= 0 &&
+            material.emissiveTexIndex < static_cast<std::int32_t>(m_scene.emissiveTextures.size())) {
+            surface.emission *= glm::vec3(sampleTexture(m_scene.emissiveTextures[material.emissiveTexIndex], uv));
+        }
+    }
+
+    return surface;
+}
+
+auto ProbeBaker::skyRadiance(const glm::vec3 direction) const -> glm::vec3 {
+    if (m_scene.skySphereTextureIndex < 0 ||
+        m_scene.skySphereTextureIndex >= static_cast<std::int32_t>(m_scene.emissiveTextures.size())) {
+        return glm::vec3(0.0f);
+    }
+
+    // Same mapping as sampleEquirectangularTexture() in pbr.slang
+    const glm::vec2 uv(std::atan2(direction.z, direction.x) / glm::two_pi<float>() + 0.5f,
+                       -std::asin(std::clamp(direction.y, -1.0f, 1.0f)) / glm::pi<float>() + 0.5f);
+    return glm::vec3(sampleTexture(m_scene.emissiveTextures[m_scene.skySphereTextureIndex], uv));
+}
+
+auto ProbeBaker::sampleTexture(const Texture& texture, const glm::vec2 uv) const -> glm::vec4 {
+    const std::size_t texelCount = static_cast<std::size_t>(texture.width) * texture.height;
+    if (texelCount == 0 || texture.image.size() < texelCount) {
+        return glm::vec4(1.0f);
+    }
+
+    const std::uint32_t x = std::min(static_cast<std::uint32_t>((uv.x - std::floor(uv.x)) * static_cast<float>(texture.width)),
+                                     texture.width - 1);
+    const std::uint32_t y = std::min(static_cast<std::uint32_t>((uv.y - std::floor(uv.y)) * static_cast<float>(texture.height)),
+                                     texture.height - 1);
+    const std::size_t bytesPerTexel = texture.image.size() / texelCount;
+    const unsigned char* texel = texture.image.data() + (static_cast<std::size_t>(y) * texture.width + x) * bytesPerTexel;
+
+    const bool srgb = texture.format == vk::Format::eR8G8B8A8Srgb || texture.format == vk::Format::eR8G8B8Srgb;
+    const auto color = [&](const std::size_t channel) {
+        return srgb ? m_srgbToLinear[texel[channel]] : static_cast<float>(texel[channel]) / 255.0f;
+    };
+
+    switch (bytesPerTexel) {
+        case 1: {
+            const float value = static_cast<float>(texel[0]) / 255.0f;
+            return {value, value, value, 1.0f};
+        }
+        case 3:
+            return {color(0), color(1), color(2), 1.0f};
+        case 4:
+            return {color(0), color(1), color(2), static_cast<float>(texel[3]) / 255.0f};
+        case 8: {
+            // R16G16B16A16Unorm (HDR sources)
+            std::array<std::uint16_t, 4> rgba{};
+            std::memcpy(rgba.data(), texel, sizeof(rgba));
+            return glm::vec4(rgba[0], rgba[1], rgba[2], rgba[3]) / 65535.0f;
+        }
+        default:
+            return glm::vec4(1.0f);
+    }
+}
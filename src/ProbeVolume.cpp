@@ -0,0 +1,111 @@
+#include <fstream>
+#include <stdexcept>
+#include <glm/gtc/packing.hpp>
+
+#include "ProbeVolume.hpp"
+#include "SceneHash.hpp"
+
+namespace {
+constexpr std::uint32_t kFileMagic = 0x31425250;  // "PRB1"
+constexpr std::uint32_t kFileVersion = 1;
+
+struct FileHeader {
+    std::uint32_t magic;
+    std::uint32_t version;
+    std::uint32_t dimensions[3];
+    std::uint32_t reserved;
+    std::uint64_t sceneHash;
+    float origin[3];
+    float spacing[3];
+};
+} // namespace
+
+ProbeVolume::ProbeVolume(const Scene& scene, const glm::uvec3 dimensions, const glm::vec3 origin, const glm::vec3 spacing)
+    : m_dimensions(dimensions),
+      m_origin(origin),
+      m_spacing(spacing),
+      m_sceneHash(hashStaticScene(scene)),
+      m_probes(static_cast<std::size_t>(dimensions.x) * dimensions.y * dimensions.z, Coefficients{}) {}
+
+auto ProbeVolume::load(const std::filesystem::path& path, const Scene& scene) -> ProbeVolume {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        throw std::runtime_error("Failed to open probe file: " + path.string());
+    }
+
+    FileHeader header{};
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(FileHeader)) || header.magic != kFileMagic ||
+        header.version != kFileVersion || header.dimensions[0] == 0 || header.dimensions[1] == 0 ||
+        header.dimensions[2] == 0) {
+        throw std::runtime_error("Not a probe file (or an older format): " + path.string());
+    }
+    if (header.sceneHash != hashStaticScene(scene)) {
+        throw std::runtime_error("Probes " + path.string() + " were baked for a different scene, rebake them with --bake-probes");
+    }
+
+    ProbeVolume volume(scene,
+                       glm::uvec3(header.dimensions[0], header.dimensions[1], header.dimensions[2]),
+                       glm::vec3(header.origin[0], header.origin[1], header.origin[2]),
+                       glm::vec3(header.spacing[0], header.spacing[1], header.spacing[2]));
+    file.read(reinterpret_cast<char*>(volume.m_probes.data()),
+              static_cast<std::streamsize>(volume.m_probes.size() * sizeof(Coefficients)));
+    if (!file) {
+        throw std::runtime_error("Truncated probe file: " + path.string());
+    }
+    return volume;
+}
+
+void ProbeVolume::save(const std::filesystem::path& path) const {
+    if (path.has_parent_path()) {
+        std::filesystem::create_directories(path.parent_path());
+    }
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        throw std::runtime_error("Failed to open probe file for writing: " + path.string());
+    }
+
+    const FileHeader header{
+        .magic = kFileMagic,
+        .version = kFileVersion,
+        .dimensions = {m_dimensions.x, m_dimensions.y, m_dimensions.z},
+        .reserved = 0,
+        .sceneHash = m_sceneHash,
+        .origin = {m_origin.x, m_origin.y, m_origin.z},
+        .spacing = {m_spacing.x, m_spacing.y, m_spacing.z},
+    };
+    file.write(reinterpret_cast<const char*>(&header), sizeof(FileHeader));
+    file.write(reinterpret_cast<const char*>(m_probes.data()),
+               static_cast<std::streamsize>(m_probes.size() * sizeof(Coefficients)));
+    if (!file) {
+        throw std::runtime_error("Failed to write probe file: " + path.string());
+    }
+}
+
+auto ProbeVolume::probeCell(const std::size_t index) const -> glm::uvec3 {
+    const std::size_t slice = static_cast<std::size_t>(m_dimensions.x) * m_dimensions.y;
+    return {
+        static_cast<std::uint32_t>(index % m_dimensions.x),
+        static_cast<std::uint32_t>(index % slice / m_dimensions.x),
+        static_cast<std::uint32_t>(index / slice),
+    };
+}
+
+auto ProbeVolume::textureScale() const -> glm::vec3 {
+    return 1.0f / (m_spacing * glm::vec3(m_dimensions));
+}
+
+auto ProbeVolume::textureBias() const -> glm::vec3 {
+    // Probe i is at origin + i * spacing and at texel center (i + 0.5) / dimensions
+    return 0.5f / glm::vec3(m_dimensions) - m_origin * textureScale();
+}
+
+void ProbeVolume::packChannel(const std::uint32_t channel, std::vector<std::uint16_t>& texels) const {
+    texels.resize(m_probes.size() * 4);
+    for (std::size_t i = 0; i < m_probes.size(); i++) {
+        const glm::vec4& coefficients = m_probes[i][channel];
+        for (glm::length_t component = 0; component < 4; component++) {
+            texels[i * 4 + component] = glm::packHalf1x16(coefficients[component]);
+        }
+    }
+}
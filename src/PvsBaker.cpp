@@ -0,0 +1,285 @@
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "PvsBaker.hpp"
+#include "Animator.hpp"
+#include "BufferManager.hpp"
+#include "CommandManager.hpp"
+#include "LinearArena.hpp"
+#include "ResourceManager.hpp"
+#include "SharedTypes.hpp"
+#include "VulkanCore.hpp"
+#include "constants.hpp"
+
+namespace {
+// Must match pvs_visibility.comp.slang
+constexpr std::uint32_t PVS_INSTANCE_BAKED = 1;
+constexpr std::uint32_t PVS_INSTANCE_OCCLUDER = 2;
+
+constexpr std::uint32_t TLAS_BINDING = 0;
+constexpr std::uint32_t INSTANCE_FLAGS_BINDING = 1;
+constexpr std::uint32_t VISIBLE_BITS_BINDING = 2;
+
+constexpr std::uint32_t WORKGROUP_SIZE = 8;
+} // namespace
+
+PvsBaker::PvsBaker(VulkanCore& vulkanCore,
+                   CommandManager& commandManager,
+                   BufferManager& bufferManager,
+                   ResourceManager& resourceManager)
+    : m_vulkanCore(vulkanCore),
+      m_commandManager(commandManager),
+      m_bufferManager(bufferManager),
+      m_resourceManager(resourceManager) {
+    m_visibilityShader = std::make_unique<Shader>(m_vulkanCore.device(), vk::ShaderStageFlagBits::eCompute,
+                                                  "shaders/bake/pvs_visibility.comp.spv");
+    createPipeline();
+}
+
+void PvsBaker::createPipeline() {
+    const std::array bindings = {
+        vk::DescriptorSetLayoutBinding{
+            .binding = TLAS_BINDING,
+            .descriptorType = vk::DescriptorType::eAccelerationStructureKHR,
+            .descriptorCount = 1,
+            .stageFlags = vk::ShaderStageFlagBits::eCompute,
+        },
+        vk::DescriptorSetLayoutBinding{
+            .binding = INSTANCE_FLAGS_BINDING,
+            .descriptorType = vk::DescriptorType::eStorageBuffer,
+            .descriptorCount = 1,
+            .stageFlags = vk::ShaderStageFlagBits::eCompute,
+        },
+        vk::DescriptorSetLayoutBinding{
+            .binding = VISIBLE_BITS_BINDING,
+            .descriptorType = vk::DescriptorType::eStorageBuffer,
+            .descriptorCount = 1,
+            .stageFlags = vk::ShaderStageFlagBits::eCompute,
+        },
+    };
+
+    const vk::DescriptorSetLayoutCreateInfo layoutCreateInfo{
+        .flags = vk::DescriptorSetLayoutCreateFlagBits::ePushDescriptorKHR,
+        .bindingCount = static_cast<std::uint32_t>(bindings.size()),
+        .pBindings = bindings.data(),
+    };
+    m_descriptorSetLayout = vk::raii::DescriptorSetLayout(m_vulkanCore.device(), layoutCreateInfo);
+
+    constexpr vk::PushConstantRange pushConstantRange{
+        .stageFlags = vk::ShaderStageFlagBits::eCompute,
+        .offset = 0,
+        .size = sizeof(PvsBakePushConstant),
+    };
+
+    const vk::PipelineLayoutCreateInfo pipelineLayoutInfo{
+        .setLayoutCount = 1,
+        .pSetLayouts = &*m_descriptorSetLayout,
+        .pushConstantRangeCount = 1,
+        .pPushConstantRanges = &pushConstantRange,
+    };
+    m_pipelineLayout = vk::raii::PipelineLayout(m_vulkanCore.device(), pipelineLayoutInfo);
+
+    // A one-off run, not worth a pipeline cache entry
+    const vk::ComputePipelineCreateInfo pipelineInfo{
+        .stage = m_visibilityShader->getStage(),
+        .layout = *m_pipelineLayout,
+    };
+    m_pipeline = vk::raii::Pipeline(m_vulkanCore.device(), nullptr, pipelineInfo);
+}
+
+auto PvsBaker::bake(const tinygltf::Model& model, Scene& scene, Animator& animator, LinearArena& arena)
+    -> PotentiallyVisibleSet {
+    const auto bakeStart = std::chrono::steady_clock::now();
+
+    const float loopDuration = Animator::loopDuration(model);
+    const auto segmentCount = std::max(1U, static_cast<std::uint32_t>(std::ceil(loopDuration / PVS_SEGMENT_SECONDS)));
+    PotentiallyVisibleSet pvs(scene, loopDuration, PVS_SEGMENT_SECONDS);
+
+    const auto instanceCount = static_cast<std::uint32_t>(scene.instances.size());
+    const std::uint32_t staticCount = pvs.staticInstanceCount();
+    const std::uint32_t wordsPerSegment = std::max(1U, (instanceCount + 31) / 32);
+
+    // Static instances the rays cannot judge go into every set: those without a TLAS mask and the sky sphere
+    const auto& tlasInstances = m_resourceManager.getTlasInstances();
+    std::vector<std::uint32_t> instanceFlags(std::max(1U, instanceCount), 0);
+    std::vector<std::uint32_t> alwaysVisible(wordsPerSegment, 0);
+    for (std::uint32_t i = 0; i < staticCount; i++) {
+        const std::int32_t meshIndex = scene.instances[i].meshIndex;
+        if (meshIndex < 0 || meshIndex >= static_cast<std::int32_t>(scene.meshes.size())) {
+            continue;
+        }
+        if (tlasInstances[i].mask == 0 || static_cast<std::int32_t>(i) == scene.skySphereInstanceIndex) {
+            alwaysVisible[i / 32] |= 1U << (i % 32);
+            continue;
+        }
+
+        instanceFlags[i] = PVS_INSTANCE_BAKED;
+        const std::int32_t materialIndex = scene.meshes[meshIndex].materialIndex;
+        if (materialIndex >= 0 && materialIndex < static_cast<std::int32_t>(scene.materials.size()) &&
+            scene.materials[materialIndex].alphaMode == 0) {
+            instanceFlags[i] |= PVS_INSTANCE_OCCLUDER;
+        }
+    }
+
+    const vk::DeviceSize flagsSize = instanceFlags.size() * sizeof(std::uint32_t);
+    const std::uint32_t batchSegments = std::min(PVS_BAKE_SEGMENTS_PER_SUBMIT, segmentCount);
+    const vk::DeviceSize bitsSize = static_cast<vk::DeviceSize>(batchSegments) * wordsPerSegment * sizeof(std::uint32_t);
+
+    vk::raii::Buffer flagsBuffer = nullptr;
+    vk::raii::DeviceMemory flagsMemory = nullptr;
+    m_bufferManager.createBuffer(MemoryCategory::PvsBake, flagsSize,
+                                 vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eTransferDst,
+                                 vk::MemoryPropertyFlagBits::eDeviceLocal, flagsBuffer, flagsMemory,
+                                 instanceFlags.data());
+
+    vk::raii::Buffer bitsBuffer = nullptr;
+    vk::raii::DeviceMemory bitsMemory = nullptr;
+    m_bufferManager.createBuffer(MemoryCategory::PvsBake, bitsSize,
+                                 vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eTransferSrc |
+                                     vk::BufferUsageFlagBits::eTransferDst,
+                                 vk::MemoryPropertyFlagBits::eDeviceLocal, bitsBuffer, bitsMemory);
+
+    vk::raii::Buffer readbackBuffer = nullptr;
+    vk::raii::DeviceMemory readbackMemory = nullptr;
+    m_bufferManager.createBuffer(MemoryCategory::PvsBake, bitsSize, vk::BufferUsageFlagBits::eTransferDst,
+                                 vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent,
+                                 readbackBuffer, readbackMemory);
+    const auto* readback = static_cast<const std::uint32_t*>(readbackMemory.mapMemory(0, bitsSize));
+
+    const vk::WriteDescriptorSetAccelerationStructureKHR tlasInfo{
+        .accelerationStructureCount = 1,
+        .pAccelerationStructures = &*m_resourceManager.getTlas(0),
+    };
+    const vk::DescriptorBufferInfo flagsInfo{.buffer = *flagsBuffer, .offset = 0, .range = flagsSize};
+    const vk::DescriptorBufferInfo bitsInfo{.buffer = *bitsBuffer, .offset = 0, .range = bitsSize};
+    const std::array writes = {
+        vk::WriteDescriptorSet{
+            .pNext = &tlasInfo,
+            .dstBinding = TLAS_BINDING,
+            .descriptorCount = 1,
+            .descriptorType = vk::DescriptorType::eAccelerationStructureKHR,
+        },
+        vk::WriteDescriptorSet{
+            .dstBinding = INSTANCE_FLAGS_BINDING,
+            .descriptorCount = 1,
+            .descriptorType = vk::DescriptorType::eStorageBuffer,
+            .pBufferInfo = &flagsInfo,
+        },
+        vk::WriteDescriptorSet{
+            .dstBinding = VISIBLE_BITS_BINDING,
+            .descriptorCount = 1,
+            .descriptorType = vk::DescriptorType::eStorageBuffer,
+            .pBufferInfo = &bitsInfo,
+        },
+    };
+
+    std::vector<PvsBakePushConstant> samples;
+    samples.reserve(static_cast<std::size_t>(batchSegments) * PVS_SAMPLES_PER_SEGMENT);
+    std::uint64_t visibleTotal = 0;
+
+    for (std::uint32_t firstSegment = 0; firstSegment < segmentCount; firstSegment += batchSegments) {
+        const std::uint32_t segments = std::min(batchSegments, segmentCount - firstSegment);
+
+        // Animate on the CPU first, the submission only records dispatches
+        samples.clear();
+        for (std::uint32_t slot = 0; slot < segments; slot++) {
+            const float segmentStart = static_cast<float>(firstSegment + slot) * PVS_SEGMENT_SECONDS;
+            for (std::uint32_t sample = 0; sample < PVS_SAMPLES_PER_SEGMENT; sample++) {
+                const float t = static_cast<float>(sample) / static_cast<float>(std::max(1U, PVS_SAMPLES_PER_SEGMENT - 1));
+                // Stay inside the loop, animate() would wrap the last segment's end back to the start
+                const float time = std::min(segmentStart + t * PVS_SEGMENT_SECONDS, std::max(0.0f, loopDuration - 1e-4f));
+
+                arena.reset();
+                animator.animate(model, scene, time, arena);
+
+                CameraParameters camera = scene.camera;
+                camera.yfov = std::min(camera.yfov * PVS_BAKE_FOV_SCALE, glm::radians(170.0f));
+                const float tanY = std::tan(camera.yfov * 0.5f);
+                const float tanX = tanY * camera.aspectRatio;
+
+                samples.push_back(PvsBakePushConstant{
+                    .inverseViewProjection = glm::inverse(camera.getViewProjection()),
+                    .origin = camera.getPosition(),
+                    .maxDistance = camera.zfar * std::sqrt(1.0f + tanX * tanX + tanY * tanY),
+                    .width = PVS_BAKE_WIDTH,
+                    .height = std::max(1U, static_cast<std::uint32_t>(std::round(PVS_BAKE_WIDTH / camera.aspectRatio))),
+                    .firstWord = slot * wordsPerSegment,
+                    ._padding = 0,
+                });
+            }
+        }
+
+        m_commandManager.immediateSubmit([&](const vk::CommandBuffer cmd) {
+            cmd.fillBuffer(*bitsBuffer, 0, bitsSize, 0);
+
+            const vk::MemoryBarrier2 clearBarrier{
+                .srcStageMask = vk::PipelineStageFlagBits2::eClear,
+                .srcAccessMask = vk::AccessFlagBits2::eTransferWrite,
+                .dstStageMask = vk::PipelineStageFlagBits2::eComputeShader,
+                .dstAccessMask = vk::AccessFlagBits2::eShaderStorageRead | vk::AccessFlagBits2::eShaderStorageWrite,
+            };
+            cmd.pipelineBarrier2(vk::DependencyInfo{.memoryBarrierCount = 1, .pMemoryBarriers = &clearBarrier});
+
+            cmd.bindPipeline(vk::PipelineBindPoint::eCompute, *m_pipeline);
+            cmd.pushDescriptorSetKHR(vk::PipelineBindPoint::eCompute, *m_pipelineLayout, 0, writes);
+
+            // Samples only OR bits into their segment's words, so the dispatches need no barriers in between
+            for (const auto& sample : samples) {
+                cmd.pushConstants<PvsBakePushConstant>(*m_pipelineLayout, vk::ShaderStageFlagBits::eCompute, 0, sample);
+                cmd.dispatch((sample.width + WORKGROUP_SIZE - 1) / WORKGROUP_SIZE,
+                             (sample.height + WORKGROUP_SIZE - 1) / WORKGROUP_SIZE, 1);
+            }
+
+            const vk::MemoryBarrier2 copyBarrier{
+                .srcStageMask = vk::PipelineStageFlagBits2::eComputeShader,
+                .srcAccessMask = vk::AccessFlagBits2::eShaderStorageWrite,
+                .dstStageMask = vk::PipelineStageFlagBits2::eCopy,
+                .dstAccessMask = vk::AccessFlagBits2::eTransferRead,
+            };
+            cmd.pipelineBarrier2(vk::DependencyInfo{.memoryBarrierCount = 1, .pMemoryBarriers = &copyBarrier});
+
+            cmd.copyBuffer(*bitsBuffer, *readbackBuffer, vk::BufferCopy{.srcOffset = 0, .dstOffset = 0, .size = bitsSize});
+
+            const vk::MemoryBarrier2 readbackBarrier{
+                .srcStageMask = vk::PipelineStageFlagBits2::eCopy,
+                .srcAccessMask = vk::AccessFlagBits2::eTransferWrite,
+                .dstStageMask = vk::PipelineStageFlagBits2::eHost,
+                .dstAccessMask = vk::AccessFlagBits2::eHostRead,
+            };
+            cmd.pipelineBarrier2(vk::DependencyInfo{.memoryBarrierCount = 1, .pMemoryBarriers = &readbackBarrier});
+        });
+
+        std::vector<std::uint32_t> segmentBits(wordsPerSegment);
+        for (std::uint32_t slot = 0; slot < segments; slot++) {
+            const std::uint32_t* bits = readback + static_cast<std::size_t>(slot) * wordsPerSegment;
+            for (std::uint32_t word = 0; word < wordsPerSegment; word++) {
+                segmentBits[word] = bits[word] | alwaysVisible[word];
+                visibleTotal += std::popcount(segmentBits[word]);
+            }
+            pvs.addSegment(segmentBits);
+        }
+
+        std::cout << "[PVS] Baked " << std::min(firstSegment + segments, segmentCount) << "/" << segmentCount
+                  << " segments" << std::endl;
+    }
+
+    readbackMemory.unmapMemory();
+    auto& memoryTracker = m_vulkanCore.memoryTracker();
+    memoryTracker.release(readbackMemory);
+    memoryTracker.release(bitsMemory);
+    memoryTracker.release(flagsMemory);
+
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - bakeStart).count();
+    const std::size_t rawBytes = static_cast<std::size_t>(segmentCount) * ((staticCount + 7) / 8);
+    std::cout << "[PVS] " << segmentCount << " segments of " << PVS_SEGMENT_SECONDS << "s in " << seconds << "s, "
+              << static_cast<double>(visibleTotal) / segmentCount << " of " << staticCount
+              << " static instances visible on average, " << pvs.encodedBytes() << " bytes encoded ("
+              << rawBytes << " as plain bitsets)" << std::endl;
+    return pvs;
+}
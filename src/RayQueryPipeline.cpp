@@ -1,8 +1,11 @@
 #include <chrono>
+#include <cstddef>
+#include <cstring>
 #include <vector>
 #include <array>
 #include <iostream>
 #include <cmath>
+#include <functional>
 #include <vulkan/vulkan.hpp>
 #include <vulkan/vulkan_raii.hpp>
 #include <vulkan/vulkan_structs.hpp>
@@ -20,6 +23,10 @@
 #include "CommandManager.hpp"
 #include "ResourceManager.hpp"
 #include "PostProcessingStack.hpp"
+#include "GpuProfiler.hpp"
+#include "CpuProfiler.hpp"
+#include "PipelineCache.hpp"
+#include "FrameExporter.hpp"
 #include "Scene.hpp"
 
 // TAA: Halton sequence for sub-pixel jitter (low-discrepancy sequence)
@@ -57,16 +64,26 @@ RayQueryPipeline::RayQueryPipeline(VulkanCore& vulkanCore,
                                    SwapChain& swapChain,
                                    ImageManager& imageManager,
                                    BufferManager& bufferManager,
-                                   PostProcessingStack& postProcessingPipeline)
+                                   PostProcessingStack& postProcessingPipeline,
+                                   GpuProfiler& gpuProfiler,
+                                   PipelineCache& pipelineCache,
+                                   const DebugView debugView)
     : m_vulkanCore(vulkanCore),
       m_resourceManager(resourceManager),
       m_commandManager(commandManager),
       m_swapChain{swapChain},
       m_imageManager{imageManager},
       m_bufferManager{bufferManager},
-      m_postProcessingPipeline{postProcessingPipeline} {
+      m_postProcessingPipeline{postProcessingPipeline},
+      m_gpuProfiler{gpuProfiler},
+      m_pipelineCache{pipelineCache},
+      m_debugView{debugView},
+      m_debugCounters{debugView == DebugView::None       ? DEBUG_COUNTERS_NONE
+                      : debugView == DebugView::Overdraw ? DEBUG_COUNTERS_FRAGMENTS
+                                                         : DEBUG_COUNTERS_RAYS} {
     createShaderModules();
     pickMsaaSamples();
+    createDebugCounterResources();  // Set 3 of the pipeline layout
     createGraphicsPipeline();
     createColorResources();
     createResolveResources();
@@ -92,26 +109,12 @@ void RayQueryPipeline::pickMsaaSamples() {
 
 
 void RayQueryPipeline::createGraphicsPipeline() {
-    std::vector<vk::PipelineShaderStageCreateInfo> shaderStages;
-    for (const auto& shader : m_shaders) {
-        shaderStages.push_back(shader.getStage());
-    }
-
-    std::vector dynamicStates = {
-        vk::DynamicState::eViewport,
-        vk::DynamicState::eScissor,
-    };
-
-    vk::PipelineDynamicStateCreateInfo const dynamicState{
-        .dynamicStateCount = static_cast<std::uint32_t>(dynamicStates.size()),
-        .pDynamicStates = dynamicStates.data(),
-    };
-
     auto [globalLayout, materialLayout, lightingLayout] = m_resourceManager.getDescriptorSetLayouts();
     std::vector<vk::DescriptorSetLayout> descriptorSetLayouts = {
         globalLayout,
         materialLayout,
         lightingLayout,
+        *m_debugCounterDescriptorSetLayout,
     };
 
     const vk::PipelineLayoutCreateInfo pipelineLayoutInfo{
@@ -123,6 +126,96 @@ void RayQueryPipeline::createGraphicsPipeline() {
 
     m_pipelineLayout = vk::raii::PipelineLayout(m_vulkanCore.device(), pipelineLayoutInfo);
 
+    // Generic variants that branch on the material at runtime. They only depend on the device, so they
+    // compile while the scene is still loading and cover every material without a pipeline of its own.
+    m_pipelineCache.buildInParallel({
+        [this] {
+            m_opaquePipeline = createScenePipeline({.permutation = MATERIAL_PERMUTATION_DYNAMIC, .transparent = false});
+        },
+        [this] {
+            m_transparentPipeline = createScenePipeline({.permutation = MATERIAL_PERMUTATION_DYNAMIC, .transparent = true});
+        },
+    });
+}
+
+void RayQueryPipeline::createMaterialPipelines(const std::vector<MaterialPipelineKey>& keys) {
+    PROFILE_ZONE("RayQueryPipeline::createMaterialPipelines");
+
+    // Pre-sized so the builders can fill their slots concurrently
+    m_materialPipelines.clear();
+    for (std::size_t i = 0; i < keys.size(); i++) {
+        m_materialPipelines.emplace_back(nullptr);
+    }
+
+    std::vector<std::function<void()>> builders;
+    for (std::size_t i = 0; i < keys.size(); i++) {
+        // The generic pipelines already exist
+        if (keys[i].permutation == MATERIAL_PERMUTATION_DYNAMIC) {
+            continue;
+        }
+        builders.emplace_back([this, &keys, i] { m_materialPipelines[i] = createScenePipeline(keys[i]); });
+    }
+    m_pipelineCache.buildInParallel(builders);
+
+    m_materialPipelineHandles.clear();
+    for (std::size_t i = 0; i < keys.size(); i++) {
+        if (keys[i].permutation != MATERIAL_PERMUTATION_DYNAMIC) {
+            m_materialPipelineHandles.push_back(*m_materialPipelines[i]);
+        } else {
+            m_materialPipelineHandles.push_back(keys[i].transparent ? *m_transparentPipeline : *m_opaquePipeline);
+        }
+    }
+}
+
+auto RayQueryPipeline::createScenePipeline(const MaterialPipelineKey& key) const -> vk::raii::Pipeline {
+    // Material feature bits are specialization constant 0 of the fragment shader, the debug counters constant 1
+    struct FragmentSpecialization {
+        std::uint32_t permutation;
+        std::uint32_t debugCounters;
+    };
+    const FragmentSpecialization specialization{
+        .permutation = key.permutation,
+        .debugCounters = m_debugCounters,
+    };
+
+    constexpr std::array specializationEntries = {
+        vk::SpecializationMapEntry{
+            .constantID = 0,
+            .offset = offsetof(FragmentSpecialization, permutation),
+            .size = sizeof(std::uint32_t),
+        },
+        vk::SpecializationMapEntry{
+            .constantID = 1,
+            .offset = offsetof(FragmentSpecialization, debugCounters),
+            .size = sizeof(std::uint32_t),
+        },
+    };
+
+    const vk::SpecializationInfo specializationInfo{
+        .mapEntryCount = static_cast<std::uint32_t>(specializationEntries.size()),
+        .pMapEntries = specializationEntries.data(),
+        .dataSize = sizeof(FragmentSpecialization),
+        .pData = &specialization,
+    };
+
+    std::vector<vk::PipelineShaderStageCreateInfo> shaderStages;
+    for (const auto& shader : m_shaders) {
+        shaderStages.push_back(shader.getStage());
+        if (shaderStages.back().stage == vk::ShaderStageFlagBits::eFragment) {
+            shaderStages.back().pSpecializationInfo = &specializationInfo;
+        }
+    }
+
+    std::vector dynamicStates = {
+        vk::DynamicState::eViewport,
+        vk::DynamicState::eScissor,
+    };
+
+    vk::PipelineDynamicStateCreateInfo const dynamicState{
+        .dynamicStateCount = static_cast<std::uint32_t>(dynamicStates.size()),
+        .pDynamicStates = dynamicStates.data(),
+    };
+
     auto bindingDescription = Vertex::getBindingDescription();
     auto attributeDescriptions = Vertex::getAttributeDescriptions();
 
@@ -247,27 +340,8 @@ void RayQueryPipeline::createGraphicsPipeline() {
         .stencilTestEnable = vk::False
     };
 
-    // Create opaque pipeline
-    vk::GraphicsPipelineCreateInfo opaquePipelineInfo{
-        .pNext = &pipelineRenderingCreateInfo,
-        .stageCount = static_cast<uint32_t>(shaderStages.size()),
-        .pStages = shaderStages.data(),
-        .pVertexInputState = &vertexInputInfo,
-        .pInputAssemblyState = &inputAssembly,
-        .pViewportState = &viewportState,
-        .pRasterizationState = &rasterizer,
-        .pMultisampleState = &multisampling,
-        .pDepthStencilState = &opaqueDepthStencil,
-        .pColorBlendState = &opaqueBlending,
-        .pDynamicState = &dynamicState,
-        .layout = m_pipelineLayout,
-        .renderPass = nullptr, // enable dynamic rendering
-    };
-
-    m_opaquePipeline = vk::raii::Pipeline(m_vulkanCore.device(), nullptr, opaquePipelineInfo);
-
-    // Create transparent pipeline
-    vk::GraphicsPipelineCreateInfo transparentPipelineInfo{
+    // Opaque and transparent variants share all state except blending/depth writes
+    vk::GraphicsPipelineCreateInfo pipelineInfo{
         .pNext = &pipelineRenderingCreateInfo,
         .stageCount = static_cast<uint32_t>(shaderStages.size()),
         .pStages = shaderStages.data(),
@@ -276,18 +350,19 @@ void RayQueryPipeline::createGraphicsPipeline() {
         .pViewportState = &viewportState,
         .pRasterizationState = &rasterizer,
         .pMultisampleState = &multisampling,
-        .pDepthStencilState = &transparentDepthStencil,
-        .pColorBlendState = &transparentBlending,
+        .pDepthStencilState = key.transparent ? &transparentDepthStencil : &opaqueDepthStencil,
+        .pColorBlendState = key.transparent ? &transparentBlending : &opaqueBlending,
         .pDynamicState = &dynamicState,
         .layout = m_pipelineLayout,
         .renderPass = nullptr, // enable dynamic rendering
     };
 
-    m_transparentPipeline = vk::raii::Pipeline(m_vulkanCore.device(), nullptr, transparentPipelineInfo);
+    return m_pipelineCache.createGraphicsPipeline(pipelineInfo);
 }
 
 void RayQueryPipeline::createColorResources() {
     m_imageManager.createImage(
+        MemoryCategory::RenderTargets,
         m_swapChain.getExtent().width,
         m_swapChain.getExtent().height,
         1,
@@ -317,6 +392,7 @@ void RayQueryPipeline::createResolveResources() {
         vk::raii::DeviceMemory resolveImageMemory{nullptr};
     
         m_imageManager.createImage(
+            MemoryCategory::RenderTargets,
             extent.width,
             extent.height,
             1,
@@ -346,6 +422,7 @@ void RayQueryPipeline::createDepthResources() {
     const vk::Format depthFormat = m_vulkanCore.findDepthFormat();
 
     m_imageManager.createImage(
+        MemoryCategory::RenderTargets,
         m_swapChain.getExtent().width,
         m_swapChain.getExtent().height,
         1,
@@ -380,6 +457,7 @@ void RayQueryPipeline::createVelocityResources() {
         vk::raii::DeviceMemory velocityImageMemory{nullptr};
         
         m_imageManager.createImage(
+            MemoryCategory::RenderTargets,
             extent.width,
             extent.height,
             1,
@@ -407,6 +485,7 @@ void RayQueryPipeline::createVelocityResources() {
     // If MSAA is enabled, we need an MSAA velocity image for rendering
     if (m_msaaSamples != vk::SampleCountFlagBits::e1) {
         m_imageManager.createImage(
+            MemoryCategory::RenderTargets,
             extent.width,
             extent.height,
             1,
@@ -429,6 +508,124 @@ void RayQueryPipeline::createVelocityResources() {
     
 }
 
+void RayQueryPipeline::createDebugCounterResources() {
+    constexpr std::array bindings = {
+        vk::DescriptorSetLayoutBinding{
+            .binding = 0,
+            .descriptorType = vk::DescriptorType::eStorageImage,
+            .descriptorCount = 1,
+            .stageFlags = vk::ShaderStageFlagBits::eFragment,
+        },
+        vk::DescriptorSetLayoutBinding{
+            .binding = 1,
+            .descriptorType = vk::DescriptorType::eStorageImage,
+            .descriptorCount = 1,
+            .stageFlags = vk::ShaderStageFlagBits::eFragment,
+        },
+        vk::DescriptorSetLayoutBinding{
+            .binding = 2,
+            .descriptorType = vk::DescriptorType::eStorageBuffer,
+            .descriptorCount = 1,
+            .stageFlags = vk::ShaderStageFlagBits::eFragment,
+        },
+    };
+
+    const vk::DescriptorSetLayoutCreateInfo layoutInfo{
+        .flags = vk::DescriptorSetLayoutCreateFlagBits::ePushDescriptorKHR,
+        .bindingCount = static_cast<std::uint32_t>(bindings.size()),
+        .pBindings = bindings.data(),
+    };
+
+    m_debugCounterDescriptorSetLayout = vk::raii::DescriptorSetLayout(m_vulkanCore.device(), layoutInfo);
+
+    const auto createCounterImages = [this](const bool used,
+                                            std::vector<vk::raii::Image>& images,
+                                            std::vector<vk::raii::DeviceMemory>& memories,
+                                            std::vector<vk::raii::ImageView>& views) {
+        images.clear();
+        memories.clear();
+        views.clear();
+
+        const auto extent = used ? m_swapChain.getExtent() : vk::Extent2D{.width = 1, .height = 1};
+
+        for (std::size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
+            vk::raii::Image image{nullptr};
+            vk::raii::DeviceMemory imageMemory{nullptr};
+
+            m_imageManager.createImage(
+                MemoryCategory::RenderTargets,
+                extent.width,
+                extent.height,
+                1,
+                vk::SampleCountFlagBits::e1,
+                DEBUG_COUNTER_FORMAT,
+                vk::ImageTiling::eOptimal,
+                vk::ImageUsageFlagBits::eStorage | vk::ImageUsageFlagBits::eTransferDst,
+                vk::MemoryPropertyFlagBits::eDeviceLocal,
+                image,
+                imageMemory
+            );
+
+            auto imageView = m_imageManager.createImageView(
+                image,
+                DEBUG_COUNTER_FORMAT,
+                vk::ImageAspectFlagBits::eColor,
+                1
+            );
+
+            images.push_back(std::move(image));
+            memories.push_back(std::move(imageMemory));
+            views.push_back(std::move(imageView));
+        }
+    };
+
+    createCounterImages(m_debugCounters != DEBUG_COUNTERS_NONE,
+                        m_pixelCountImages, m_pixelCountImageMemories, m_pixelCountImageViews);
+    createCounterImages(m_debugCounters == DEBUG_COUNTERS_RAYS,
+                        m_candidateCountImages, m_candidateCountImageMemories, m_candidateCountImageViews);
+
+    m_rayTotalsBuffers.clear();
+    m_rayTotalsBufferMemories.clear();
+    m_rayTotalsReadbackBuffers.clear();
+    m_rayTotalsReadbackMemories.clear();
+    m_rayTotalsReadbackMapped.clear();
+
+    constexpr vk::DeviceSize totalsSize = sizeof(RayCounterTotals);
+
+    for (std::size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
+        vk::raii::Buffer buffer{nullptr};
+        vk::raii::DeviceMemory bufferMemory{nullptr};
+
+        m_bufferManager.createBuffer(
+            MemoryCategory::PerFrame,
+            totalsSize,
+            vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eTransferSrc |
+            vk::BufferUsageFlagBits::eTransferDst,
+            vk::MemoryPropertyFlagBits::eDeviceLocal,
+            buffer,
+            bufferMemory
+        );
+
+        m_rayTotalsBuffers.emplace_back(std::move(buffer));
+        m_rayTotalsBufferMemories.emplace_back(std::move(bufferMemory));
+
+        vk::raii::Buffer readbackBuffer{nullptr};
+        vk::raii::DeviceMemory readbackMemory{nullptr};
+
+        m_bufferManager.createBuffer(
+            MemoryCategory::PerFrame,
+            totalsSize,
+            vk::BufferUsageFlagBits::eTransferDst,
+            vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent,
+            readbackBuffer,
+            readbackMemory
+        );
+
+        m_rayTotalsReadbackBuffers.emplace_back(std::move(readbackBuffer));
+        m_rayTotalsReadbackMemories.emplace_back(std::move(readbackMemory));
+        m_rayTotalsReadbackMapped.emplace_back(m_rayTotalsReadbackMemories[i].mapMemory(0, totalsSize));
+    }
+}
 
 void RayQueryPipeline::createSyncObjects() {
     m_presentationCompleteSemaphores.clear();
@@ -455,13 +652,27 @@ void RayQueryPipeline::createSyncObjects() {
 }
 
 void RayQueryPipeline::recordCommandBuffer(const Scene& scene, const std::uint32_t imageIndex) {
+    PROFILE_ZONE("RayQueryPipeline::recordCommandBuffer");
+
     const auto& cmd = m_commandManager.getCommandBuffer(m_currentFrame);
 
     cmd.begin({});
 
+    m_rayTotalsFrameNumbers[m_currentFrame] = m_recordedFrames++;
+
+    m_gpuProfiler.beginFrame(cmd, m_currentFrame);
+    m_gpuProfiler.beginPass(cmd, GpuPass::Frame);
+
+    // Copy the instance, light, TLAS instance and draw command changes staged this frame into device-local memory
+    m_gpuProfiler.beginPass(cmd, GpuPass::Upload);
+    m_resourceManager.recordUploads(*cmd);
+    m_gpuProfiler.endPass(cmd, GpuPass::Upload);
+
     // Update TLAS if scene has animated objects - this happens BEFORE rendering
     // so the updated acceleration structure is ready for ray queries
+    m_gpuProfiler.beginPass(cmd, GpuPass::TLASUpdate);
     m_resourceManager.recordTLASUpdate(*cmd, scene, false, m_currentFrame);
+    m_gpuProfiler.endPass(cmd, GpuPass::TLASUpdate);
     
     // transition multisampled color image
     m_imageManager.transitionImageLayout(
@@ -517,6 +728,8 @@ void RayQueryPipeline::recordCommandBuffer(const Scene& scene, const std::uint32
             );
     }
 
+    recordDebugCounterClears(cmd);
+
     constexpr vk::ClearValue clearColor = vk::ClearColorValue(0.0F, 0.0F, 0.0F, 1.0F);
     constexpr vk::ClearValue clearVelocity = vk::ClearColorValue(0.0F, 0.0F, 0.0F, 0.0F);  // Zero velocity
     constexpr vk::ClearValue clearDepth = vk::ClearDepthStencilValue(1.0F, 0);
@@ -595,7 +808,10 @@ void RayQueryPipeline::recordCommandBuffer(const Scene& scene, const std::uint32
         .pDepthAttachment = &depthAttachmentInfo,
     };
 
+    // Opaque timing includes the attachment clears at the start of rendering
+    m_gpuProfiler.beginPass(cmd, GpuPass::Opaque);
     cmd.beginRendering(renderingInfo);
+    m_gpuProfiler.beginStatistics(cmd, GpuPass::Opaque);
 
     cmd.bindPipeline(vk::PipelineBindPoint::eGraphics, *m_opaquePipeline);
 
@@ -614,7 +830,7 @@ void RayQueryPipeline::recordCommandBuffer(const Scene& scene, const std::uint32
     const auto descriptorSets = m_resourceManager.getDescriptorSets();
     const std::array<vk::DescriptorSet, 3> allDescriptorSets = {
         *descriptorSets.globalSets[m_currentFrame],
-        *descriptorSets.materialSets[m_currentFrame],
+        *descriptorSets.materialSet,
         *descriptorSets.lightSets[m_currentFrame]
     };
     cmd.bindDescriptorSets(
@@ -625,43 +841,85 @@ void RayQueryPipeline::recordCommandBuffer(const Scene& scene, const std::uint32
         nullptr  // dynamic offsets
     );
 
-    // Get indirect draw buffer and draw counts
+    const vk::DescriptorImageInfo pixelCountsInfo{
+        .imageView = *m_pixelCountImageViews[m_currentFrame],
+        .imageLayout = vk::ImageLayout::eGeneral,
+    };
+    const vk::DescriptorImageInfo candidateCountsInfo{
+        .imageView = *m_candidateCountImageViews[m_currentFrame],
+        .imageLayout = vk::ImageLayout::eGeneral,
+    };
+    const vk::DescriptorBufferInfo rayTotalsInfo{
+        .buffer = *m_rayTotalsBuffers[m_currentFrame],
+        .offset = 0,
+        .range = vk::WholeSize,
+    };
+    const std::array debugCounterWrites = {
+        vk::WriteDescriptorSet{
+            .dstBinding = 0,
+            .dstArrayElement = 0,
+            .descriptorCount = 1,
+            .descriptorType = vk::DescriptorType::eStorageImage,
+            .pImageInfo = &pixelCountsInfo,
+        },
+        vk::WriteDescriptorSet{
+            .dstBinding = 1,
+            .dstArrayElement = 0,
+            .descriptorCount = 1,
+            .descriptorType = vk::DescriptorType::eStorageImage,
+            .pImageInfo = &candidateCountsInfo,
+        },
+        vk::WriteDescriptorSet{
+            .dstBinding = 2,
+            .dstArrayElement = 0,
+            .descriptorCount = 1,
+            .descriptorType = vk::DescriptorType::eStorageBuffer,
+            .pBufferInfo = &rayTotalsInfo,
+        },
+    };
+    cmd.pushDescriptorSetKHR(vk::PipelineBindPoint::eGraphics, *m_pipelineLayout, 3, debugCounterWrites);
+
+    // Get indirect draw buffer and the per-material-pipeline command ranges
     const auto [indirectBuffer, ___] = m_resourceManager.getIndirectDrawBuffer(m_currentFrame);
-    const std::uint32_t opaqueDrawCount = m_resourceManager.getOpaqueDrawCount();
-    const std::uint32_t transparentDrawCount = m_resourceManager.getTransparentDrawCount();
+    const auto& drawRanges = m_resourceManager.getDrawRanges(m_currentFrame);
+    const auto& pipelineKeys = m_resourceManager.getMaterialPipelineKeys();
     
     // Early exit optimization: if nothing to draw, skip binding and draw calls
-    if (opaqueDrawCount == 0 && transparentDrawCount == 0) {
+    if (drawRanges.empty()) {
+        m_gpuProfiler.endStatistics(cmd, GpuPass::Opaque);
         cmd.endRendering();
+        m_gpuProfiler.endPass(cmd, GpuPass::Opaque);
         // Continue to post-processing even with empty scene
     } else {
-        const vk::DeviceSize transparentOffset = m_resourceManager.getTransparentDrawOffset();
-
-        // First pass: Render ALL opaque objects with a SINGLE multi-draw indirect call!
-        if (opaqueDrawCount > 0) {
-            cmd.drawIndexedIndirect(
-                *indirectBuffer,
-                0, // offset = 0 (opaque commands start at the beginning)
-                opaqueDrawCount, // draw all opaque commands at once
-                sizeof(DrawIndexedIndirectCommand) // stride between commands
-            );
-        }
-
-        // Second pass: Render ALL transparent objects with a SINGLE multi-draw indirect call!
-        if (transparentDrawCount > 0) {
-            cmd.bindPipeline(vk::PipelineBindPoint::eGraphics, *m_transparentPipeline);
-            
+        // One multi-draw indirect call per material pipeline. Opaque ranges come first, the
+        // transparent ones follow once every opaque object has written its depth.
+        bool transparentPass = false;
+        for (const auto& range : drawRanges) {
+            if (pipelineKeys[range.pipelineIndex].transparent && !transparentPass) {
+                m_gpuProfiler.endStatistics(cmd, GpuPass::Opaque);
+                m_gpuProfiler.endPass(cmd, GpuPass::Opaque);
+                m_gpuProfiler.beginPass(cmd, GpuPass::Transparent);
+                m_gpuProfiler.beginStatistics(cmd, GpuPass::Transparent);
+                transparentPass = true;
+            }
+
+            cmd.bindPipeline(vk::PipelineBindPoint::eGraphics, m_materialPipelineHandles[range.pipelineIndex]);
             cmd.drawIndexedIndirect(
                 *indirectBuffer,
-                transparentOffset, // offset = after opaque commands
-                transparentDrawCount, // draw all transparent commands at once
+                range.firstCommand * sizeof(DrawIndexedIndirectCommand),
+                range.commandCount,
                 sizeof(DrawIndexedIndirectCommand) // stride between commands
             );
         }
 
+        const GpuPass lastPass = transparentPass ? GpuPass::Transparent : GpuPass::Opaque;
+        m_gpuProfiler.endStatistics(cmd, lastPass);
+        m_gpuProfiler.endPass(cmd, lastPass);
         cmd.endRendering();
     }
 
+    recordDebugCounterResolve(cmd);
+
     // Transition resolved image for post-processing
     m_imageManager.transitionImageLayout(
         m_resolveImages[m_currentFrame],
@@ -701,6 +959,18 @@ void RayQueryPipeline::recordCommandBuffer(const Scene& scene, const std::uint32
         vk::ImageAspectFlagBits::eColor
         );
 
+    // Debug views show one counter image instead of the tonemapped scene
+    const DebugHeatmap heatmap = [this] {
+        switch (m_debugView) {
+            case DebugView::RayCount:
+                return DebugHeatmap{.countsView = m_pixelCountImageViews[m_currentFrame], .maxCount = RAY_COUNT_HEATMAP_MAX_COUNT};
+            case DebugView::RayCandidates:
+                return DebugHeatmap{.countsView = m_candidateCountImageViews[m_currentFrame], .maxCount = RAY_CANDIDATE_HEATMAP_MAX_COUNT};
+            default:
+                return DebugHeatmap{.countsView = m_pixelCountImageViews[m_currentFrame], .maxCount = OVERDRAW_HEATMAP_MAX_COUNT};
+        }
+    }();
+
     // Post processing pass (now includes TAA)
     m_postProcessingPipeline.recordCommandBuffer(
         m_resolveImages[m_currentFrame],
@@ -710,73 +980,133 @@ void RayQueryPipeline::recordCommandBuffer(const Scene& scene, const std::uint32
         m_swapChain.getImageView(imageIndex),
         cmd,
         scene.bloom,
-        m_currentFrame
+        m_currentFrame,
+        m_debugView != DebugView::None ? &heatmap : nullptr
     );
 
-    // Transition swap chain image for presentation
-    m_imageManager.transitionImageLayout(
-        m_swapChain.getImage(imageIndex),
-        cmd,
-        vk::ImageLayout::eColorAttachmentOptimal,
-        vk::ImageLayout::ePresentSrcKHR,
-        vk::AccessFlagBits2::eColorAttachmentWrite,
-        vk::AccessFlagBits2::eNone,
-        vk::PipelineStageFlagBits2::eColorAttachmentOutput,
-        vk::PipelineStageFlagBits2::eBottomOfPipe,
-        vk::ImageAspectFlagBits::eColor
-        );
+    if (m_swapChain.isHeadless()) {
+        // Headless: nothing is presented, leave the offscreen image ready to be copied out
+        m_imageManager.transitionImageLayout(
+            m_swapChain.getImage(imageIndex),
+            cmd,
+            vk::ImageLayout::eColorAttachmentOptimal,
+            vk::ImageLayout::eTransferSrcOptimal,
+            vk::AccessFlagBits2::eColorAttachmentWrite,
+            vk::AccessFlagBits2::eTransferRead,
+            vk::PipelineStageFlagBits2::eColorAttachmentOutput,
+            vk::PipelineStageFlagBits2::eTransfer,
+            vk::ImageAspectFlagBits::eColor
+            );
 
+        if (m_frameExporter) {
+            m_frameExporter->recordCopy(cmd, m_swapChain.getImage(imageIndex), m_currentFrame);
+        }
+    } else {
+        // Transition swap chain image for presentation
+        m_imageManager.transitionImageLayout(
+            m_swapChain.getImage(imageIndex),
+            cmd,
+            vk::ImageLayout::eColorAttachmentOptimal,
+            vk::ImageLayout::ePresentSrcKHR,
+            vk::AccessFlagBits2::eColorAttachmentWrite,
+            vk::AccessFlagBits2::eNone,
+            vk::PipelineStageFlagBits2::eColorAttachmentOutput,
+            vk::PipelineStageFlagBits2::eBottomOfPipe,
+            vk::ImageAspectFlagBits::eColor
+            );
+    }
+
+    m_gpuProfiler.endPass(cmd, GpuPass::Frame);
 
     cmd.end();
 }
 
-void RayQueryPipeline::drawFrame(Scene& scene, float animationTime) {
-    static auto startTime = std::chrono::high_resolution_clock::now();
-    const auto currentTime = std::chrono::high_resolution_clock::now();
-    const float time = std::chrono::duration<float>(currentTime - startTime).count();
-    
+bool RayQueryPipeline::drawFrame(Scene& scene, float animationTime) {
+    PROFILE_ZONE("RayQueryPipeline::drawFrame");
+
+    using Clock = std::chrono::steady_clock;
+    const auto elapsedMs = [](const Clock::time_point since) {
+        return std::chrono::duration<double, std::milli>(Clock::now() - since).count();
+    };
+
     // TAA: Update jitter offset for this frame
     updateJitter();
     
     // Wait for the current frame's fence (ensures we don't have more than MAX_FRAMES_IN_FLIGHT in flight)
     // IMPORTANT: Camera should be updated AFTER this wait, so it matches when the frame actually renders
-    while (vk::Result::eTimeout == m_vulkanCore.device().waitForFences(*m_inFlightFences[m_currentFrame], vk::True,
-        UINT64_MAX)) {
-        // wait
+    auto stageStart = Clock::now();
+    {
+        PROFILE_ZONE("RayQueryPipeline::waitForFence");
+        while (vk::Result::eTimeout == m_vulkanCore.device().waitForFences(*m_inFlightFences[m_currentFrame], vk::True,
+            UINT64_MAX)) {
+            // wait
+        }
+    }
+    m_lastFrameTimings.fenceWaitMs = elapsedMs(stageStart);
+
+    // This slot's previous frame is done, its ray totals and exported image can be read without stalling
+    resolveRayCounters(m_currentFrame);
+    if (m_frameExporter) {
+        m_frameExporter->resolve(m_currentFrame);
     }
-    
-    // Calculate animation time based on ACTUAL render time (after fence wait)
-    // This ensures camera position matches when the frame actually renders, not when we started
-    const float renderTime = std::chrono::duration<float>(currentTime - startTime).count() * 0.5f;
+
+    const bool headless = m_swapChain.isHeadless();
 
     // Acquire the next available swap chain image
     // We use m_semaphoreIndex to rotate through acquire semaphores
-    auto [result, imageIndex] = m_swapChain.getSwapChain().acquireNextImage(
-        UINT64_MAX, *m_presentationCompleteSemaphores[m_semaphoreIndex], nullptr);
+    // Headless: the offscreen ring is at least MAX_FRAMES_IN_FLIGHT deep, so the fence wait
+    // above already guarantees the next image is no longer in use by the GPU
+    stageStart = Clock::now();
+    std::uint32_t imageIndex = 0;
+    if (headless) {
+        imageIndex = m_swapChain.nextOffscreenImage();
+    } else {
+        PROFILE_ZONE("RayQueryPipeline::acquireNextImage");
+        auto [result, acquiredIndex] = m_swapChain.getSwapChain().acquireNextImage(
+            UINT64_MAX, *m_presentationCompleteSemaphores[m_semaphoreIndex], nullptr);
 
-    if (result == vk::Result::eErrorOutOfDateKHR) {
-        // recreateSwapChain();
-        return;
+        if (result == vk::Result::eErrorOutOfDateKHR) {
+            // recreateSwapChain();
+            return false;
+        }
+        imageIndex = acquiredIndex;
     }
+    m_lastFrameTimings.acquireMs = elapsedMs(stageStart);
 
-    // NOTE: Camera should be updated here (after fence wait) using renderTime
-    // But we can't do it here without animator access, so Application must update it
-    // right before calling drawFrame() - the animationTime parameter is for future use
+    // NOTE: Camera is updated by the Application right before calling drawFrame().
+    // Shader time follows animationTime so fixed-step (benchmark) runs are reproducible.
+    stageStart = Clock::now();
+    m_resourceManager.updateSceneResources(scene, animationTime, m_currentFrame, m_jitterOffset);
 
-    m_resourceManager.updateSceneResources(scene, time, m_currentFrame, m_jitterOffset);
-
-    // Update post-processing descriptor sets with the current frame's resolve image and velocity buffer
-    m_postProcessingPipeline.updateDescriptorSets(m_resolveImageViews[m_currentFrame], m_velocityImageViews[m_currentFrame], m_currentFrame);
+    m_lastFrameTimings.sceneUpdateMs = elapsedMs(stageStart);
 
     m_vulkanCore.device().resetFences(*m_inFlightFences[m_currentFrame]);
 
     const auto& cmd = m_commandManager.getCommandBuffer(m_currentFrame);
 
+    stageStart = Clock::now();
     cmd.reset();
     recordCommandBuffer(scene, imageIndex);
+    m_lastFrameTimings.recordMs = elapsedMs(stageStart);
 
     constexpr vk::PipelineStageFlags waitDestinationStageMask(vk::PipelineStageFlagBits::eColorAttachmentOutput);
 
+    stageStart = Clock::now();
+    if (headless) {
+        // No acquire/present semaphores: the in-flight fence is the only synchronization needed
+        const vk::SubmitInfo submitInfo{
+            .commandBufferCount = 1,
+            .pCommandBuffers = &*cmd,
+        };
+
+        m_vulkanCore.graphicsQueue().submit(submitInfo, *m_inFlightFences[m_currentFrame]);
+        m_lastFrameTimings.submitMs = elapsedMs(stageStart);
+        m_lastFrameTimings.presentMs = 0.0;
+
+        m_currentFrame = (m_currentFrame + 1) % MAX_FRAMES_IN_FLIGHT;
+        return true;
+    }
+
     // Wait on the acquire semaphore - this ensures the presentation engine has released the image
     const vk::SubmitInfo submitInfo{
         .waitSemaphoreCount = 1,
@@ -789,7 +1119,9 @@ void RayQueryPipeline::drawFrame(Scene& scene, float animationTime) {
     };
 
     m_vulkanCore.graphicsQueue().submit(submitInfo, *m_inFlightFences[m_currentFrame]);
+    m_lastFrameTimings.submitMs = elapsedMs(stageStart);
 
+    stageStart = Clock::now();
     vk::PresentInfoKHR const presentInfoKHR{
         .waitSemaphoreCount = 1,
         .pWaitSemaphores = &*m_renderFinishedSemaphores[imageIndex],
@@ -799,6 +1131,7 @@ void RayQueryPipeline::drawFrame(Scene& scene, float animationTime) {
     };
 
     auto presentationResult = m_vulkanCore.presentQueue().presentKHR(presentInfoKHR);
+    m_lastFrameTimings.presentMs = elapsedMs(stageStart);
 
     switch (presentationResult) {
         case vk::Result::eSuccess:
@@ -813,4 +1146,160 @@ void RayQueryPipeline::drawFrame(Scene& scene, float animationTime) {
 
     m_semaphoreIndex = (m_semaphoreIndex + 1) % m_presentationCompleteSemaphores.size();
     m_currentFrame = (m_currentFrame + 1) % MAX_FRAMES_IN_FLIGHT;
+    return true;
+}
+
+void RayQueryPipeline::recordDebugCounterClears(const vk::raii::CommandBuffer& cmd) {
+    // Counter images live in General layout; only the ones the pipelines count into are cleared
+    const auto prepareCounterImage = [this, &cmd](const vk::raii::Image& image, const bool used) {
+        if (!used) {
+            m_imageManager.transitionImageLayout(
+                image,
+                cmd,
+                vk::ImageLayout::eUndefined,
+                vk::ImageLayout::eGeneral,
+                {},
+                {},
+                vk::PipelineStageFlagBits2::eTopOfPipe,
+                vk::PipelineStageFlagBits2::eFragmentShader,
+                vk::ImageAspectFlagBits::eColor
+                );
+            return;
+        }
+
+        m_imageManager.transitionImageLayout(
+            image,
+            cmd,
+            vk::ImageLayout::eUndefined,
+            vk::ImageLayout::eGeneral,
+            {},
+            vk::AccessFlagBits2::eTransferWrite,
+            vk::PipelineStageFlagBits2::eTopOfPipe,
+            vk::PipelineStageFlagBits2::eClear,
+            vk::ImageAspectFlagBits::eColor
+            );
+
+        cmd.clearColorImage(
+            *image,
+            vk::ImageLayout::eGeneral,
+            vk::ClearColorValue(0U, 0U, 0U, 0U),
+            vk::ImageSubresourceRange{
+                .aspectMask = vk::ImageAspectFlagBits::eColor,
+                .baseMipLevel = 0,
+                .levelCount = 1,
+                .baseArrayLayer = 0,
+                .layerCount = 1,
+            });
+
+        m_imageManager.transitionImageLayout(
+            image,
+            cmd,
+            vk::ImageLayout::eGeneral,
+            vk::ImageLayout::eGeneral,
+            vk::AccessFlagBits2::eTransferWrite,
+            vk::AccessFlagBits2::eShaderStorageRead | vk::AccessFlagBits2::eShaderStorageWrite,
+            vk::PipelineStageFlagBits2::eClear,
+            vk::PipelineStageFlagBits2::eFragmentShader,
+            vk::ImageAspectFlagBits::eColor
+            );
+    };
+
+    const bool countingRays = m_debugCounters == DEBUG_COUNTERS_RAYS;
+    prepareCounterImage(m_pixelCountImages[m_currentFrame], m_debugCounters != DEBUG_COUNTERS_NONE);
+    prepareCounterImage(m_candidateCountImages[m_currentFrame], countingRays);
+
+    if (!countingRays) {
+        return;
+    }
+
+    // The previous copy out of this buffer finished before the slot's fence, only the fill -> atomics order matters
+    cmd.fillBuffer(*m_rayTotalsBuffers[m_currentFrame], 0, vk::WholeSize, 0);
+
+    const vk::MemoryBarrier2 clearBarrier{
+        .srcStageMask = vk::PipelineStageFlagBits2::eClear,
+        .srcAccessMask = vk::AccessFlagBits2::eTransferWrite,
+        .dstStageMask = vk::PipelineStageFlagBits2::eFragmentShader,
+        .dstAccessMask = vk::AccessFlagBits2::eShaderStorageRead | vk::AccessFlagBits2::eShaderStorageWrite,
+    };
+
+    cmd.pipelineBarrier2(vk::DependencyInfo{
+        .memoryBarrierCount = 1,
+        .pMemoryBarriers = &clearBarrier,
+    });
+}
+
+void RayQueryPipeline::recordDebugCounterResolve(const vk::raii::CommandBuffer& cmd) {
+    if (m_debugCounters == DEBUG_COUNTERS_NONE) {
+        return;
+    }
+
+    // The heatmap in the composite pass reads the counts of both scene passes
+    const auto& heatmapImage = m_debugView == DebugView::RayCandidates ? m_candidateCountImages[m_currentFrame]
+                                                                       : m_pixelCountImages[m_currentFrame];
+    m_imageManager.transitionImageLayout(
+        heatmapImage,
+        cmd,
+        vk::ImageLayout::eGeneral,
+        vk::ImageLayout::eGeneral,
+        vk::AccessFlagBits2::eShaderStorageWrite,
+        vk::AccessFlagBits2::eShaderStorageRead,
+        vk::PipelineStageFlagBits2::eFragmentShader,
+        vk::PipelineStageFlagBits2::eFragmentShader,
+        vk::ImageAspectFlagBits::eColor
+        );
+
+    if (m_debugCounters != DEBUG_COUNTERS_RAYS) {
+        return;
+    }
+
+    const vk::MemoryBarrier2 copyBarrier{
+        .srcStageMask = vk::PipelineStageFlagBits2::eFragmentShader,
+        .srcAccessMask = vk::AccessFlagBits2::eShaderStorageWrite,
+        .dstStageMask = vk::PipelineStageFlagBits2::eCopy,
+        .dstAccessMask = vk::AccessFlagBits2::eTransferRead,
+    };
+
+    cmd.pipelineBarrier2(vk::DependencyInfo{
+        .memoryBarrierCount = 1,
+        .pMemoryBarriers = &copyBarrier,
+    });
+
+    cmd.copyBuffer(*m_rayTotalsBuffers[m_currentFrame], *m_rayTotalsReadbackBuffers[m_currentFrame],
+                   vk::BufferCopy(0, 0, sizeof(RayCounterTotals)));
+
+    // Makes the copy visible to the host once the frame's fence signals
+    const vk::MemoryBarrier2 readbackBarrier{
+        .srcStageMask = vk::PipelineStageFlagBits2::eCopy,
+        .srcAccessMask = vk::AccessFlagBits2::eTransferWrite,
+        .dstStageMask = vk::PipelineStageFlagBits2::eHost,
+        .dstAccessMask = vk::AccessFlagBits2::eHostRead,
+    };
+
+    cmd.pipelineBarrier2(vk::DependencyInfo{
+        .memoryBarrierCount = 1,
+        .pMemoryBarriers = &readbackBarrier,
+    });
+
+    m_rayTotalsPending[m_currentFrame] = true;
+}
+
+void RayQueryPipeline::resolveRayCounters(const std::uint32_t frameIndex) {
+    if (!m_rayTotalsPending[frameIndex]) {
+        return;
+    }
+    m_rayTotalsPending[frameIndex] = false;
+
+    RayCounterTotals totals{};
+    std::memcpy(&totals, m_rayTotalsReadbackMapped[frameIndex], sizeof(RayCounterTotals));
+
+    if (m_rayCounterCallback) {
+        m_rayCounterCallback(m_rayTotalsFrameNumbers[frameIndex], totals);
+    }
+}
+
+void RayQueryPipeline::resolvePendingRayCounters() {
+    // Oldest frame first, so the callback sees frame numbers in order
+    for (std::uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
+        resolveRayCounters((m_currentFrame + i) % MAX_FRAMES_IN_FLIGHT);
+    }
 }
@@ -4,6 +4,7 @@
 #include <cstdint>
 #include <array>
 #include <algorithm>
+#include <functional>
 #include <utility>
 #include <vector>
 #include <chrono>
@@ -23,9 +24,13 @@
 #include "SharedTypes.hpp"
 #include "ImageManager.hpp"
 #include "FrustumCulling.hpp"
+#include "PotentiallyVisibleSet.hpp"
+#include "ProbeVolume.hpp"
+#include "InstanceCulling.hpp"
+#include "SceneBvh.hpp"
+#include "TextureStreamer.hpp"
+#include "CpuProfiler.hpp"
 
-constexpr std::uint32_t AS_REFLECTIVE_OBJECT_MASK = 0x01;
-constexpr std::uint32_t AS_SHADOW_OBJECT_MASK = 0x02;
 constexpr std::uint32_t AS_UNKNOWN_OBJ_MASK = 0x00;
 
 constexpr std::uint32_t DS_UBO_BINDING = 0;
@@ -37,42 +42,13 @@ constexpr std::uint32_t DS_INDEX_BINDING = 5;
 constexpr std::uint32_t DS_VERTEX_BINDING = 6;
 
 constexpr std::uint32_t DS_MATERIALS_BINDING = 0;
-constexpr std::uint32_t DS_BASE_COLOR_TEXTURE_BINDING = 1;
-constexpr std::uint32_t DS_METALLIC_ROUGHNESS_TEXTURE_BINDING = 2;
-constexpr std::uint32_t DS_NORMAL_TEXTURE_BINDING = 3;
-constexpr std::uint32_t DS_EMISSIVE_TEXTURE_BINDING = 4;
-constexpr std::uint32_t DS_OCCLUSION_TEXTURE_BINDING = 5;
-constexpr std::uint32_t DS_SKYBOX_TEXTURE_BINDING = 6;
+constexpr std::uint32_t DS_SKYBOX_TEXTURE_BINDING = 1;
+constexpr std::uint32_t DS_PROBE_VOLUME_BINDING = 2;
+constexpr std::uint32_t DS_TEXTURE_TABLE_BINDING = 3; // Variable count, must stay the last binding
 
 constexpr std::uint32_t DS_POINT_LIGHTS_BINDING = 0;
 constexpr std::uint32_t DS_SPOT_LIGHTS_BINDING = 1;
 
-namespace {
-void appendTextureWrites(
-    std::vector<vk::WriteDescriptorSet>& descriptorWrites,
-    std::vector<vk::DescriptorImageInfo>& allImageInfos,
-    const vk::DescriptorSet dstSet,
-    const std::uint32_t dstBinding,
-    const vk::raii::Sampler& sampler,
-    const std::vector<AllocatedTextureImage>& textureImages
-    ) {
-    for (std::size_t i = 0; i < textureImages.size(); ++i) {
-        allImageInfos.emplace_back(vk::DescriptorImageInfo{
-            .sampler = sampler,
-            .imageView = textureImages[i].imageView,
-            .imageLayout = vk::ImageLayout::eShaderReadOnlyOptimal
-        });
-        descriptorWrites.emplace_back(vk::WriteDescriptorSet{
-            .dstSet = dstSet,
-            .dstBinding = dstBinding,
-            .dstArrayElement = static_cast<uint32_t>(i),
-            .descriptorCount = 1,
-            .descriptorType = vk::DescriptorType::eCombinedImageSampler,
-            .pImageInfo = &allImageInfos.back(),
-        });
-    }
-}
-}
 
 
 ResourceManager::ResourceManager(VulkanCore& vulkanCore, CommandManager& commandManager, BufferManager& bufferManager,
@@ -81,7 +57,10 @@ ResourceManager::ResourceManager(VulkanCore& vulkanCore, CommandManager& command
       m_commandManager{commandManager},
       m_bufferManager{bufferManager},
       m_imageManager{imageManager},
+      m_stagingRing{vulkanCore, bufferManager},
+      m_tlasUpdatePending(MAX_FRAMES_IN_FLIGHT, false),
       m_cachedCameraViewProj(MAX_FRAMES_IN_FLIGHT, glm::mat4(0.0f)),
+      m_cachedPvsSegments(MAX_FRAMES_IN_FLIGHT, NO_PVS_SEGMENT),
       m_indirectDrawBuffersInitialized(MAX_FRAMES_IN_FLIGHT, false),
       m_prevViewMatrices(MAX_FRAMES_IN_FLIGHT, glm::mat4(1.0f)),
       m_prevProjMatrices(MAX_FRAMES_IN_FLIGHT, glm::mat4(1.0f)),
@@ -95,23 +74,18 @@ void ResourceManager::createDescriptorPool() {
     constexpr vk::DescriptorPoolSize uboPoolSize(vk::DescriptorType::eUniformBuffer, MAX_FRAMES_IN_FLIGHT);
     constexpr vk::DescriptorPoolSize tlasPoolSize(vk::DescriptorType::eAccelerationStructureKHR, MAX_FRAMES_IN_FLIGHT);
 
-    // We have 5 texture arrays, and we allocate a descriptor set for each frame in flight.
-    // In addition, we have one skybox with one descriptor set per frame.
-    constexpr std::uint32_t texturesPerFrame = (MAX_TEXTURES_PER_TYPE * 5) + 1; // 5 arrays + 1 skybox
-    constexpr vk::DescriptorPoolSize texturesPoolSize(vk::DescriptorType::eCombinedImageSampler, texturesPerFrame * MAX_FRAMES_IN_FLIGHT);
-
-    // Global (5) + Material (1) + Light (2) = 9 SSBOs per frame.
+    // Global (5) + Light (2) = 7 SSBOs per frame.
     // We allocate descriptor sets for each type per frame.
-    constexpr std::uint32_t storageBuffersPerFrame = 5 + 1 + 2;
+    // The material set (with all textures) is shared by the frames and has its own pool, see growTextureTable().
+    constexpr std::uint32_t storageBuffersPerFrame = 5 + 2;
     constexpr vk::DescriptorPoolSize
         storagePoolSize(vk::DescriptorType::eStorageBuffer, storageBuffersPerFrame * MAX_FRAMES_IN_FLIGHT);
 
-    std::vector poolSizes = {uboPoolSize, tlasPoolSize, texturesPoolSize, storagePoolSize};
+    std::vector poolSizes = {uboPoolSize, tlasPoolSize, storagePoolSize};
 
     const vk::DescriptorPoolCreateInfo poolInfo{
-        .flags = vk::DescriptorPoolCreateFlagBits::eFreeDescriptorSet |
-                 vk::DescriptorPoolCreateFlagBits::eUpdateAfterBind,
-        .maxSets = MAX_FRAMES_IN_FLIGHT * 3, // We have 3 descriptor sets per frame
+        .flags = vk::DescriptorPoolCreateFlagBits::eFreeDescriptorSet,
+        .maxSets = MAX_FRAMES_IN_FLIGHT * 2, // We have 2 descriptor sets per frame
         .poolSizeCount = static_cast<uint32_t>(poolSizes.size()),
         .pPoolSizes = poolSizes.data()
     };
@@ -204,72 +178,47 @@ void ResourceManager::createDescriptorSetLayouts() {
         .pImmutableSamplers = nullptr,
     };
 
-    constexpr vk::DescriptorSetLayoutBinding baseColorTextureBinding{
-        .binding = DS_BASE_COLOR_TEXTURE_BINDING,
-        .descriptorType = vk::DescriptorType::eCombinedImageSampler,
-        .descriptorCount = MAX_TEXTURES_PER_TYPE,
-        .stageFlags = vk::ShaderStageFlagBits::eFragment,
-        .pImmutableSamplers = nullptr,
-    };
-
-    constexpr vk::DescriptorSetLayoutBinding metallicTextureBinding{
-        .binding = DS_METALLIC_ROUGHNESS_TEXTURE_BINDING,
-        .descriptorType = vk::DescriptorType::eCombinedImageSampler,
-        .descriptorCount = MAX_TEXTURES_PER_TYPE,
-        .stageFlags = vk::ShaderStageFlagBits::eFragment,
-        .pImmutableSamplers = nullptr,
-    };
-
-    constexpr vk::DescriptorSetLayoutBinding normalTextureBinding{
-        .binding = DS_NORMAL_TEXTURE_BINDING,
-        .descriptorType = vk::DescriptorType::eCombinedImageSampler,
-        .descriptorCount = MAX_TEXTURES_PER_TYPE,
-        .stageFlags = vk::ShaderStageFlagBits::eFragment,
-        .pImmutableSamplers = nullptr,
-    };
-
-    constexpr vk::DescriptorSetLayoutBinding emissiveTextureBinding{
-        .binding = DS_EMISSIVE_TEXTURE_BINDING,
+    constexpr vk::DescriptorSetLayoutBinding skyboxTextureBinding{
+        .binding = DS_SKYBOX_TEXTURE_BINDING,
         .descriptorType = vk::DescriptorType::eCombinedImageSampler,
-        .descriptorCount = MAX_TEXTURES_PER_TYPE,
+        .descriptorCount = 1,
         .stageFlags = vk::ShaderStageFlagBits::eFragment,
         .pImmutableSamplers = nullptr,
     };
 
-    constexpr vk::DescriptorSetLayoutBinding occlusionTextureBinding{
-        .binding = DS_OCCLUSION_TEXTURE_BINDING,
+    // One texture per color channel, see ProbeVolume
+    constexpr vk::DescriptorSetLayoutBinding probeVolumeBinding{
+        .binding = DS_PROBE_VOLUME_BINDING,
         .descriptorType = vk::DescriptorType::eCombinedImageSampler,
-        .descriptorCount = MAX_TEXTURES_PER_TYPE,
+        .descriptorCount = 3,
         .stageFlags = vk::ShaderStageFlagBits::eFragment,
         .pImmutableSamplers = nullptr,
     };
 
-    constexpr vk::DescriptorSetLayoutBinding skyboxTextureBinding{
-        .binding = DS_SKYBOX_TEXTURE_BINDING,
+    // Every material texture lives in this one array. Sets are allocated with only as many
+    // descriptors as the table currently holds (variable descriptor count).
+    constexpr vk::DescriptorSetLayoutBinding textureTableBinding{
+        .binding = DS_TEXTURE_TABLE_BINDING,
         .descriptorType = vk::DescriptorType::eCombinedImageSampler,
-        .descriptorCount = 1,
+        .descriptorCount = TEXTURE_TABLE_MAX_SIZE,
         .stageFlags = vk::ShaderStageFlagBits::eFragment,
         .pImmutableSamplers = nullptr,
     };
 
     std::array materialBindings = {
         materialsBinding,
-        baseColorTextureBinding,
-        metallicTextureBinding,
-        normalTextureBinding,
-        emissiveTextureBinding,
-        occlusionTextureBinding,
         skyboxTextureBinding,
+        probeVolumeBinding,
+        textureTableBinding,
     };
 
     std::array bindingFlags = {
         vk::DescriptorBindingFlags(0),                                              // materials
-        vk::DescriptorBindingFlags(vk::DescriptorBindingFlagBits::ePartiallyBound), // baseColor
-        vk::DescriptorBindingFlags(vk::DescriptorBindingFlagBits::ePartiallyBound), // metallicRoughness
-        vk::DescriptorBindingFlags(vk::DescriptorBindingFlagBits::ePartiallyBound), // normal
-        vk::DescriptorBindingFlags(vk::DescriptorBindingFlagBits::ePartiallyBound), // emissive
-        vk::DescriptorBindingFlags(vk::DescriptorBindingFlagBits::ePartiallyBound), // occlusion
         vk::DescriptorBindingFlags(vk::DescriptorBindingFlagBits::ePartiallyBound), // skybox (may be skipped on low VRAM)
+        vk::DescriptorBindingFlags(vk::DescriptorBindingFlagBits::ePartiallyBound), // probe volume (--probes only)
+        // texture table: new textures are written while earlier frames using the set are still in flight
+        vk::DescriptorBindingFlagBits::eUpdateAfterBind | vk::DescriptorBindingFlagBits::eUpdateUnusedWhilePending |
+        vk::DescriptorBindingFlagBits::ePartiallyBound | vk::DescriptorBindingFlagBits::eVariableDescriptorCount,
     };
 
     vk::DescriptorSetLayoutBindingFlagsCreateInfo flagsInfo{
@@ -279,6 +228,7 @@ void ResourceManager::createDescriptorSetLayouts() {
 
     const vk::DescriptorSetLayoutCreateInfo materialsLayoutCreateInfo{
         .pNext = &flagsInfo,
+        .flags = vk::DescriptorSetLayoutCreateFlagBits::eUpdateAfterBindPool,
         .bindingCount = static_cast<std::uint32_t>(materialBindings.size()),
         .pBindings = materialBindings.data(),
     };
@@ -319,6 +269,7 @@ void ResourceManager::createDescriptorSetLayouts() {
 
 void ResourceManager::createTextureSamplers() {
     m_skyboxSampler = m_imageManager.createSkyboxSampler();
+    m_probeVolumeSampler = m_imageManager.createPostProcessingSampler();  // Trilinear, clamped at the volume edges
     m_baseColorTextureSampler = m_imageManager.createSampler(true);
     m_metallicRoughnessTextureSampler = m_imageManager.createSampler(false);
     m_normalTextureSampler = m_imageManager.createSampler(false);
@@ -326,10 +277,42 @@ void ResourceManager::createTextureSamplers() {
     m_occlusionTextureSampler = m_imageManager.createSampler(false);
 }
 
+void ResourceManager::setPotentiallyVisibleSet(const PotentiallyVisibleSet* pvs) {
+    m_pvs = pvs;
+    if (m_pvs != nullptr) {
+        // A decoded segment never holds more than the static range, decoding at runtime never allocates
+        m_pvsInstances.reserve(m_pvs->staticInstanceCount());
+    }
+}
+
 void ResourceManager::allocateSceneResources(const Scene& scene) {
     allocateVertexBuffer(scene.vertices);
     allocateIndexBuffer(scene.indices);
 
+    // Worst case per frame: every dynamic buffer rewritten in full
+    const std::size_t instanceCount = scene.instances.size();
+    const vk::DeviceSize uploadCapacity =
+        instanceCount * (sizeof(Instance) + sizeof(vk::AccelerationStructureInstanceKHR) +
+                         sizeof(DrawIndexedIndirectCommand)) +
+        scene.pointLights.size() * sizeof(PointLight) + scene.spotLights.size() * sizeof(SpotLight) +
+        5 * UPLOAD_STAGING_ALIGNMENT;
+
+    // Every stage() call of a frame, if none of them merge: one per run of changed elements in each versioned
+    // buffer (updateInstanceBuffers, updateBlasInstances, updateLightBuffers), where a run is at least one element,
+    // plus the indirect draw commands of rebuildIndirectDrawCommands, staged as one range
+    const std::size_t maxStagesPerFrame = instanceCount +                // Instance runs
+                                          instanceCount +                // TLAS instance runs
+                                          scene.pointLights.size() +     // Point light runs
+                                          scene.spotLights.size() +      // Spot light runs
+                                          1;                             // Indirect draw commands
+    m_stagingRing.allocate(uploadCapacity, maxStagesPerFrame);
+
+    // Textures go first: materials reference them by their texture table index
+    createTextureImages(scene);
+    createSkyboxImage(scene);
+    createProbeVolumeImages();
+    createTextureTable(scene);
+
     createUniformBuffers();
     createInstanceBuffers(scene);
     createMeshesBuffer(scene);
@@ -337,14 +320,18 @@ void ResourceManager::allocateSceneResources(const Scene& scene) {
     createMaterialBuffers(scene);
     createLightBuffers(scene);
     createIndirectDrawBuffers(scene);
-    
-    createTextureImages(scene);
-    createSkyboxImage(scene);
 
     createAccelerationStructures(scene);
+
+    // Every GPU copy now holds the scene as it is, later frames only receive what changes after this point
+    m_instanceVersions.reset(scene.instanceGenerations);
+    m_blasInstanceVersions.reset(scene.instanceGenerations);
+    m_indirectDrawVersions.reset(scene.instanceGenerations);
+    m_pointLightVersions.reset(scene.pointLightGenerations);
+    m_spotLightVersions.reset(scene.spotLightGenerations);
     
     createGlobalDescriptorSets(scene);
-    createMaterialDescriptorSets(scene);
+    writeMaterialDescriptorSet();
     createLightingDescriptorSets(scene);
 }
 
@@ -352,16 +339,34 @@ void ResourceManager::updateSceneResources(const Scene& scene,
                                            const float time,
                                            const std::uint32_t frameIdx,
                                            glm::vec2 jitterOffset) {
+    PROFILE_ZONE("ResourceManager::updateSceneResources");
+
+    // This frame's fence has been waited on, which eventually frees texture tables that were grown out of
+    releaseRetiredTextureTables();
+
+    // ...and makes this frame's staging buffer free to reuse
+    m_stagingRing.beginFrame(frameIdx);
+    if (m_textureStreamer != nullptr) {
+        m_textureStreamer->beginFrame(frameIdx, time);
+    }
+
     updateUniformBuffer(scene, time, frameIdx, jitterOffset);
     updateInstanceBuffers(scene, frameIdx);
     updateLightBuffers(scene, frameIdx);
-    updateIndirectDrawBuffers(scene, frameIdx);
+    updateBlasInstances(scene, frameIdx);
+    updateIndirectDrawBuffers(scene, time, frameIdx);
     
     // TLAS update is now recorded directly into the command buffer via recordTLASUpdate()
     // This eliminates the waitIdle() stall!
     
-    // we do not animate materials (blender export limitations), but it saves us some fps      
-    // updateMaterialBuffers(scene, frameIdx);
+    // we do not animate materials (blender export limitations), they are uploaded once in createMaterialBuffers()
+}
+
+void ResourceManager::recordUploads(const vk::CommandBuffer& cmd) {
+    m_stagingRing.recordUploads(cmd);
+    if (m_textureStreamer != nullptr) {
+        m_textureStreamer->recordUploads(cmd);
+    }
 }
 
 
@@ -369,6 +374,7 @@ void ResourceManager::allocateVertexBuffer(const std::vector<Vertex>& vertices)
     const vk::DeviceSize bufferSize = vertices.empty() ? sizeof(Vertex) : sizeof(Vertex) * vertices.size();
     const void* data = vertices.empty() ? nullptr : vertices.data();
     m_bufferManager.createBuffer(
+        MemoryCategory::Geometry,
         bufferSize,
         vk::BufferUsageFlagBits::eTransferDst
         | vk::BufferUsageFlagBits::eVertexBuffer
@@ -386,6 +392,7 @@ void ResourceManager::allocateIndexBuffer(const std::vector<std::uint32_t>& indi
     const vk::DeviceSize bufferSize = indices.empty() ? sizeof(std::uint32_t) : sizeof(std::uint32_t) * indices.size();
     const void* data = indices.empty() ? nullptr : indices.data();
     m_bufferManager.createBuffer(
+        MemoryCategory::Geometry,
         bufferSize,
         vk::BufferUsageFlagBits::eTransferDst
         | vk::BufferUsageFlagBits::eIndexBuffer
@@ -411,6 +418,7 @@ void ResourceManager::createUniformBuffers() {
         vk::raii::DeviceMemory bufferMem({});
 
         m_bufferManager.createBuffer(
+            MemoryCategory::PerFrame,
             bufferSize,
             vk::BufferUsageFlagBits::eUniformBuffer,
             vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent,
@@ -437,22 +445,21 @@ void ResourceManager::createInstanceBuffers(const Scene& scene) {
         vk::raii::Buffer buffer({});
         vk::raii::DeviceMemory bufferMem({});
 
+        // Initialized with the instance data, later frames only upload what the animator changed
         m_bufferManager.createBuffer(
+            MemoryCategory::PerFrame,
             bufferSize,
-            vk::BufferUsageFlagBits::eStorageBuffer,
-            vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent,
+            vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eTransferDst,
+            m_stagingRing.getTargetMemoryProperties(),
             buffer,
-            bufferMem
+            bufferMem,
+            scene.instances.empty() ? nullptr : scene.instances.data()
             );
 
         m_instanceBuffers.emplace_back(std::move(buffer));
         m_instanceBuffersMemory.emplace_back(std::move(bufferMem));
-        m_instanceBuffersMapped.emplace_back(m_instanceBuffersMemory[i].mapMemory(0, bufferSize));
-        
-        // Initialize buffer with instance data
-        if (!scene.instances.empty()) {
-            memcpy(m_instanceBuffersMapped[i], scene.instances.data(), sizeof(Instance) * scene.instances.size());
-        }
+        m_instanceBuffersMapped.emplace_back(
+            m_stagingRing.isDirect() ? m_instanceBuffersMemory[i].mapMemory(0, bufferSize) : nullptr);
     }
 }
 
@@ -460,6 +467,7 @@ void ResourceManager::createMeshesBuffer(const Scene& scene) {
     const vk::DeviceSize bufferSize = scene.meshes.empty() ? sizeof(Mesh) : sizeof(Mesh) * scene.meshes.size();
     const void* data = scene.meshes.empty() ? nullptr : scene.meshes.data();
     m_bufferManager.createBuffer(
+        MemoryCategory::Geometry,
         bufferSize,
         vk::BufferUsageFlagBits::eStorageBuffer,
         vk::MemoryPropertyFlagBits::eDeviceLocal,
@@ -473,6 +481,7 @@ void ResourceManager::createUVBuffer(const Scene& scene) {
     const vk::DeviceSize bufferSize = scene.uvs.empty() ? sizeof(glm::vec2) : sizeof(glm::vec2) * scene.uvs.size();
     const void* data = scene.uvs.empty() ? nullptr : scene.uvs.data();
     m_bufferManager.createBuffer(
+        MemoryCategory::Geometry,
         bufferSize,
         vk::BufferUsageFlagBits::eStorageBuffer,
         vk::MemoryPropertyFlagBits::eDeviceLocal,
@@ -483,34 +492,21 @@ void ResourceManager::createUVBuffer(const Scene& scene) {
 }
 
 void ResourceManager::createMaterialBuffers(const Scene& scene) {
-    m_materialBuffers.clear();
-    m_materialBuffersMemory.clear();
-    m_materialBuffersMapped.clear();
+    remapMaterialTextures(scene);
 
-    for (std::size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
-        const vk::DeviceSize bufferSize = scene.materials.empty()
-                                              ? sizeof(Material)
-                                              : sizeof(Material) * scene.materials.size();
+    const vk::DeviceSize bufferSize = m_gpuMaterials.empty()
+                                          ? sizeof(Material)
+                                          : sizeof(Material) * m_gpuMaterials.size();
 
-        vk::raii::Buffer buffer({});
-        vk::raii::DeviceMemory bufferMem({});
-
-        m_bufferManager.createBuffer(
-            bufferSize,
-            vk::BufferUsageFlagBits::eStorageBuffer,
-            vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent,
-            buffer,
-            bufferMem
-            );
-
-        m_materialBuffers.emplace_back(std::move(buffer));
-        m_materialBuffersMemory.emplace_back(std::move(bufferMem));
-        m_materialBuffersMapped.emplace_back(m_materialBuffersMemory[i].mapMemory(0, bufferSize));
-    }
-
-    for (std::size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
-        updateMaterialBuffers(scene, i);
-    }
+    m_bufferManager.createBuffer(
+        MemoryCategory::Materials,
+        bufferSize,
+        vk::BufferUsageFlagBits::eStorageBuffer,
+        vk::MemoryPropertyFlagBits::eDeviceLocal,
+        m_materialBuffer,
+        m_materialBufferMemory,
+        m_gpuMaterials.empty() ? nullptr : m_gpuMaterials.data()
+        );
 }
 
 void ResourceManager::createLightBuffers(const Scene& scene) {
@@ -527,16 +523,19 @@ void ResourceManager::createLightBuffers(const Scene& scene) {
         vk::raii::DeviceMemory pointLightBufferMemory({});
 
         m_bufferManager.createBuffer(
+            MemoryCategory::PerFrame,
             pointLightBufferSize,
-            vk::BufferUsageFlagBits::eStorageBuffer,
-            vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent,
+            vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eTransferDst,
+            m_stagingRing.getTargetMemoryProperties(),
             pointLightBuffer,
-            pointLightBufferMemory
+            pointLightBufferMemory,
+            scene.pointLights.empty() ? nullptr : scene.pointLights.data()
             );
 
         m_pointLightBuffers.emplace_back(std::move(pointLightBuffer));
         m_pointLightBuffersMemory.emplace_back(std::move(pointLightBufferMemory));
-        m_pointLightBuffersMapped.emplace_back(m_pointLightBuffersMemory[i].mapMemory(0, pointLightBufferSize));
+        m_pointLightBuffersMapped.emplace_back(
+            m_stagingRing.isDirect() ? m_pointLightBuffersMemory[i].mapMemory(0, pointLightBufferSize) : nullptr);
     }
 
     m_spotLightBuffers.clear();
@@ -552,20 +551,19 @@ void ResourceManager::createLightBuffers(const Scene& scene) {
         vk::raii::DeviceMemory spotLightBufferMemory({});
 
         m_bufferManager.createBuffer(
+            MemoryCategory::PerFrame,
             spotLightBufferSize,
-            vk::BufferUsageFlagBits::eStorageBuffer,
-            vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent,
+            vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eTransferDst,
+            m_stagingRing.getTargetMemoryProperties(),
             spotLightBuffer,
-            spotLightBufferMemory
+            spotLightBufferMemory,
+            scene.spotLights.empty() ? nullptr : scene.spotLights.data()
             );
 
         m_spotLightBuffers.emplace_back(std::move(spotLightBuffer));
         m_spotLightBuffersMemory.emplace_back(std::move(spotLightBufferMemory));
-        m_spotLightBuffersMapped.emplace_back(m_spotLightBuffersMemory[i].mapMemory(0, spotLightBufferSize));
-    }
-
-    for (std::size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
-        updateLightBuffers(scene, i);
+        m_spotLightBuffersMapped.emplace_back(
+            m_stagingRing.isDirect() ? m_spotLightBuffersMemory[i].mapMemory(0, spotLightBufferSize) : nullptr);
     }
 }
 
@@ -594,37 +592,62 @@ void ResourceManager::createTextureImages(const Scene& scene) {
         }
     };
 
-    for (std::size_t i = 0; i < scene.baseColorTextures.size(); i++) {
-        const auto& texture = scene.baseColorTextures[i];
-        m_imageManager.createImageFromTexture(
-            texture,
-            m_baseColorTextureImages[i].image,
-            m_baseColorTextureImages[i].imageView,
-            m_baseColorTextureImages[i].imageMemory
-            );
-        tdrPreventionCheck();
-    }
+    // Streamed arrays only get their resident tails uploaded here (TextureStreamer), emissive textures keep a
+    // single level and are never streamed
+    if (m_textureStreamer != nullptr) {
+        m_textureStreamer->addTextures(MemoryCategory::TextureBaseColor, scene.baseColorTextures, m_baseColorTextureImages);
+        m_textureStreamer->addTextures(MemoryCategory::TextureMetallicRoughness, scene.metallicRoughnessTextures,
+                                       m_metallicTextureImages);
+        m_textureStreamer->addTextures(MemoryCategory::TextureNormal, scene.normalTextures, m_normalTextureImages);
+        m_textureStreamer->addTextures(MemoryCategory::TextureOcclusion, scene.occlusionTextures, m_occlusionTextureImages);
+    } else {
+        for (std::size_t i = 0; i < scene.baseColorTextures.size(); i++) {
+            const auto& texture = scene.baseColorTextures[i];
+            m_imageManager.createImageFromTexture(
+                MemoryCategory::TextureBaseColor,
+                texture,
+                m_baseColorTextureImages[i].image,
+                m_baseColorTextureImages[i].imageView,
+                m_baseColorTextureImages[i].imageMemory
+                );
+            tdrPreventionCheck();
+        }
 
-    for (std::size_t i = 0; i < scene.metallicRoughnessTextures.size(); i++) {
-        const auto& texture = scene.metallicRoughnessTextures[i];
-        m_imageManager.createImageFromTexture(
-            texture,
-            m_metallicTextureImages[i].image,
-            m_metallicTextureImages[i].imageView,
-            m_metallicTextureImages[i].imageMemory
-            );
-        tdrPreventionCheck();
-    }
+        for (std::size_t i = 0; i < scene.metallicRoughnessTextures.size(); i++) {
+            const auto& texture = scene.metallicRoughnessTextures[i];
+            m_imageManager.createImageFromTexture(
+                MemoryCategory::TextureMetallicRoughness,
+                texture,
+                m_metallicTextureImages[i].image,
+                m_metallicTextureImages[i].imageView,
+                m_metallicTextureImages[i].imageMemory
+                );
+            tdrPreventionCheck();
+        }
 
-    for (std::size_t i = 0; i < scene.normalTextures.size(); i++) {
-        const auto& texture = scene.normalTextures[i];
-        m_imageManager.createImageFromTexture(
-            texture,
-            m_normalTextureImages[i].image,
-            m_normalTextureImages[i].imageView,
-            m_normalTextureImages[i].imageMemory
-            );
-        tdrPreventionCheck();
+        for (std::size_t i = 0; i < scene.normalTextures.size(); i++) {
+            const auto& texture = scene.normalTextures[i];
+            m_imageManager.createImageFromTexture(
+                MemoryCategory::TextureNormal,
+                texture,
+                m_normalTextureImages[i].image,
+                m_normalTextureImages[i].imageView,
+                m_normalTextureImages[i].imageMemory
+                );
+            tdrPreventionCheck();
+        }
+
+        for (std::size_t i = 0; i < scene.occlusionTextures.size(); i++) {
+            const auto& texture = scene.occlusionTextures[i];
+            m_imageManager.createImageFromTexture(
+                MemoryCategory::TextureOcclusion,
+                texture,
+                m_occlusionTextureImages[i].image,
+                m_occlusionTextureImages[i].imageView,
+                m_occlusionTextureImages[i].imageMemory
+                );
+            tdrPreventionCheck();
+        }
     }
 
     if (g_textureConfig.skipEmissiveTextures) {
@@ -636,6 +659,7 @@ void ResourceManager::createTextureImages(const Scene& scene) {
             texture.format = vk::Format::eR8G8B8A8Srgb;
             
             m_imageManager.createImageFromTexture(
+                MemoryCategory::TextureEmissive,
                 texture,
                 m_emissiveTextureImages[i].image,
                 m_emissiveTextureImages[i].imageView,
@@ -646,17 +670,6 @@ void ResourceManager::createTextureImages(const Scene& scene) {
             tdrPreventionCheck();
         }
     }
-
-    for (std::size_t i = 0; i < scene.occlusionTextures.size(); i++) {
-        const auto& texture = scene.occlusionTextures[i];
-        m_imageManager.createImageFromTexture(
-            texture,
-            m_occlusionTextureImages[i].image,
-            m_occlusionTextureImages[i].imageView,
-            m_occlusionTextureImages[i].imageMemory
-            );
-        tdrPreventionCheck();
-    }
 }
 
 void ResourceManager::createSkyboxImage(const Scene& scene) {
@@ -675,6 +688,7 @@ void ResourceManager::createSkyboxImage(const Scene& scene) {
     texture.format = vk::Format::eR8G8B8A8Srgb;
 
     m_imageManager.createImageFromTexture(
+        MemoryCategory::TextureSkybox,
         texture,
         m_skyboxImage.image,
         m_skyboxImage.imageView,
@@ -682,6 +696,268 @@ void ResourceManager::createSkyboxImage(const Scene& scene) {
         );
 }
 
+void ResourceManager::createProbeVolumeImages() {
+    if (m_probeVolume == nullptr) {
+        return;
+    }
+
+    const glm::uvec3 dimensions = m_probeVolume->dimensions();
+    const vk::Extent3D extent{.width = dimensions.x, .height = dimensions.y, .depth = dimensions.z};
+    const vk::DeviceSize channelSize = m_probeVolume->probeCount() * 4 * sizeof(std::uint16_t);
+
+    vk::raii::Buffer stagingBuffer = nullptr;
+    vk::raii::DeviceMemory stagingMemory = nullptr;
+    m_bufferManager.createBuffer(
+        MemoryCategory::Staging,
+        channelSize * m_probeVolumeImages.size(),
+        vk::BufferUsageFlagBits::eTransferSrc,
+        vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent,
+        stagingBuffer,
+        stagingMemory
+        );
+
+    auto* mapped = static_cast<std::uint8_t*>(stagingMemory.mapMemory(0, channelSize * m_probeVolumeImages.size()));
+    std::vector<std::uint16_t> texels;
+    for (std::uint32_t channel = 0; channel < m_probeVolumeImages.size(); channel++) {
+        m_probeVolume->packChannel(channel, texels);
+        memcpy(mapped + channel * channelSize, texels.data(), channelSize);
+
+        m_imageManager.createVolumeImage(
+            MemoryCategory::ProbeVolume,
+            extent,
+            vk::Format::eR16G16B16A16Sfloat,
+            vk::ImageUsageFlagBits::eTransferDst | vk::ImageUsageFlagBits::eSampled,
+            m_probeVolumeImages[channel].image,
+            m_probeVolumeImages[channel].imageMemory
+            );
+    }
+    stagingMemory.unmapMemory();
+
+    m_commandManager.immediateSubmit([&](const vk::CommandBuffer cmd) {
+        std::array<vk::ImageMemoryBarrier2, 3> barriers{};
+        for (std::uint32_t channel = 0; channel < barriers.size(); channel++) {
+            barriers[channel] = vk::ImageMemoryBarrier2{
+                .srcStageMask = vk::PipelineStageFlagBits2::eNone,
+                .srcAccessMask = vk::AccessFlagBits2::eNone,
+                .dstStageMask = vk::PipelineStageFlagBits2::eCopy,
+                .dstAccessMask = vk::AccessFlagBits2::eTransferWrite,
+                .oldLayout = vk::ImageLayout::eUndefined,
+                .newLayout = vk::ImageLayout::eTransferDstOptimal,
+                .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                .image = m_probeVolumeImages[channel].image,
+                .subresourceRange = {
+                    .aspectMask = vk::ImageAspectFlagBits::eColor,
+                    .baseMipLevel = 0,
+                    .levelCount = 1,
+                    .baseArrayLayer = 0,
+                    .layerCount = 1,
+                },
+            };
+        }
+        cmd.pipelineBarrier2(vk::DependencyInfo{
+            .imageMemoryBarrierCount = static_cast<std::uint32_t>(barriers.size()),
+            .pImageMemoryBarriers = barriers.data(),
+        });
+
+        for (std::uint32_t channel = 0; channel < barriers.size(); channel++) {
+            const vk::BufferImageCopy region{
+                .bufferOffset = channel * channelSize,
+                .bufferRowLength = 0,
+                .bufferImageHeight = 0,
+                .imageSubresource = {
+                    .aspectMask = vk::ImageAspectFlagBits::eColor,
+                    .mipLevel = 0,
+                    .baseArrayLayer = 0,
+                    .layerCount = 1,
+                },
+                .imageOffset = {.x = 0, .y = 0, .z = 0},
+                .imageExtent = extent,
+            };
+            cmd.copyBufferToImage(*stagingBuffer, *m_probeVolumeImages[channel].image,
+                                  vk::ImageLayout::eTransferDstOptimal, {region});
+        }
+
+        for (auto& barrier : barriers) {
+            barrier.srcStageMask = vk::PipelineStageFlagBits2::eCopy;
+            barrier.srcAccessMask = vk::AccessFlagBits2::eTransferWrite;
+            barrier.dstStageMask = vk::PipelineStageFlagBits2::eFragmentShader;
+            barrier.dstAccessMask = vk::AccessFlagBits2::eShaderSampledRead;
+            barrier.oldLayout = vk::ImageLayout::eTransferDstOptimal;
+            barrier.newLayout = vk::ImageLayout::eShaderReadOnlyOptimal;
+        }
+        cmd.pipelineBarrier2(vk::DependencyInfo{
+            .imageMemoryBarrierCount = static_cast<std::uint32_t>(barriers.size()),
+            .pImageMemoryBarriers = barriers.data(),
+        });
+    });
+
+    m_vulkanCore.memoryTracker().release(stagingMemory);
+
+    for (auto& probeImage : m_probeVolumeImages) {
+        probeImage.imageView = m_imageManager.createImageView(
+            probeImage.image,
+            vk::Format::eR16G16B16A16Sfloat,
+            vk::ImageAspectFlagBits::eColor,
+            1,
+            vk::ImageViewType::e3D
+            );
+    }
+
+    std::cout << "[Probes] Uploaded " << dimensions.x << "x" << dimensions.y << "x" << dimensions.z
+              << " irradiance probes" << std::endl;
+}
+
+
+void ResourceManager::createTextureTable(const Scene& scene) {
+    m_textureTableSize = 0;
+    m_textureTableCapacity = 0;
+    m_retiredTextureTables.clear();
+
+    // The table starts at TEXTURE_TABLE_INITIAL_CAPACITY; scenes with more textures take the same grow path as
+    // any later registerTexture() call
+    growTextureTable(0);
+
+    registerTextures(m_baseColorTextureImages, m_baseColorTextureSampler, m_textureTableIndices.baseColor);
+    registerTextures(m_metallicTextureImages, m_metallicRoughnessTextureSampler, m_textureTableIndices.metallicRoughness);
+    registerTextures(m_normalTextureImages, m_normalTextureSampler, m_textureTableIndices.normal);
+    registerTextures(m_emissiveTextureImages, m_emissiveTextureSampler, m_textureTableIndices.emissive);
+    registerTextures(m_occlusionTextureImages, m_occlusionTextureSampler, m_textureTableIndices.occlusion);
+
+    // Skipped emissive textures (low VRAM) have no image, materials referencing them fall back to the factor
+    m_textureTableIndices.emissive.resize(scene.emissiveTextures.size(), -1);
+
+    std::cout << "[TextureTable] " << m_textureTableSize << " textures in one bindless table (capacity "
+              << m_textureTableCapacity << ")" << std::endl;
+}
+
+void ResourceManager::growTextureTable(const std::uint32_t minCapacity) {
+    if (minCapacity > TEXTURE_TABLE_MAX_SIZE) {
+        throw std::runtime_error("texture table exceeds TEXTURE_TABLE_MAX_SIZE!");
+    }
+
+    auto capacity = std::max(m_textureTableCapacity, TEXTURE_TABLE_INITIAL_CAPACITY);
+    while (capacity < minCapacity) {
+        capacity *= 2;
+    }
+    capacity = std::min(capacity, TEXTURE_TABLE_MAX_SIZE);
+
+    if (capacity == m_textureTableCapacity && *m_materialDescriptorSet) {
+        return;
+    }
+
+    const std::array poolSizes = {
+        vk::DescriptorPoolSize(vk::DescriptorType::eStorageBuffer, 1),
+        vk::DescriptorPoolSize(vk::DescriptorType::eCombinedImageSampler, capacity + 4), // table + skybox + probes
+    };
+
+    const vk::DescriptorPoolCreateInfo poolInfo{
+        .flags = vk::DescriptorPoolCreateFlagBits::eFreeDescriptorSet |
+                 vk::DescriptorPoolCreateFlagBits::eUpdateAfterBind,
+        .maxSets = 1,
+        .poolSizeCount = static_cast<std::uint32_t>(poolSizes.size()),
+        .pPoolSizes = poolSizes.data(),
+    };
+
+    vk::raii::DescriptorPool pool(m_vulkanCore.device(), poolInfo);
+
+    const vk::DescriptorSetVariableDescriptorCountAllocateInfo variableCountInfo{
+        .descriptorSetCount = 1,
+        .pDescriptorCounts = &capacity,
+    };
+
+    const vk::DescriptorSetLayout layout = *m_materialDescriptorSetLayout;
+    const vk::DescriptorSetAllocateInfo allocInfo{
+        .pNext = &variableCountInfo,
+        .descriptorPool = pool,
+        .descriptorSetCount = 1,
+        .pSetLayouts = &layout,
+    };
+
+    auto sets = m_vulkanCore.device().allocateDescriptorSets(allocInfo);
+    vk::raii::DescriptorSet set = std::move(sets.front());
+
+    if (*m_materialDescriptorSet) {
+        // Carry over the registered textures, then keep the old set alive for the frames still using it
+        if (m_textureTableSize > 0) {
+            const vk::CopyDescriptorSet copy{
+                .srcSet = m_materialDescriptorSet,
+                .srcBinding = DS_TEXTURE_TABLE_BINDING,
+                .srcArrayElement = 0,
+                .dstSet = set,
+                .dstBinding = DS_TEXTURE_TABLE_BINDING,
+                .dstArrayElement = 0,
+                .descriptorCount = m_textureTableSize,
+            };
+            m_vulkanCore.device().updateDescriptorSets({}, copy);
+        }
+
+        m_retiredTextureTables.push_back({
+            .pool = std::move(m_materialDescriptorPool),
+            .set = std::move(m_materialDescriptorSet),
+            .framesLeft = MAX_FRAMES_IN_FLIGHT,
+        });
+    }
+
+    m_materialDescriptorPool = std::move(pool);
+    m_materialDescriptorSet = std::move(set);
+    m_textureTableCapacity = capacity;
+
+    // The material buffer, skybox and probes are not part of the copy; they only exist once the scene is allocated
+    if (*m_materialBuffer) {
+        writeMaterialDescriptorSet();
+    }
+}
+
+void ResourceManager::registerTextures(const std::vector<AllocatedTextureImage>& textureImages,
+                                       const vk::raii::Sampler& sampler,
+                                       std::vector<std::int32_t>& outIndices) {
+    outIndices.clear();
+    outIndices.reserve(textureImages.size());
+
+    for (const auto& textureImage : textureImages) {
+        outIndices.push_back(registerTexture(textureImage.imageView, sampler));
+    }
+}
+
+auto ResourceManager::registerTexture(const vk::raii::ImageView& imageView, const vk::raii::Sampler& sampler)
+    -> std::int32_t {
+    if (m_textureTableSize >= m_textureTableCapacity) {
+        growTextureTable(m_textureTableSize + 1);
+    }
+
+    const auto index = m_textureTableSize;
+
+    const vk::DescriptorImageInfo imageInfo{
+        .sampler = sampler,
+        .imageView = imageView,
+        .imageLayout = vk::ImageLayout::eShaderReadOnlyOptimal
+    };
+
+    const vk::WriteDescriptorSet write{
+        .dstSet = m_materialDescriptorSet,
+        .dstBinding = DS_TEXTURE_TABLE_BINDING,
+        .dstArrayElement = index,
+        .descriptorCount = 1,
+        .descriptorType = vk::DescriptorType::eCombinedImageSampler,
+        .pImageInfo = &imageInfo
+    };
+
+    m_vulkanCore.device().updateDescriptorSets(write, {});
+    m_textureTableSize++;
+
+    return static_cast<std::int32_t>(index);
+}
+
+void ResourceManager::releaseRetiredTextureTables() {
+    for (auto& retired : m_retiredTextureTables) {
+        retired.framesLeft--;
+    }
+
+    std::erase_if(m_retiredTextureTables, [](const RetiredTextureTable& retired) {
+        return retired.framesLeft == 0;
+    });
+}
 
 void ResourceManager::createAccelerationStructures(const Scene& scene) {
     createBLAS(scene);
@@ -821,73 +1097,62 @@ void ResourceManager::createGlobalDescriptorSets(const Scene& scene) {
     }
 }
 
-void ResourceManager::createMaterialDescriptorSets(const Scene& scene) {
-    m_materialDescriptorSets.clear();
-
-    std::vector<vk::DescriptorSetLayout> materialLayouts(MAX_FRAMES_IN_FLIGHT, m_materialDescriptorSetLayout);
-
-    const vk::DescriptorSetAllocateInfo allocInfoMaterial{
-        .descriptorPool = m_descriptorPool,
-        .descriptorSetCount = static_cast<uint32_t>(materialLayouts.size()),
-        .pSetLayouts = materialLayouts.data()
+void ResourceManager::writeMaterialDescriptorSet() {
+    const vk::DescriptorBufferInfo materialsInfo{
+        .buffer = m_materialBuffer,
+        .offset = 0,
+        .range = VK_WHOLE_SIZE,
     };
 
-    m_materialDescriptorSets = m_vulkanCore.device().allocateDescriptorSets(allocInfoMaterial);
-
-    std::vector<vk::DescriptorImageInfo> allImageInfos;
-    allImageInfos.reserve(
-        (scene.baseColorTextures.size() + scene.metallicRoughnessTextures.size() + scene.normalTextures.size() +
-         scene.emissiveTextures.size() + scene.occlusionTextures.size()) * MAX_FRAMES_IN_FLIGHT + MAX_FRAMES_IN_FLIGHT);
-
-    for (std::size_t frameIdx = 0; frameIdx < MAX_FRAMES_IN_FLIGHT; frameIdx++) {
-        const vk::DescriptorBufferInfo materialsInfo{
-            .buffer = m_materialBuffers[frameIdx],
-            .offset = 0,
-            .range = scene.materials.empty() ? VK_WHOLE_SIZE : sizeof(Material) * scene.materials.size(),
-        };
-
-        const vk::WriteDescriptorSet materialsWrite{
-            .dstSet = m_materialDescriptorSets[frameIdx],
+    std::vector<vk::WriteDescriptorSet> descriptorWrites{
+        vk::WriteDescriptorSet{
+            .dstSet = m_materialDescriptorSet,
             .dstBinding = DS_MATERIALS_BINDING,
             .dstArrayElement = 0,
             .descriptorCount = 1,
             .descriptorType = vk::DescriptorType::eStorageBuffer,
             .pBufferInfo = &materialsInfo
-        };
+        },
+    };
 
-        std::vector descriptorWrites{materialsWrite};
-
-        appendTextureWrites(descriptorWrites, allImageInfos, m_materialDescriptorSets[frameIdx],
-                            DS_BASE_COLOR_TEXTURE_BINDING, m_baseColorTextureSampler, m_baseColorTextureImages);
-        appendTextureWrites(descriptorWrites, allImageInfos, m_materialDescriptorSets[frameIdx],
-                            DS_METALLIC_ROUGHNESS_TEXTURE_BINDING, m_metallicRoughnessTextureSampler,
-                            m_metallicTextureImages);
-        appendTextureWrites(descriptorWrites, allImageInfos, m_materialDescriptorSets[frameIdx],
-                            DS_NORMAL_TEXTURE_BINDING, m_normalTextureSampler, m_normalTextureImages);
-        appendTextureWrites(descriptorWrites, allImageInfos, m_materialDescriptorSets[frameIdx],
-                            DS_EMISSIVE_TEXTURE_BINDING, m_emissiveTextureSampler, m_emissiveTextureImages);
-        appendTextureWrites(descriptorWrites, allImageInfos, m_materialDescriptorSets[frameIdx],
-                            DS_OCCLUSION_TEXTURE_BINDING, m_occlusionTextureSampler, m_occlusionTextureImages);
-
-        if (*m_skyboxImage.imageView) {
-            allImageInfos.emplace_back(vk::DescriptorImageInfo{
-                .sampler = m_skyboxSampler,
-                .imageView = m_skyboxImage.imageView,
-                .imageLayout = vk::ImageLayout::eShaderReadOnlyOptimal
-            });
-
-            descriptorWrites.emplace_back(vk::WriteDescriptorSet{
-                .dstSet = m_materialDescriptorSets[frameIdx],
-                .dstBinding = DS_SKYBOX_TEXTURE_BINDING,
-                .dstArrayElement = 0,
-                .descriptorCount = 1,
-                .descriptorType = vk::DescriptorType::eCombinedImageSampler,
-                .pImageInfo = &allImageInfos.back()
-            });
-        }
+    const vk::DescriptorImageInfo skyboxInfo{
+        .sampler = m_skyboxSampler,
+        .imageView = m_skyboxImage.imageView,
+        .imageLayout = vk::ImageLayout::eShaderReadOnlyOptimal
+    };
 
-        m_vulkanCore.device().updateDescriptorSets(descriptorWrites, {});
+    if (*m_skyboxImage.imageView) {
+        descriptorWrites.emplace_back(vk::WriteDescriptorSet{
+            .dstSet = m_materialDescriptorSet,
+            .dstBinding = DS_SKYBOX_TEXTURE_BINDING,
+            .dstArrayElement = 0,
+            .descriptorCount = 1,
+            .descriptorType = vk::DescriptorType::eCombinedImageSampler,
+            .pImageInfo = &skyboxInfo
+        });
+    }
+
+    std::array<vk::DescriptorImageInfo, 3> probeVolumeInfos{};
+    for (std::size_t channel = 0; channel < probeVolumeInfos.size(); channel++) {
+        probeVolumeInfos[channel] = vk::DescriptorImageInfo{
+            .sampler = m_probeVolumeSampler,
+            .imageView = m_probeVolumeImages[channel].imageView,
+            .imageLayout = vk::ImageLayout::eShaderReadOnlyOptimal
+        };
+    }
+
+    if (*m_probeVolumeImages[0].imageView) {
+        descriptorWrites.emplace_back(vk::WriteDescriptorSet{
+            .dstSet = m_materialDescriptorSet,
+            .dstBinding = DS_PROBE_VOLUME_BINDING,
+            .dstArrayElement = 0,
+            .descriptorCount = static_cast<std::uint32_t>(probeVolumeInfos.size()),
+            .descriptorType = vk::DescriptorType::eCombinedImageSampler,
+            .pImageInfo = probeVolumeInfos.data()
+        });
     }
+
+    m_vulkanCore.device().updateDescriptorSets(descriptorWrites, {});
 }
 
 void ResourceManager::createLightingDescriptorSets(const Scene& scene) {
@@ -1004,6 +1269,7 @@ void ResourceManager::createBLAS(const Scene& scene) {
         vk::raii::Buffer scratchBuffer = nullptr;
         vk::raii::DeviceMemory scratchMemory = nullptr;
         m_bufferManager.createBuffer(
+            MemoryCategory::AccelerationScratch,
             blasBuildSizes.buildScratchSize,
             vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eShaderDeviceAddress,
             vk::MemoryPropertyFlagBits::eDeviceLocal,
@@ -1022,6 +1288,7 @@ void ResourceManager::createBLAS(const Scene& scene) {
         m_blasMemories.emplace_back(std::move(blasMemory));
 
         m_bufferManager.createBuffer(
+            MemoryCategory::Blas,
             blasBuildSizes.accelerationStructureSize,
             vk::BufferUsageFlagBits::eAccelerationStructureStorageKHR |
             vk::BufferUsageFlagBits::eShaderDeviceAddress |
@@ -1051,6 +1318,8 @@ void ResourceManager::createBLAS(const Scene& scene) {
         m_commandManager.immediateSubmit([&](const vk::CommandBuffer cmd) {
             cmd.buildAccelerationStructuresKHR({blasBuildGeometryInfo}, {&blasRangeInfo});
         });
+
+        m_vulkanCore.memoryTracker().release(scratchMemory);
     }
 }
 
@@ -1074,38 +1343,16 @@ void ResourceManager::createBLASInstances(const Scene& scene) {
             std::array<float,4>{t[0][2], t[1][2], t[2][2], t[3][2]}
         }};
 
-        // Start with no mask (invisible to all ray types)
-        std::uint32_t mask = 0;
-
-        // Check instance-level properties first
-        bool instanceReflective = instance.reflective != 0;
-        bool instanceCastsShadows = instance.castsShadows != 0;
-
-        // Check material-level properties
-        bool materialReflective = true;
-        bool materialCastsShadows = true;
-
-        if (instance.meshIndex >= 0 && instance.meshIndex < static_cast<std::int32_t>(scene.meshes.size())) {
-            const auto& mesh = scene.meshes[instance.meshIndex];
-            if (mesh.materialIndex >= 0 && mesh.materialIndex < static_cast<std::int32_t>(scene.materials.size())) {
-                const auto& material = scene.materials[mesh.materialIndex];
-                materialReflective = material.reflective != 0;
-                materialCastsShadows = material.castsShadows != 0;
-            }
-        }
-
-        if (instanceReflective || materialReflective) {
-            mask |= AS_REFLECTIVE_OBJECT_MASK;
-        }
-        if (instanceCastsShadows || materialCastsShadows) {
-            mask |= AS_SHADOW_OBJECT_MASK;
-        }
+        // Instances without either ray type stay in the TLAS with mask 0, invisible to every ray
+        const std::uint32_t mask = SceneBvh::instanceMask(scene, instance);
 
         vk::AccelerationStructureInstanceKHR asInstance{
             .transform = transformMatrix,
             .instanceCustomIndex = static_cast<uint32_t>(i),
             .mask = mask,
             .instanceShaderBindingTableRecordOffset = 0,
+            // Ray facing defaults to clockwise, the raster pipelines treat counterclockwise (glTF) as front
+            .flags = static_cast<VkGeometryInstanceFlagsKHR>(vk::GeometryInstanceFlagBitsKHR::eTriangleFrontCounterclockwise),
             .accelerationStructureReference = blasDeviceAddr,
         };
 
@@ -1126,19 +1373,20 @@ void ResourceManager::createBLASInstances(const Scene& scene) {
         vk::raii::Buffer instancesBuffer{nullptr};
         vk::raii::DeviceMemory instancesMemory{nullptr};
 
-        // Host-visible + coherent so we can update instance transforms every frame without staging.
+        // Device-local; changed transforms are staged per frame slot (see updateBlasInstances)
         m_bufferManager.createBuffer(
+            MemoryCategory::Tlas,
             instBufferSize,
             vk::BufferUsageFlagBits::eShaderDeviceAddress |
             vk::BufferUsageFlagBits::eTransferDst |
             vk::BufferUsageFlagBits::eAccelerationStructureBuildInputReadOnlyKHR,
-            vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent,
+            m_stagingRing.getTargetMemoryProperties(),
             instancesBuffer,
             instancesMemory,
             m_blasInstances.data()
         );
 
-        void* mapped = instancesMemory.mapMemory(0, instBufferSize);
+        void* mapped = m_stagingRing.isDirect() ? instancesMemory.mapMemory(0, instBufferSize) : nullptr;
 
         m_blasInstancesBuffers.emplace_back(std::move(instancesBuffer));
         m_blasInstancesMemories.emplace_back(std::move(instancesMemory));
@@ -1198,6 +1446,7 @@ void ResourceManager::createTLAS() {
         vk::raii::Buffer tlasScratchBuffer{nullptr};
         vk::raii::DeviceMemory tlasScratchMemory{nullptr};
         m_bufferManager.createBuffer(
+            MemoryCategory::AccelerationScratch,
             scratchSize,
             vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eShaderDeviceAddress,
             vk::MemoryPropertyFlagBits::eDeviceLocal,
@@ -1212,6 +1461,7 @@ void ResourceManager::createTLAS() {
         vk::raii::Buffer tlasBuffer{nullptr};
         vk::raii::DeviceMemory tlasMemory{nullptr};
         m_bufferManager.createBuffer(
+            MemoryCategory::Tlas,
             tlasBuildSizes.accelerationStructureSize,
             vk::BufferUsageFlagBits::eAccelerationStructureStorageKHR |
             vk::BufferUsageFlagBits::eShaderDeviceAddress |
@@ -1251,14 +1501,16 @@ void ResourceManager::createTLAS() {
 }
 
 void ResourceManager::updateUniformBuffer(const Scene& scene, const float time, const std::uint32_t frameIdx, glm::vec2 jitterOffset) {
+    PROFILE_ZONE("ResourceManager::updateUniformBuffer");
+
     const auto view = scene.camera.getView();
     auto proj = scene.camera.getProjection();
     
     // TAA: Apply jitter to projection matrix
     if constexpr (TAA_ENABLED) {
         // Convert jitter from pixels to NDC
-        const float jitterX = (jitterOffset.x * 2.0f) / static_cast<float>(WINDOW_WIDTH);
-        const float jitterY = (jitterOffset.y * 2.0f) / static_cast<float>(WINDOW_HEIGHT);
+        const float jitterX = (jitterOffset.x * 2.0f) / static_cast<float>(m_renderExtent.width);
+        const float jitterY = (jitterOffset.y * 2.0f) / static_cast<float>(m_renderExtent.height);
         
         // Apply jitter to projection matrix (affects clip space position)
         proj[2][0] += jitterX;
@@ -1287,7 +1539,10 @@ void ResourceManager::updateUniformBuffer(const Scene& scene, const float time,
         .jitterOffset = jitterOffset,
         .fogColor = scene.fog.fogColor,
         .fogDensity = scene.fog.fogDensity,
-        .screenSize = glm::vec2(static_cast<float>(WINDOW_WIDTH), static_cast<float>(WINDOW_HEIGHT)),
+        .screenSize = glm::vec2(static_cast<float>(m_renderExtent.width), static_cast<float>(m_renderExtent.height)),
+        .probeVolumeEnabled = m_probeVolume != nullptr ? 1U : 0U,
+        .probeVolumeScale = m_probeVolume != nullptr ? m_probeVolume->textureScale() : glm::vec3(0.0f),
+        .probeVolumeBias = m_probeVolume != nullptr ? m_probeVolume->textureBias() : glm::vec3(0.0f),
     };
 
     memcpy(m_uniformBuffersMapped[frameIdx], &ubo, sizeof(ubo));
@@ -1299,153 +1554,46 @@ void ResourceManager::updateUniformBuffer(const Scene& scene, const float time,
     m_frameInitialized[frameIdx] = true;
 }
 
-void ResourceManager::updateTopLevelAccelerationStructures(const Scene& scene, bool initialBuild, std::uint32_t frameIdx) {
-    auto primitiveCount = static_cast<uint32_t>(scene.instances.size());
-
-    // Get pointer to persistently mapped buffer for this frame
-    auto* instancesPtr = static_cast<vk::AccelerationStructureInstanceKHR*>(m_blasInstancesBuffersMapped[frameIdx]);
-    
-    // Only update transforms for animated instances
-    std::uint32_t updatedCount = 0;
-    for (std::size_t i = 0; i < primitiveCount; ++i) {
-        const auto& instance = scene.instances[i];
-
-        // Skip static instances unless it's the initial build
-        if (instance.animated == 0 && !initialBuild) {
-            continue;
-        }
-    
-        const auto& t = instance.transform;
-        vk::TransformMatrixKHR transformMatrix{};
-        transformMatrix.matrix = std::array<std::array<float,4>,3>{{
-            std::array<float,4>{t[0][0], t[1][0], t[2][0], t[3][0]},
-            std::array<float,4>{t[0][1], t[1][1], t[2][1], t[3][1]},
-            std::array<float,4>{t[0][2], t[1][2], t[2][2], t[3][2]}
-        }};
-        
-        // Update both the CPU-side cache and GPU-mapped memory directly
-        m_blasInstances[i].setTransform(transformMatrix);
-        instancesPtr[i].transform = transformMatrix;
-        updatedCount++;
-    }
-    
-    // Early exit if nothing was updated and this isn't the initial build
-    if (updatedCount == 0 && !initialBuild) {
-        return;
-    }
-    
-    // No need to map/unmap - memory is persistently mapped and HostCoherent
-    // so writes are automatically visible to the GPU
-
-    vk::BufferDeviceAddressInfo instanceAddrInfo{.buffer = m_blasInstancesBuffers[frameIdx]};
-    vk::DeviceAddress instanceAddr = m_vulkanCore.device().getBufferAddress(instanceAddrInfo);
-
-    auto instancesData = vk::AccelerationStructureGeometryInstancesDataKHR{
-        .arrayOfPointers = false,
-        .data = instanceAddr
-    };
-
-    vk::AccelerationStructureGeometryDataKHR geometryData(instancesData);
-
-    vk::AccelerationStructureGeometryKHR tlasGeometry{
-        .geometryType = vk::GeometryTypeKHR::eInstances,
-        .geometry = geometryData
-    };
-
-    vk::AccelerationStructureBuildGeometryInfoKHR tlasBuildGeometryInfo{
-        .type = vk::AccelerationStructureTypeKHR::eTopLevel,
-        .flags = vk::BuildAccelerationStructureFlagBitsKHR::eAllowUpdate,
-        .mode = vk::BuildAccelerationStructureModeKHR::eUpdate,
-        .srcAccelerationStructure = m_tlasHandles[frameIdx],
-        .dstAccelerationStructure = m_tlasHandles[frameIdx],
-        .geometryCount = 1,
-        .pGeometries = &tlasGeometry
-    };
-
-    vk::BufferDeviceAddressInfo scratchAddressInfo{.buffer = *m_tlasScratchBuffers[frameIdx]};
-    vk::DeviceAddress scratchAddr = m_vulkanCore.device().getBufferAddress(scratchAddressInfo);
-    tlasBuildGeometryInfo.scratchData.deviceAddress = scratchAddr;
-
-    vk::AccelerationStructureBuildRangeInfoKHR tlasRangeInfo{
-        .primitiveCount = primitiveCount,
-        .primitiveOffset = 0,
-        .firstVertex = 0,
-        .transformOffset = 0
-    };
-
-    m_commandManager.immediateSubmit([&](const vk::CommandBuffer cmd) {
-        const vk::MemoryBarrier preBarrier{
-            .srcAccessMask = vk::AccessFlagBits::eAccelerationStructureWriteKHR | vk::AccessFlagBits::eTransferWrite |
-                             vk::AccessFlagBits::eShaderRead,
-            .dstAccessMask = vk::AccessFlagBits::eAccelerationStructureReadKHR |
-                             vk::AccessFlagBits::eAccelerationStructureWriteKHR
-        };
-
-        cmd.pipelineBarrier(
-            vk::PipelineStageFlagBits::eAccelerationStructureBuildKHR | vk::PipelineStageFlagBits::eTransfer |
-            vk::PipelineStageFlagBits::eFragmentShader,
-            vk::PipelineStageFlagBits::eAccelerationStructureBuildKHR,
-            {},
-            preBarrier,
-            {},
-            {}
-            );
-
-        cmd.buildAccelerationStructuresKHR({tlasBuildGeometryInfo}, {&tlasRangeInfo});
-
-        const vk::MemoryBarrier postBarrier{
-            .srcAccessMask = vk::AccessFlagBits::eAccelerationStructureWriteKHR,
-            .dstAccessMask = vk::AccessFlagBits::eAccelerationStructureReadKHR | vk::AccessFlagBits::eShaderRead
-        };
+void ResourceManager::updateBlasInstances(const Scene& scene, const std::uint32_t frameIdx) {
+    PROFILE_ZONE("ResourceManager::updateBlasInstances");
+
+    const vk::Buffer instancesBuffer = *m_blasInstancesBuffers[frameIdx];
+    void* instancesMapped = m_blasInstancesBuffersMapped[frameIdx];
+
+    // Only instances whose transform changed since this frame slot last refitted its TLAS
+    m_tlasUpdatePending[frameIdx] = m_blasInstanceVersions.sync(
+        scene.instanceGenerations, frameIdx, [&](const std::size_t first, const std::size_t count) {
+            for (std::size_t i = first; i < first + count; ++i) {
+                const auto& t = scene.instances[i].transform;
+                vk::TransformMatrixKHR transformMatrix{};
+                transformMatrix.matrix = std::array<std::array<float,4>,3>{{
+                    std::array<float,4>{t[0][0], t[1][0], t[2][0], t[3][0]},
+                    std::array<float,4>{t[0][1], t[1][1], t[2][1], t[3][1]},
+                    std::array<float,4>{t[0][2], t[1][2], t[2][2], t[3][2]}
+                }};
+
+                // Keep the CPU-side cache complete so the run can be staged as whole instances
+                m_blasInstances[i].setTransform(transformMatrix);
+            }
 
-        cmd.pipelineBarrier(
-            vk::PipelineStageFlagBits::eAccelerationStructureBuildKHR,
-            vk::PipelineStageFlagBits::eAccelerationStructureBuildKHR | vk::PipelineStageFlagBits::eFragmentShader,
-            {},
-            postBarrier,
-            {},
-            {}
-            );
-    });
+            const auto size = count * sizeof(vk::AccelerationStructureInstanceKHR);
+            auto* staged = m_stagingRing.stage(instancesBuffer, instancesMapped,
+                                               first * sizeof(vk::AccelerationStructureInstanceKHR), size);
+            memcpy(staged, &m_blasInstances[first], size);
+        });
 }
 
 void ResourceManager::recordTLASUpdate(const vk::CommandBuffer& cmd, const Scene& scene, bool initialBuild, std::uint32_t frameIdx) {
-    auto primitiveCount = static_cast<uint32_t>(scene.instances.size());
+    PROFILE_ZONE("ResourceManager::recordTLASUpdate");
 
-    // Get pointer to persistently mapped buffer
-    auto* instancesPtr = static_cast<vk::AccelerationStructureInstanceKHR*>(m_blasInstancesBuffersMapped[frameIdx]);
-    
-    // Only update transforms for animated instances
-    std::uint32_t updatedCount = 0;
-    for (std::size_t i = 0; i < primitiveCount; ++i) {
-        const auto& instance = scene.instances[i];
+    auto primitiveCount = static_cast<uint32_t>(scene.instances.size());
 
-        // Skip static instances unless it's the initial build
-        if (instance.animated == 0 && !initialBuild) {
-            continue;
-        }
-    
-        const auto& t = instance.transform;
-        vk::TransformMatrixKHR transformMatrix{};
-        transformMatrix.matrix = std::array<std::array<float,4>,3>{{
-            std::array<float,4>{t[0][0], t[1][0], t[2][0], t[3][0]},
-            std::array<float,4>{t[0][1], t[1][1], t[2][1], t[3][1]},
-            std::array<float,4>{t[0][2], t[1][2], t[2][2], t[3][2]}
-        }};
-        
-        // Update both the CPU-side cache and GPU-mapped memory directly
-        m_blasInstances[i].setTransform(transformMatrix);
-        instancesPtr[i].transform = transformMatrix;
-        updatedCount++;
-    }
-    
-    // Early exit if nothing was updated and this isn't the initial build
-    if (updatedCount == 0 && !initialBuild) {
+    // The transforms were staged by updateBlasInstances() and copied by recordUploads() before this point
+    if (!m_tlasUpdatePending[frameIdx] && !initialBuild) {
         return;
     }
-    
-    // Memory is persistently mapped and HostCoherent - writes are visible to GPU
-    
+    m_tlasUpdatePending[frameIdx] = false;
+
     vk::BufferDeviceAddressInfo instanceAddrInfo{.buffer = m_blasInstancesBuffers[frameIdx]};
     vk::DeviceAddress instanceAddr = m_vulkanCore.device().getBufferAddress(instanceAddrInfo);
 
@@ -1502,6 +1650,7 @@ void ResourceManager::recordTLASUpdate(const vk::CommandBuffer& cmd, const Scene
 
     // Build/update the TLAS
     cmd.buildAccelerationStructuresKHR({tlasBuildGeometryInfo}, {&tlasRangeInfo});
+    m_tlasUpdateCount++;
 
     // Post-build barrier: Make TLAS available for shader reads
     const vk::MemoryBarrier postBarrier{
@@ -1520,76 +1669,142 @@ void ResourceManager::recordTLASUpdate(const vk::CommandBuffer& cmd, const Scene
 }
 
 void ResourceManager::updateInstanceBuffers(const Scene& scene, const std::uint32_t frameIdx) {
-    if (scene.instances.empty()) {
-        return;
-    }
-    
-    // On first frame (or when frameIdx wraps), copy all instances
-    static bool initialCopyDone[MAX_FRAMES_IN_FLIGHT] = {false};
-    
-    if (!initialCopyDone[frameIdx]) {
-        memcpy(m_instanceBuffersMapped[frameIdx], scene.instances.data(), sizeof(Instance) * scene.instances.size());
-        initialCopyDone[frameIdx] = true;
-        return;
-    }
-    
-    // For subsequent frames, only update animated instances
-    auto* bufferPtr = static_cast<Instance*>(m_instanceBuffersMapped[frameIdx]);
-    std::uint32_t updatedCount = 0;
-    
-    for (std::size_t i = 0; i < scene.instances.size(); ++i) {
-        if (scene.instances[i].animated != 0) {
-            bufferPtr[i] = scene.instances[i];
-            updatedCount++;
-        }
-    }
+    PROFILE_ZONE("ResourceManager::updateInstanceBuffers");
+
+    const vk::Buffer instanceBuffer = *m_instanceBuffers[frameIdx];
+    void* instanceMapped = m_instanceBuffersMapped[frameIdx];
+
+    // Runs of instances changed since this frame slot's last upload, each one a single staged range.
+    // The animated instances are contiguous (Scene::firstDynamicInstance), so this is usually one memcpy
+    m_instanceVersions.sync(scene.instanceGenerations, frameIdx, [&](const std::size_t first, const std::size_t count) {
+        const auto size = count * sizeof(Instance);
+        memcpy(m_stagingRing.stage(instanceBuffer, instanceMapped, first * sizeof(Instance), size),
+               &scene.instances[first], size);
+    });
 }
 
-void ResourceManager::updateMaterialBuffers(const Scene& scene, const std::uint32_t frameIdx) {
-    if (!scene.materials.empty()) {
-        memcpy(m_materialBuffersMapped[frameIdx], scene.materials.data(), sizeof(Material) * scene.materials.size());
+void ResourceManager::remapMaterialTextures(const Scene& scene) {
+    const auto remap = [](const std::vector<std::int32_t>& tableIndices, const std::int32_t texIndex) {
+        if (texIndex < 0 || texIndex >= static_cast<std::int32_t>(tableIndices.size())) {
+            return -1;
+        }
+        return tableIndices[texIndex];
+    };
+
+    m_gpuMaterials = scene.materials;
+    for (auto& material : m_gpuMaterials) {
+        material.baseColorTexIndex = remap(m_textureTableIndices.baseColor, material.baseColorTexIndex);
+        material.metallicRoughnessTexIndex = remap(m_textureTableIndices.metallicRoughness,
+                                                   material.metallicRoughnessTexIndex);
+        material.normalTexIndex = remap(m_textureTableIndices.normal, material.normalTexIndex);
+        material.emissiveTexIndex = remap(m_textureTableIndices.emissive, material.emissiveTexIndex);
+        material.occlusionTexIndex = remap(m_textureTableIndices.occlusion, material.occlusionTexIndex);
     }
 }
 
 void ResourceManager::updateLightBuffers(const Scene& scene, const std::uint32_t frameIdx) {
-    static bool initialCopyDone[MAX_FRAMES_IN_FLIGHT] = {false};
-    
-    if (!initialCopyDone[frameIdx]) {
-        if (!scene.pointLights.empty()) {
-            memcpy(m_pointLightBuffersMapped[frameIdx], scene.pointLights.data(),
-                   sizeof(PointLight) * scene.pointLights.size());
+    PROFILE_ZONE("ResourceManager::updateLightBuffers");
+
+    const vk::Buffer pointLightBuffer = *m_pointLightBuffers[frameIdx];
+    const vk::Buffer spotLightBuffer = *m_spotLightBuffers[frameIdx];
+    void* pointLightMapped = m_pointLightBuffersMapped[frameIdx];
+    void* spotLightMapped = m_spotLightBuffersMapped[frameIdx];
+
+    m_pointLightVersions.sync(scene.pointLightGenerations, frameIdx, [&](const std::size_t first, const std::size_t count) {
+        const auto size = count * sizeof(PointLight);
+        memcpy(m_stagingRing.stage(pointLightBuffer, pointLightMapped, first * sizeof(PointLight), size),
+               &scene.pointLights[first], size);
+    });
+
+    m_spotLightVersions.sync(scene.spotLightGenerations, frameIdx, [&](const std::size_t first, const std::size_t count) {
+        const auto size = count * sizeof(SpotLight);
+        memcpy(m_stagingRing.stage(spotLightBuffer, spotLightMapped, first * sizeof(SpotLight), size),
+               &scene.spotLights[first], size);
+    });
+}
+void ResourceManager::assignMaterialPipelines(const Scene& scene) {
+    const auto materialCount = scene.materials.size();
+
+    m_materialPipelineKeys.clear();
+    m_materialPipelineIndices.assign(materialCount, 0);
+
+    // Instances drawn with each material decide which permutations earn a pipeline of their own
+    std::vector<std::uint32_t> materialUsage(materialCount, 0);
+    for (const auto& instance : scene.instances) {
+        if (instance.meshIndex < 0 || instance.meshIndex >= static_cast<std::int32_t>(scene.meshes.size())) {
+            continue;
         }
-        if (!scene.spotLights.empty()) {
-            memcpy(m_spotLightBuffersMapped[frameIdx], scene.spotLights.data(),
-                   sizeof(SpotLight) * scene.spotLights.size());
+        const std::int32_t matIdx = scene.meshes[instance.meshIndex].materialIndex;
+        if (matIdx >= 0 && matIdx < static_cast<std::int32_t>(materialCount)) {
+            materialUsage[matIdx]++;
         }
-        initialCopyDone[frameIdx] = true;
-        return;
     }
-    
-    // For subsequent frames, only update animated lights
-    std::uint32_t pointLightsUpdated = 0;
-    std::uint32_t spotLightsUpdated = 0;
-    
-    if (!scene.pointLights.empty()) {
-        auto* bufferPtr = static_cast<PointLight*>(m_pointLightBuffersMapped[frameIdx]);
-        for (std::size_t i = 0; i < scene.pointLights.size(); ++i) {
-            if (scene.pointLights[i].animated != 0) {
-                bufferPtr[i] = scene.pointLights[i];
-                pointLightsUpdated++;
-            }
+
+    struct Candidate {
+        MaterialPipelineKey key;
+        std::uint32_t usage;
+    };
+    std::vector<Candidate> candidates;
+
+    const auto keyOf = [](const Material& material) -> MaterialPipelineKey {
+        return {
+            .permutation = MATERIAL_PERMUTATIONS_ENABLED ? getMaterialPermutation(material)
+                                                         : MATERIAL_PERMUTATION_DYNAMIC,
+            .transparent = material.alphaMode == 1,
+        };
+    };
+
+    for (std::size_t matIdx = 0; matIdx < materialCount; matIdx++) {
+        if (materialUsage[matIdx] == 0) {
+            continue;
+        }
+        const auto key = keyOf(m_gpuMaterials[matIdx]);
+        const auto it = std::ranges::find(candidates, key, &Candidate::key);
+        if (it != candidates.end()) {
+            it->usage += materialUsage[matIdx];
+        } else {
+            candidates.push_back({.key = key, .usage = materialUsage[matIdx]});
         }
     }
-    
-    if (!scene.spotLights.empty()) {
-        auto* bufferPtr = static_cast<SpotLight*>(m_spotLightBuffersMapped[frameIdx]);
-        for (std::size_t i = 0; i < scene.spotLights.size(); ++i) {
-            if (scene.spotLights[i].animated != 0) {
-                bufferPtr[i] = scene.spotLights[i];
-                spotLightsUpdated++;
+
+    // Keep the most used permutations, everything else shares the generic pipeline of its blend mode
+    std::ranges::stable_sort(candidates, std::ranges::greater{}, &Candidate::usage);
+    std::uint32_t uberMaterials = 0;
+    for (std::size_t i = 0; i < candidates.size(); i++) {
+        if (i >= MAX_MATERIAL_PIPELINES) {
+            candidates[i].key.permutation = MATERIAL_PERMUTATION_DYNAMIC;
+        }
+        if (std::ranges::find(m_materialPipelineKeys, candidates[i].key) == m_materialPipelineKeys.end()) {
+            m_materialPipelineKeys.push_back(candidates[i].key);
+        }
+    }
+
+    // Opaque pipelines first so the draw ranges come out in render order
+    std::ranges::sort(m_materialPipelineKeys, [](const MaterialPipelineKey& a, const MaterialPipelineKey& b) {
+        return a.transparent != b.transparent ? !a.transparent : a.permutation < b.permutation;
+    });
+
+    for (std::size_t matIdx = 0; matIdx < materialCount; matIdx++) {
+        auto key = keyOf(m_gpuMaterials[matIdx]);
+        auto it = std::ranges::find(m_materialPipelineKeys, key);
+        if (it == m_materialPipelineKeys.end()) {
+            // Unused material or a permutation that did not make the cut
+            key.permutation = MATERIAL_PERMUTATION_DYNAMIC;
+            it = std::ranges::find(m_materialPipelineKeys, key);
+            if (materialUsage[matIdx] > 0) {
+                uberMaterials++;
             }
         }
+        m_materialPipelineIndices[matIdx] =
+            it != m_materialPipelineKeys.end() ? static_cast<std::uint32_t>(it - m_materialPipelineKeys.begin()) : 0;
     }
+
+    std::cout << "[Materials] " << m_materialPipelineKeys.size() << " material pipelines for " << materialCount
+              << " materials";
+    if (uberMaterials > 0) {
+        std::cout << " (" << uberMaterials << " on the generic shader)";
+    }
+    std::cout << std::endl;
 }
 
 void ResourceManager::createIndirectDrawBuffers(const Scene& scene) {
@@ -1599,9 +1814,10 @@ void ResourceManager::createIndirectDrawBuffers(const Scene& scene) {
 
     // Allocate for one draw command per instance (worst case)
     // This ensures we have enough space even if all instances use different meshes
-    m_indirectDrawCount = static_cast<std::uint32_t>(scene.instances.size());
+    m_indirectDrawCapacity = static_cast<std::uint32_t>(scene.instances.size());
+    m_indirectDrawCount = m_indirectDrawCapacity;
 
-    const vk::DeviceSize bufferSize = sizeof(DrawIndexedIndirectCommand) * m_indirectDrawCount;
+    const vk::DeviceSize bufferSize = sizeof(DrawIndexedIndirectCommand) * m_indirectDrawCapacity;
 
     for (std::size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
         vk::raii::Buffer indirectDrawBuffer{nullptr};
@@ -1609,36 +1825,55 @@ void ResourceManager::createIndirectDrawBuffers(const Scene& scene) {
         void* indirectDrawBufferMapped = nullptr;
 
         m_bufferManager.createBuffer(
+            MemoryCategory::PerFrame,
             bufferSize,
             vk::BufferUsageFlagBits::eIndirectBuffer | vk::BufferUsageFlagBits::eTransferDst,
-            vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent,
+            m_stagingRing.getTargetMemoryProperties(),
             indirectDrawBuffer,
             indirectDrawBufferMemory,
             nullptr
         );
 
-        indirectDrawBufferMapped = indirectDrawBufferMemory.mapMemory(0, bufferSize);
+        if (m_stagingRing.isDirect()) {
+            indirectDrawBufferMapped = indirectDrawBufferMemory.mapMemory(0, bufferSize);
+        }
 
         m_indirectDrawBuffers.push_back(std::move(indirectDrawBuffer));
         m_indirectDrawBuffersMemory.push_back(std::move(indirectDrawBufferMemory));
         m_indirectDrawBuffersMapped.push_back(indirectDrawBufferMapped);
     }
 
-    for (std::uint32_t frameIdx = 0; frameIdx < MAX_FRAMES_IN_FLIGHT; frameIdx++) {
-        updateIndirectDrawBuffers(scene, frameIdx);
+    assignMaterialPipelines(scene);
+
+    m_visibleDraws.reserve(m_indirectDrawCapacity);
+    m_visibleDrawPipelines.reserve(m_indirectDrawCapacity);
+    m_staticVisibleDraws.reserve(m_indirectDrawCapacity);
+    m_staticVisibleDrawPipelines.reserve(m_indirectDrawCapacity);
+    m_staticCullValid = false;
+    m_pipelineDrawCounts.reserve(m_materialPipelineKeys.size());
+    m_drawRanges.assign(MAX_FRAMES_IN_FLIGHT, {});
+    for (auto& ranges : m_drawRanges) {
+        ranges.reserve(m_materialPipelineKeys.size());
     }
+
+    // The draw commands are built (and staged) by the first updateSceneResources() of each frame slot
 }
 
-void ResourceManager::updateIndirectDrawBuffers(const Scene& scene, const std::uint32_t frameIdx) {
-    if (m_indirectDrawBuffersMapped.empty() || m_indirectDrawCount == 0) {
+void ResourceManager::updateIndirectDrawBuffers(const Scene& scene, const float time, const std::uint32_t frameIdx) {
+    PROFILE_ZONE("ResourceManager::updateIndirectDrawBuffers");
+
+    if (m_indirectDrawBuffers.empty() || m_indirectDrawCapacity == 0) {
         return;
     }
     
     // Get current camera view-projection
     const glm::mat4 currentViewProj = scene.camera.getViewProjection();
     
+    // A new PVS segment changes the static candidates like a camera move does
+    const std::uint32_t pvsSegment = m_pvs != nullptr ? m_pvs->segmentAt(time) : NO_PVS_SEGMENT;
+
     // Check if camera has moved significantly (use epsilon to avoid tiny movements)
-    bool cameraChanged = !m_indirectDrawBuffersInitialized[frameIdx];
+    bool cameraChanged = !m_indirectDrawBuffersInitialized[frameIdx] || pvsSegment != m_cachedPvsSegments[frameIdx];
     if (!cameraChanged) {
         // Check if any matrix element changed by more than threshold
         constexpr float CAMERA_CHANGE_THRESHOLD = 0.01f;
@@ -1653,213 +1888,107 @@ void ResourceManager::updateIndirectDrawBuffers(const Scene& scene, const std::u
         }
     }
     
-    // Cache scene data pointers to reduce pointer chasing
-    const Instance* instances = scene.instances.data();
-    const Mesh* meshes = scene.meshes.data();
-    const Material* materials = scene.materials.data();
-    const std::uint32_t instanceCount = static_cast<std::uint32_t>(scene.instances.size());
-    const std::uint32_t meshCount = static_cast<std::uint32_t>(scene.meshes.size());
-    const std::uint32_t materialCount = static_cast<std::uint32_t>(scene.materials.size());
-
-    // Get frustum for culling (only if camera changed)
-    Frustum frustum;
-    if (cameraChanged) {
-        frustum = scene.camera.getFrustum();
-    }
-
-    // Write directly to mapped buffer - NO intermediate vectors
-    auto* bufferPtr = static_cast<DrawIndexedIndirectCommand*>(m_indirectDrawBuffersMapped[frameIdx]);
-    
     if (cameraChanged) {
         // FULL REBUILD: Camera moved or first frame - rebuild entire buffer
-        std::uint32_t opaqueCount = 0;
-        std::uint32_t transparentCount = 0;
-        
-        const std::uint32_t maxTransparent = std::min(instanceCount, 500u);
-        std::vector<DrawIndexedIndirectCommand> tempTransparent;
-        tempTransparent.reserve(maxTransparent);
-            
-        const auto& planes = frustum.planes;
-
-        // Process all instances
-        for (std::uint32_t instanceIdx = 0; instanceIdx < instanceCount; instanceIdx++) {
-            const auto& instance = instances[instanceIdx];
-            
-            const std::int32_t meshIdx = instance.meshIndex;
-            if (meshIdx < 0 || meshIdx >= static_cast<std::int32_t>(meshCount)) {
-                continue;
-            }
-            
-            const auto& mesh = meshes[meshIdx];
-            const std::int32_t matIdx = mesh.materialIndex;
-            
-            if (matIdx < 0 || matIdx >= static_cast<std::int32_t>(materialCount)) {
-                continue;
-            }
-            
-            // Frustum culling
-            const glm::vec3 localCenter = (mesh.boundingBoxMin + mesh.boundingBoxMax) * 0.5f;
-            const glm::vec3 boxExtents = mesh.boundingBoxMax - mesh.boundingBoxMin;
-            const float localRadius = glm::length(boxExtents) * 0.5f;
-            const glm::vec3 worldCenter = glm::vec3(instance.transform * glm::vec4(localCenter, 1.0f));
-            
-            const glm::vec3 col0 = instance.transform[0];
-            const glm::vec3 col1 = instance.transform[1];
-            const glm::vec3 col2 = instance.transform[2];
-            const float scale0Sq = glm::dot(col0, col0);
-            const float scale1Sq = glm::dot(col1, col1);
-            const float scale2Sq = glm::dot(col2, col2);
-            const float maxScaleSq = glm::max(scale0Sq, glm::max(scale1Sq, scale2Sq));
-            const float worldRadius = localRadius * std::sqrt(maxScaleSq);
-            
-            bool visible = true;
-            for (int i = 0; i < 5; ++i) {
-                const float dist = glm::dot(planes[i].normal, worldCenter) + planes[i].distance;
-                if (dist < -worldRadius) {
-                    visible = false;
-                    break;
-                }
-            }
-            
-            if (!visible) {
-                continue;
-            }
-            
-            const DrawIndexedIndirectCommand cmd{
-                .indexCount = mesh.indexCount,
-                .instanceCount = 1,
-                .firstIndex = mesh.baseIndex,
-                .vertexOffset = static_cast<std::int32_t>(mesh.baseVertex),
-                .firstInstance = instanceIdx
-            };
-            
-            if (materials[matIdx].alphaMode == 1) {
-                if (transparentCount < maxTransparent) {
-                    tempTransparent.push_back(cmd);
-                    transparentCount++;
-                }
-            } else {
-                bufferPtr[opaqueCount++] = cmd;
-            }
-        }
-        
-        // Copy transparent commands after opaque
-        if (transparentCount > 0) {
-            std::memcpy(bufferPtr + opaqueCount, tempTransparent.data(), 
-                       transparentCount * sizeof(DrawIndexedIndirectCommand));
-        }
+        rebuildIndirectDrawCommands(scene, currentViewProj, pvsSegment, frameIdx);
 
-        m_opaqueDrawCount = opaqueCount;
-        m_transparentDrawCount = transparentCount;
-        m_indirectDrawCount = m_opaqueDrawCount + m_transparentDrawCount;
-        
         // Update cache
         m_cachedCameraViewProj[frameIdx] = currentViewProj;
+        m_cachedPvsSegments[frameIdx] = pvsSegment;
         m_indirectDrawBuffersInitialized[frameIdx] = true;
-        
-    } else {
-        // PARTIAL UPDATE: Camera hasn't moved - only update animated instances
-        // This is a simplified optimization - we rebuild only animated objects
-        // A more complex approach would be to track and update individual commands,
-        // but that requires maintaining a mapping structure
-        
-        // For now, we check if there are any animated instances
-        bool hasAnimated = false;
-        for (std::uint32_t instanceIdx = 0; instanceIdx < instanceCount; instanceIdx++) {
-            if (instances[instanceIdx].animated != 0) {
-                hasAnimated = true;
-                break;
+        m_indirectDrawVersions.markSynced(scene.instanceGenerations, frameIdx);
+        return;
+    }
+
+    // Camera hasn't moved - visibility can only change if an instance moved since this slot's last rebuild.
+    // A static frame skips the update entirely
+    if (m_indirectDrawVersions.isStale(scene.instanceGenerations, frameIdx)) {
+        rebuildIndirectDrawCommands(scene, currentViewProj, pvsSegment, frameIdx);
+        m_indirectDrawVersions.markSynced(scene.instanceGenerations, frameIdx);
+    }
+}
+
+void ResourceManager::rebuildIndirectDrawCommands(const Scene& scene,
+                                                  const glm::mat4& viewProj,
+                                                  const std::uint32_t pvsSegment,
+                                                  const std::uint32_t frameIdx) {
+    const std::uint32_t instanceCount = static_cast<std::uint32_t>(scene.instances.size());
+    const std::uint32_t firstDynamic = std::min(scene.firstDynamicInstance, instanceCount);
+    const std::uint32_t maxTransparent = std::min(instanceCount, 500u);
+    const Frustum frustum = Frustum::fromViewProjection(viewProj);
+
+    // Static instances only change visibility with the camera, their culling result is reused until it moves
+    if (!m_staticCullValid || viewProj != m_staticCullViewProj || pvsSegment != m_staticCullPvsSegment) {
+        m_staticVisibleDraws.clear();
+        m_staticVisibleDrawPipelines.clear();
+        m_staticTransparentCount = 0;
+        if (pvsSegment != NO_PVS_SEGMENT) {
+            // Only what some camera sample of this stretch of the path could see
+            if (pvsSegment != m_pvsDecodedSegment) {
+                m_pvs->decodeSegment(pvsSegment, m_pvsInstances);
+                m_pvsDecodedSegment = pvsSegment;
             }
+            cullInstances(scene, frustum, m_pvsInstances, m_materialPipelineIndices, maxTransparent,
+                          m_staticTransparentCount, m_staticVisibleDraws, m_staticVisibleDrawPipelines);
+        } else {
+            cullInstances(scene, frustum, 0, firstDynamic, m_materialPipelineIndices, maxTransparent,
+                          m_staticTransparentCount, m_staticVisibleDraws, m_staticVisibleDrawPipelines);
         }
-        
-        // If we have animated instances, we need to rebuild (because their positions changed)
-        // This could be further optimized by only updating their specific draw commands,
-        // but that's more complex and requires tracking which buffer positions they occupy
-        if (hasAnimated) {
-            // For simplicity, do a full rebuild if any animated objects exist
-            // This is still better than the original, because we skip this entirely
-            // when nothing is animated and camera hasn't moved
-            frustum = scene.camera.getFrustum();
-            const auto& planes = frustum.planes;
-            
-            std::uint32_t opaqueCount = 0;
-            std::uint32_t transparentCount = 0;
-            
-            const std::uint32_t maxTransparent = std::min(instanceCount, 500u);
-            std::vector<DrawIndexedIndirectCommand> tempTransparent;
-            tempTransparent.reserve(maxTransparent);
-
-            for (std::uint32_t instanceIdx = 0; instanceIdx < instanceCount; instanceIdx++) {
-                const auto& instance = instances[instanceIdx];
-                
-                const std::int32_t meshIdx = instance.meshIndex;
-                if (meshIdx < 0 || meshIdx >= static_cast<std::int32_t>(meshCount)) {
-                    continue;
-                }
-                
-                const auto& mesh = meshes[meshIdx];
-                const std::int32_t matIdx = mesh.materialIndex;
-                
-                if (matIdx < 0 || matIdx >= static_cast<std::int32_t>(materialCount)) {
-                    continue;
-                }
-                
-                // Frustum culling
-                const glm::vec3 localCenter = (mesh.boundingBoxMin + mesh.boundingBoxMax) * 0.5f;
-                const glm::vec3 boxExtents = mesh.boundingBoxMax - mesh.boundingBoxMin;
-                const float localRadius = glm::length(boxExtents) * 0.5f;
-                const glm::vec3 worldCenter = glm::vec3(instance.transform * glm::vec4(localCenter, 1.0f));
-                
-                const glm::vec3 col0 = instance.transform[0];
-                const glm::vec3 col1 = instance.transform[1];
-                const glm::vec3 col2 = instance.transform[2];
-                const float scale0Sq = glm::dot(col0, col0);
-                const float scale1Sq = glm::dot(col1, col1);
-                const float scale2Sq = glm::dot(col2, col2);
-                const float maxScaleSq = glm::max(scale0Sq, glm::max(scale1Sq, scale2Sq));
-                const float worldRadius = localRadius * std::sqrt(maxScaleSq);
-                
-                bool visible = true;
-                for (int i = 0; i < 5; ++i) {
-                    const float dist = glm::dot(planes[i].normal, worldCenter) + planes[i].distance;
-                    if (dist < -worldRadius) {
-                        visible = false;
-                        break;
-                    }
-                }
-                
-                if (!visible) {
-                    continue;
-                }
-                
-                const DrawIndexedIndirectCommand cmd{
-                    .indexCount = mesh.indexCount,
-                    .instanceCount = 1,
-                    .firstIndex = mesh.baseIndex,
-                    .vertexOffset = static_cast<std::int32_t>(mesh.baseVertex),
-                    .firstInstance = instanceIdx
-                };
-                
-                if (materials[matIdx].alphaMode == 1) {
-                    if (transparentCount < maxTransparent) {
-                        tempTransparent.push_back(cmd);
-                        transparentCount++;
-                    }
-                } else {
-                    bufferPtr[opaqueCount++] = cmd;
-                }
-            }
-            
-            if (transparentCount > 0) {
-                std::memcpy(bufferPtr + opaqueCount, tempTransparent.data(), 
-                           transparentCount * sizeof(DrawIndexedIndirectCommand));
-            }
+        m_staticCullViewProj = viewProj;
+        m_staticCullPvsSegment = pvsSegment;
+        m_staticCullValid = true;
+    }
+
+    // The animated instances are one contiguous range at the end
+    m_visibleDraws.assign(m_staticVisibleDraws.begin(), m_staticVisibleDraws.end());
+    m_visibleDrawPipelines.assign(m_staticVisibleDrawPipelines.begin(), m_staticVisibleDrawPipelines.end());
+    std::uint32_t transparentCount = m_staticTransparentCount;
+    cullInstances(scene, frustum, firstDynamic, instanceCount, m_materialPipelineIndices, maxTransparent,
+                  transparentCount, m_visibleDraws, m_visibleDrawPipelines);
+
+    // Counting sort by material pipeline. The keys are ordered opaque first, so the
+    // transparent commands still end up after all opaque ones.
+    m_pipelineDrawCounts.assign(m_materialPipelineKeys.size(), 0);
+    for (const auto pipelineIdx : m_visibleDrawPipelines) {
+        m_pipelineDrawCounts[pipelineIdx]++;
+    }
 
-            m_opaqueDrawCount = opaqueCount;
-            m_transparentDrawCount = transparentCount;
-            m_indirectDrawCount = m_opaqueDrawCount + m_transparentDrawCount;
+    auto& ranges = m_drawRanges[frameIdx];
+    ranges.clear();
+
+    std::uint32_t firstCommand = 0;
+    std::uint32_t opaqueCount = 0;
+    for (std::uint32_t pipelineIdx = 0; pipelineIdx < m_pipelineDrawCounts.size(); pipelineIdx++) {
+        const std::uint32_t count = m_pipelineDrawCounts[pipelineIdx];
+        if (count > 0) {
+            ranges.push_back({.pipelineIndex = pipelineIdx, .firstCommand = firstCommand, .commandCount = count});
+        }
+        if (!m_materialPipelineKeys[pipelineIdx].transparent) {
+            opaqueCount += count;
         }
-        // If no animated instances, we skip the update entirely - huge win!
+        // From here on the count slot is the write cursor of this range
+        m_pipelineDrawCounts[pipelineIdx] = firstCommand;
+        firstCommand += count;
     }
-    
+
+    // Scatter straight into the staged range (or the mapped buffer on ReBAR/UMA)
+    if (!m_visibleDraws.empty()) {
+        auto* bufferPtr = static_cast<DrawIndexedIndirectCommand*>(m_stagingRing.stage(
+            *m_indirectDrawBuffers[frameIdx], m_indirectDrawBuffersMapped[frameIdx], 0,
+            sizeof(DrawIndexedIndirectCommand) * m_visibleDraws.size()));
+        for (std::size_t i = 0; i < m_visibleDraws.size(); i++) {
+            bufferPtr[m_pipelineDrawCounts[m_visibleDrawPipelines[i]]++] = m_visibleDraws[i];
+        }
+    }
+
+    std::uint64_t triangles = 0;
+    for (const auto& draw : m_visibleDraws) {
+        triangles += static_cast<std::uint64_t>(draw.indexCount / 3) * draw.instanceCount;
+    }
+
+    m_opaqueDrawCount = opaqueCount;
+    m_transparentDrawCount = transparentCount;
+    m_indirectDrawCount = m_opaqueDrawCount + m_transparentDrawCount;
+    m_drawCallCount = static_cast<std::uint32_t>(ranges.size());
+    m_visibleTriangleCount = triangles;
 }
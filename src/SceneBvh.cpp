@@ -0,0 +1,535 @@
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+#include "SceneBvh.hpp"
+#include "CpuProfiler.hpp"
+#include "JobSystem.hpp"
+#include "constants.hpp"
+
+namespace {
+constexpr float INF = std::numeric_limits<float>::infinity();
+
+// Below this depth ranges are halved instead of SAH split, which bounds the tree at this plus log2 of the
+// primitive count (32) levels
+constexpr std::uint32_t MAX_SAH_DEPTH = 48;
+
+// Deep enough for any tree the builder makes: every level pushes at most three siblings
+constexpr std::size_t TRAVERSAL_STACK_SIZE = 3 * (MAX_SAH_DEPTH + 32) + 1;
+
+struct Bounds {
+    glm::vec3 min{INF};
+    glm::vec3 max{-INF};
+
+    void grow(const glm::vec3& point) {
+        min = glm::min(min, point);
+        max = glm::max(max, point);
+    }
+
+    void grow(const Bounds& other) {
+        min = glm::min(min, other.min);
+        max = glm::max(max, other.max);
+    }
+
+    [[nodiscard]] auto empty() const -> bool { return min.x > max.x; }
+
+    [[nodiscard]] auto area() const -> float {
+        if (empty()) {
+            return 0.0f;
+        }
+        const glm::vec3 extent = max - min;
+        return extent.x * extent.y + extent.y * extent.z + extent.z * extent.x;
+    }
+};
+
+struct BinaryNode {
+    Bounds bounds;
+    std::uint32_t left = 0;   // Inner: children, leaf: range of the primitive order
+    std::uint32_t right = 0;
+    std::uint32_t first = 0;
+    std::uint32_t count = 0;  // > 0 for leaves
+};
+
+class BvhBuilder {
+public:
+    BvhBuilder(std::span<const Bounds> primitives, std::vector<std::uint32_t>& order)
+        : m_primitives(primitives), m_order(order) {
+        m_centroids.reserve(primitives.size());
+        for (const auto& bounds : primitives) {
+            m_centroids.push_back((bounds.min + bounds.max) * 0.5f);
+        }
+        m_order.resize(primitives.size());
+        std::iota(m_order.begin(), m_order.end(), 0U);
+    }
+
+    // Binary SAH tree collapsed into 4-wide nodes, m_order holds the primitives in leaf order
+    auto build() -> std::vector<SceneBvh::WideNode> {
+        std::vector<SceneBvh::WideNode> wide;
+        if (m_primitives.empty()) {
+            return wide;
+        }
+
+        m_nodes.reserve(2 * m_primitives.size() / BVH_MAX_LEAF_SIZE + 1);
+        buildBinary(0, static_cast<std::uint32_t>(m_primitives.size()), 0);
+
+        wide.reserve(m_nodes.size() / 2 + 1);
+        wide.emplace_back();
+        if (m_nodes[0].count > 0) {
+            fillWide(wide, 0, {0U, 0U, 0U, 0U}, 1);
+        } else {
+            collapse(wide, 0, 0);
+        }
+        return wide;
+    }
+
+private:
+    std::span<const Bounds> m_primitives;
+    std::vector<std::uint32_t>& m_order;
+    std::vector<glm::vec3> m_centroids;
+    std::vector<BinaryNode> m_nodes;
+
+    auto buildBinary(const std::uint32_t first, const std::uint32_t count, const std::uint32_t depth) -> std::uint32_t {
+        const auto index = static_cast<std::uint32_t>(m_nodes.size());
+        m_nodes.emplace_back();
+
+        Bounds bounds;
+        Bounds centroidBounds;
+        for (std::uint32_t i = first; i < first + count; i++) {
+            bounds.grow(m_primitives[m_order[i]]);
+            centroidBounds.grow(m_centroids[m_order[i]]);
+        }
+        m_nodes[index].bounds = bounds;
+
+        std::uint32_t split = count > 1 && depth < MAX_SAH_DEPTH ? findSplit(first, count, bounds, centroidBounds) : 0;
+        if (split == 0 && count <= BVH_MAX_LEAF_SIZE) {
+            m_nodes[index].first = first;
+            m_nodes[index].count = count;
+            return index;
+        }
+
+        // Coincident centroids cannot be binned (and deep ranges are not), halve the range instead
+        if (split == 0) {
+            split = count / 2;
+        }
+
+        const std::uint32_t left = buildBinary(first, split, depth + 1);
+        const std::uint32_t right = buildBinary(first + split, count - split, depth + 1);
+        m_nodes[index].left = left;
+        m_nodes[index].right = right;
+        return index;
+    }
+
+    // Partitions [first, first + count) at the cheapest binned SAH split and returns the size of the left part.
+    // 0 when the centroids cannot be binned, or when no split beats a leaf and the range fits one.
+    auto findSplit(const std::uint32_t first, const std::uint32_t count, const Bounds& bounds,
+                   const Bounds& centroidBounds) -> std::uint32_t {
+        struct Bin {
+            Bounds bounds;
+            std::uint32_t count = 0;
+        };
+
+        float bestCost = INF;
+        int bestAxis = -1;
+        std::uint32_t bestBin = 0;
+
+        const glm::vec3 extent = centroidBounds.max - centroidBounds.min;
+        for (int axis = 0; axis < 3; axis++) {
+            if (extent[axis] <= 0.0f) {
+                continue;
+            }
+
+            std::array<Bin, BVH_SAH_BINS> bins{};
+            const float scale = static_cast<float>(BVH_SAH_BINS) / extent[axis];
+            for (std::uint32_t i = first; i < first + count; i++) {
+                const std::uint32_t primitive = m_order[i];
+                const auto bin = std::min(
+                    static_cast<std::uint32_t>((m_centroids[primitive][axis] - centroidBounds.min[axis]) * scale),
+                    BVH_SAH_BINS - 1);
+                bins[bin].bounds.grow(m_primitives[primitive]);
+                bins[bin].count++;
+            }
+
+            // Right-hand area and count of every split plane, then one sweep from the left
+            std::array<float, BVH_SAH_BINS> rightArea{};
+            std::array<std::uint32_t, BVH_SAH_BINS> rightCount{};
+            Bounds right;
+            std::uint32_t rightPrimitives = 0;
+            for (std::uint32_t bin = BVH_SAH_BINS - 1; bin > 0; bin--) {
+                right.grow(bins[bin].bounds);
+                rightPrimitives += bins[bin].count;
+                rightArea[bin] = right.area();
+                rightCount[bin] = rightPrimitives;
+            }
+
+            Bounds left;
+            std::uint32_t leftPrimitives = 0;
+            for (std::uint32_t bin = 1; bin < BVH_SAH_BINS; bin++) {
+                left.grow(bins[bin - 1].bounds);
+                leftPrimitives += bins[bin - 1].count;
+                if (leftPrimitives == 0 || rightCount[bin] == 0) {
+                    continue;
+                }
+                const float cost = left.area() * static_cast<float>(leftPrimitives) +
+                                   rightArea[bin] * static_cast<float>(rightCount[bin]);
+                if (cost < bestCost) {
+                    bestCost = cost;
+                    bestAxis = axis;
+                    bestBin = bin;
+                }
+            }
+        }
+
+        if (bestAxis < 0) {
+            return 0;
+        }
+
+        const float parentArea = bounds.area();
+        const float splitCost = parentArea > 0.0f ? BVH_NODE_COST + bestCost / parentArea : INF;
+        if (count <= BVH_MAX_LEAF_SIZE && splitCost >= static_cast<float>(count)) {
+            return 0;
+        }
+
+        const float scale = static_cast<float>(BVH_SAH_BINS) / extent[bestAxis];
+        const auto middle = std::partition(m_order.begin() + first, m_order.begin() + first + count,
+                                           [&](const std::uint32_t primitive) {
+                                               const auto bin = std::min(
+                                                   static_cast<std::uint32_t>((m_centroids[primitive][bestAxis] -
+                                                                               centroidBounds.min[bestAxis]) * scale),
+                                                   BVH_SAH_BINS - 1);
+                                               return bin < bestBin;
+                                           });
+        return static_cast<std::uint32_t>(middle - (m_order.begin() + first));
+    }
+
+    // Pulls the largest grandchildren up until the wide node has four children or only leaves
+    void collapse(std::vector<SceneBvh::WideNode>& wide, const std::uint32_t wideIndex, const std::uint32_t binary) {
+        std::array<std::uint32_t, 4> children{m_nodes[binary].left, m_nodes[binary].right};
+        std::size_t childCount = 2;
+        while (childCount < 4) {
+            std::size_t largest = childCount;
+            float largestArea = -1.0f;
+            for (std::size_t i = 0; i < childCount; i++) {
+                const BinaryNode& child = m_nodes[children[i]];
+                if (child.count == 0 && child.bounds.area() > largestArea) {
+                    largest = i;
+                    largestArea = child.bounds.area();
+                }
+            }
+            if (largest == childCount) {
+                break;
+            }
+
+            const BinaryNode& expanded = m_nodes[children[largest]];
+            children[largest] = expanded.left;
+            children[childCount++] = expanded.right;
+        }
+
+        fillWide(wide, wideIndex, children, childCount);
+    }
+
+    void fillWide(std::vector<SceneBvh::WideNode>& wide, const std::uint32_t wideIndex,
+                  const std::array<std::uint32_t, 4>& children, const std::size_t childCount) {
+        // Empty lanes sit at infinity, where no ray direction can both enter and leave them
+        SceneBvh::WideNode node{};
+        for (std::size_t lane = 0; lane < 4; lane++) {
+            node.minX[lane] = node.minY[lane] = node.minZ[lane] = INF;
+            node.maxX[lane] = node.maxY[lane] = node.maxZ[lane] = INF;
+        }
+
+        for (std::size_t lane = 0; lane < childCount; lane++) {
+            const BinaryNode& child = m_nodes[children[lane]];
+            node.minX[lane] = child.bounds.min.x;
+            node.minY[lane] = child.bounds.min.y;
+            node.minZ[lane] = child.bounds.min.z;
+            node.maxX[lane] = child.bounds.max.x;
+            node.maxY[lane] = child.bounds.max.y;
+            node.maxZ[lane] = child.bounds.max.z;
+
+            if (child.count > 0) {
+                node.first[lane] = child.first;
+                node.count[lane] = child.count;
+            } else {
+                node.first[lane] = static_cast<std::uint32_t>(wide.size());
+                wide.emplace_back();
+                collapse(wide, node.first[lane], children[lane]);
+            }
+        }
+
+        wide[wideIndex] = node;
+    }
+};
+
+auto safeInverse(const glm::vec3& direction) -> glm::vec3 {
+    constexpr float epsilon = 1e-20f;
+    glm::vec3 inverse;
+    for (int axis = 0; axis < 3; axis++) {
+        const float d = direction[axis];
+        inverse[axis] = 1.0f / (std::abs(d) > epsilon ? d : std::copysign(epsilon, d));
+    }
+    return inverse;
+}
+
+// Walks nodes front to back; leaf(first, count) tests a leaf's primitives against the ray, shrinks tMax on
+// a hit and returns true to end the walk early
+template <typename Leaf>
+auto traverse(const std::vector<SceneBvh::WideNode>& nodes, const glm::vec3& origin, const glm::vec3& direction,
+              const float tMin, const float& tMax, Leaf&& leaf) -> bool {
+    if (nodes.empty()) {
+        return false;
+    }
+
+    const glm::vec3 inverse = safeInverse(direction);
+    const glm::vec3 scaledOrigin = origin * inverse;
+
+    std::array<std::uint32_t, TRAVERSAL_STACK_SIZE> stack;
+    std::size_t stackSize = 0;
+    stack[stackSize++] = 0;
+
+    while (stackSize > 0) {
+        const SceneBvh::WideNode& node = nodes[stack[--stackSize]];
+
+        // Slab test of all four children at once, missed and empty lanes enter at infinity
+        std::array<float, 4> entry;
+        for (std::size_t lane = 0; lane < 4; lane++) {
+            const float x0 = node.minX[lane] * inverse.x - scaledOrigin.x;
+            const float x1 = node.maxX[lane] * inverse.x - scaledOrigin.x;
+            const float y0 = node.minY[lane] * inverse.y - scaledOrigin.y;
+            const float y1 = node.maxY[lane] * inverse.y - scaledOrigin.y;
+            const float z0 = node.minZ[lane] * inverse.z - scaledOrigin.z;
+            const float z1 = node.maxZ[lane] * inverse.z - scaledOrigin.z;
+            const float near = std::max(std::max(std::min(x0, x1), std::min(y0, y1)), std::max(std::min(z0, z1), tMin));
+            const float far = std::min(std::min(std::max(x0, x1), std::max(y0, y1)), std::min(std::max(z0, z1), tMax));
+            entry[lane] = near <= far ? near : INF;
+        }
+
+        // Nearest child first: leaves are tested right away, inner nodes pushed farthest first
+        std::array<std::uint32_t, 4> lanes{0, 1, 2, 3};
+        std::sort(lanes.begin(), lanes.end(), [&entry](const std::uint32_t a, const std::uint32_t b) {
+            return entry[a] < entry[b];
+        });
+
+        std::array<std::uint32_t, 4> inner;
+        std::size_t innerCount = 0;
+        for (const std::uint32_t lane : lanes) {
+            if (entry[lane] == INF || entry[lane] > tMax) {
+                break;
+            }
+            if (node.count[lane] > 0) {
+                if (leaf(node.first[lane], node.count[lane])) {
+                    return true;
+                }
+            } else {
+                inner[innerCount++] = node.first[lane];
+            }
+        }
+        while (innerCount > 0) {
+            stack[stackSize++] = inner[--innerCount];
+        }
+    }
+    return false;
+}
+} // namespace
+
+SceneBvh::SceneBvh(const Scene& scene, JobSystem& jobSystem) : m_jobSystem(jobSystem) {
+    PROFILE_ZONE("SceneBvh::build");
+
+    m_meshes.resize(scene.meshes.size());
+    m_jobSystem.parallelFor(scene.meshes.size(), [&](const std::size_t meshIndex) {
+        const Mesh& mesh = scene.meshes[meshIndex];
+        MeshBvh& bvh = m_meshes[meshIndex];
+        const std::uint32_t triangleCount = mesh.indexCount / 3;
+
+        std::vector<Bounds> bounds(triangleCount);
+        std::vector<std::array<glm::vec3, 3>> corners(triangleCount);
+        Bounds meshBounds;
+        for (std::uint32_t triangle = 0; triangle < triangleCount; triangle++) {
+            for (std::uint32_t corner = 0; corner < 3; corner++) {
+                const std::uint32_t index = scene.indices[mesh.baseIndex + 3 * triangle + corner];
+                corners[triangle][corner] = scene.vertices[mesh.baseVertex + index].position;
+                bounds[triangle].grow(corners[triangle][corner]);
+            }
+            meshBounds.grow(bounds[triangle]);
+        }
+
+        std::vector<std::uint32_t> order;
+        bvh.nodes = BvhBuilder(bounds, order).build();
+        bvh.triangles.reserve(triangleCount);
+        for (const std::uint32_t triangle : order) {
+            const auto& [v0, v1, v2] = corners[triangle];
+            bvh.triangles.push_back({.v0 = v0, .edge1 = v1 - v0, .edge2 = v2 - v0, .index = triangle});
+        }
+        bvh.boundsMin = meshBounds.min;
+        bvh.boundsMax = meshBounds.max;
+    });
+
+    for (const auto& bvh : m_meshes) {
+        m_triangleCount += bvh.triangles.size();
+        m_meshNodeCount += bvh.nodes.size();
+    }
+
+    updateInstances(scene);
+}
+
+void SceneBvh::updateInstances(const Scene& scene, const std::uint32_t instanceCount) {
+    PROFILE_ZONE("SceneBvh::updateInstances");
+
+    const std::uint32_t count = std::min(instanceCount, static_cast<std::uint32_t>(scene.instances.size()));
+
+    std::vector<BvhInstance> candidates;
+    std::vector<Bounds> bounds;
+    candidates.reserve(count);
+    bounds.reserve(count);
+
+    for (std::uint32_t i = 0; i < count; i++) {
+        const Instance& instance = scene.instances[i];
+        if (instance.meshIndex < 0 || instance.meshIndex >= static_cast<std::int32_t>(m_meshes.size())) {
+            continue;
+        }
+        const MeshBvh& mesh = m_meshes[instance.meshIndex];
+        const std::uint32_t mask = instanceMask(scene, instance);
+        if (mesh.triangles.empty() || mask == 0) {
+            continue;
+        }
+
+        const AABB world = AABB{mesh.boundsMin, mesh.boundsMax}.transform(instance.transform);
+        bounds.push_back({.min = world.min, .max = world.max});
+        candidates.push_back({
+            .worldToObject = instance.inverseTransform,
+            .instance = i,
+            .mesh = static_cast<std::uint32_t>(instance.meshIndex),
+            .mask = mask,
+        });
+    }
+
+    std::vector<std::uint32_t> order;
+    m_instanceNodes = BvhBuilder(bounds, order).build();
+    m_instances.clear();
+    m_instances.reserve(order.size());
+    for (const std::uint32_t candidate : order) {
+        m_instances.push_back(candidates[candidate]);
+    }
+}
+
+auto SceneBvh::castRay(const Ray& ray) const -> RayHit {
+    RayHit hit;
+    trace<false>(ray, hit);
+    return hit;
+}
+
+auto SceneBvh::occluded(const Ray& ray) const -> bool {
+    RayHit hit;
+    return trace<true>(ray, hit);
+}
+
+void SceneBvh::castRays(const std::span<const Ray> rays, const std::span<RayHit> hits) const {
+    PROFILE_ZONE("SceneBvh::castRays");
+
+    const std::size_t jobs = (rays.size() + BVH_RAYS_PER_JOB - 1) / BVH_RAYS_PER_JOB;
+    m_jobSystem.parallelFor(jobs, [&](const std::size_t job) {
+        const std::size_t end = std::min(rays.size(), (job + 1) * BVH_RAYS_PER_JOB);
+        for (std::size_t i = job * BVH_RAYS_PER_JOB; i < end; i++) {
+            hits[i] = castRay(rays[i]);
+        }
+    });
+}
+
+void SceneBvh::occludedRays(const std::span<const Ray> rays, const std::span<std::uint8_t> occluded) const {
+    PROFILE_ZONE("SceneBvh::occludedRays");
+
+    const std::size_t jobs = (rays.size() + BVH_RAYS_PER_JOB - 1) / BVH_RAYS_PER_JOB;
+    m_jobSystem.parallelFor(jobs, [&](const std::size_t job) {
+        const std::size_t end = std::min(rays.size(), (job + 1) * BVH_RAYS_PER_JOB);
+        for (std::size_t i = job * BVH_RAYS_PER_JOB; i < end; i++) {
+            occluded[i] = this->occluded(rays[i]) ? 1 : 0;
+        }
+    });
+}
+
+auto SceneBvh::instanceMask(const Scene& scene, const Instance& instance) -> std::uint32_t {
+    bool materialReflective = true;
+    bool materialCastsShadows = true;
+
+    if (instance.meshIndex >= 0 && instance.meshIndex < static_cast<std::int32_t>(scene.meshes.size())) {
+        const auto& mesh = scene.meshes[instance.meshIndex];
+        if (mesh.materialIndex >= 0 && mesh.materialIndex < static_cast<std::int32_t>(scene.materials.size())) {
+            const auto& material = scene.materials[mesh.materialIndex];
+            materialReflective = material.reflective != 0;
+            materialCastsShadows = material.castsShadows != 0;
+        }
+    }
+
+    std::uint32_t mask = 0;
+    if (instance.reflective != 0 || materialReflective) {
+        mask |= AS_REFLECTIVE_OBJECT_MASK;
+    }
+    if (instance.castsShadows != 0 || materialCastsShadows) {
+        mask |= AS_SHADOW_OBJECT_MASK;
+    }
+    return mask;
+}
+
+template <bool AnyHit>
+auto SceneBvh::trace(const Ray& ray, RayHit& hit) const -> bool {
+    float tMax = ray.tMax;
+
+    return traverse(m_instanceNodes, ray.origin, ray.direction, ray.tMin, tMax,
+                    [&](const std::uint32_t firstInstance, const std::uint32_t instanceCount) {
+        for (std::uint32_t i = firstInstance; i < firstInstance + instanceCount; i++) {
+            const BvhInstance& instance = m_instances[i];
+            if ((instance.mask & ray.mask) == 0) {
+                continue;
+            }
+
+            // An unnormalized object-space direction keeps t comparable across instances
+            const glm::vec3 origin = glm::vec3(instance.worldToObject * glm::vec4(ray.origin, 1.0f));
+            const glm::vec3 direction = glm::vec3(instance.worldToObject * glm::vec4(ray.direction, 0.0f));
+            const std::vector<Triangle>& triangles = m_meshes[instance.mesh].triangles;
+
+            const bool stop = traverse(m_meshes[instance.mesh].nodes, origin, direction, ray.tMin, tMax,
+                                       [&](const std::uint32_t firstTriangle, const std::uint32_t triangleCount) {
+                bool found = false;
+                for (std::uint32_t t = firstTriangle; t < firstTriangle + triangleCount; t++) {
+                    const Triangle& triangle = triangles[t];
+
+                    // Möller-Trumbore, both faces
+                    const glm::vec3 p = glm::cross(direction, triangle.edge2);
+                    const float determinant = glm::dot(triangle.edge1, p);
+                    if (std::abs(determinant) < 1e-12f) {
+                        continue;
+                    }
+                    const float inverseDeterminant = 1.0f / determinant;
+                    const glm::vec3 s = origin - triangle.v0;
+                    const float u = glm::dot(s, p) * inverseDeterminant;
+                    if (u < 0.0f || u > 1.0f) {
+                        continue;
+                    }
+                    const glm::vec3 q = glm::cross(s, triangle.edge1);
+                    const float v = glm::dot(direction, q) * inverseDeterminant;
+                    if (v < 0.0f || u + v > 1.0f) {
+                        continue;
+                    }
+                    const float distance = glm::dot(triangle.edge2, q) * inverseDeterminant;
+                    if (distance < ray.tMin || distance > tMax) {
+                        continue;
+                    }
+
+                    tMax = distance;
+                    hit.t = distance;
+                    hit.instance = instance.instance;
+                    hit.triangle = triangle.index;
+                    hit.barycentrics = glm::vec2(u, v);
+                    found = true;
+                    if constexpr (AnyHit) {
+                        return true;
+                    }
+                }
+                return AnyHit && found;
+            });
+
+            if (stop) {
+                return true;
+            }
+        }
+        return false;
+    }) || hit.hit();
+}
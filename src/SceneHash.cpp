@@ -0,0 +1,24 @@
+#include <algorithm>
+
+#include "SceneHash.hpp"
+
+namespace {
+void fnv1a(std::uint64_t& hash, const void* data, const std::size_t size) {
+    const auto* bytes = static_cast<const std::uint8_t*>(data);
+    for (std::size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= 0x100000001b3ULL;
+    }
+}
+} // namespace
+
+auto hashStaticScene(const Scene& scene) -> std::uint64_t {
+    std::uint64_t hash = 0xcbf29ce484222325ULL;
+    const std::uint32_t staticCount = std::min(scene.firstDynamicInstance, static_cast<std::uint32_t>(scene.instances.size()));
+    for (std::uint32_t i = 0; i < staticCount; i++) {
+        const auto& instance = scene.instances[i];
+        fnv1a(hash, &instance.meshIndex, sizeof(instance.meshIndex));
+        fnv1a(hash, &instance.transform, sizeof(instance.transform));
+    }
+    return hash;
+}
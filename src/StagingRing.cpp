@@ -0,0 +1,178 @@
+#include <algorithm>
+#include <cassert>
+#include <iostream>
+#include <stdexcept>
+
+#include "constants.hpp"
+#include "StagingRing.hpp"
+#include "VulkanCore.hpp"
+#include "BufferManager.hpp"
+#include "CpuProfiler.hpp"
+
+namespace {
+auto alignUp(const vk::DeviceSize value, const vk::DeviceSize alignment) -> vk::DeviceSize {
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+} // namespace
+
+StagingRing::StagingRing(VulkanCore& vulkanCore, BufferManager& bufferManager)
+    : m_vulkanCore(vulkanCore), m_bufferManager(bufferManager) {
+    detectDirectWrites();
+}
+
+void StagingRing::detectDirectWrites() {
+    if constexpr (!UPLOAD_ALLOW_DIRECT_WRITES) {
+        return;
+    }
+
+    const auto& physicalDevice = m_vulkanCore.physicalDevice();
+    const auto memProperties = physicalDevice.getMemoryProperties();
+    const bool unifiedMemory = physicalDevice.getProperties().deviceType == vk::PhysicalDeviceType::eIntegratedGpu;
+
+    constexpr auto directFlags = vk::MemoryPropertyFlagBits::eDeviceLocal |
+                                 vk::MemoryPropertyFlagBits::eHostVisible |
+                                 vk::MemoryPropertyFlagBits::eHostCoherent;
+
+    // Without ReBAR only a 256 MiB window of VRAM is host visible. That window is shared with the driver and
+    // too small to hold every scene buffer, so it only qualifies on integrated GPUs where all memory is shared
+    for (std::uint32_t i = 0; i < memProperties.memoryTypeCount; i++) {
+        const auto& memoryType = memProperties.memoryTypes[i];
+        if ((memoryType.propertyFlags & directFlags) != directFlags) {
+            continue;
+        }
+
+        if (unifiedMemory || memProperties.memoryHeaps[memoryType.heapIndex].size > UPLOAD_DIRECT_MIN_HEAP_SIZE) {
+            m_direct = true;
+            break;
+        }
+    }
+}
+
+auto StagingRing::getTargetMemoryProperties() const -> vk::MemoryPropertyFlags {
+    if (m_direct) {
+        return vk::MemoryPropertyFlagBits::eDeviceLocal | vk::MemoryPropertyFlagBits::eHostVisible |
+               vk::MemoryPropertyFlagBits::eHostCoherent;
+    }
+    return vk::MemoryPropertyFlagBits::eDeviceLocal;
+}
+
+void StagingRing::allocate(const vk::DeviceSize capacityPerFrame, const std::size_t maxStagesPerFrame) {
+    m_stagingBuffers.clear();
+    m_stagingBuffersMemory.clear();
+    m_stagingBuffersMapped.clear();
+    m_capacity = 0;
+    m_cursor = 0;
+
+    m_pendingCopies.clear();
+    m_pendingCopies.reserve(maxStagesPerFrame);
+    m_regionScratch.reserve(maxStagesPerFrame);
+
+    std::cout << "[Upload] Scene buffers: device-local, "
+              << (m_direct ? "written in place (ReBAR/UMA)" : "updated through a staging ring") << std::endl;
+
+    if (m_direct) {
+        return;
+    }
+
+    m_capacity = std::max<vk::DeviceSize>(capacityPerFrame, UPLOAD_STAGING_ALIGNMENT);
+
+    for (std::uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
+        vk::raii::Buffer buffer{nullptr};
+        vk::raii::DeviceMemory memory{nullptr};
+
+        m_bufferManager.createStagingBuffer(m_capacity, buffer, memory);
+
+        m_stagingBuffersMapped.push_back(static_cast<std::byte*>(memory.mapMemory(0, m_capacity)));
+        m_stagingBuffers.emplace_back(std::move(buffer));
+        m_stagingBuffersMemory.emplace_back(std::move(memory));
+    }
+}
+
+void StagingRing::beginFrame(const std::uint32_t frameIdx) {
+    m_frameIdx = frameIdx;
+    m_cursor = 0;
+    m_pendingCopies.clear();
+}
+
+auto StagingRing::stage(const vk::Buffer dst, void* dstMapped, const vk::DeviceSize dstOffset,
+                        const vk::DeviceSize size) -> void* {
+    if (m_direct) {
+        return static_cast<std::byte*>(dstMapped) + dstOffset;
+    }
+
+    const vk::DeviceSize srcOffset = alignUp(m_cursor, UPLOAD_STAGING_ALIGNMENT);
+    if (srcOffset + size > m_capacity) {
+        throw std::runtime_error("staging ring overflow, the per-frame upload capacity is too small!");
+    }
+    m_cursor = srcOffset + size;
+
+    // Consecutive elements of the same buffer (e.g. a run of animated instances) become one region
+    if (!m_pendingCopies.empty()) {
+        auto& last = m_pendingCopies.back();
+        if (last.dst == dst && last.region.srcOffset + last.region.size == srcOffset &&
+            last.region.dstOffset + last.region.size == dstOffset) {
+            last.region.size += size;
+            return m_stagingBuffersMapped[m_frameIdx] + srcOffset;
+        }
+    }
+
+    // allocate() reserved every stage() of a frame, growing here would be a steady-state heap allocation
+    assert(m_pendingCopies.size() < m_pendingCopies.capacity());
+    m_pendingCopies.push_back({
+        .dst = dst,
+        .region = vk::BufferCopy{.srcOffset = srcOffset, .dstOffset = dstOffset, .size = size},
+    });
+
+    return m_stagingBuffersMapped[m_frameIdx] + srcOffset;
+}
+
+void StagingRing::recordUploads(const vk::CommandBuffer& cmd) {
+    PROFILE_ZONE("StagingRing::recordUploads");
+
+    m_lastUploadBytes = 0;
+    m_lastCopyRegions = static_cast<std::uint32_t>(m_pendingCopies.size());
+
+    if (m_pendingCopies.empty()) {
+        return;
+    }
+
+    const vk::Buffer src = *m_stagingBuffers[m_frameIdx];
+
+    // One copy command per run of regions targeting the same buffer
+    std::size_t runStart = 0;
+    while (runStart < m_pendingCopies.size()) {
+        const vk::Buffer dst = m_pendingCopies[runStart].dst;
+
+        m_regionScratch.clear();
+        assert(m_regionScratch.capacity() >= m_pendingCopies.size());
+        std::size_t runEnd = runStart;
+        while (runEnd < m_pendingCopies.size() && m_pendingCopies[runEnd].dst == dst) {
+            m_regionScratch.push_back(m_pendingCopies[runEnd].region);
+            m_lastUploadBytes += m_pendingCopies[runEnd].region.size;
+            runEnd++;
+        }
+
+        cmd.copyBuffer(src, dst, m_regionScratch);
+        runStart = runEnd;
+    }
+
+    // The buffers are per frame in flight and were last read before this slot's fence, so only RAW matters
+    const vk::MemoryBarrier2 uploadBarrier{
+        .srcStageMask = vk::PipelineStageFlagBits2::eCopy,
+        .srcAccessMask = vk::AccessFlagBits2::eTransferWrite,
+        .dstStageMask = vk::PipelineStageFlagBits2::eDrawIndirect |
+                        vk::PipelineStageFlagBits2::eVertexShader |
+                        vk::PipelineStageFlagBits2::eFragmentShader |
+                        vk::PipelineStageFlagBits2::eAccelerationStructureBuildKHR,
+        .dstAccessMask = vk::AccessFlagBits2::eIndirectCommandRead |
+                         vk::AccessFlagBits2::eShaderStorageRead |
+                         vk::AccessFlagBits2::eShaderRead,
+    };
+
+    cmd.pipelineBarrier2(vk::DependencyInfo{
+        .memoryBarrierCount = 1,
+        .pMemoryBarriers = &uploadBarrier,
+    });
+
+    m_pendingCopies.clear();
+}
@@ -0,0 +1,119 @@
+#include <algorithm>
+#include <format>
+#include <iostream>
+
+#include "StartupTimeline.hpp"
+
+namespace {
+double toMs(const std::chrono::steady_clock::duration duration) {
+    return std::chrono::duration<double, std::milli>(duration).count();
+}
+} // namespace
+
+StartupTimeline::StartupTimeline() : m_origin(Clock::now()) {
+}
+
+auto StartupTimeline::begin(std::string name, std::string thread, const std::initializer_list<PhaseId> dependencies)
+    -> PhaseId {
+    const std::lock_guard lock(m_mutex);
+    m_phases.push_back({
+        .name = std::move(name),
+        .thread = std::move(thread),
+        .dependencies = dependencies,
+        .start = Clock::now(),
+        .end = {},
+    });
+    return m_phases.size() - 1;
+}
+
+void StartupTimeline::end(const PhaseId phase) {
+    const std::lock_guard lock(m_mutex);
+    m_phases[phase].end = Clock::now();
+    m_phases[phase].finished = true;
+}
+
+StartupTimeline::Scope::Scope(StartupTimeline& timeline,
+                              std::string name,
+                              std::string thread,
+                              const std::initializer_list<PhaseId> dependencies)
+    : m_timeline(timeline), m_phase(timeline.begin(std::move(name), std::move(thread), dependencies)) {
+}
+
+StartupTimeline::Scope::~Scope() {
+    m_timeline.end(m_phase);
+}
+
+auto StartupTimeline::criticalPath() const -> std::vector<PhaseId> {
+    std::vector<PhaseId> path;
+
+    // Start from the phase that finished last
+    std::size_t current = m_phases.size();
+    for (std::size_t i = 0; i < m_phases.size(); i++) {
+        if (m_phases[i].finished && (current == m_phases.size() || m_phases[i].end > m_phases[current].end)) {
+            current = i;
+        }
+    }
+
+    while (current < m_phases.size()) {
+        path.push_back(current);
+        const auto& phase = m_phases[current];
+
+        // Whichever predecessor (explicit dependency or the previous phase on the same thread)
+        // finished last is what held this phase back
+        std::size_t predecessor = m_phases.size();
+        const auto consider = [&](const std::size_t candidate) {
+            // Predecessors started strictly earlier, which also guarantees the walk terminates
+            const auto& other = m_phases[candidate];
+            if (!other.finished || other.start >= phase.start || other.end > phase.end) {
+                return;
+            }
+            if (predecessor == m_phases.size() || other.end > m_phases[predecessor].end) {
+                predecessor = candidate;
+            }
+        };
+
+        for (const auto dependency : phase.dependencies) {
+            consider(dependency);
+        }
+        for (std::size_t i = 0; i < m_phases.size(); i++) {
+            if (m_phases[i].thread == phase.thread && m_phases[i].end <= phase.start) {
+                consider(i);
+            }
+        }
+
+        current = predecessor;
+    }
+
+    std::ranges::reverse(path);
+    return path;
+}
+
+void StartupTimeline::printReport() const {
+    const std::lock_guard lock(m_mutex);
+
+    Clock::time_point lastEnd = m_origin;
+    for (const auto& phase : m_phases) {
+        if (phase.finished) {
+            lastEnd = std::max(lastEnd, phase.end);
+        }
+    }
+
+    std::cout << std::format("[Startup] {:.1f} ms until the first frame\n", toMs(lastEnd - m_origin));
+    std::cout << std::format("  {:<28} {:<8} {:>9} {:>9}\n", "phase", "thread", "start", "duration");
+    for (const auto& phase : m_phases) {
+        if (!phase.finished) {
+            continue;
+        }
+        std::cout << std::format("  {:<28} {:<8} {:>9.1f} {:>9.1f}\n", phase.name, phase.thread,
+                                 toMs(phase.start - m_origin), toMs(phase.end - phase.start));
+    }
+
+    std::cout << "[Startup] Critical path:\n";
+    for (const auto id : criticalPath()) {
+        const auto& phase = m_phases[id];
+        const double duration = toMs(phase.end - phase.start);
+        std::cout << std::format("  {:<28} {:<8} {:>9.1f} ms ({:>4.1f}%)\n", phase.name, phase.thread, duration,
+                                 100.0 * duration / std::max(toMs(lastEnd - m_origin), 1e-6));
+    }
+    std::cout << std::flush;
+}
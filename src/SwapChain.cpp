@@ -9,11 +9,75 @@
 #include "SwapChain.hpp"
 #include "VulkanCore.hpp"
 
-SwapChain::SwapChain(VulkanCore& vulkanCore, GLFWwindow* window) : m_vulkanCore{vulkanCore} {
-    createSwapChain(window);
+SwapChain::SwapChain(VulkanCore& vulkanCore, GLFWwindow* window, const vk::Extent2D offscreenExtent)
+    : m_vulkanCore{vulkanCore},
+      m_headless{window == nullptr} {
+    if (m_headless) {
+        createOffscreenImages(offscreenExtent);
+    } else {
+        createSwapChain(window);
+    }
     createImageViews();
 }
 
+auto SwapChain::nextOffscreenImage() -> std::uint32_t {
+    const auto imageIndex = m_nextOffscreenImage;
+    m_nextOffscreenImage = (m_nextOffscreenImage + 1) % static_cast<std::uint32_t>(m_swapChainImages.size());
+    return imageIndex;
+}
+
+void SwapChain::createOffscreenImages(const vk::Extent2D extent) {
+    static_assert(HEADLESS_IMAGE_COUNT >= MAX_FRAMES_IN_FLIGHT,
+                  "offscreen ring must not be smaller than the number of frames in flight");
+
+    m_swapChainImageFormat = PREFERRED_COLOR_FORMAT;
+    m_swapChainExtent = extent;
+
+    m_offscreenImages.clear();
+    for (auto& memory : m_offscreenImageMemories) {
+        m_vulkanCore.memoryTracker().release(memory);
+    }
+    m_offscreenImageMemories.clear();
+    m_swapChainImages.clear();
+
+    for (std::uint32_t i = 0; i < HEADLESS_IMAGE_COUNT; i++) {
+        const vk::ImageCreateInfo imageInfo{
+            .imageType = vk::ImageType::e2D,
+            .format = m_swapChainImageFormat,
+            .extent = {m_swapChainExtent.width, m_swapChainExtent.height, 1},
+            .mipLevels = 1,
+            .arrayLayers = 1,
+            .samples = vk::SampleCountFlagBits::e1,
+            .tiling = vk::ImageTiling::eOptimal,
+            // TransferSrc so finished frames can be copied out for inspection/export
+            .usage = vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eTransferSrc,
+            .sharingMode = vk::SharingMode::eExclusive,
+            .initialLayout = vk::ImageLayout::eUndefined,
+        };
+
+        vk::raii::Image image(m_vulkanCore.device(), imageInfo);
+
+        const auto memRequirements = image.getMemoryRequirements();
+        const vk::MemoryAllocateInfo allocInfo{
+            .allocationSize = memRequirements.size,
+            .memoryTypeIndex = m_vulkanCore.findMemoryType(memRequirements.memoryTypeBits,
+                                                           vk::MemoryPropertyFlagBits::eDeviceLocal),
+        };
+
+        vk::raii::DeviceMemory memory(m_vulkanCore.device(), allocInfo);
+        image.bindMemory(*memory, 0);
+        m_vulkanCore.memoryTracker().recordAllocation(*memory, MemoryCategory::RenderTargets, memRequirements.size,
+                                                      allocInfo.memoryTypeIndex);
+
+        m_swapChainImages.push_back(*image);
+        m_offscreenImages.push_back(std::move(image));
+        m_offscreenImageMemories.push_back(std::move(memory));
+    }
+
+    std::cout << "[Headless] Rendering into " << HEADLESS_IMAGE_COUNT << " offscreen images ("
+              << m_swapChainExtent.width << "x" << m_swapChainExtent.height << ")" << std::endl;
+}
+
 void SwapChain::createSwapChain(GLFWwindow* window) {
     auto [format, colorSpace] = chooseSurfaceFormat();
     const auto presentationMode = choosePresentationMode();
@@ -0,0 +1,173 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <glm/glm.hpp>
+
+#include "TexturePrefetchPlanner.hpp"
+#include "Animator.hpp"
+#include "CpuProfiler.hpp"
+#include "TextureStreamer.hpp"
+#include "constants.hpp"
+
+namespace {
+constexpr std::uint32_t NOT_SAMPLED = std::numeric_limits<std::uint32_t>::max();
+}
+
+TexturePrefetchPlanner::TexturePrefetchPlanner(const Scene& scene,
+                                               TextureStreamer& streamer,
+                                               const std::uint32_t viewportHeight)
+    : m_streamer(streamer),
+      m_viewportHeight(static_cast<float>(viewportHeight)) {
+    m_meshUvDensity.reserve(scene.meshes.size());
+    for (const auto& mesh : scene.meshes) {
+        double surfaceArea = 0.0;
+        double uvArea = 0.0;
+        for (std::uint32_t i = 0; i + 2 < mesh.indexCount; i += 3) {
+            const Vertex& a = scene.vertices[mesh.baseVertex + scene.indices[mesh.baseIndex + i]];
+            const Vertex& b = scene.vertices[mesh.baseVertex + scene.indices[mesh.baseIndex + i + 1]];
+            const Vertex& c = scene.vertices[mesh.baseVertex + scene.indices[mesh.baseIndex + i + 2]];
+
+            surfaceArea += 0.5 * glm::length(glm::cross(b.position - a.position, c.position - a.position));
+            const glm::vec2 uvEdge0 = b.texCoord - a.texCoord;
+            const glm::vec2 uvEdge1 = c.texCoord - a.texCoord;
+            uvArea += 0.5 * std::abs(uvEdge0.x * uvEdge1.y - uvEdge0.y * uvEdge1.x);
+        }
+
+        m_meshUvDensity.push_back(surfaceArea > 0.0 && uvArea > 0.0
+                                      ? static_cast<float>(std::sqrt(uvArea / surfaceArea))
+                                      : 0.0f);
+    }
+
+    m_materialTextures.reserve(scene.materials.size());
+    for (const auto& material : scene.materials) {
+        const auto streamed = [&](const std::vector<Texture>& textures, const std::int32_t index) {
+            return index >= 0 ? streamer.textureId(textures, static_cast<std::size_t>(index))
+                              : TextureStreamer::NOT_STREAMED;
+        };
+        m_materialTextures.push_back({
+            streamed(scene.baseColorTextures, material.baseColorTexIndex),
+            streamed(scene.metallicRoughnessTextures, material.metallicRoughnessTexIndex),
+            streamed(scene.normalTextures, material.normalTexIndex),
+            streamed(scene.occlusionTextures, material.occlusionTexIndex),
+        });
+    }
+
+    m_sampleMips.resize(streamer.textureCount());
+}
+
+void TexturePrefetchPlanner::update(const tinygltf::Model& model,
+                                    const Scene& scene,
+                                    const float time,
+                                    const bool followPath,
+                                    std::pmr::memory_resource& memory) {
+    PROFILE_ZONE("TexturePrefetchPlanner::update");
+
+    if (!followPath) {
+        evaluate(scene, scene.camera, time);
+        m_plannedUntil = -1.0f;
+        return;
+    }
+
+    // Restart from the current time after a jump backwards, or when the samples fell behind the animation
+    if (time < m_lastTime || m_plannedUntil < time) {
+        m_plannedUntil = time - TEXTURE_PREFETCH_STEP_SECONDS;
+    }
+    m_lastTime = time;
+
+    CameraParameters camera = scene.camera;
+    for (std::uint32_t sample = 0; sample < TEXTURE_PREFETCH_SAMPLES_PER_FRAME &&
+                                   m_plannedUntil + TEXTURE_PREFETCH_STEP_SECONDS <= time + TEXTURE_PREFETCH_LOOKAHEAD_SECONDS;
+         sample++) {
+        m_plannedUntil += TEXTURE_PREFETCH_STEP_SECONDS;
+        if (!Animator::sampleCamera(model, m_plannedUntil, memory, camera)) {
+            return;
+        }
+        evaluate(scene, camera, m_plannedUntil);
+    }
+}
+
+void TexturePrefetchPlanner::prime(const tinygltf::Model& model,
+                                   const Scene& scene,
+                                   const float time,
+                                   std::pmr::memory_resource& memory) {
+    PROFILE_ZONE("TexturePrefetchPlanner::prime");
+
+    evaluate(scene, scene.camera, time);
+
+    CameraParameters camera = scene.camera;
+    m_plannedUntil = time;
+    m_lastTime = time;
+    while (m_plannedUntil + TEXTURE_PREFETCH_STEP_SECONDS <= time + TEXTURE_PREFETCH_LOOKAHEAD_SECONDS) {
+        m_plannedUntil += TEXTURE_PREFETCH_STEP_SECONDS;
+        if (!Animator::sampleCamera(model, m_plannedUntil, memory, camera)) {
+            return;
+        }
+        evaluate(scene, camera, m_plannedUntil);
+    }
+}
+
+void TexturePrefetchPlanner::evaluate(const Scene& scene, const CameraParameters& camera, const float time) {
+    std::ranges::fill(m_sampleMips, NOT_SAMPLED);
+
+    // Widened so objects about to turn into view are requested too. Animated instances are judged where they
+    // are now, not where they will be at time.
+    CameraParameters widened = camera;
+    widened.yfov = std::min(camera.yfov * TEXTURE_PREFETCH_FOV_SCALE, 3.0f);
+    const auto& planes = widened.getFrustum().planes;
+
+    const glm::vec3 eye = camera.getPosition();
+    const float pixelsPerUnitAtOne = m_viewportHeight / (2.0f * std::tan(camera.yfov * 0.5f));
+    const auto meshCount = static_cast<std::int32_t>(scene.meshes.size());
+
+    for (const auto& instance : scene.instances) {
+        if (instance.meshIndex < 0 || instance.meshIndex >= meshCount) {
+            continue;
+        }
+        const Mesh& mesh = scene.meshes[instance.meshIndex];
+        if (mesh.materialIndex < 0 || mesh.materialIndex >= static_cast<std::int32_t>(m_materialTextures.size())) {
+            continue;
+        }
+
+        // Bounding sphere as in InstanceCulling
+        const glm::vec3 localCenter = (mesh.boundingBoxMin + mesh.boundingBoxMax) * 0.5f;
+        const float localRadius = glm::length(mesh.boundingBoxMax - mesh.boundingBoxMin) * 0.5f;
+        const glm::vec3 worldCenter = glm::vec3(instance.transform * glm::vec4(localCenter, 1.0f));
+        const float maxScale = std::sqrt(std::max({
+            glm::dot(glm::vec3(instance.transform[0]), glm::vec3(instance.transform[0])),
+            glm::dot(glm::vec3(instance.transform[1]), glm::vec3(instance.transform[1])),
+            glm::dot(glm::vec3(instance.transform[2]), glm::vec3(instance.transform[2])),
+        }));
+        const float worldRadius = localRadius * maxScale;
+
+        bool visible = true;
+        for (int i = 0; i < 5; ++i) {
+            if (planes[i].distanceToPoint(worldCenter) < -worldRadius) {
+                visible = false;
+                break;
+            }
+        }
+        if (!visible || maxScale <= 0.0f || m_meshUvDensity[instance.meshIndex] <= 0.0f) {
+            continue;
+        }
+
+        // Texture coordinates one pixel spans on the nearest point of the sphere; times the texture size that
+        // is texels per pixel, whose log2 is the mip the sampler picks
+        const float distance = std::max(glm::length(worldCenter - eye) - worldRadius, camera.znear);
+        const float uvPerPixel = m_meshUvDensity[instance.meshIndex] / maxScale * distance / pixelsPerUnitAtOne;
+
+        for (const std::uint32_t texture : m_materialTextures[mesh.materialIndex]) {
+            if (texture == TextureStreamer::NOT_STREAMED) {
+                continue;
+            }
+            const float texelsPerPixel = uvPerPixel * static_cast<float>(m_streamer.textureSize(texture));
+            const std::uint32_t mip = texelsPerPixel > 1.0f ? static_cast<std::uint32_t>(std::log2(texelsPerPixel)) : 0;
+            m_sampleMips[texture] = std::min(m_sampleMips[texture], mip);
+        }
+    }
+
+    for (std::uint32_t texture = 0; texture < m_sampleMips.size(); texture++) {
+        if (m_sampleMips[texture] != NOT_SAMPLED) {
+            m_streamer.request(texture, m_sampleMips[texture], time);
+        }
+    }
+}
@@ -0,0 +1,678 @@
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <numeric>
+
+#include "TextureStreamer.hpp"
+#include "BufferManager.hpp"
+#include "CommandManager.hpp"
+#include "CpuProfiler.hpp"
+#include "ImageManager.hpp"
+#include "JobSystem.hpp"
+#include "ResourceManager.hpp"
+#include "VulkanCore.hpp"
+
+namespace {
+auto levelExtent(const std::uint32_t size, const std::uint32_t level) -> std::uint32_t {
+    return std::max(1U, size >> level);
+}
+
+auto bytesPerPixel(const vk::Format format) -> std::uint32_t {
+    switch (format) {
+        case vk::Format::eR8Unorm: return 1;
+        case vk::Format::eR8G8B8Srgb: return 3;
+        case vk::Format::eR16G16B16A16Unorm: return 8;
+        default: return 4;
+    }
+}
+
+auto isSrgb(const vk::Format format) -> bool {
+    return format == vk::Format::eR8G8B8A8Srgb || format == vk::Format::eR8G8B8Srgb;
+}
+
+auto srgbToLinear(const std::uint8_t value) -> float {
+    static const auto table = [] {
+        std::array<float, 256> values{};
+        for (std::size_t i = 0; i < values.size(); i++) {
+            const float c = static_cast<float>(i) / 255.0f;
+            values[i] = c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+        }
+        return values;
+    }();
+    return table[value];
+}
+
+auto linearToSrgb(const float value) -> float {
+    return value <= 0.0031308f ? value * 12.92f : 1.055f * std::pow(value, 1.0f / 2.4f) - 0.055f;
+}
+
+// Staging offsets of copyBufferToImage must be multiples of 4 and of the texel size
+auto alignUp(const vk::DeviceSize offset, const std::uint32_t bytesPerPixel) -> vk::DeviceSize {
+    const vk::DeviceSize alignment = std::lcm(bytesPerPixel, 4U);
+    return (offset + alignment - 1) / alignment * alignment;
+}
+} // namespace
+
+TextureStreamer::TextureStreamer(VulkanCore& vulkanCore,
+                                 CommandManager& commandManager,
+                                 BufferManager& bufferManager,
+                                 ImageManager& imageManager,
+                                 JobSystem& jobSystem)
+    : m_vulkanCore(vulkanCore),
+      m_commandManager(commandManager),
+      m_bufferManager(bufferManager),
+      m_imageManager(imageManager),
+      m_jobSystem(jobSystem) {
+    for (std::uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
+        auto& buffer = m_stagingBuffers.emplace_back(nullptr);
+        auto& memory = m_stagingBuffersMemory.emplace_back(nullptr);
+        m_bufferManager.createBuffer(MemoryCategory::Staging, TEXTURE_STREAMING_UPLOAD_BUDGET,
+                                     vk::BufferUsageFlagBits::eTransferSrc,
+                                     vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent,
+                                     buffer, memory);
+        m_stagingBuffersMapped.push_back(static_cast<std::uint8_t*>(memory.mapMemory(0, TEXTURE_STREAMING_UPLOAD_BUDGET)));
+    }
+
+    // Bands of every prepared level in one frame at most
+    m_pendingBands.reserve(TEXTURE_STREAMING_PREPARED_LEVELS);
+
+    m_thread = std::thread([this] { threadLoop(); });
+}
+
+TextureStreamer::~TextureStreamer() {
+    {
+        const std::lock_guard lock(m_mutex);
+        m_stopping = true;
+    }
+    m_wake.notify_all();
+    m_thread.join();
+
+    for (auto& memory : m_stagingBuffersMemory) {
+        m_vulkanCore.memoryTracker().release(memory);
+    }
+    m_vulkanCore.memoryTracker().release(m_assemblyMemory);
+}
+
+void TextureStreamer::addTextures(const MemoryCategory category,
+                                  const std::vector<Texture>& textures,
+                                  std::vector<AllocatedTextureImage>& images) {
+    PROFILE_ZONE("TextureStreamer::addTextures");
+
+    const auto firstId = static_cast<std::uint32_t>(m_textures.size());
+    m_arrays.push_back({.textures = &textures, .firstId = firstId});
+    images.resize(textures.size());
+
+    vk::DeviceSize stagingSize = 0;
+    std::vector<vk::DeviceSize> tailOffsets;
+    tailOffsets.reserve(textures.size());
+
+    for (std::size_t i = 0; i < textures.size(); i++) {
+        const Texture& source = textures[i];
+        auto& image = images[i];
+
+        m_imageManager.createImage(category, source.width, source.height, source.mipLevels,
+                                   vk::SampleCountFlagBits::e1, source.format, vk::ImageTiling::eOptimal,
+                                   vk::ImageUsageFlagBits::eTransferSrc | vk::ImageUsageFlagBits::eTransferDst |
+                                       vk::ImageUsageFlagBits::eSampled,
+                                   vk::MemoryPropertyFlagBits::eDeviceLocal, image.image, image.imageMemory);
+        image.imageView = m_imageManager.createImageView(image.image, source.format,
+                                                            vk::ImageAspectFlagBits::eColor, source.mipLevels);
+
+        StreamedTexture texture{
+            .source = &source,
+            .image = *image.image,
+            .width = source.width,
+            .height = source.height,
+            .mipLevels = source.mipLevels,
+            .bytesPerPixel = bytesPerPixel(source.format),
+        };
+
+        // Resident tail: the first level that fits TEXTURE_STREAMING_RESIDENT_SIZE
+        std::uint32_t tail = 0;
+        while (tail + 1 < texture.mipLevels &&
+               std::max(levelExtent(texture.width, tail), levelExtent(texture.height, tail)) > TEXTURE_STREAMING_RESIDENT_SIZE) {
+            tail++;
+        }
+        texture.residentMip = tail;
+        texture.targetMip = tail;
+
+        stagingSize = alignUp(stagingSize, texture.bytesPerPixel);
+        tailOffsets.push_back(stagingSize);
+        stagingSize += levelBytes(texture, tail);
+
+        m_textures.push_back(texture);
+    }
+
+    if (textures.empty()) {
+        return;
+    }
+
+    // Any level above the resident tail may be streamed, level 0 is the largest
+    vk::DeviceSize largestLevel = 0;
+    for (std::size_t i = 0; i < textures.size(); i++) {
+        const StreamedTexture& texture = m_textures[firstId + i];
+        if (texture.residentMip > 0) {
+            largestLevel = std::max(largestLevel, levelBytes(texture, 0));
+        }
+    }
+    if (largestLevel > m_assemblyBytes) {
+        m_assemblyBuffer.clear();
+        m_vulkanCore.memoryTracker().release(m_assemblyMemory);
+        m_bufferManager.createBuffer(MemoryCategory::Staging, largestLevel,
+                                     vk::BufferUsageFlagBits::eTransferSrc | vk::BufferUsageFlagBits::eTransferDst,
+                                     vk::MemoryPropertyFlagBits::eDeviceLocal, m_assemblyBuffer, m_assemblyMemory);
+        m_assemblyBytes = largestLevel;
+    }
+
+    vk::raii::Buffer stagingBuffer = nullptr;
+    vk::raii::DeviceMemory stagingMemory = nullptr;
+    m_bufferManager.createBuffer(MemoryCategory::Staging, stagingSize, vk::BufferUsageFlagBits::eTransferSrc,
+                                 vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent,
+                                 stagingBuffer, stagingMemory);
+    auto* staging = static_cast<std::uint8_t*>(stagingMemory.mapMemory(0, stagingSize));
+
+    // Every tail reads its whole level 0, so they are filtered in parallel
+    m_jobSystem.parallelFor(textures.size(), [&](const std::size_t i) {
+        const StreamedTexture& texture = m_textures[firstId + i];
+        filterLevel(texture, texture.residentMip, staging + tailOffsets[i]);
+    });
+
+    m_commandManager.immediateSubmit([&](const vk::CommandBuffer cmd) {
+        for (std::size_t i = 0; i < textures.size(); i++) {
+            const StreamedTexture& texture = m_textures[firstId + i];
+            const std::uint32_t tail = texture.residentMip;
+
+            recordLevelBarrier(cmd, texture.image, tail, 1, vk::ImageLayout::eUndefined,
+                               vk::ImageLayout::eTransferDstOptimal);
+            cmd.copyBufferToImage(*stagingBuffer, texture.image, vk::ImageLayout::eTransferDstOptimal,
+                                  vk::BufferImageCopy{
+                                      .bufferOffset = tailOffsets[i],
+                                      .imageSubresource = {
+                                          .aspectMask = vk::ImageAspectFlagBits::eColor,
+                                          .mipLevel = tail,
+                                          .baseArrayLayer = 0,
+                                          .layerCount = 1,
+                                      },
+                                      .imageExtent = {levelExtent(texture.width, tail), levelExtent(texture.height, tail), 1},
+                                  });
+            recordResidencyChange(cmd, texture, tail, texture.mipLevels, vk::ImageLayout::eUndefined);
+        }
+    });
+
+    stagingMemory.unmapMemory();
+    m_vulkanCore.memoryTracker().release(stagingMemory);
+}
+
+auto TextureStreamer::textureId(const std::vector<Texture>& textures, const std::size_t index) const -> std::uint32_t {
+    for (const auto& array : m_arrays) {
+        if (array.textures == &textures && index < textures.size()) {
+            return array.firstId + static_cast<std::uint32_t>(index);
+        }
+    }
+    return NOT_STREAMED;
+}
+
+void TextureStreamer::request(const std::uint32_t texture, std::uint32_t mip, const float time) {
+    StreamedTexture& streamed = m_textures[texture];
+    mip = std::min(mip, streamed.mipLevels - 1);
+    if (mip >= streamed.residentMip) {
+        return;
+    }
+
+    // An earlier deadline of a coarser level still stands, its level comes first on the way down
+    streamed.deadline = streamed.residentMip > streamed.targetMip ? std::min(streamed.deadline, time) : time;
+    streamed.targetMip = std::min(streamed.targetMip, mip);
+}
+
+void TextureStreamer::flush() {
+    PROFILE_ZONE("TextureStreamer::flush");
+
+    // Straight to the target level, the levels in between are downsampled from it on the GPU
+    std::vector<std::uint32_t> pending;
+    vk::DeviceSize largestLevel = 0;
+    for (std::uint32_t i = 0; i < m_textures.size(); i++) {
+        const StreamedTexture& texture = m_textures[i];
+        if (texture.targetMip < texture.residentMip && !texture.inFlight) {
+            pending.push_back(i);
+            largestLevel = std::max(largestLevel, levelBytes(texture, texture.targetMip));
+        }
+    }
+    if (pending.empty()) {
+        return;
+    }
+
+    std::ranges::sort(pending, [this](const std::uint32_t a, const std::uint32_t b) {
+        return m_textures[a].deadline < m_textures[b].deadline;
+    });
+
+    const vk::DeviceSize stagingSize = std::max(TEXTURE_STREAMING_PRIME_BATCH, largestLevel + 16);
+    vk::raii::Buffer stagingBuffer = nullptr;
+    vk::raii::DeviceMemory stagingMemory = nullptr;
+    m_bufferManager.createBuffer(MemoryCategory::Staging, stagingSize, vk::BufferUsageFlagBits::eTransferSrc,
+                                 vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent,
+                                 stagingBuffer, stagingMemory);
+    auto* staging = static_cast<std::uint8_t*>(stagingMemory.mapMemory(0, stagingSize));
+
+    std::vector<vk::DeviceSize> offsets;
+    std::size_t batchStart = 0;
+    vk::DeviceSize primedBytes = 0;
+    while (batchStart < pending.size()) {
+        // At least one level per batch, the staging buffer fits the largest
+        offsets.clear();
+        vk::DeviceSize cursor = 0;
+        std::size_t batchEnd = batchStart;
+        while (batchEnd < pending.size()) {
+            const StreamedTexture& texture = m_textures[pending[batchEnd]];
+            const vk::DeviceSize offset = alignUp(cursor, texture.bytesPerPixel);
+            const vk::DeviceSize bytes = levelBytes(texture, texture.targetMip);
+            if (batchEnd > batchStart && offset + bytes > stagingSize) {
+                break;
+            }
+            offsets.push_back(offset);
+            cursor = offset + bytes;
+            batchEnd++;
+        }
+
+        m_jobSystem.parallelFor(batchEnd - batchStart, [&](const std::size_t i) {
+            const StreamedTexture& texture = m_textures[pending[batchStart + i]];
+            filterLevel(texture, texture.targetMip, staging + offsets[i]);
+        });
+
+        m_commandManager.immediateSubmit([&](const vk::CommandBuffer cmd) {
+            for (std::size_t i = 0; i < batchEnd - batchStart; i++) {
+                const StreamedTexture& texture = m_textures[pending[batchStart + i]];
+                const std::uint32_t level = texture.targetMip;
+
+                recordLevelBarrier(cmd, texture.image, level, 1, vk::ImageLayout::eShaderReadOnlyOptimal,
+                                   vk::ImageLayout::eTransferDstOptimal);
+                cmd.copyBufferToImage(*stagingBuffer, texture.image, vk::ImageLayout::eTransferDstOptimal,
+                                      vk::BufferImageCopy{
+                                          .bufferOffset = offsets[i],
+                                          .imageSubresource = {
+                                              .aspectMask = vk::ImageAspectFlagBits::eColor,
+                                              .mipLevel = level,
+                                              .baseArrayLayer = 0,
+                                              .layerCount = 1,
+                                          },
+                                          .imageExtent = {levelExtent(texture.width, level), levelExtent(texture.height, level), 1},
+                                      });
+                recordResidencyChange(cmd, texture, level, texture.residentMip, vk::ImageLayout::eShaderReadOnlyOptimal);
+            }
+        });
+
+        for (std::size_t i = batchStart; i < batchEnd; i++) {
+            StreamedTexture& texture = m_textures[pending[i]];
+            primedBytes += levelBytes(texture, texture.targetMip);
+            texture.residentMip = texture.targetMip;
+        }
+        batchStart = batchEnd;
+    }
+
+    stagingMemory.unmapMemory();
+    m_vulkanCore.memoryTracker().release(stagingMemory);
+
+    std::cout << "[Streaming] Primed " << pending.size() << " textures ("
+              << static_cast<double>(primedBytes) / (1024.0 * 1024.0) << " MB)" << std::endl;
+}
+
+void TextureStreamer::beginFrame(const std::uint32_t frameIdx, const float time) {
+    PROFILE_ZONE("TextureStreamer::beginFrame");
+
+    m_frameIdx = frameIdx;
+    m_pendingBands.clear();
+
+    // A texture still coarser than requested after its deadline may be visibly blurry this frame
+    bool late = false;
+    for (const auto& texture : m_textures) {
+        if (texture.residentMip > texture.targetMip && texture.deadline < time) {
+            late = true;
+            m_maxLateness = std::max(m_maxLateness, time - texture.deadline);
+        }
+    }
+    if (late) {
+        m_lateFrames++;
+    }
+
+    scheduleLevels();
+
+    std::uint8_t* staging = m_stagingBuffersMapped[frameIdx];
+    vk::DeviceSize cursor = 0;
+    for (std::size_t slot = 0; slot < m_prepared.size(); slot++) {
+        PreparedLevel& prepared = m_prepared[slot];
+        auto state = prepared.state.load(std::memory_order_acquire);
+        if (state != PreparedLevel::State::Ready && state != PreparedLevel::State::Uploading) {
+            continue;
+        }
+
+        StreamedTexture& texture = m_textures[prepared.texture];
+        const std::uint32_t width = levelExtent(texture.width, prepared.level);
+        const std::uint32_t height = levelExtent(texture.height, prepared.level);
+        const vk::DeviceSize rowBytes = static_cast<vk::DeviceSize>(width) * texture.bytesPerPixel;
+
+        cursor = alignUp(cursor, texture.bytesPerPixel);
+        if (cursor >= TEXTURE_STREAMING_UPLOAD_BUDGET) {
+            break;
+        }
+
+        // A level that does not fit the rest of the budget waits for the assembly buffer
+        const bool fits = prepared.nextRow == 0 && cursor + levelBytes(texture, prepared.level) <= TEXTURE_STREAMING_UPLOAD_BUDGET;
+        if (!fits && m_assembling != slot) {
+            if (m_assembling != NO_PREPARED_LEVEL) {
+                continue;
+            }
+            m_assembling = slot;
+        }
+
+        const auto rows = static_cast<std::uint32_t>(
+            std::min<vk::DeviceSize>(height - prepared.nextRow, (TEXTURE_STREAMING_UPLOAD_BUDGET - cursor) / rowBytes));
+        if (rows == 0) {
+            break;
+        }
+        prepared.state.store(PreparedLevel::State::Uploading, std::memory_order_relaxed);
+
+        std::memcpy(staging + cursor, prepared.pixels.data() + prepared.nextRow * rowBytes, rows * rowBytes);
+        const bool completes = prepared.nextRow + rows == height;
+        m_pendingBands.push_back({
+            .texture = prepared.texture,
+            .level = prepared.level,
+            .firstRow = prepared.nextRow,
+            .rowCount = rows,
+            .bufferOffset = cursor,
+            .completesLevel = completes,
+            .assembled = m_assembling == slot,
+        });
+        cursor += rows * rowBytes;
+        prepared.nextRow += rows;
+        m_uploadedBytes += rows * rowBytes;
+
+        // The texels are in the staging buffer, the slot can take the next level
+        if (completes) {
+            if (m_assembling == slot) {
+                m_assembling = NO_PREPARED_LEVEL;
+            }
+            texture.residentMip = prepared.level;
+            texture.inFlight = false;
+            m_uploadedLevels++;
+            prepared.state.store(PreparedLevel::State::Free, std::memory_order_relaxed);
+        }
+    }
+}
+
+void TextureStreamer::recordUploads(const vk::CommandBuffer& cmd) {
+    if (m_pendingBands.empty()) {
+        return;
+    }
+
+    // Orders the assembly buffer against its copies of earlier frames and this frame's band before the final copy
+    const auto assemblyBarrier = [&cmd] {
+        const vk::MemoryBarrier2 barrier{
+            .srcStageMask = vk::PipelineStageFlagBits2::eAllTransfer,
+            .srcAccessMask = vk::AccessFlagBits2::eTransferWrite,
+            .dstStageMask = vk::PipelineStageFlagBits2::eAllTransfer,
+            .dstAccessMask = vk::AccessFlagBits2::eTransferRead | vk::AccessFlagBits2::eTransferWrite,
+        };
+        cmd.pipelineBarrier2(vk::DependencyInfo{.memoryBarrierCount = 1, .pMemoryBarriers = &barrier});
+    };
+
+    const vk::Buffer staging = *m_stagingBuffers[m_frameIdx];
+    for (const auto& band : m_pendingBands) {
+        const StreamedTexture& texture = m_textures[band.texture];
+        const vk::DeviceSize rowBytes = static_cast<vk::DeviceSize>(levelExtent(texture.width, band.level)) * texture.bytesPerPixel;
+
+        // Only the assembled level's last band or a whole level reaches the image
+        vk::Buffer source = staging;
+        vk::DeviceSize sourceOffset = band.bufferOffset;
+        if (band.assembled) {
+            assemblyBarrier();
+            cmd.copyBuffer(staging, *m_assemblyBuffer,
+                           vk::BufferCopy{
+                               .srcOffset = band.bufferOffset,
+                               .dstOffset = band.firstRow * rowBytes,
+                               .size = band.rowCount * rowBytes,
+                           });
+            if (!band.completesLevel) {
+                continue;
+            }
+            assemblyBarrier();
+            source = *m_assemblyBuffer;
+            sourceOffset = 0;
+        }
+
+        recordLevelBarrier(cmd, texture.image, band.level, 1, vk::ImageLayout::eShaderReadOnlyOptimal,
+                           vk::ImageLayout::eTransferDstOptimal);
+        cmd.copyBufferToImage(source, texture.image, vk::ImageLayout::eTransferDstOptimal,
+                              vk::BufferImageCopy{
+                                  .bufferOffset = sourceOffset,
+                                  .imageSubresource = {
+                                      .aspectMask = vk::ImageAspectFlagBits::eColor,
+                                      .mipLevel = band.level,
+                                      .baseArrayLayer = 0,
+                                      .layerCount = 1,
+                                  },
+                                  .imageExtent = {levelExtent(texture.width, band.level), levelExtent(texture.height, band.level), 1},
+                              });
+        recordResidencyChange(cmd, texture, band.level, band.level + 1, vk::ImageLayout::eShaderReadOnlyOptimal);
+    }
+}
+
+void TextureStreamer::printReport() const {
+    std::uint32_t behind = 0;
+    for (const auto& texture : m_textures) {
+        if (texture.residentMip > texture.targetMip) {
+            behind++;
+        }
+    }
+
+    std::cout << "[Streaming] " << m_uploadedLevels << " levels streamed ("
+              << static_cast<double>(m_uploadedBytes) / (1024.0 * 1024.0) << " MB), " << m_lateFrames
+              << " frames with a texture behind its deadline";
+    if (m_lateFrames > 0) {
+        std::cout << " (at most " << m_maxLateness << "s)";
+    }
+    std::cout << ", " << behind << " of " << m_textures.size() << " textures still below their target" << std::endl;
+}
+
+void TextureStreamer::threadLoop() {
+    PROFILE_THREAD_NAME("TextureStreaming");
+
+    while (true) {
+        PreparedLevel* next = nullptr;
+        {
+            std::unique_lock lock(m_mutex);
+            m_wake.wait(lock, [this, &next] {
+                for (auto& prepared : m_prepared) {
+                    if (prepared.state.load(std::memory_order_acquire) == PreparedLevel::State::Queued) {
+                        next = &prepared;
+                        return true;
+                    }
+                }
+                return m_stopping;
+            });
+            if (m_stopping) {
+                return;
+            }
+        }
+
+        PROFILE_ZONE("TextureStreamer::filterLevel");
+        const StreamedTexture& texture = m_textures[next->texture];
+        next->pixels.resize(levelBytes(texture, next->level));
+        filterLevel(texture, next->level, next->pixels.data());
+        next->state.store(PreparedLevel::State::Ready, std::memory_order_release);
+    }
+}
+
+void TextureStreamer::scheduleLevels() {
+    bool queued = false;
+    for (auto& prepared : m_prepared) {
+        if (prepared.state.load(std::memory_order_acquire) != PreparedLevel::State::Free) {
+            continue;
+        }
+
+        // Earliest deadline first, one level at a time per texture
+        StreamedTexture* urgent = nullptr;
+        std::uint32_t urgentId = 0;
+        for (std::uint32_t i = 0; i < m_textures.size(); i++) {
+            StreamedTexture& texture = m_textures[i];
+            if (!texture.inFlight && texture.targetMip < texture.residentMip &&
+                (urgent == nullptr || texture.deadline < urgent->deadline)) {
+                urgent = &texture;
+                urgentId = i;
+            }
+        }
+        if (urgent == nullptr) {
+            break;
+        }
+
+        urgent->inFlight = true;
+        const std::lock_guard lock(m_mutex);
+        prepared.texture = urgentId;
+        prepared.level = urgent->residentMip - 1;
+        prepared.nextRow = 0;
+        prepared.state.store(PreparedLevel::State::Queued, std::memory_order_release);
+        queued = true;
+    }
+
+    if (queued) {
+        m_wake.notify_one();
+    }
+}
+
+auto TextureStreamer::levelBytes(const StreamedTexture& texture, const std::uint32_t level) -> vk::DeviceSize {
+    return static_cast<vk::DeviceSize>(levelExtent(texture.width, level)) * levelExtent(texture.height, level) *
+           texture.bytesPerPixel;
+}
+
+void TextureStreamer::filterLevel(const StreamedTexture& texture, const std::uint32_t level, std::uint8_t* out) {
+    const std::uint8_t* source = texture.source->image.data();
+    if (level == 0) {
+        std::memcpy(out, source, levelBytes(texture, 0));
+        return;
+    }
+
+    const std::uint32_t width = levelExtent(texture.width, level);
+    const std::uint32_t height = levelExtent(texture.height, level);
+    const bool sixteenBit = texture.source->format == vk::Format::eR16G16B16A16Unorm;
+    const std::uint32_t channels = sixteenBit ? 4 : texture.bytesPerPixel;
+    const std::uint32_t colorChannels = isSrgb(texture.source->format) ? 3 : 0;  // Averaged in linear space
+
+    for (std::uint32_t y = 0; y < height; y++) {
+        const std::uint32_t y0 = static_cast<std::uint32_t>(static_cast<std::uint64_t>(y) * texture.height / height);
+        const std::uint32_t y1 = std::max(y0 + 1, static_cast<std::uint32_t>(static_cast<std::uint64_t>(y + 1) * texture.height / height));
+
+        for (std::uint32_t x = 0; x < width; x++) {
+            const std::uint32_t x0 = static_cast<std::uint32_t>(static_cast<std::uint64_t>(x) * texture.width / width);
+            const std::uint32_t x1 = std::max(x0 + 1, static_cast<std::uint32_t>(static_cast<std::uint64_t>(x + 1) * texture.width / width));
+
+            std::array<float, 4> sum{};
+            for (std::uint32_t sy = y0; sy < y1; sy++) {
+                const std::uint8_t* row = source + (static_cast<std::size_t>(sy) * texture.width + x0) * texture.bytesPerPixel;
+                for (std::uint32_t sx = x0; sx < x1; sx++, row += texture.bytesPerPixel) {
+                    for (std::uint32_t c = 0; c < channels; c++) {
+                        if (sixteenBit) {
+                            std::uint16_t value;
+                            std::memcpy(&value, row + c * 2, sizeof(value));
+                            sum[c] += static_cast<float>(value);
+                        } else {
+                            sum[c] += c < colorChannels ? srgbToLinear(row[c]) : static_cast<float>(row[c]);
+                        }
+                    }
+                }
+            }
+
+            const float scale = 1.0f / static_cast<float>((x1 - x0) * (y1 - y0));
+            std::uint8_t* texel = out + (static_cast<std::size_t>(y) * width + x) * texture.bytesPerPixel;
+            for (std::uint32_t c = 0; c < channels; c++) {
+                const float average = sum[c] * scale;
+                if (sixteenBit) {
+                    const auto value = static_cast<std::uint16_t>(average + 0.5f);
+                    std::memcpy(texel + c * 2, &value, sizeof(value));
+                } else if (c < colorChannels) {
+                    texel[c] = static_cast<std::uint8_t>(std::clamp(linearToSrgb(average), 0.0f, 1.0f) * 255.0f + 0.5f);
+                } else {
+                    texel[c] = static_cast<std::uint8_t>(average + 0.5f);
+                }
+            }
+        }
+    }
+}
+
+void TextureStreamer::recordLevelBarrier(const vk::CommandBuffer& cmd,
+                                         const vk::Image image,
+                                         const std::uint32_t baseLevel,
+                                         const std::uint32_t levelCount,
+                                         const vk::ImageLayout oldLayout,
+                                         const vk::ImageLayout newLayout) {
+    // Levels move between sampling in the scene passes, uploads and blits, one barrier covers all three
+    const vk::ImageMemoryBarrier2 barrier{
+        .srcStageMask = vk::PipelineStageFlagBits2::eAllTransfer | vk::PipelineStageFlagBits2::eFragmentShader,
+        .srcAccessMask = vk::AccessFlagBits2::eTransferWrite,
+        .dstStageMask = vk::PipelineStageFlagBits2::eAllTransfer | vk::PipelineStageFlagBits2::eFragmentShader,
+        .dstAccessMask = vk::AccessFlagBits2::eTransferRead | vk::AccessFlagBits2::eTransferWrite |
+                         vk::AccessFlagBits2::eShaderSampledRead,
+        .oldLayout = oldLayout,
+        .newLayout = newLayout,
+        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .image = image,
+        .subresourceRange = {
+            .aspectMask = vk::ImageAspectFlagBits::eColor,
+            .baseMipLevel = baseLevel,
+            .levelCount = levelCount,
+            .baseArrayLayer = 0,
+            .layerCount = 1,
+        },
+    };
+
+    cmd.pipelineBarrier2(vk::DependencyInfo{.imageMemoryBarrierCount = 1, .pImageMemoryBarriers = &barrier});
+}
+
+void TextureStreamer::recordResidencyChange(const vk::CommandBuffer& cmd,
+                                            const StreamedTexture& texture,
+                                            const std::uint32_t level,
+                                            const std::uint32_t oldResident,
+                                            const vk::ImageLayout otherLayout) {
+    const vk::Image image = texture.image;
+    const auto blit = [&](const std::uint32_t srcLevel, const std::uint32_t dstLevel) {
+        const vk::ImageBlit region{
+            .srcSubresource = {.aspectMask = vk::ImageAspectFlagBits::eColor, .mipLevel = srcLevel, .baseArrayLayer = 0, .layerCount = 1},
+            .srcOffsets = std::array{
+                vk::Offset3D{0, 0, 0},
+                vk::Offset3D{static_cast<std::int32_t>(levelExtent(texture.width, srcLevel)),
+                             static_cast<std::int32_t>(levelExtent(texture.height, srcLevel)), 1},
+            },
+            .dstSubresource = {.aspectMask = vk::ImageAspectFlagBits::eColor, .mipLevel = dstLevel, .baseArrayLayer = 0, .layerCount = 1},
+            .dstOffsets = std::array{
+                vk::Offset3D{0, 0, 0},
+                vk::Offset3D{static_cast<std::int32_t>(levelExtent(texture.width, dstLevel)),
+                             static_cast<std::int32_t>(levelExtent(texture.height, dstLevel)), 1},
+            },
+        };
+        cmd.blitImage(image, vk::ImageLayout::eTransferSrcOptimal, image, vk::ImageLayout::eTransferDstOptimal,
+                      region, vk::Filter::eLinear);
+    };
+
+    recordLevelBarrier(cmd, image, level, 1, vk::ImageLayout::eTransferDstOptimal, vk::ImageLayout::eTransferSrcOptimal);
+    if (level > 0) {
+        recordLevelBarrier(cmd, image, 0, level, otherLayout, vk::ImageLayout::eTransferDstOptimal);
+    }
+    if (oldResident > level + 1) {
+        recordLevelBarrier(cmd, image, level + 1, oldResident - level - 1, otherLayout, vk::ImageLayout::eTransferDstOptimal);
+    }
+
+    // Coarser levels that were placeholders until now, each from the one before
+    for (std::uint32_t coarser = level + 1; coarser < oldResident; coarser++) {
+        blit(coarser - 1, coarser);
+        recordLevelBarrier(cmd, image, coarser, 1, vk::ImageLayout::eTransferDstOptimal, vk::ImageLayout::eTransferSrcOptimal);
+    }
+
+    // Finer levels become upsampled copies of the new resident level
+    for (std::uint32_t finer = 0; finer < level; finer++) {
+        blit(level, finer);
+    }
+
+    if (level > 0) {
+        recordLevelBarrier(cmd, image, 0, level, vk::ImageLayout::eTransferDstOptimal, vk::ImageLayout::eShaderReadOnlyOptimal);
+    }
+    recordLevelBarrier(cmd, image, level, oldResident - level, vk::ImageLayout::eTransferSrcOptimal,
+                       vk::ImageLayout::eShaderReadOnlyOptimal);
+}
@@ -2,6 +2,8 @@
 
 #include <GLFW/glfw3.h>
 #include <vulkan/vulkan_hpp_macros.hpp>
+#include <algorithm>
+#include <cstring>
 #include <format>
 #include <iostream>
 #include <stdexcept>
@@ -30,19 +32,33 @@ const std::vector kRequiredValidationLayers = {"VK_LAYER_KHRONOS_validation"};
 // Note the following extensions are built-in since 1.2
 // VK_KHR_spirv_1_4, VK_KHR_shader_float_controls, VK_KHR_maintenance3, VK_KHR_buffer_device_address
 const std::vector kRequiredDeviceExtensions = {
-    vk::KHRSwapchainExtensionName,
     vk::KHRAccelerationStructureExtensionName,
     vk::KHRRayQueryExtensionName,
     vk::KHRDeferredHostOperationsExtensionName,
+    vk::KHRPushDescriptorExtensionName,
+};
+
+// Only needed when presenting to a window
+const std::vector kPresentationDeviceExtensions = {
+    vk::KHRSwapchainExtensionName,
 };
 } // namespace
 
-VulkanCore::VulkanCore(GLFWwindow* window) {
+VulkanCore::VulkanCore(GLFWwindow* window) : m_headless(window == nullptr) {
+    m_deviceExtensions = kRequiredDeviceExtensions;
+    if (!m_headless) {
+        m_deviceExtensions.insert(m_deviceExtensions.end(),
+                                  kPresentationDeviceExtensions.begin(),
+                                  kPresentationDeviceExtensions.end());
+    }
+
     createInstance();
 #ifdef ENABLE_VALIDATION_LAYERS
     setupDebugMessenger();
 #endif
-    createSurface(window);
+    if (!m_headless) {
+        createSurface(window);
+    }
     pickPhysicalDevice();
     createLogicalDevice();
 }
@@ -140,9 +156,13 @@ void VulkanCore::createInstance() {
         .apiVersion = version(),
     };
 
-    std::uint32_t glfwExtensionCount = 0;
-    const char** glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
-    std::vector extensions(glfwExtensions, glfwExtensions + glfwExtensionCount);
+    // Headless runs never initialize GLFW, so no surface extensions are requested
+    std::vector<const char*> extensions;
+    if (!m_headless) {
+        std::uint32_t glfwExtensionCount = 0;
+        const char** glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
+        extensions.assign(glfwExtensions, glfwExtensions + glfwExtensionCount);
+    }
 
 #ifdef ENABLE_VALIDATION_LAYERS
     extensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
@@ -212,7 +232,7 @@ void VulkanCore::pickPhysicalDevice() {
     }
 
     for (const auto& device : physicalDevices) {
-        if (isDeviceSuitable(device, kRequiredDeviceExtensions)) {
+        if (isDeviceSuitable(device, m_deviceExtensions)) {
             m_physicalDevice = device;
             break;
         }
@@ -225,6 +245,15 @@ void VulkanCore::pickPhysicalDevice() {
 
 void VulkanCore::createLogicalDevice() {
     m_queueFamilyIndices = findQueueFamilies(m_physicalDevice);
+    m_pipelineStatisticsSupported = m_physicalDevice.getFeatures().pipelineStatisticsQuery == vk::True;
+
+    const auto availableExtensions = m_physicalDevice.enumerateDeviceExtensionProperties();
+    m_memoryBudgetSupported = std::ranges::any_of(availableExtensions, [](const auto& extension) {
+        return std::strcmp(extension.extensionName.data(), vk::EXTMemoryBudgetExtensionName) == 0;
+    });
+    if (m_memoryBudgetSupported) {
+        m_deviceExtensions.push_back(vk::EXTMemoryBudgetExtensionName);
+    }
 
     auto featureChain = buildFeatureChain();
     auto queueCreateInfos = buildQueueInfos(m_queueFamilyIndices);
@@ -234,9 +263,8 @@ void VulkanCore::createLogicalDevice() {
         .queueCreateInfoCount =
         static_cast<std::uint32_t>(queueCreateInfos.size()),
         .pQueueCreateInfos = queueCreateInfos.data(),
-        .enabledExtensionCount = static_cast<uint32_t>(kRequiredDeviceExtensions
-            .size()),
-        .ppEnabledExtensionNames = kRequiredDeviceExtensions.data(),
+        .enabledExtensionCount = static_cast<uint32_t>(m_deviceExtensions.size()),
+        .ppEnabledExtensionNames = m_deviceExtensions.data(),
     };
 
     m_device = vk::raii::Device(m_physicalDevice, deviceCreateInfo);
@@ -244,9 +272,11 @@ void VulkanCore::createLogicalDevice() {
     m_presentQueue = vk::raii::Queue(m_device, m_queueFamilyIndices.presentFamily.value(), 0);
 
     vk::detail::defaultDispatchLoaderDynamic.init(*m_instance, *m_device);
+
+    m_memoryTracker = std::make_unique<MemoryTracker>(m_physicalDevice, m_memoryBudgetSupported);
 }
 
-auto VulkanCore::buildFeatureChain() -> vk::StructureChain<
+auto VulkanCore::buildFeatureChain() const -> vk::StructureChain<
     vk::PhysicalDeviceFeatures2,
     vk::PhysicalDeviceVulkan13Features,
     vk::PhysicalDeviceVulkan12Features,
@@ -260,6 +290,7 @@ auto VulkanCore::buildFeatureChain() -> vk::StructureChain<
             .multiDrawIndirect = true,
             .drawIndirectFirstInstance = true,
             .samplerAnisotropy = true,
+            .pipelineStatisticsQuery = m_pipelineStatisticsSupported,
             .vertexPipelineStoresAndAtomics = true,
             .fragmentStoresAndAtomics = true,
             .shaderInt64 = true,
@@ -273,6 +304,7 @@ auto VulkanCore::buildFeatureChain() -> vk::StructureChain<
         .storageBuffer8BitAccess = true,
         .shaderSampledImageArrayNonUniformIndexing = true,
         .descriptorBindingSampledImageUpdateAfterBind = true,
+        .descriptorBindingUpdateUnusedWhilePending = true,
         .descriptorBindingPartiallyBound = true,
         .descriptorBindingVariableDescriptorCount = true,
         .runtimeDescriptorArray = true,
@@ -381,11 +413,17 @@ auto VulkanCore::findQueueFamilies(const vk::raii::PhysicalDevice& physicalDevic
             queueFamilyIndices.graphicsFamily = i;
         }
 
-        if (physicalDevice.getSurfaceSupportKHR(i, *m_surface) && !queueFamilyIndices.presentFamily.has_value()) {
+        if (!m_headless && physicalDevice.getSurfaceSupportKHR(i, *m_surface) &&
+            !queueFamilyIndices.presentFamily.has_value()) {
             queueFamilyIndices.presentFamily = i;
         }
     }
 
+    // Nothing is presented in headless mode, the "present" queue is just the graphics queue
+    if (m_headless) {
+        queueFamilyIndices.presentFamily = queueFamilyIndices.graphicsFamily;
+    }
+
     return queueFamilyIndices;
 }
 
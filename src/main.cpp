@@ -11,16 +11,30 @@ VULKAN_HPP_DEFAULT_DISPATCH_LOADER_DYNAMIC_STORAGE
 #include <memory>
 
 #include "Application.hpp"
+#include "CommandLine.hpp"
+#include "ExportCoordinator.hpp"
 
-int main() {
+int main(int argc, char** argv) {
     try {
-        Application app;
+        const LaunchOptions options = parseCommandLine(argc, argv);
+        if (options.showHelp) {
+            printUsage(argv[0]);
+            return 0;
+        }
+
+        // The coordinator only starts worker processes, each of them runs its own Application
+        if (options.exportWorkers > 0) {
+            ExportCoordinator coordinator(options, argv[0]);
+            coordinator.run();
+            return 0;
+        }
+
+        Application app(options);
         app.run();
     } catch (const std::exception& e) {
         std::cerr << "Error: " << e.what() << std::endl;
         return -1;
     }
-    
+
     return 0;
 }
-
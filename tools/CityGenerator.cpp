@@ -0,0 +1,178 @@
+#define STB_IMAGE_IMPLEMENTATION
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#define TINYGLTF_IMPLEMENTATION
+
+#include <vulkan/vulkan.hpp>
+
+VULKAN_HPP_DEFAULT_DISPATCH_LOADER_DYNAMIC_STORAGE
+
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <format>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+#include "GLTFLoader.hpp"
+#include "GltfBuilder.hpp"
+#include "JobSystem.hpp"
+#include "SyntheticCity.hpp"
+
+// Writes a procedural city GLB (bench/SyntheticCity.cpp) for scale testing, e.g.
+//   CityGenerator --buildings 20000 --point-lights 640 --vehicles 500 --out city_20k.glb --verify
+//   CyberpunkCityDemo --scene city_20k.glb --benchmark
+
+namespace {
+struct GeneratorOptions {
+    CityDesc city;
+    std::string outputPath = "city.glb";
+    bool verify = false;
+    bool showHelp = false;
+};
+
+auto requireValue(const int argc, char** argv, int& i) -> std::string {
+    if (i + 1 >= argc) {
+        throw std::runtime_error("Missing value for command line option " + std::string(argv[i]));
+    }
+    return argv[++i];
+}
+
+auto parseSize(const std::string_view option, const std::string& value) -> std::size_t {
+    try {
+        return static_cast<std::size_t>(std::stoull(value));
+    } catch (const std::exception&) {
+        throw std::runtime_error("Invalid value '" + value + "' for " + std::string(option));
+    }
+}
+
+auto parseFloat(const std::string_view option, const std::string& value) -> float {
+    try {
+        return std::stof(value);
+    } catch (const std::exception&) {
+        throw std::runtime_error("Invalid value '" + value + "' for " + std::string(option));
+    }
+}
+
+auto parseOptions(const int argc, char** argv) -> GeneratorOptions {
+    GeneratorOptions options{};
+    CityDesc& city = options.city;
+
+    for (int i = 1; i < argc; i++) {
+        const std::string_view arg = argv[i];
+
+        if (arg == "--out") {
+            options.outputPath = requireValue(argc, argv, i);
+        } else if (arg == "--buildings") {
+            city.buildingCount = parseSize(arg, requireValue(argc, argv, i));
+        } else if (arg == "--unique-buildings") {
+            city.uniqueBuildingCount = parseSize(arg, requireValue(argc, argv, i));
+        } else if (arg == "--materials") {
+            city.materialCount = parseSize(arg, requireValue(argc, argv, i));
+        } else if (arg == "--textures") {
+            city.textureCount = parseSize(arg, requireValue(argc, argv, i));
+        } else if (arg == "--texture-size") {
+            city.textureSize = static_cast<std::uint32_t>(std::clamp<std::size_t>(parseSize(arg, requireValue(argc, argv, i)), 16, 8192));
+        } else if (arg == "--point-lights") {
+            city.pointLightCount = parseSize(arg, requireValue(argc, argv, i));
+        } else if (arg == "--spot-lights") {
+            city.spotLightCount = parseSize(arg, requireValue(argc, argv, i));
+        } else if (arg == "--shadow-fraction") {
+            city.shadowCasterFraction = std::clamp(parseFloat(arg, requireValue(argc, argv, i)), 0.0f, 1.0f);
+        } else if (arg == "--vehicles") {
+            city.vehicleCount = parseSize(arg, requireValue(argc, argv, i));
+        } else if (arg == "--vehicle-keyframes") {
+            city.vehicleKeyframes = parseSize(arg, requireValue(argc, argv, i));
+        } else if (arg == "--duration") {
+            city.duration = parseFloat(arg, requireValue(argc, argv, i));
+            if (city.duration <= 0.0f) {
+                throw std::runtime_error("--duration must be positive");
+            }
+        } else if (arg == "--seed") {
+            city.seed = static_cast<std::uint32_t>(parseSize(arg, requireValue(argc, argv, i)));
+        } else if (arg == "--verify") {
+            options.verify = true;
+        } else if (arg == "--help" || arg == "-h") {
+            options.showHelp = true;
+        } else {
+            throw std::runtime_error("Unknown command line option: " + std::string(arg));
+        }
+    }
+
+    return options;
+}
+
+void printUsage(const char* executableName) {
+    const CityDesc defaults{};
+    std::cout << "Usage: " << executableName << " [options]\n"
+              << "  --out <path>               Output GLB (default: city.glb)\n"
+              << "  --buildings <n>            Building instances (default: " << defaults.buildingCount << ")\n"
+              << "  --unique-buildings <n>     Distinct building meshes shared by the instances (default: " << defaults.uniqueBuildingCount << ")\n"
+              << "  --materials <n>            Facade materials (default: " << defaults.materialCount << ")\n"
+              << "  --textures <n>             Facade textures, 0 = untextured (default: " << defaults.textureCount << ")\n"
+              << "  --texture-size <px>        Texture edge length (default: " << defaults.textureSize << ")\n"
+              << "  --point-lights <n>         Neon point lights (default: " << defaults.pointLightCount << ")\n"
+              << "  --spot-lights <n>          Street lamp spot lights (default: " << defaults.spotLightCount << ")\n"
+              << "  --shadow-fraction <f>      Share of the lights tagged castsShadows (default: " << defaults.shadowCasterFraction << ")\n"
+              << "  --vehicles <n>             Animated vehicles (default: " << defaults.vehicleCount << ")\n"
+              << "  --vehicle-keyframes <n>    Keys per vehicle path (default: " << defaults.vehicleKeyframes << ")\n"
+              << "  --duration <s>             Animation loop length (default: " << defaults.duration << ")\n"
+              << "  --seed <n>                 Random seed (default: " << defaults.seed << ")\n"
+              << "  --verify                   Load the written file with GLTFLoader and check the counts\n";
+}
+
+// Reads the file back through the engine's loader and compares what it built against the description
+void verify(const GeneratorOptions& options) {
+    JobSystem jobSystem;
+    GLTFLoader loader(jobSystem);
+    const auto loaded = loader.load(options.outputPath);
+    const Scene& scene = loaded->scene;
+    const CityCounts expected = expectedCityCounts(options.city);
+
+    const auto check = [](const char* what, const std::size_t actual, const std::size_t wanted) {
+        if (actual != wanted) {
+            throw std::runtime_error(std::format("Verification failed: {} {} instead of {}", actual, what, wanted));
+        }
+    };
+    check("instances", scene.instances.size(), expected.instances);
+    check("animated instances", scene.instances.size() - scene.firstDynamicInstance, expected.animatedInstances);
+    check("meshes", scene.meshes.size(), expected.meshes);
+    check("materials", scene.materials.size(), expected.materials);
+    check("point lights", scene.pointLights.size(), expected.pointLights);
+    check("spot lights", scene.spotLights.size(), expected.spotLights);
+
+    std::cout << "[CityGenerator] Verified with GLTFLoader: " << scene.baseColorTextures.size()
+              << " base color textures, " << scene.vertices.size() << " vertices" << std::endl;
+}
+} // namespace
+
+int main(int argc, char** argv) {
+    try {
+        const GeneratorOptions options = parseOptions(argc, argv);
+        if (options.showHelp) {
+            printUsage(argv[0]);
+            return 0;
+        }
+
+        const tinygltf::Model model = buildCityModel(options.city);
+        writeGlb(model, options.outputPath);
+
+        const CityCounts counts = expectedCityCounts(options.city);
+        const auto bytes = std::filesystem::file_size(options.outputPath);
+        std::cout << std::format("[CityGenerator] Wrote {} ({:.1f} MB): {} instances of {} meshes, {} animated, "
+                                 "{} materials, {} textures, {} point / {} spot lights\n",
+                                 options.outputPath, static_cast<double>(bytes) / (1024.0 * 1024.0), counts.instances,
+                                 counts.meshes, counts.animatedInstances, counts.materials, model.textures.size(),
+                                 counts.pointLights, counts.spotLights);
+
+        if (options.verify) {
+            verify(options);
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return -1;
+    }
+
+    return 0;
+}
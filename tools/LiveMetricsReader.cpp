@@ -0,0 +1,215 @@
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+
+#include "LiveMetrics.hpp"
+
+// Samples the metrics a running demo publishes with --live-metrics (include/LiveMetrics.hpp), e.g.
+//   CyberpunkCityDemo --live-metrics cyberpunk_metrics
+//   LiveMetricsReader --name cyberpunk_metrics --interval 500 --csv kiosk.csv
+
+namespace {
+struct ReaderOptions {
+    std::string name = LIVE_METRICS_DEFAULT_NAME;
+    std::uint32_t intervalMs = 1000;
+    std::uint64_t count = 0;  // 0 = until interrupted
+    std::string csvPath;
+    bool showHelp = false;
+};
+
+auto requireValue(const int argc, char** argv, int& i) -> std::string {
+    if (i + 1 >= argc) {
+        throw std::runtime_error("Missing value for command line option " + std::string(argv[i]));
+    }
+    return argv[++i];
+}
+
+auto parseSize(const std::string_view option, const std::string& value) -> std::uint64_t {
+    try {
+        return std::stoull(value);
+    } catch (const std::exception&) {
+        throw std::runtime_error("Invalid value '" + value + "' for " + std::string(option));
+    }
+}
+
+auto parseOptions(const int argc, char** argv) -> ReaderOptions {
+    ReaderOptions options{};
+
+    for (int i = 1; i < argc; i++) {
+        const std::string_view arg = argv[i];
+
+        if (arg == "--name") {
+            options.name = requireValue(argc, argv, i);
+        } else if (arg == "--interval") {
+            options.intervalMs = static_cast<std::uint32_t>(parseSize(arg, requireValue(argc, argv, i)));
+            if (options.intervalMs == 0) {
+                throw std::runtime_error("--interval must be positive");
+            }
+        } else if (arg == "--count") {
+            options.count = parseSize(arg, requireValue(argc, argv, i));
+        } else if (arg == "--csv") {
+            options.csvPath = requireValue(argc, argv, i);
+        } else if (arg == "--help" || arg == "-h") {
+            options.showHelp = true;
+        } else {
+            throw std::runtime_error("Unknown command line option: " + std::string(arg));
+        }
+    }
+
+    return options;
+}
+
+void printUsage(const char* executableName) {
+    std::cout << "Usage: " << executableName << " [options]\n"
+              << "  --name <name>       Shared memory segment of the demo's --live-metrics (default: " << LIVE_METRICS_DEFAULT_NAME << ")\n"
+              << "  --interval <ms>     Time between samples (default: 1000)\n"
+              << "  --count <n>         Stop after n samples (default: until interrupted)\n"
+              << "  --csv <path>        Also append every sample to a CSV file\n";
+}
+
+auto toMegabytes(const std::uint64_t bytes) -> double {
+    return static_cast<double>(bytes) / (1024.0 * 1024.0);
+}
+
+void writeCsvHeader(std::ostream& csv, const LiveMetricsReader& reader) {
+    csv << "frame,timestamp_ns,frame_ms,animate_ms,fence_wait_ms,acquire_ms,scene_update_ms,record_ms,submit_ms,present_ms,"
+           "gpu_frame";
+    for (std::uint32_t pass = 0; pass < reader.gpuPassCount(); pass++) {
+        csv << ",gpu." << reader.gpuPassName(pass) << "_ms";
+    }
+    csv << ",draw_calls,visible_instances,visible_triangles,ray_frame,shadow_rays,reflection_rays,candidate_iterations,"
+           "memory_tracked_bytes,memory_peak_bytes,memory_budget_bytes,memory_usage_bytes,tlas_updates\n";
+}
+
+// Results that have not arrived yet are left empty
+auto optionalFrame(const std::uint64_t frame) -> std::string {
+    return frame == LIVE_METRICS_NONE ? std::string() : std::to_string(frame);
+}
+
+void writeCsvRow(std::ostream& csv, const LiveMetricsReader& reader, const LiveMetricsFrame& frame) {
+    csv << std::format("{},{},{:.3f},{:.3f},{:.3f},{:.3f},{:.3f},{:.3f},{:.3f},{:.3f},{}", frame.frameNumber,
+                       frame.timestampNs, frame.frameMs, frame.animateMs, frame.fenceWaitMs, frame.acquireMs,
+                       frame.sceneUpdateMs, frame.recordMs, frame.submitMs, frame.presentMs,
+                       optionalFrame(frame.gpuFrameNumber));
+    for (std::uint32_t pass = 0; pass < reader.gpuPassCount(); pass++) {
+        const double ms = frame.gpuPassMs[pass];
+        csv << (frame.gpuFrameNumber == LIVE_METRICS_NONE || std::isnan(ms) ? "," : std::format(",{:.3f}", ms));
+    }
+    csv << std::format(",{},{},{},{},{},{},{},{},{},{},{},{}\n", frame.drawCalls, frame.visibleInstances,
+                       frame.visibleTriangles, optionalFrame(frame.rayFrameNumber), frame.shadowRays,
+                       frame.reflectionRays, frame.candidateIterations, frame.memoryTrackedBytes,
+                       frame.memoryPeakBytes, frame.memoryBudgetBytes, frame.memoryUsageBytes, frame.tlasUpdates);
+    csv.flush();
+}
+
+// One line per sample: rate since the previous sample, then the latest frame
+void printSample(const LiveMetricsFrame& frame,
+                 const LiveMetricsFrame* previous,
+                 const std::uint32_t gpuFramePass) {
+    std::string line = std::format("[LiveMetrics] frame {}", frame.frameNumber);
+
+    if (previous != nullptr) {
+        if (frame.frameNumber == previous->frameNumber) {
+            std::cout << line << " | STALLED, no new frame since the last sample" << std::endl;
+            return;
+        }
+        const double seconds = static_cast<double>(frame.timestampNs - previous->timestampNs) / 1e9;
+        if (seconds > 0.0) {
+            line += std::format(" | {:.1f} fps", static_cast<double>(frame.frameNumber - previous->frameNumber) / seconds);
+        }
+    }
+
+    line += std::format(" | cpu {:.2f} ms (fence {:.2f}, record {:.2f})", frame.frameMs, frame.fenceWaitMs,
+                        frame.recordMs);
+    if (frame.gpuFrameNumber != LIVE_METRICS_NONE && gpuFramePass < LIVE_METRICS_MAX_GPU_PASSES &&
+        !std::isnan(frame.gpuPassMs[gpuFramePass])) {
+        line += std::format(" | gpu {:.2f} ms", frame.gpuPassMs[gpuFramePass]);
+    }
+    line += std::format(" | {} draws, {} instances, {:.2f} M triangles", frame.drawCalls, frame.visibleInstances,
+                        static_cast<double>(frame.visibleTriangles) / 1e6);
+    if (frame.rayFrameNumber != LIVE_METRICS_NONE) {
+        line += std::format(" | rays {:.2f} M shadow, {:.2f} M reflection", static_cast<double>(frame.shadowRays) / 1e6,
+                            static_cast<double>(frame.reflectionRays) / 1e6);
+    }
+    line += std::format(" | {:.1f} MB tracked", toMegabytes(frame.memoryTrackedBytes));
+    if (frame.memoryBudgetBytes > 0) {
+        line += std::format(" ({:.1f} / {:.1f} MB budget)", toMegabytes(frame.memoryUsageBytes),
+                            toMegabytes(frame.memoryBudgetBytes));
+    }
+    line += std::format(" | {} TLAS updates", frame.tlasUpdates);
+
+    std::cout << line << std::endl;
+}
+} // namespace
+
+int main(int argc, char** argv) {
+    try {
+        const ReaderOptions options = parseOptions(argc, argv);
+        if (options.showHelp) {
+            printUsage(argv[0]);
+            return 0;
+        }
+
+        const LiveMetricsReader reader(options.name);
+
+        // The whole-frame GPU time is the pass named "frame"
+        std::uint32_t gpuFramePass = LIVE_METRICS_MAX_GPU_PASSES;
+        for (std::uint32_t pass = 0; pass < reader.gpuPassCount(); pass++) {
+            if (reader.gpuPassName(pass) == "frame") {
+                gpuFramePass = pass;
+            }
+        }
+
+        // Appends, so several reader sessions can log into one file; the header only goes into a new or empty one
+        std::ofstream csv;
+        if (!options.csvPath.empty()) {
+            std::error_code error;
+            const bool newFile = !std::filesystem::exists(options.csvPath, error) ||
+                                 std::filesystem::file_size(options.csvPath, error) == 0;
+            csv.open(options.csvPath, std::ios::app);
+            if (!csv) {
+                throw std::runtime_error("Failed to open CSV for writing: " + options.csvPath);
+            }
+            if (newFile) {
+                writeCsvHeader(csv, reader);
+            }
+        }
+
+        std::cout << "[LiveMetrics] Reading '" << options.name << "' of process " << reader.processId() << " every "
+                  << options.intervalMs << " ms" << std::endl;
+
+        LiveMetricsFrame previous{};
+        bool havePrevious = false;
+        for (std::uint64_t sample = 0; options.count == 0 || sample < options.count; sample++) {
+            if (sample > 0) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(options.intervalMs));
+            }
+
+            LiveMetricsFrame frame{};
+            if (!reader.read(frame)) {
+                std::cout << "[LiveMetrics] Writer busy for every retry, sample skipped" << std::endl;
+                continue;
+            }
+
+            printSample(frame, havePrevious ? &previous : nullptr, gpuFramePass);
+            if (csv.is_open()) {
+                writeCsvRow(csv, reader, frame);
+            }
+            previous = frame;
+            havePrevious = true;
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return -1;
+    }
+
+    return 0;
+}